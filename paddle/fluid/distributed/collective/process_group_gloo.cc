@@ -12,7 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <numeric>
 
 #ifdef _WIN32
 #include <gloo/common/win.h>
@@ -34,6 +37,7 @@
 #include "paddle/fluid/distributed/collective/process_group_gloo.h"
 #include "paddle/fluid/framework/fleet/gloo_wrapper.h"
 #include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/core/distributed/gloo_collectives.h"
 
 namespace paddle {
 namespace distributed {
@@ -444,6 +448,131 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
   return task;
 }
 
+class AllreduceCoalescedGlooTask : public ProcessGroupGloo::GlooTask {
+ public:
+  AllreduceCoalescedGlooTask(int rank,
+                             const std::shared_ptr<gloo::Context>& context,
+                             std::vector<phi::DenseTensor>& tensors,  // NOLINT
+                             ReduceOp reduce_op,
+                             int64_t bucket_size,
+                             uint32_t tag)
+      : ProcessGroupGloo::GlooTask(rank, tensors, CommType::ALLREDUCE),
+        _context(context),
+        _tensors(tensors),
+        _reduce_op(reduce_op),
+        _bucket_size(bucket_size),
+        _tag(tag) {}
+
+  void Run() override { _do_allreduce_coalesced(_tensors); }
+
+ private:
+  std::shared_ptr<gloo::Context> _context;
+  std::vector<phi::DenseTensor> _tensors;
+  const ReduceOp _reduce_op;
+  const int64_t _bucket_size;
+  uint32_t _tag;
+  std::vector<char> _buffer;
+
+  template <typename T>
+  void _allreduce_buffer(void* data, int64_t numel) {
+    gloo::AllreduceOptions opts(_context);
+    opts.setInput(reinterpret_cast<T*>(data), numel);
+    opts.setOutput(reinterpret_cast<T*>(data), numel);
+    opts.setReduceFunction(get_function<T>(_reduce_op));
+    opts.setTag(_tag);
+    gloo::allreduce(opts);
+  }
+
+  // Allreduces the tensors [begin, end) of the same dtype, a bucket of one
+  // tensor is reduced inplace without packing.
+  void _allreduce_bucket(const std::vector<phi::DenseTensor*>& tensors,
+                         size_t begin,
+                         size_t end) {
+    const auto& dtype = tensors[begin]->dtype();
+    if (end - begin == 1) {
+      GENERATE_FUNC(dtype,
+                    _allreduce_buffer,
+                    tensors[begin]->data(),
+                    tensors[begin]->numel());
+      return;
+    }
+    const size_t elem_size = phi::SizeOf(dtype);
+    int64_t numel = 0;
+    for (size_t i = begin; i < end; ++i) {
+      numel += tensors[i]->numel();
+    }
+    _buffer.resize(numel * elem_size);
+    char* ptr = _buffer.data();
+    for (size_t i = begin; i < end; ++i) {
+      size_t bytes = tensors[i]->numel() * elem_size;
+      std::memcpy(ptr, tensors[i]->data(), bytes);
+      ptr += bytes;
+    }
+    GENERATE_FUNC(dtype, _allreduce_buffer, _buffer.data(), numel);
+    ptr = _buffer.data();
+    for (size_t i = begin; i < end; ++i) {
+      size_t bytes = tensors[i]->numel() * elem_size;
+      std::memcpy(tensors[i]->data(), ptr, bytes);
+      ptr += bytes;
+    }
+  }
+
+  void _do_allreduce_coalesced(
+      std::vector<phi::DenseTensor>& tensors) {  // NOLINT
+    // group the tensors by dtype, keeping their order within a dtype so that
+    // all the ranks build the same buckets
+    std::vector<phi::DenseTensor*> sorted;
+    sorted.reserve(tensors.size());
+    for (auto& tensor : tensors) {
+      if (tensor.numel() > 0) {
+        sorted.push_back(&tensor);
+      }
+    }
+    std::stable_sort(sorted.begin(),
+                     sorted.end(),
+                     [](const phi::DenseTensor* a, const phi::DenseTensor* b) {
+                       return a->dtype() < b->dtype();
+                     });
+
+    size_t begin = 0;
+    int64_t bytes = 0;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+      int64_t tensor_bytes =
+          sorted[i]->numel() * phi::SizeOf(sorted[i]->dtype());
+      if (i > begin && (sorted[i]->dtype() != sorted[begin]->dtype() ||
+                        bytes + tensor_bytes > _bucket_size)) {
+        _allreduce_bucket(sorted, begin, i);
+        begin = i;
+        bytes = 0;
+      }
+      bytes += tensor_bytes;
+    }
+    if (begin < sorted.size()) {
+      _allreduce_bucket(sorted, begin, sorted.size());
+    }
+  }
+};
+
+std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduceCoalesced(
+    std::vector<phi::DenseTensor>& tensors,
+    const AllreduceOptions& opts,
+    int64_t bucket_size,
+    bool sync_op) {
+  PADDLE_ENFORCE_GT(bucket_size,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The bucket_size of all_reduce_coalesced should be "
+                        "greater than 0, but got %d.",
+                        bucket_size));
+  auto tag = next_tag();
+  std::shared_ptr<GlooTask> task;
+  auto context = get_context();
+  task = std::make_shared<AllreduceCoalescedGlooTask>(
+      rank_, context, tensors, opts.reduce_op, bucket_size, tag);
+  task->Run();
+  return task;
+}
+
 class BarrierGlooTask : public ProcessGroupGloo::GlooTask {
  public:
   BarrierGlooTask(int rank, const std::shared_ptr<gloo::Context>& context)
@@ -616,6 +745,74 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Reduce(
   return Reduce(&outputs[0], inputs[0], opts, true);
 }
 
+class ReduceScatterGlooTask : public ProcessGroupGloo::GlooTask {
+ public:
+  ReduceScatterGlooTask(int rank,
+                        const std::shared_ptr<gloo::Context>& context,
+                        const phi::DenseTensor& input,
+                        phi::DenseTensor* output,
+                        ReduceOp reduce_op,
+                        uint32_t tag)
+      : ProcessGroupGloo::GlooTask(rank, {input}, CommType::REDUCE_SCATTER),
+        _context(context),
+        _input(input),
+        _output(*output),
+        _reduce_op(reduce_op),
+        _tag(tag) {}
+
+  void Run() override { _do_reduce_scatter(_input, &_output); }
+
+ private:
+  std::shared_ptr<gloo::Context> _context;
+  phi::DenseTensor _input;
+  phi::DenseTensor _output;
+  const ReduceOp _reduce_op;
+  uint32_t _tag;
+
+  template <typename T>
+  void _get_function_impl(reduce_func& fn,  // NOLINT
+                          const ReduceOp op) {
+    fn = get_function<T>(op);
+  }
+
+  void _do_reduce_scatter(const phi::DenseTensor& in,
+                          phi::DenseTensor* out) {
+    const auto& dtype = in.dtype();
+    reduce_func fn;
+    GENERATE_FUNC(dtype, _get_function_impl, fn, _reduce_op);
+    phi::distributed::GlooReduceScatter(_context,
+                                        in.data(),
+                                        out->data(),
+                                        out->numel(),
+                                        phi::SizeOf(dtype),
+                                        fn,
+                                        _tag);
+  }
+};
+
+std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::ReduceScatter(
+    phi::DenseTensor* out_tensor,
+    const phi::DenseTensor& in_tensor,
+    const ReduceScatterOptions& opts,
+    bool sync_op) {
+  PADDLE_ENFORCE_EQ(
+      in_tensor.numel(),
+      out_tensor->numel() * size_,
+      platform::errors::InvalidArgument(
+          "The input of reduce_scatter should have %d times the elements of "
+          "the output, but got %d and %d.",
+          size_,
+          in_tensor.numel(),
+          out_tensor->numel()));
+  std::shared_ptr<ReduceScatterGlooTask> task;
+  auto tag = next_tag();
+  auto context = get_context();
+  task = std::make_shared<ReduceScatterGlooTask>(
+      rank_, context, in_tensor, out_tensor, opts.reduce_op, tag);
+  task->Run();
+  return task;
+}
+
 class ScatterGlooTask : public ProcessGroupGloo::GlooTask {
  public:
   ScatterGlooTask(int rank,
@@ -740,6 +937,88 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Gather(
   return task;
 }
 
+class AllToAllGlooTask : public ProcessGroupGloo::GlooTask {
+ public:
+  AllToAllGlooTask(int rank,
+                   const std::shared_ptr<gloo::Context>& context,
+                   const phi::DenseTensor& input,
+                   phi::DenseTensor* output,
+                   const std::vector<size_t>& in_bytes,
+                   const std::vector<size_t>& out_bytes,
+                   uint32_t tag)
+      : ProcessGroupGloo::GlooTask(rank, {input}, CommType::ALLTOALL),
+        _context(context),
+        _input(input),
+        _output(*output),
+        _in_bytes(in_bytes),
+        _out_bytes(out_bytes),
+        _tag(tag) {}
+
+  void Run() override {
+    phi::distributed::GlooAllToAll(
+        _context, _input.data(), _output.data(), _in_bytes, _out_bytes, _tag);
+  }
+
+ private:
+  std::shared_ptr<gloo::Context> _context;
+  phi::DenseTensor _input;
+  phi::DenseTensor _output;
+  std::vector<size_t> _in_bytes;
+  std::vector<size_t> _out_bytes;
+  uint32_t _tag;
+};
+
+// Bytes of the blocks of tensor exchanged with each rank, a block has
+// size_each_rank[i] rows of dim[0].
+static std::vector<size_t> GetBlockBytesOfEachRank(
+    const phi::DenseTensor& tensor,
+    const std::vector<int64_t>& size_each_rank,
+    int world_size) {
+  PADDLE_ENFORCE_EQ(
+      size_each_rank.size(),
+      static_cast<size_t>(world_size),
+      platform::errors::InvalidArgument(
+          "The length of size_on_each_rank must be equal to world_size."));
+  const auto& dims = tensor.dims();
+  PADDLE_ENFORCE_EQ(
+      std::accumulate(size_each_rank.begin(),
+                      size_each_rank.end(),
+                      static_cast<int64_t>(0)),
+      dims[0],
+      platform::errors::InvalidArgument(
+          "The sum of size_on_each_rank must be equal to tensor's dim[0]."));
+  size_t row_bytes =
+      dims[0] == 0 ? 0 : tensor.numel() / dims[0] * phi::SizeOf(tensor.dtype());
+  std::vector<size_t> block_bytes(world_size);
+  for (int i = 0; i < world_size; ++i) {
+    block_bytes[i] = size_each_rank[i] * row_bytes;
+  }
+  return block_bytes;
+}
+
+std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllToAll(
+    phi::DenseTensor* out_tensor,
+    const phi::DenseTensor& in_tensor,
+    const std::vector<int64_t>& out_size_each_rank,
+    const std::vector<int64_t>& in_size_each_rank,
+    bool sync_op) {
+  PADDLE_ENFORCE_EQ(
+      in_tensor.dtype(),
+      out_tensor->dtype(),
+      platform::errors::InvalidArgument(
+          "The input and output of all_to_all should have the same dtype."));
+  auto in_bytes = GetBlockBytesOfEachRank(in_tensor, in_size_each_rank, size_);
+  auto out_bytes =
+      GetBlockBytesOfEachRank(*out_tensor, out_size_each_rank, size_);
+  std::shared_ptr<AllToAllGlooTask> task;
+  auto tag = next_tag();
+  auto context = get_context();
+  task = std::make_shared<AllToAllGlooTask>(
+      rank_, context, in_tensor, out_tensor, in_bytes, out_bytes, tag);
+  task->Run();
+  return task;
+}
+
 std::shared_ptr<::gloo::transport::Device>
 ProcessGroupGloo::createDeviceForInterface(const std::string& ifname) {
   ::gloo::transport::tcp::attr attr;
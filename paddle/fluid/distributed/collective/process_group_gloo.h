@@ -17,6 +17,7 @@
 #include <future>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "paddle/fluid/distributed/collective/process_group.h"
 #include "paddle/fluid/distributed/collective/process_group_without_stream.h"
@@ -126,6 +127,13 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
       const AllreduceOptions& opts,
       bool sync_op) override;
 
+  std::shared_ptr<ProcessGroup::Task> AllToAll(
+      phi::DenseTensor* out_tensor,
+      const phi::DenseTensor& in_tensor,
+      const std::vector<int64_t>& out_size_each_rank,
+      const std::vector<int64_t>& in_size_each_rank,
+      bool sync_op) override;
+
   std::shared_ptr<ProcessGroup::Task> Broadcast(
       phi::DenseTensor* out_tensor,
       const phi::DenseTensor& in_tensor,
@@ -145,6 +153,12 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
                                              const ReduceOptions& opts,
                                              bool sync_op) override;
 
+  std::shared_ptr<ProcessGroup::Task> ReduceScatter(
+      phi::DenseTensor* out_tensor,
+      const phi::DenseTensor& in_tensor,
+      const ReduceScatterOptions& opts,
+      bool sync_op) override;
+
   std::shared_ptr<ProcessGroup::Task> Scatter(phi::DenseTensor* out_tensor,
                                               const phi::DenseTensor& in_tensor,
                                               const ScatterOptions& opts,
@@ -156,6 +170,15 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
                                              bool sync_op,
                                              bool use_calc_stream) override;
 
+  // Allreduces the tensors inplace, which may differ in shape and dtype, by
+  // packing the tensors of a dtype into flat buckets of at most bucket_size
+  // bytes, so many small gradients cost one gloo allreduce per bucket.
+  std::shared_ptr<ProcessGroup::Task> AllReduceCoalesced(
+      std::vector<phi::DenseTensor>& tensors,  // NOLINT
+      const AllreduceOptions& opts,
+      int64_t bucket_size,
+      bool sync_op);
+
   // TODO(sunyilun): methods below will be removed later
   std::shared_ptr<ProcessGroup::Task> Broadcast(
       std::vector<phi::DenseTensor>& inputs,
@@ -0,0 +1,191 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle {
+namespace distributed {
+
+/*
+ * Codec of the gradients pushed with TableParameter.push_quant_type.
+ *
+ * A row of floats is sent as fp16, or as int8 after a float scale of the
+ * row. The error feedback keeps what the quantization of a row lost in a
+ * residual, which is added to the next push of the same row, so the error
+ * does not accumulate on the servers.
+ *
+ * A sparse push value keeps its leading floats, like slot, show and click,
+ * as they are, and only quantizes the trailing quant_dim gradients. A dense
+ * push is quantized in rows of kDensePushQuantRowDim.
+ */
+constexpr size_t kDensePushQuantRowDim = 256;
+
+inline size_t PushQuantRowBytes(PushQuantType type, size_t dim) {
+  switch (type) {
+    case PUSH_QUANT_FP16:
+      return dim * sizeof(phi::dtype::float16);
+    case PUSH_QUANT_INT8:
+      return sizeof(float) + dim * sizeof(int8_t);
+    default:
+      return dim * sizeof(float);
+  }
+}
+
+// residual may be nullptr when there is no error feedback.
+inline void PushQuantRow(PushQuantType type,
+                         const float *row,
+                         size_t dim,
+                         float *residual,
+                         char *out) {
+  auto value = [row, residual](size_t i) {
+    return residual == nullptr ? row[i] : row[i] + residual[i];
+  };
+  switch (type) {
+    case PUSH_QUANT_FP16:
+      for (size_t i = 0; i < dim; ++i) {
+        float v = value(i);
+        phi::dtype::float16 q(v);
+        memcpy(out + i * sizeof(q), &q, sizeof(q));
+        if (residual != nullptr) residual[i] = v - static_cast<float>(q);
+      }
+      break;
+    case PUSH_QUANT_INT8: {
+      float max_abs = 0;
+      for (size_t i = 0; i < dim; ++i) {
+        max_abs = std::max(max_abs, std::fabs(value(i)));
+      }
+      float scale = max_abs / 127.0f;
+      memcpy(out, &scale, sizeof(float));
+      auto *q = reinterpret_cast<int8_t *>(out + sizeof(float));
+      for (size_t i = 0; i < dim; ++i) {
+        float v = value(i);
+        q[i] = scale > 0 ? static_cast<int8_t>(std::max(
+                               -127L, std::min(127L, std::lround(v / scale))))
+                         : 0;
+        if (residual != nullptr) residual[i] = v - q[i] * scale;
+      }
+      break;
+    }
+    default:
+      for (size_t i = 0; i < dim; ++i) {
+        float v = value(i);
+        memcpy(out + i * sizeof(float), &v, sizeof(float));
+        if (residual != nullptr) residual[i] = 0;
+      }
+  }
+}
+
+inline void PushDequantRow(PushQuantType type,
+                           const char *in,
+                           size_t dim,
+                           float *row) {
+  switch (type) {
+    case PUSH_QUANT_FP16:
+      for (size_t i = 0; i < dim; ++i) {
+        phi::dtype::float16 q;
+        memcpy(&q, in + i * sizeof(q), sizeof(q));
+        row[i] = static_cast<float>(q);
+      }
+      break;
+    case PUSH_QUANT_INT8: {
+      float scale;
+      memcpy(&scale, in, sizeof(float));
+      const auto *q = reinterpret_cast<const int8_t *>(in + sizeof(float));
+      for (size_t i = 0; i < dim; ++i) {
+        row[i] = q[i] * scale;
+      }
+      break;
+    }
+    default:
+      memcpy(row, in, dim * sizeof(float));
+  }
+}
+
+inline size_t SparsePushQuantBytes(PushQuantType type,
+                                   size_t update_dim,
+                                   size_t quant_dim) {
+  return (update_dim - quant_dim) * sizeof(float) +
+         PushQuantRowBytes(type, quant_dim);
+}
+
+inline void SparsePushQuant(PushQuantType type,
+                            const float *value,
+                            size_t update_dim,
+                            size_t quant_dim,
+                            float *residual,
+                            char *out) {
+  size_t raw_dim = update_dim - quant_dim;
+  memcpy(out, value, raw_dim * sizeof(float));
+  PushQuantRow(type,
+               value + raw_dim,
+               quant_dim,
+               residual,
+               out + raw_dim * sizeof(float));
+}
+
+inline void SparsePushDequant(PushQuantType type,
+                              const char *in,
+                              size_t update_dim,
+                              size_t quant_dim,
+                              float *value) {
+  size_t raw_dim = update_dim - quant_dim;
+  memcpy(value, in, raw_dim * sizeof(float));
+  PushDequantRow(
+      type, in + raw_dim * sizeof(float), quant_dim, value + raw_dim);
+}
+
+inline size_t DensePushQuantBytes(PushQuantType type, size_t num) {
+  size_t full_rows = num / kDensePushQuantRowDim;
+  size_t tail = num % kDensePushQuantRowDim;
+  return full_rows * PushQuantRowBytes(type, kDensePushQuantRowDim) +
+         (tail > 0 ? PushQuantRowBytes(type, tail) : 0);
+}
+
+inline void DensePushQuant(PushQuantType type,
+                           const float *values,
+                           size_t num,
+                           float *residual,
+                           char *out) {
+  for (size_t begin = 0; begin < num; begin += kDensePushQuantRowDim) {
+    size_t dim = std::min(kDensePushQuantRowDim, num - begin);
+    PushQuantRow(type,
+                 values + begin,
+                 dim,
+                 residual == nullptr ? nullptr : residual + begin,
+                 out);
+    out += PushQuantRowBytes(type, dim);
+  }
+}
+
+inline void DensePushDequant(PushQuantType type,
+                             const char *in,
+                             size_t num,
+                             float *values) {
+  for (size_t begin = 0; begin < num; begin += kDensePushQuantRowDim) {
+    size_t dim = std::min(kDensePushQuantRowDim, num - begin);
+    PushDequantRow(type, in, dim, values + begin);
+    in += PushQuantRowBytes(type, dim);
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -18,6 +18,7 @@
 #include <sstream>
 #include <string>
 
+#include "paddle/fluid/distributed/common/push_quant.h"
 #include "paddle/fluid/distributed/ps/service/coordinator_client.h"
 #include "paddle/fluid/framework/archive.h"
 #include "paddle/fluid/string/split.h"
@@ -78,6 +79,24 @@ DEFINE_int32(pserver_sparse_table_shard_num,
              1000,
              "sparse table shard for save & load");
 
+DEFINE_int32(pserver_sparse_cache_capacity,
+             0,
+             "max keys cached from each sparse table by PullSparse, "
+             "0 disables the cache");
+
+DEFINE_int32(pserver_sparse_cache_staleness_steps,
+             1,
+             "max pushes to the table a cached sparse value may lag");
+
+DEFINE_int32(pserver_sparse_cache_staleness_ms,
+             0,
+             "max ms a cached sparse value may live, 0 for no limit");
+
+DEFINE_int32(pserver_push_quant_residual_capacity,
+             1000000,
+             "max sparse keys whose push quant residual is kept for each "
+             "server, the residuals are dropped past it");
+
 inline size_t get_sparse_shard(uint32_t shard_num,
                                uint32_t server_num,
                                uint64_t key) {
@@ -334,6 +353,20 @@ int32_t BrpcPsClient::Initialize() {
   for (int i = 0; i < worker_param.downpour_table_param_size(); ++i) {
     auto type = worker_param.downpour_table_param(i).type();
     auto table_id = worker_param.downpour_table_param(i).table_id();
+    const auto &table_param = worker_param.downpour_table_param(i);
+    if (table_param.push_quant_type() != PUSH_QUANT_NONE &&
+        (type == PS_DENSE_TABLE || type == PS_SPARSE_TABLE)) {
+      auto quant = std::make_unique<PushQuantState>();
+      quant->type = table_param.push_quant_type();
+      quant->sparse_quant_dim = std::min<uint32_t>(
+          table_param.accessor().embedx_dim(),
+          GetTableAccessor(table_id)->GetAccessorInfo().update_dim);
+      for (size_t j = 0; j < _server_channels.size(); ++j) {
+        quant->sparse_residuals.emplace_back(
+            new PushQuantState::SparseResidualShard());
+      }
+      _push_quant_map[table_id] = std::move(quant);
+    }
     if (type == PS_DENSE_TABLE) {
       _push_dense_task_queue_map[table_id] =
           paddle::framework::MakeChannel<DenseAsyncTask *>();
@@ -342,6 +375,14 @@ int32_t BrpcPsClient::Initialize() {
       _push_sparse_task_queue_map[table_id] =
           paddle::framework::MakeChannel<SparseAsyncTask *>();
       _push_sparse_merge_count_map[table_id] = 0;
+      if (FLAGS_pserver_sparse_cache_capacity > 0) {
+        auto *accessor = GetTableAccessor(table_id);
+        _sparse_pull_cache_map[table_id] = std::make_shared<SparsePullCache>(
+            accessor->GetAccessorInfo().select_size / sizeof(float),
+            FLAGS_pserver_sparse_cache_capacity,
+            FLAGS_pserver_sparse_cache_staleness_steps,
+            FLAGS_pserver_sparse_cache_staleness_ms);
+      }
     }
   }
 
@@ -350,6 +391,7 @@ int32_t BrpcPsClient::Initialize() {
   profiler.register_profiler("pserver_client_pull_sparse");
   profiler.register_profiler("pserver_client_pull_sparse_param");
   profiler.register_profiler("pserver_client_pull_sparse_local");
+  profiler.register_profiler("pserver_client_pull_sparse_cache_hit_rate");
   profiler.register_profiler("pserver_client_push_sparse");
   profiler.register_profiler("pserver_client_push_sparse_parse");
   profiler.register_profiler("client_push_sparse_put");
@@ -556,6 +598,8 @@ std::future<int32_t> BrpcPsClient::SendSaveCmd(
 
 std::future<int32_t> BrpcPsClient::Shrink(uint32_t table_id,
                                           const std::string threshold) {
+  // the shrunk keys would otherwise keep their residuals forever
+  ClearPushQuantResidual(table_id);
   return SendCmd(table_id, PS_SHRINK_TABLE, {threshold});
 }
 
@@ -1006,7 +1050,7 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     const float **update_values,
     size_t num,
     void *done) {
-  auto *accessor = GetTableAccessor(table_id);
+  AdvanceSparsePullCache(table_id);
   // 发送RPC请求
   DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
   auto promise = std::make_shared<std::promise<int32_t>>();
@@ -1040,7 +1084,6 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     auto value_ptr = value_ptrs[shard_idx];
 
     size_t kv_size = kvs.size();
-    uint32_t value_size = accessor->GetAccessorInfo().update_size;
 
     // 发送RPC请求
     auto *push_request = closure->request(shard_idx);
@@ -1048,16 +1091,12 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     push_request->set_table_id(table_id);
     push_request->set_client_id(_client_id);
     push_request->add_params((char *)&kv_size, sizeof(uint32_t));  // NOLINT
-    auto *push_data = push_request->mutable_data();
-    push_data->resize(kv_size * (sizeof(uint64_t) + value_size));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
-    push_data_ptr += kv_size * sizeof(uint64_t);
-
-    for (size_t i = 0; i < kv_size; ++i) {
-      memcpy(push_data_ptr, value_ptr[i], value_size);
-      push_data_ptr += value_size;
-    }
+    SerializeSparsePush(table_id,
+                        shard_idx,
+                        kvs.data(),
+                        value_ptr.data(),
+                        kv_size,
+                        push_request);
     PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
     closure->cntl(shard_idx)->set_request_compress_type(
         (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -1086,14 +1125,11 @@ std::future<int32_t> BrpcPsClient::PushDenseRawGradient(
     closure->request(i)->set_cmd_id(PS_PUSH_DENSE_TABLE);
     closure->request(i)->set_table_id(table_id);
     closure->request(i)->set_client_id(_client_id);
-    auto *push_data = closure->request(i)->mutable_data();
-    push_data->clear();
-    push_data->resize(sizeof(uint32_t) + num_per_shard * sizeof(float));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
-    memcpy(push_data_ptr + sizeof(uint32_t),
-           total_send_data + i * num_per_shard,
-           num_per_shard * sizeof(float));
+    SerializeDensePush(table_id,
+                       total_send_data + i * num_per_shard,
+                       num_per_shard,
+                       i * num_per_shard,
+                       closure->request(i));
     // closure->cntl(i)->set_request_compress_type(
     //     (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
     PsService_Stub rpc_stub(GetDenseChannel(i));
@@ -1156,17 +1192,38 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
     }
   }
 
+  // The hot keys are served by the local cache, the rest are pulled and
+  // offered to the cache once they arrive.
+  std::shared_ptr<SparsePullCache> cache;
+  auto cache_itr = _sparse_pull_cache_map.find(table_id);
+  if (cache_itr != _sparse_pull_cache_map.end()) {
+    cache = cache_itr->second;
+  }
+  uint64_t cache_version = cache ? cache->version() : 0;
+  size_t cache_hit_num = 0;
   for (size_t i = 0; i < num; ++i) {
+    if (cache && cache->Get(keys[i], select_values[i])) {
+      ++cache_hit_num;
+      continue;
+    }
     size_t shard_id = get_sparse_shard(shard_num, request_call_num, keys[i]);
     shard_sorted_kvs->at(shard_id).push_back({keys[i], select_values[i]});
   }
+  if (cache && num > 0) {
+    auto *hit_rate = CostProfiler::instance().profiler(
+        "pserver_client_pull_sparse_cache_hit_rate");
+    if (hit_rate != nullptr) {
+      *(hit_rate->recorder) << cache_hit_num * 100 / num;
+    }
+  }
 
   auto *accessor = GetTableAccessor(table_id);
 
   size_t value_size = accessor->GetAccessorInfo().select_size;
 
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
-      request_call_num, [shard_sorted_kvs, value_size](void *done) {
+      request_call_num,
+      [shard_sorted_kvs, value_size, cache, cache_version](void *done) {
         int ret = 0;
         auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
         for (size_t i = 0; i < shard_sorted_kvs->size(); ++i) {
@@ -1197,6 +1254,9 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
                 ret = -1;
                 break;
               }
+              if (cache) {
+                cache->Put(last_key, last_value_data, cache_version);
+              }
             }
           }
         }
@@ -1530,6 +1590,7 @@ std::future<int32_t> BrpcPsClient::PushSparse(size_t table_id,
                                               size_t num) {
   auto push_timer = std::make_shared<CostTimer>("pserver_client_push_sparse");
   CostTimer parse_timer("pserver_client_push_sparse_parse");
+  AdvanceSparsePullCache(table_id);
   int push_sparse_async_num = _push_sparse_task_queue_map[table_id]->Size();
   while (push_sparse_async_num > FLAGS_pserver_max_async_call_num) {
     //    LOG(INFO) << "PushSparse Waiting for async_call_num comsume,
@@ -1590,6 +1651,13 @@ std::future<int32_t> BrpcPsClient::PushSparse(size_t table_id,
   return fut;
 }
 
+void BrpcPsClient::AdvanceSparsePullCache(size_t table_id) {
+  auto itr = _sparse_pull_cache_map.find(table_id);
+  if (itr != _sparse_pull_cache_map.end()) {
+    itr->second->AdvanceVersion();
+  }
+}
+
 void BrpcPsClient::PushSparseTaskConsume() {
   uint64_t merge_size = FLAGS_pserver_push_sparse_merge_limit;
   std::vector<std::shared_ptr<SparseAsyncTask>> task_list;
@@ -1857,22 +1925,17 @@ int BrpcPsClient::PushSparseAsyncShardPush(
   push_request->set_client_id(_client_id);
   push_request->add_params(reinterpret_cast<char *>(&merged_kv_count),
                            sizeof(uint32_t));  // NOLINT
-  auto *push_data = push_request->mutable_data();
-  int update_size = accessor->GetAccessorInfo().update_size;
-  push_data->resize(merged_kv_count * (sizeof(uint64_t) + update_size));
-  char *push_data_ptr = const_cast<char *>(push_data->data());
-  memcpy(push_data_ptr,
-         merged_key_list.data(),
-         merged_kv_count * sizeof(uint64_t));
-  push_data_ptr += merged_kv_count * sizeof(uint64_t);
+  std::vector<const float *> merged_value_ptrs(merged_kv_count);
   for (size_t i = 0; i < merged_kv_count; ++i) {
-    const char *task_data_ptr = merged_value_list[i].data();
-
-    memcpy(push_data_ptr,
-           (float *)(task_data_ptr),  // NOLINT
-           update_size);
-    push_data_ptr += update_size;
+    merged_value_ptrs[i] =
+        reinterpret_cast<const float *>(merged_value_list[i].data());
   }
+  SerializeSparsePush(table_id,
+                      shard_idx,
+                      merged_key_list.data(),
+                      merged_value_ptrs.data(),
+                      merged_kv_count,
+                      push_request);
   PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
   closure->cntl(shard_idx)->set_request_compress_type(
       (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -2051,14 +2114,11 @@ void BrpcPsClient::PushDenseRawGradient(std::shared_ptr<DenseAsyncTask> &task,
     closure->request(i)->set_cmd_id(PS_PUSH_DENSE_TABLE);
     closure->request(i)->set_table_id(task->table_id());
     closure->request(i)->set_client_id(_client_id);
-    auto *push_data = closure->request(i)->mutable_data();
-    push_data->clear();
-    push_data->resize(sizeof(uint32_t) + num_per_shard * sizeof(float));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
-    memcpy(push_data_ptr + sizeof(uint32_t),
-           total_send_data + i * num_per_shard,
-           num_per_shard * sizeof(float));
+    SerializeDensePush(task->table_id(),
+                       total_send_data + i * num_per_shard,
+                       num_per_shard,
+                       i * num_per_shard,
+                       closure->request(i));
     closure->cntl(i)->set_request_compress_type(
         (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
     PsService_Stub rpc_stub(GetDenseChannel(i));
@@ -2067,5 +2127,108 @@ void BrpcPsClient::PushDenseRawGradient(std::shared_ptr<DenseAsyncTask> &task,
   }
 }
 
+void BrpcPsClient::SerializeSparsePush(uint32_t table_id,
+                                       int shard_idx,
+                                       const uint64_t *keys,
+                                       const float *const *values,
+                                       uint32_t num,
+                                       PsRequestMessage *request) {
+  auto *accessor = GetTableAccessor(table_id);
+  size_t update_dim = accessor->GetAccessorInfo().update_dim;
+  size_t update_size = accessor->GetAccessorInfo().update_size;
+  auto quant_itr = _push_quant_map.find(table_id);
+  auto *quant =
+      quant_itr == _push_quant_map.end() ? nullptr : quant_itr->second.get();
+  size_t value_bytes = update_size;
+  if (quant != nullptr) {
+    value_bytes = SparsePushQuantBytes(
+        quant->type, update_dim, quant->sparse_quant_dim);
+  }
+
+  auto *push_data = request->mutable_data();
+  push_data->resize(num * (sizeof(uint64_t) + value_bytes));
+  char *push_data_ptr = const_cast<char *>(push_data->data());
+  memcpy(push_data_ptr, keys, num * sizeof(uint64_t));
+  push_data_ptr += num * sizeof(uint64_t);
+  if (quant == nullptr) {
+    for (size_t i = 0; i < num; ++i) {
+      memcpy(push_data_ptr, values[i], update_size);
+      push_data_ptr += update_size;
+    }
+    return;
+  }
+
+  int32_t quant_type = quant->type;
+  request->add_params(reinterpret_cast<char *>(&quant_type), sizeof(int32_t));
+  request->add_params(reinterpret_cast<char *>(&quant->sparse_quant_dim),
+                      sizeof(uint32_t));
+  auto &residual_shard = *quant->sparse_residuals[shard_idx];
+  std::lock_guard<std::mutex> lock(residual_shard.mutex);
+  size_t capacity = std::max(FLAGS_pserver_push_quant_residual_capacity, 0);
+  if (residual_shard.residuals.size() + num > capacity) {
+    // losing the residuals only delays their error feedback, so they are
+    // dropped as a whole instead of tracking their recency
+    VLOG(1) << "drop " << residual_shard.residuals.size()
+            << " push quant residuals of table " << table_id << " shard "
+            << shard_idx;
+    residual_shard.residuals.clear();
+  }
+  for (size_t i = 0; i < num; ++i) {
+    auto &residual = residual_shard.residuals[keys[i]];
+    residual.resize(quant->sparse_quant_dim, 0);
+    SparsePushQuant(quant->type,
+                    values[i],
+                    update_dim,
+                    quant->sparse_quant_dim,
+                    residual.data(),
+                    push_data_ptr);
+    push_data_ptr += value_bytes;
+  }
+}
+
+void BrpcPsClient::ClearPushQuantResidual(uint32_t table_id) {
+  auto quant_itr = _push_quant_map.find(table_id);
+  if (quant_itr == _push_quant_map.end()) {
+    return;
+  }
+  for (auto &residual_shard : quant_itr->second->sparse_residuals) {
+    std::lock_guard<std::mutex> lock(residual_shard->mutex);
+    residual_shard->residuals.clear();
+  }
+}
+
+void BrpcPsClient::SerializeDensePush(uint32_t table_id,
+                                      const float *values,
+                                      uint32_t num,
+                                      size_t offset,
+                                      PsRequestMessage *request) {
+  auto *push_data = request->mutable_data();
+  push_data->clear();
+  auto quant_itr = _push_quant_map.find(table_id);
+  if (quant_itr == _push_quant_map.end()) {
+    push_data->resize(sizeof(uint32_t) + num * sizeof(float));
+    char *push_data_ptr = const_cast<char *>(push_data->data());
+    memcpy(push_data_ptr, &num, sizeof(uint32_t));
+    memcpy(push_data_ptr + sizeof(uint32_t), values, num * sizeof(float));
+    return;
+  }
+
+  auto *quant = quant_itr->second.get();
+  int32_t quant_type = quant->type;
+  request->add_params(reinterpret_cast<char *>(&quant_type), sizeof(int32_t));
+  push_data->resize(sizeof(uint32_t) + DensePushQuantBytes(quant->type, num));
+  char *push_data_ptr = const_cast<char *>(push_data->data());
+  memcpy(push_data_ptr, &num, sizeof(uint32_t));
+  std::lock_guard<std::mutex> lock(quant->dense_mutex);
+  if (quant->dense_residual.size() < offset + num) {
+    quant->dense_residual.resize(offset + num, 0);
+  }
+  DensePushQuant(quant->type,
+                 values,
+                 num,
+                 quant->dense_residual.data() + offset,
+                 push_data_ptr + sizeof(uint32_t));
+}
+
 }  // namespace distributed
 }  // namespace paddle
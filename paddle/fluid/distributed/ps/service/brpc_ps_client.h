@@ -17,7 +17,9 @@
 #include <ThreadPool.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "brpc/channel.h"
@@ -26,6 +28,7 @@
 #include "paddle/fluid/distributed/ps/service/brpc_utils.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/ps/service/sparse_pull_cache.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
@@ -360,6 +363,44 @@ class BrpcPsClient : public PSClient {
   std::unordered_map<uint32_t, paddle::framework::Channel<SparseAsyncTask *>>
       _push_sparse_task_queue_map;
   std::unordered_map<uint32_t, uint32_t> _push_sparse_merge_count_map;
+  // quantization of the pushed gradients by table, see push_quant.h
+  struct PushQuantState {
+    struct SparseResidualShard {
+      std::mutex mutex;
+      std::unordered_map<uint64_t, std::vector<float>> residuals;
+    };
+    PushQuantType type = PUSH_QUANT_NONE;
+    uint32_t sparse_quant_dim = 0;
+    // error feedback of the sparse keys, by server, bounded by
+    // pserver_push_quant_residual_capacity keys
+    std::vector<std::unique_ptr<SparseResidualShard>> sparse_residuals;
+    std::mutex dense_mutex;
+    std::vector<float> dense_residual;
+  };
+  std::unordered_map<uint32_t, std::unique_ptr<PushQuantState>>
+      _push_quant_map;
+  // Fills the data of a sparse push request with keys and values, which
+  // are quantized if the table sets push_quant_type.
+  void SerializeSparsePush(uint32_t table_id,
+                           int shard_idx,
+                           const uint64_t *keys,
+                           const float *const *values,
+                           uint32_t num,
+                           PsRequestMessage *request);
+  // Drops the sparse residuals of the table, e.g. when it is shrunk.
+  void ClearPushQuantResidual(uint32_t table_id);
+  // The same for the num values of a dense push request, which start at
+  // offset of the whole dense table.
+  void SerializeDensePush(uint32_t table_id,
+                          const float *values,
+                          uint32_t num,
+                          size_t offset,
+                          PsRequestMessage *request);
+
+  // worker-local caches of PullSparse, see pserver_sparse_cache_capacity
+  std::unordered_map<uint32_t, std::shared_ptr<SparsePullCache>>
+      _sparse_pull_cache_map;
+  void AdvanceSparsePullCache(size_t table_id);
 
   std::thread _print_thread;
 
@@ -389,6 +389,11 @@ int32_t BrpcPsService::PushDense(Table *table,
   table_context.push_context.values =
       (const float *)(request.data().data() + sizeof(uint32_t));
   table_context.num = num;
+  // The values are quantized, see push_quant.h.
+  if (request.params_size() >= 1) {
+    table_context.push_context.quant_type =
+        *(reinterpret_cast<const int32_t *>(request.params(0).c_str()));
+  }
   // const float *values = (const float *)(request.data().data() +
   // sizeof(uint32_t));
   if (table->Push(table_context) != 0) {
@@ -582,6 +587,13 @@ int32_t BrpcPsService::PushSparse(Table *table,
   table_context.push_context.values =
       (const float *)(push_data.data() + sizeof(uint64_t) * num);
   table_context.num = num;
+  // The values are quantized, see push_quant.h.
+  if (request.params_size() >= 3) {
+    table_context.push_context.quant_type =
+        *(reinterpret_cast<const int32_t *>(request.params(1).c_str()));
+    table_context.push_context.quant_dim =
+        *(reinterpret_cast<const uint32_t *>(request.params(2).c_str()));
+  }
   // const uint64_t *keys = (const uint64_t *)push_data.data();
   // const float *values = (const float *)(push_data.data() + sizeof(uint64_t) *
   // num);
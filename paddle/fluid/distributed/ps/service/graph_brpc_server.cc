@@ -197,6 +197,7 @@ int32_t GraphBrpcService::Initialize() {
   _service_handler_map[PS_STOP_SERVER] = &GraphBrpcService::StopServer;
   _service_handler_map[PS_LOAD_ONE_TABLE] = &GraphBrpcService::LoadOneTable;
   _service_handler_map[PS_LOAD_ALL_TABLE] = &GraphBrpcService::LoadAllTable;
+  _service_handler_map[PS_SAVE_ONE_TABLE] = &GraphBrpcService::SaveOneTable;
 
   _service_handler_map[PS_PRINT_TABLE_STAT] = &GraphBrpcService::PrintTableStat;
   _service_handler_map[PS_BARRIER] = &GraphBrpcService::Barrier;
@@ -340,6 +341,25 @@ int32_t GraphBrpcService::LoadAllTable(Table *table,
   return 0;
 }
 
+int32_t GraphBrpcService::SaveOneTable(Table *table,
+                                       const PsRequestMessage &request,
+                                       PsResponseMessage &response,
+                                       brpc::Controller *cntl) {
+  CHECK_TABLE_EXIST(table, request, response)
+  if (request.params_size() < 2) {
+    set_response_code(
+        response,
+        -1,
+        "PsRequestMessage.datas is requeired at least 2 for path & converter");
+    return -1;
+  }
+  if (table->Save(request.params(0), request.params(1)) != 0) {
+    set_response_code(response, -1, "table save failed");
+    return -1;
+  }
+  return 0;
+}
+
 int32_t GraphBrpcService::StopServer(Table *table,
                                      const PsRequestMessage &request,
                                      PsResponseMessage &response,
@@ -123,6 +123,10 @@ class GraphBrpcService : public PsBaseService {
                        const PsRequestMessage &request,
                        PsResponseMessage &response,  // NOLINT
                        brpc::Controller *cntl);
+  int32_t SaveOneTable(Table *table,
+                       const PsRequestMessage &request,
+                       PsResponseMessage &response,  // NOLINT
+                       brpc::Controller *cntl);
   int32_t StopServer(Table *table,
                      const PsRequestMessage &request,
                      PsResponseMessage &response,  // NOLINT
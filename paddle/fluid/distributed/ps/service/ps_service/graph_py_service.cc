@@ -293,6 +293,21 @@ void GraphPyClient::load_edge_file(std::string name,
   // }
 }
 
+void GraphPyClient::save_csr(std::string name, std::string dir) {
+  // 'c' means the csr shards of the edge type
+  if (edge_to_id.find(name) != edge_to_id.end()) {
+    auto status = get_ps_client()->Save(0, dir, "c" + name);
+    status.wait();
+  }
+}
+
+void GraphPyClient::load_csr(std::string name, std::string dir) {
+  if (edge_to_id.find(name) != edge_to_id.end()) {
+    auto status = get_ps_client()->Load(0, dir, "c" + name);
+    status.wait();
+  }
+}
+
 void GraphPyClient::clear_nodes(std::string name) {
   if (edge_to_id.find(name) != edge_to_id.end()) {
     int idx = edge_to_id[name];
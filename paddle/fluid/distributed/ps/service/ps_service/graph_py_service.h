@@ -49,6 +49,8 @@ class GraphPyService {
   std::vector<std::string> server_list, port_list, host_sign_list;
   int server_size, shard_num;
   int num_node_types;
+  bool build_csr = false;
+  std::string sample_type = "random";
   std::unordered_map<std::string, int> edge_to_id, feature_to_id;
   std::vector<std::string> id_to_feature, id_to_edge;
   std::vector<std::unordered_map<std::string, int>> table_feat_mapping;
@@ -59,6 +61,12 @@ class GraphPyService {
  public:
   int get_shard_num() { return shard_num; }
   void set_shard_num(int shard_num) { this->shard_num = shard_num; }
+  // see GraphParameter.build_csr, set it before start_server
+  void set_build_csr(bool build_csr) { this->build_csr = build_csr; }
+  // see GraphParameter.sample_type, set it before start_server
+  void set_sample_type(std::string sample_type) {
+    this->sample_type = sample_type;
+  }
   void GetDownpourSparseTableProto(
       ::paddle::distributed::TableParameter* sparse_table_proto) {
     sparse_table_proto->set_table_id(0);
@@ -81,6 +89,8 @@ class GraphPyService {
 
     graph_proto->set_table_name("cpu_graph_table");
     graph_proto->set_use_cache(false);
+    graph_proto->set_build_csr(build_csr);
+    graph_proto->set_sample_type(sample_type);
     for (size_t i = 0; i < id_to_edge.size(); i++)
       graph_proto->add_edge_types(id_to_edge[i]);
     for (size_t i = 0; i < id_to_feature.size(); i++) {
@@ -175,6 +185,10 @@ class GraphPyClient : public GraphPyService {
   void StopServer();
   void FinalizeWorker();
   void load_edge_file(std::string name, std::string filepath, bool reverse);
+  // Saves the csr shards of edge type name on every server to its local
+  // dir, and maps them back, see GraphTable::save_csr.
+  void save_csr(std::string name, std::string dir);
+  void load_csr(std::string name, std::string dir);
   void load_node_file(std::string name, std::string filepath);
   void clear_nodes(std::string name);
   void add_graph_node(std::string name,
@@ -0,0 +1,159 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/sparse_pull_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+uint64_t MixHash(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+}  // namespace
+
+SparsePullCache::FrequencySketch::FrequencySketch(size_t capacity) {
+  size_t width = 16;
+  while (width < capacity) {
+    width <<= 1;
+  }
+  _table.assign(width * kDepth, 0);
+  _mask = width - 1;
+  _sample_size = std::max<size_t>(capacity, 1) * 10;
+}
+
+size_t SparsePullCache::FrequencySketch::Index(uint64_t key, int row) const {
+  static const uint64_t kSeeds[kDepth] = {0x97cb3127a5f2b5e1ULL,
+                                          0x5ed4b7a3c1f1d8a9ULL,
+                                          0x3c6ef372fe94f82bULL,
+                                          0xa54ff53a5f1d36f1ULL};
+  return row * (_mask + 1) + (MixHash(key ^ kSeeds[row]) & _mask);
+}
+
+void SparsePullCache::FrequencySketch::Increment(uint64_t key) {
+  for (int row = 0; row < kDepth; ++row) {
+    auto &counter = _table[Index(key, row)];
+    if (counter < 15) ++counter;
+  }
+  if (++_additions >= _sample_size) {
+    for (auto &counter : _table) {
+      counter >>= 1;
+    }
+    _additions /= 2;
+  }
+}
+
+uint32_t SparsePullCache::FrequencySketch::Frequency(uint64_t key) const {
+  uint32_t freq = 15;
+  for (int row = 0; row < kDepth; ++row) {
+    freq = std::min<uint32_t>(freq, _table[Index(key, row)]);
+  }
+  return freq;
+}
+
+SparsePullCache::SparsePullCache(size_t value_dim,
+                                 size_t capacity,
+                                 int max_staleness_steps,
+                                 int max_staleness_ms,
+                                 size_t shard_num)
+    : _value_dim(value_dim),
+      _max_staleness_steps(max_staleness_steps),
+      _max_staleness_ms(max_staleness_ms) {
+  shard_num = std::max<size_t>(shard_num, 1);
+  _shard_capacity = std::max<size_t>(capacity / shard_num, 1);
+  _shards.reserve(shard_num);
+  for (size_t i = 0; i < shard_num; ++i) {
+    _shards.emplace_back(new Shard(_shard_capacity));
+  }
+}
+
+bool SparsePullCache::IsFresh(const Entry &entry, int64_t now_ms) const {
+  uint64_t lag = version() - entry.version;
+  if (lag > static_cast<uint64_t>(std::max(_max_staleness_steps, 0))) {
+    return false;
+  }
+  return _max_staleness_ms <= 0 || now_ms - entry.fill_ms <= _max_staleness_ms;
+}
+
+bool SparsePullCache::Get(uint64_t key, float *value) {
+  auto &shard = GetShard(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.sketch.Increment(key);
+  auto itr = shard.entries.find(key);
+  if (itr == shard.entries.end() || !IsFresh(itr->second, NowMs())) {
+    return false;
+  }
+  memcpy(value, itr->second.value.data(), _value_dim * sizeof(float));
+  shard.lru.splice(shard.lru.begin(), shard.lru, itr->second.lru_itr);
+  return true;
+}
+
+void SparsePullCache::Put(uint64_t key,
+                          const float *value,
+                          uint64_t version) {
+  auto &shard = GetShard(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto itr = shard.entries.find(key);
+  if (itr != shard.entries.end() && itr->second.version > version) {
+    return;
+  }
+  if (itr == shard.entries.end()) {
+    if (shard.entries.size() >= _shard_capacity) {
+      uint64_t victim = shard.lru.back();
+      if (shard.sketch.Frequency(key) <= shard.sketch.Frequency(victim)) {
+        return;
+      }
+      shard.entries.erase(victim);
+      shard.lru.pop_back();
+    }
+    shard.lru.push_front(key);
+    itr = shard.entries.emplace(key, Entry()).first;
+    itr->second.value.resize(_value_dim);
+    itr->second.lru_itr = shard.lru.begin();
+  } else {
+    shard.lru.splice(shard.lru.begin(), shard.lru, itr->second.lru_itr);
+  }
+  memcpy(itr->second.value.data(), value, _value_dim * sizeof(float));
+  itr->second.version = version;
+  itr->second.fill_ms = NowMs();
+}
+
+size_t SparsePullCache::Size() {
+  size_t size = 0;
+  for (auto &shard : _shards) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    size += shard->entries.size();
+  }
+  return size;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,110 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+/*
+ * Worker-local cache of the values pulled from a sparse table, so the few
+ * hot feasigns do not go to the servers on every pull.
+ *
+ * A cached value is served while it lags at most max_staleness_steps pushes
+ * of the table (see AdvanceVersion) and, if max_staleness_ms > 0, at most
+ * max_staleness_ms milliseconds. The keys are split into shards with their
+ * own lock. Every shard admits a new key by TinyLFU: when it is full, the key
+ * replaces the least recently used one only if it was looked up more often,
+ * as estimated by a count-min sketch of the recent lookups.
+ */
+class SparsePullCache {
+ public:
+  SparsePullCache(size_t value_dim,
+                  size_t capacity,
+                  int max_staleness_steps,
+                  int max_staleness_ms,
+                  size_t shard_num = 16);
+
+  // Copies the value of key into value and returns true if it is cached and
+  // fresh. The lookup counts toward the frequency of key either way.
+  bool Get(uint64_t key, float *value);
+
+  // Offers a value pulled from the servers, version is the version() seen
+  // before the pull was sent.
+  void Put(uint64_t key, const float *value, uint64_t version);
+
+  // Called for every push to the table.
+  void AdvanceVersion() { _version.fetch_add(1, std::memory_order_relaxed); }
+  uint64_t version() const { return _version.load(std::memory_order_relaxed); }
+
+  size_t Size();
+
+  size_t value_dim() const { return _value_dim; }
+
+ private:
+  // Count-min sketch of 4-bit counters, which are halved every
+  // _sample_size increments so the frequency follows recent lookups.
+  class FrequencySketch {
+   public:
+    explicit FrequencySketch(size_t capacity);
+    void Increment(uint64_t key);
+    uint32_t Frequency(uint64_t key) const;
+
+   private:
+    static constexpr int kDepth = 4;
+    size_t Index(uint64_t key, int row) const;
+
+    std::vector<uint8_t> _table;
+    size_t _mask;
+    size_t _sample_size;
+    size_t _additions = 0;
+  };
+
+  struct Entry {
+    std::vector<float> value;
+    uint64_t version;
+    int64_t fill_ms;
+    std::list<uint64_t>::iterator lru_itr;
+  };
+
+  struct Shard {
+    explicit Shard(size_t capacity) : sketch(capacity) {}
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Entry> entries;
+    // The most recently used key is at the front.
+    std::list<uint64_t> lru;
+    FrequencySketch sketch;
+  };
+
+  Shard &GetShard(uint64_t key) { return *_shards[key % _shards.size()]; }
+  bool IsFresh(const Entry &entry, int64_t now_ms) const;
+
+  size_t _value_dim;
+  size_t _shard_capacity;
+  int _max_staleness_steps;
+  int _max_staleness_ms;
+  std::atomic<uint64_t> _version{0};
+  std::vector<std::unique_ptr<Shard>> _shards;
+};
+
+}  // namespace distributed
+}  // namespace paddle
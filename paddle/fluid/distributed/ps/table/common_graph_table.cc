@@ -15,6 +15,7 @@
 #include "paddle/fluid/distributed/ps/table/common_graph_table.h"
 
 #include <time.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <chrono>
@@ -1214,6 +1215,16 @@ GraphTable::~GraphTable() {
 int32_t GraphTable::Load(const std::string &path, const std::string &param) {
   bool load_edge = (param[0] == 'e');
   bool load_node = (param[0] == 'n');
+  if (param[0] == 'c') {
+    // 'c' means load the csr shards of save_csr
+    auto it = edge_to_id.find(param.substr(1));
+    if (it == edge_to_id.end()) {
+      VLOG(0) << "Fail to load csr, edge_type[" << param.substr(1)
+              << "] is not defined";
+      return -1;
+    }
+    return load_csr(it->second, path);
+  }
   if (load_edge) {
     bool reverse_edge = (param[1] == '<');
     std::string edge_type = param.substr(2);
@@ -1236,6 +1247,20 @@ int32_t GraphTable::Load(const std::string &path, const std::string &param) {
   return 0;
 }
 
+int32_t GraphTable::Save(const std::string &path,
+                         const std::string &converter) {
+  if (converter.empty() || converter[0] != 'c') {
+    return 0;
+  }
+  auto it = edge_to_id.find(converter.substr(1));
+  if (it == edge_to_id.end()) {
+    VLOG(0) << "Fail to save csr, edge_type[" << converter.substr(1)
+            << "] is not defined";
+    return -1;
+  }
+  return save_csr(it->second, path);
+}
+
 std::string GraphTable::get_inverse_etype(std::string &etype) {
   auto etype_split = paddle::string::split_string<std::string>(etype, "2");
   std::string res;
@@ -1706,12 +1731,22 @@ int32_t GraphTable::load_nodes(const std::string &path, std::string node_type) {
 }
 
 int32_t GraphTable::build_sampler(int idx, std::string sample_type) {
-  for (auto &shard : edge_shards[idx]) {
-    auto bucket = shard->get_bucket();
-    for (size_t i = 0; i < bucket.size(); i++) {
-      bucket[i]->build_sampler(sample_type);
-    }
+  auto &shards = edge_shards[idx];
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < shards.size(); ++i) {
+    uint32_t pool = get_thread_pool_index_by_shard_index(shard_start + i);
+    tasks.push_back(_shards_task_pool[pool]->enqueue([&, i, this]() -> int {
+      for (auto *node : shards[i]->get_bucket()) {
+        node->build_sampler(sample_type);
+      }
+      if (static_cast<size_t>(idx) < csr_shards.size() &&
+          csr_shards[idx][i] != nullptr) {
+        csr_shards[idx][i]->build_alias(sample_type == "alias");
+      }
+      return 0;
+    }));
   }
+  for (size_t i = 0; i < tasks.size(); i++) tasks[i].get();
   return 0;
 }
 
@@ -1835,20 +1870,17 @@ int32_t GraphTable::load_edges(const std::string &path,
   }
 #endif
 
+  if (build_csr_on_load) {
+    build_csr(idx, false);
+  }
   if (!build_sampler_on_cpu) {
     // To reduce memory overhead, CPU samplers won't be created in gpugraph.
     // In order not to affect the sampler function of other scenario,
     // this optimization is only performed in load_edges function.
     VLOG(0) << "run in gpugraph mode!";
   } else {
-    std::string sample_type = "random";
-    VLOG(0) << "build sampler ... ";
-    for (auto &shard : edge_shards[idx]) {
-      auto bucket = shard->get_bucket();
-      for (size_t i = 0; i < bucket.size(); i++) {
-        bucket[i]->build_sampler(sample_type);
-      }
-    }
+    VLOG(0) << "build " << edge_sample_type << " sampler ... ";
+    build_sampler(idx, edge_sample_type);
   }
 
   return 0;
@@ -1899,6 +1931,84 @@ uint32_t GraphTable::get_thread_pool_index_by_shard_index(
   return shard_index % shard_num_per_server % task_pool_size_;
 }
 
+GraphCsrShard *GraphTable::find_csr_shard(int idx, uint64_t id) {
+  size_t shard_id = id % shard_num;
+  if (static_cast<size_t>(idx) >= csr_shards.size() || shard_id >= shard_end ||
+      shard_id < shard_start) {
+    return nullptr;
+  }
+  return csr_shards[idx][shard_id - shard_start].get();
+}
+
+int32_t GraphTable::build_csr(int idx, bool release_edges) {
+  auto &shards = edge_shards[idx];
+  std::vector<std::future<int>> tasks;
+  // Each shard is converted on the thread which samples it.
+  for (size_t i = 0; i < shards.size(); ++i) {
+    uint32_t pool = get_thread_pool_index_by_shard_index(shard_start + i);
+    tasks.push_back(_shards_task_pool[pool]->enqueue([&, i, this]() -> int {
+      csr_shards[idx][i] = GraphCsrShard::build(shards[i]->get_bucket());
+      if (release_edges) {
+        delete shards[i];
+        shards[i] = new GraphShard();
+      }
+      return 0;
+    }));
+  }
+  size_t edge_num = 0;
+  for (size_t i = 0; i < tasks.size(); i++) {
+    tasks[i].get();
+    edge_num += csr_shards[idx][i]->edge_num();
+  }
+  VLOG(0) << "build csr of edge type " << idx << ", " << edge_num
+          << " edges in " << shards.size() << " shards";
+  return 0;
+}
+
+int32_t GraphTable::save_csr(int idx, const std::string &dir) {
+  paddle::framework::localfs_mkdir(dir);
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < csr_shards[idx].size(); ++i) {
+    if (csr_shards[idx][i] == nullptr) {
+      continue;
+    }
+    tasks.push_back(load_node_edge_task_pool->enqueue([&, i, this]() -> int {
+      csr_shards[idx][i]->save(
+          paddle::string::format_string("%s/part-%05d.csr",
+                                        dir.c_str(),
+                                        static_cast<int>(shard_start + i)));
+      return 0;
+    }));
+  }
+  for (size_t i = 0; i < tasks.size(); i++) tasks[i].get();
+  return 0;
+}
+
+int32_t GraphTable::load_csr(int idx, const std::string &dir) {
+  auto &shards = csr_shards[idx];
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < shards.size(); ++i) {
+    uint32_t pool = get_thread_pool_index_by_shard_index(shard_start + i);
+    tasks.push_back(_shards_task_pool[pool]->enqueue([&, i, this]() -> int {
+      std::string path =
+          paddle::string::format_string("%s/part-%05d.csr",
+                                        dir.c_str(),
+                                        static_cast<int>(shard_start + i));
+      if (access(path.c_str(), F_OK) != 0) {
+        shards[i] = nullptr;
+        return 0;
+      }
+      shards[i] = GraphCsrShard::load(path);
+      return 1;
+    }));
+  }
+  int loaded = 0;
+  for (size_t i = 0; i < tasks.size(); i++) loaded += tasks[i].get();
+  VLOG(0) << "load csr of edge type " << idx << " from " << dir << ", "
+          << loaded << "/" << shards.size() << " shards";
+  return 0;
+}
+
 int32_t GraphTable::clear_nodes(GraphTableType table_type, int idx) {
   auto &search_shards = table_type == GraphTableType::EDGE_TABLE
                             ? edge_shards[idx]
@@ -2021,10 +2131,14 @@ int32_t GraphTable::random_sample_neighbors(
           index++;
         } else {
           node_id = id_list[i][k].node_key;
-          Node *node = find_node(GraphTableType::EDGE_TABLE, idx, node_id);
+          GraphCsrShard *csr = find_csr_shard(idx, node_id);
+          int64_t pos = csr == nullptr ? -1 : csr->find(node_id);
+          Node *node =
+              pos >= 0 ? nullptr
+                       : find_node(GraphTableType::EDGE_TABLE, idx, node_id);
           int idy = seq_id[i][k];
           int &actual_size = actual_sizes[idy];
-          if (node == nullptr) {
+          if (node == nullptr && pos < 0) {
 #ifdef PADDLE_WITH_HETERPS
             if (search_level == 2) {
               VLOG(2) << "enter sample from ssd for node_id " << node_id;
@@ -2042,7 +2156,9 @@ int32_t GraphTable::random_sample_neighbors(
             continue;
           }
           std::shared_ptr<char> &buffer = buffers[idy];
-          std::vector<int> res = node->sample_k(sample_size, rng);
+          std::vector<int> res = pos >= 0
+                                     ? csr->sample_k(pos, sample_size, rng)
+                                     : node->sample_k(sample_size, rng);
           actual_size =
               res.size() * (need_weight ? (Node::id_size + Node::weight_size)
                                         : Node::id_size);
@@ -2058,11 +2174,13 @@ int32_t GraphTable::random_sample_neighbors(
             buffer.reset(buffer_addr, char_del);
           }
           for (int &x : res) {
-            id = node->get_neighbor_id(x);
+            id = pos >= 0 ? csr->get_neighbor_id(pos, x)
+                          : node->get_neighbor_id(x);
             memcpy(buffer_addr + offset, &id, Node::id_size);
             offset += Node::id_size;
             if (need_weight) {
-              weight = node->get_neighbor_weight(x);
+              weight = pos >= 0 ? csr->get_neighbor_weight(pos, x)
+                                : node->get_neighbor_weight(x);
               memcpy(buffer_addr + offset, &weight, Node::weight_size);
               offset += Node::weight_size;
             }
@@ -2542,6 +2660,16 @@ void GraphTable::load_node_weight(int type_id, int idx, std::string path) {
 int32_t GraphTable::Initialize(const GraphParameter &graph) {
   task_pool_size_ = graph.task_pool_size();
   build_sampler_on_cpu = graph.build_sampler_on_cpu();
+  build_csr_on_load = graph.build_csr();
+  edge_sample_type = graph.sample_type();
+  PADDLE_ENFORCE_EQ(
+      edge_sample_type == "random" || edge_sample_type == "weighted" ||
+          edge_sample_type == "alias",
+      true,
+      paddle::platform::errors::InvalidArgument(
+          "GraphParameter.sample_type should be random, weighted or alias, "
+          "but got %s.",
+          edge_sample_type));
 
 #ifdef PADDLE_WITH_HETERPS
   _db = NULL;
@@ -2640,6 +2768,9 @@ int32_t GraphTable::Initialize(const GraphParameter &graph) {
       edge_shards[k].push_back(new GraphShard());
     }
   }
+  csr_shards.resize(
+      id_to_edge.size(),
+      std::vector<std::shared_ptr<GraphCsrShard>>(shard_num_per_server));
   node_weight[1].resize(id_to_feature.size());
   feature_shards.resize(id_to_feature.size());
   for (size_t k = 0; k < feature_shards.size(); k++) {
@@ -41,6 +41,7 @@
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
 #include "paddle/fluid/distributed/ps/table/graph/class_macro.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
 #include "paddle/fluid/string/string_helper.h"
 #include "paddle/phi/core/utils/rw_lock.h"
@@ -632,9 +633,8 @@ class GraphTable : public Table {
   virtual int32_t Flush() { return 0; }
   virtual int32_t Shrink(const std::string &param) { return 0; }
   // 指定保存路径
-  virtual int32_t Save(const std::string &path, const std::string &converter) {
-    return 0;
-  }
+  // converter "c" followed by an edge type saves its csr shards to path.
+  virtual int32_t Save(const std::string &path, const std::string &converter);
   virtual int32_t InitializeShard() { return 0; }
   virtual int32_t SetShard(size_t shard_idx, size_t server_num) {
     _shard_idx = shard_idx;
@@ -740,7 +740,21 @@ class GraphTable : public Table {
   int next_partition;
 #endif
   virtual int32_t add_comm_edge(int idx, uint64_t src_id, uint64_t dst_id);
+  // sample_type is "random" or "weighted", which sample distinct neighbors,
+  // or "alias", which samples neighbors with replacement in proportion to
+  // their weights.
+  // Each shard is rebuilt on the thread which samples it, so it may run
+  // while random_sample_neighbors is sampling the edge type.
   virtual int32_t build_sampler(int idx, std::string sample_type = "random");
+  // Converts the edges of edge type idx to GraphCsrShard, which
+  // random_sample_neighbors samples first, and releases the edges of the
+  // GraphShard if release_edges.
+  int32_t build_csr(int idx, bool release_edges);
+  // Writes the csr shards of edge type idx to files in the local dir.
+  int32_t save_csr(int idx, const std::string &dir);
+  // Maps the csr shards of edge type idx from the files of save_csr.
+  int32_t load_csr(int idx, const std::string &dir);
+  GraphCsrShard *find_csr_shard(int idx, uint64_t id);
   void set_slot_feature_separator(const std::string &ch);
   void set_feature_separator(const std::string &ch);
 
@@ -752,6 +766,7 @@ class GraphTable : public Table {
   std::unordered_map<int, int> type_to_index_;
 
   std::vector<std::vector<GraphShard *>> edge_shards, feature_shards;
+  std::vector<std::vector<std::shared_ptr<GraphCsrShard>>> csr_shards;
   size_t shard_start, shard_end, server_num, shard_num_per_server, shard_num;
   int task_pool_size_ = 64;
   int load_thread_num = 160;
@@ -781,6 +796,8 @@ class GraphTable : public Table {
   int cache_ttl;
   mutable std::mutex mutex_;
   bool build_sampler_on_cpu;
+  bool build_csr_on_load = false;
+  std::string edge_sample_type = "random";
   bool is_load_reverse_edge = false;
   std::shared_ptr<pthread_rwlock_t> rw_lock;
 #ifdef PADDLE_WITH_HETERPS
@@ -15,6 +15,10 @@
 #pragma once
 
 #include <mct/hash-map.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <vector>
 
 #include "gflags/gflags.h"
@@ -27,19 +31,194 @@ static const int CTR_SPARSE_SHARD_BUCKET_NUM_BITS = 6;
 static const size_t CTR_SPARSE_SHARD_BUCKET_NUM =
     static_cast<size_t>(1) << CTR_SPARSE_SHARD_BUCKET_NUM_BITS;
 
+// Slab arena of the float arrays of FixedFeatureValue. Arrays of the same
+// size are carved from 1MB slabs and recycled through a free list linked by
+// their first 8 bytes, so a feasign costs no malloc call and no malloc header.
+// Arrays larger than kMaxSlabValueSize floats are allocated by malloc.
+//
+// Like ChunkAllocator, an arena is NOT thread-safe, it is owned by a
+// SparseTableShard which is only accessed by one thread at a time.
+class FeatureValueArena {
+ public:
+  static constexpr size_t kSlabBytes = 1 << 20;
+  static constexpr size_t kMaxSlabValueSize = 4096;
+
+  FeatureValueArena() {}
+  FeatureValueArena(const FeatureValueArena&) = delete;
+  FeatureValueArena& operator=(const FeatureValueArena&) = delete;
+  ~FeatureValueArena() {
+    for (auto& size_class : _size_classes) {
+      for (float* slab : size_class.slabs) {
+        free(slab);
+      }
+    }
+  }
+
+  float* acquire(size_t size) {
+    if (size > kMaxSlabValueSize) {
+      return reinterpret_cast<float*>(malloc(size * sizeof(float)));
+    }
+    size_t index = class_index(size);
+    if (index >= _size_classes.size()) {
+      _size_classes.resize(index + 1);
+    }
+    SizeClass& size_class = _size_classes[index];
+    _live_bytes += class_size(index) * sizeof(float);
+    if (size_class.free_list != nullptr) {
+      float* ptr = size_class.free_list;
+      size_class.free_list = *reinterpret_cast<float**>(ptr);
+      return ptr;
+    }
+    size_t block_size = class_size(index);
+    if (size_class.slab_remain < block_size) {
+      size_class.slabs.push_back(
+          reinterpret_cast<float*>(malloc(slab_size(block_size))));
+      size_class.slab_cursor = size_class.slabs.back();
+      size_class.slab_remain = slab_size(block_size) / sizeof(float);
+      _slab_bytes += slab_size(block_size);
+    }
+    float* ptr = size_class.slab_cursor;
+    size_class.slab_cursor += block_size;
+    size_class.slab_remain -= block_size;
+    return ptr;
+  }
+
+  void release(float* ptr, size_t size) {
+    if (size > kMaxSlabValueSize) {
+      free(ptr);
+      return;
+    }
+    size_t index = class_index(size);
+    SizeClass& size_class = _size_classes[index];
+    _live_bytes -= class_size(index) * sizeof(float);
+    *reinterpret_cast<float**>(ptr) = size_class.free_list;
+    size_class.free_list = ptr;
+  }
+
+  // bytes of all the slabs, including the free blocks
+  size_t slab_bytes() const { return _slab_bytes; }
+  // bytes of the blocks in use
+  size_t live_bytes() const { return _live_bytes; }
+
+ private:
+  struct SizeClass {
+    std::vector<float*> slabs;
+    float* free_list = nullptr;
+    float* slab_cursor = nullptr;
+    size_t slab_remain = 0;  // in floats
+  };
+
+  // blocks hold an even number of floats, so that a free block is able to
+  // store the next pointer and blocks are 8-byte aligned
+  static size_t class_index(size_t size) { return (size + 1) / 2; }
+  static size_t class_size(size_t index) { return index * 2; }
+  static size_t slab_size(size_t block_size) {
+    return std::max(kSlabBytes, block_size * sizeof(float));
+  }
+
+  std::vector<SizeClass> _size_classes;
+  size_t _slab_bytes = 0;
+  size_t _live_bytes = 0;
+};
+
 class FixedFeatureValue {
  public:
   FixedFeatureValue() {}
-  ~FixedFeatureValue() {}
-  float* data() { return _data.data(); }
-  size_t size() { return _data.size(); }
-  void resize(size_t size) { _data.resize(size); }
-  void shrink_to_fit() { _data.shrink_to_fit(); }
+  FixedFeatureValue(const FixedFeatureValue& other) { *this = other; }
+  FixedFeatureValue(FixedFeatureValue&& other)
+      : _data(other._data), _size(other._size), _arena(other._arena) {
+    other._data = nullptr;
+    other._size = 0;
+  }
+  ~FixedFeatureValue() { release_data(_data, _size); }
+
+  FixedFeatureValue& operator=(const FixedFeatureValue& other) {
+    if (this != &other) {
+      resize(other._size);
+      if (_size > 0) {
+        memcpy(_data, other._data, _size * sizeof(float));
+      }
+    }
+    return *this;
+  }
+
+  float* data() { return _data; }
+  size_t size() { return _size; }
+  // Same as std::vector::resize, keeps the leading data and fills the
+  // new tail with zero.
+  void resize(size_t size) {
+    if (size == _size) {
+      return;
+    }
+    float* data = acquire_data(size);
+    size_t keep = std::min(size, _size);
+    if (keep > 0) {
+      memcpy(data, _data, keep * sizeof(float));
+    }
+    if (size > keep) {
+      memset(data + keep, 0, (size - keep) * sizeof(float));
+    }
+    release_data(_data, _size);
+    _data = data;
+    _size = size;
+  }
+  // The storage always fits the size exactly.
+  void shrink_to_fit() {}
+
+  // Move the data into arena, nullptr means malloc.
+  void set_arena(FeatureValueArena* arena) {
+    if (arena == _arena) {
+      return;
+    }
+    float* data = nullptr;
+    if (_size > 0) {
+      data = arena != nullptr ? arena->acquire(_size)
+                              : reinterpret_cast<float*>(
+                                    malloc(_size * sizeof(float)));
+      memcpy(data, _data, _size * sizeof(float));
+    }
+    release_data(_data, _size);
+    _data = data;
+    _arena = arena;
+  }
 
  private:
-  std::vector<float> _data;
+  float* acquire_data(size_t size) {
+    if (size == 0) {
+      return nullptr;
+    }
+    if (_arena != nullptr) {
+      return _arena->acquire(size);
+    }
+    return reinterpret_cast<float*>(malloc(size * sizeof(float)));
+  }
+
+  void release_data(float* data, size_t size) {
+    if (data == nullptr) {
+      return;
+    }
+    if (_arena != nullptr) {
+      _arena->release(data, size);
+    } else {
+      free(data);
+    }
+  }
+
+  float* _data = nullptr;
+  size_t _size = 0;
+  FeatureValueArena* _arena = nullptr;  // not owned
 };
 
+// Values of SparseTableShard are bound to the arena of the shard, only
+// FixedFeatureValue uses the arena for now.
+template <class VALUE>
+inline void BindFeatureValueArena(VALUE* value, FeatureValueArena* arena) {}
+
+inline void BindFeatureValueArena(FixedFeatureValue* value,
+                                  FeatureValueArena* arena) {
+  value->set_arena(arena);
+}
+
 template <class KEY, class VALUE>
 struct alignas(64) SparseTableShard {
  public:
@@ -149,7 +328,9 @@ struct alignas(64) SparseTableShard {
     auto res = _buckets[bucket].insert_with_hash({key, NULL}, hash);
 
     if (res.second) {
-      res.first->second = _alloc.acquire(std::forward<ARGS>(args)...);
+      VALUE* value = _alloc.acquire(std::forward<ARGS>(args)...);
+      BindFeatureValueArena(value, _arena.get());
+      res.first->second = value;
     }
 
     return {{res.first, bucket, _buckets}, res.second};
@@ -184,6 +365,22 @@ struct alignas(64) SparseTableShard {
     quick_erase(it);
     return 1;
   }
+  // Move all the values into a new arena, so that the slabs left with free
+  // blocks after erasing lots of values (e.g. by Shrink) are released.
+  void compact() {
+    std::unique_ptr<FeatureValueArena> arena(new FeatureValueArena());
+    for (auto it = begin(); it != end(); ++it) {
+      BindFeatureValueArena(it.value_ptr(), arena.get());
+    }
+    _arena.swap(arena);
+  }
+  // bytes of the slabs in arena
+  size_t arena_bytes() { return _arena->slab_bytes(); }
+  // bytes of the slabs in arena not used by any value, i.e. the free blocks
+  // and the unused tails of the slabs
+  size_t arena_free_bytes() {
+    return _arena->slab_bytes() - _arena->live_bytes();
+  }
   size_t compute_bucket(size_t hash) {
     if (CTR_SPARSE_SHARD_BUCKET_NUM == 1) {
       return 0;
@@ -195,6 +392,7 @@ struct alignas(64) SparseTableShard {
  private:
   map_type _buckets[CTR_SPARSE_SHARD_BUCKET_NUM];
   ChunkAllocator<VALUE> _alloc;
+  std::unique_ptr<FeatureValueArena> _arena{new FeatureValueArena()};
   std::hash<KEY> _hasher;
 };
 
@@ -0,0 +1,248 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+size_t csr_file_size(uint64_t node_num, uint64_t edge_num, bool has_weight) {
+  return sizeof(GraphCsrFileHeader) +
+         sizeof(uint64_t) * (node_num + node_num + 1 + edge_num) +
+         (has_weight ? sizeof(float) * edge_num : 0);
+}
+}  // namespace
+
+GraphCsrShard::~GraphCsrShard() {
+  if (mapped_) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+}
+
+std::shared_ptr<GraphCsrShard> GraphCsrShard::build(
+    const std::vector<Node *> &nodes) {
+  std::vector<Node *> sorted;
+  sorted.reserve(nodes.size());
+  size_t edge_num = 0;
+  bool has_weight = false;
+  for (auto node : nodes) {
+    size_t degree = node->get_neighbor_size();
+    if (degree == 0) {
+      continue;
+    }
+    sorted.push_back(node);
+    edge_num += degree;
+    for (size_t i = 0; i < degree && !has_weight; i++) {
+      has_weight = node->get_neighbor_weight(i) != 1.;
+    }
+  }
+  std::sort(sorted.begin(), sorted.end(), [](Node *a, Node *b) {
+    return a->get_id() < b->get_id();
+  });
+
+  std::shared_ptr<GraphCsrShard> csr(new GraphCsrShard());
+  size_t size = csr_file_size(sorted.size(), edge_num, has_weight);
+  csr->buffer_.resize((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+  char *data = reinterpret_cast<char *>(csr->buffer_.data());
+  GraphCsrFileHeader header;
+  header.magic = GraphCsrFileHeader::kMagic;
+  header.version = GraphCsrFileHeader::kVersion;
+  header.has_weight = has_weight;
+  header.node_num = sorted.size();
+  header.edge_num = edge_num;
+  memcpy(data, &header, sizeof(header));
+  csr->set_arrays(data, size);
+
+  auto *ids = const_cast<uint64_t *>(csr->ids_);
+  auto *offsets = const_cast<uint64_t *>(csr->offsets_);
+  auto *neighbors = const_cast<uint64_t *>(csr->neighbors_);
+  auto *weights = const_cast<float *>(csr->weights_);
+  uint64_t offset = 0;
+  for (size_t i = 0; i < sorted.size(); i++) {
+    Node *node = sorted[i];
+    ids[i] = node->get_id();
+    offsets[i] = offset;
+    size_t degree = node->get_neighbor_size();
+    for (size_t j = 0; j < degree; j++) {
+      neighbors[offset + j] = node->get_neighbor_id(j);
+      if (has_weight) {
+        weights[offset + j] = node->get_neighbor_weight(j);
+      }
+    }
+    offset += degree;
+  }
+  offsets[sorted.size()] = offset;
+  return csr;
+}
+
+std::shared_ptr<GraphCsrShard> GraphCsrShard::load(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_GE(
+      fd,
+      0,
+      paddle::platform::errors::Unavailable("Failed to open %s.", path));
+  struct stat st;
+  fstat(fd, &st);
+  size_t size = st.st_size;
+  if (size < sizeof(GraphCsrFileHeader)) {
+    close(fd);
+    PADDLE_THROW(paddle::platform::errors::InvalidArgument(
+        "Graph csr file %s is truncated.", path));
+  }
+  void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  PADDLE_ENFORCE_NE(
+      data,
+      MAP_FAILED,
+      paddle::platform::errors::Unavailable("Failed to mmap %s.", path));
+  // neighbors are sampled at random positions
+  madvise(data, size, MADV_RANDOM);
+
+  std::shared_ptr<GraphCsrShard> csr(new GraphCsrShard());
+  csr->mapped_ = true;
+  csr->data_ = static_cast<const char *>(data);
+  csr->size_ = size;
+  GraphCsrFileHeader header;
+  memcpy(&header, data, sizeof(header));
+  PADDLE_ENFORCE_EQ(header.magic == GraphCsrFileHeader::kMagic &&
+                        header.version == GraphCsrFileHeader::kVersion,
+                    true,
+                    paddle::platform::errors::InvalidArgument(
+                        "%s is not a graph csr file of version %d.",
+                        path,
+                        GraphCsrFileHeader::kVersion));
+  PADDLE_ENFORCE_GE(
+      size,
+      csr_file_size(header.node_num, header.edge_num, header.has_weight),
+      paddle::platform::errors::InvalidArgument(
+          "Graph csr file %s is truncated.", path));
+  csr->set_arrays(csr->data_, size);
+  return csr;
+}
+
+void GraphCsrShard::save(const std::string &path) const {
+  FILE *fp = fopen(path.c_str(), "wb");
+  PADDLE_ENFORCE_NOT_NULL(
+      fp,
+      paddle::platform::errors::Unavailable("Failed to open %s to write.",
+                                            path));
+  size_t size = csr_file_size(node_num_, edge_num_, weights_ != nullptr);
+  size_t written = fwrite(data_, 1, size, fp);
+  fclose(fp);
+  PADDLE_ENFORCE_EQ(
+      written,
+      size,
+      paddle::platform::errors::Unavailable("Failed to write %s.", path));
+}
+
+void GraphCsrShard::set_arrays(const char *data, size_t size) {
+  GraphCsrFileHeader header;
+  memcpy(&header, data, sizeof(header));
+  data_ = data;
+  size_ = size;
+  node_num_ = header.node_num;
+  edge_num_ = header.edge_num;
+  ids_ = reinterpret_cast<const uint64_t *>(data + sizeof(header));
+  offsets_ = ids_ + node_num_;
+  neighbors_ = offsets_ + node_num_ + 1;
+  weights_ = header.has_weight
+                 ? reinterpret_cast<const float *>(neighbors_ + edge_num_)
+                 : nullptr;
+}
+
+int64_t GraphCsrShard::find(uint64_t id) const {
+  const uint64_t *it = std::lower_bound(ids_, ids_ + node_num_, id);
+  if (it == ids_ + node_num_ || *it != id) {
+    return -1;
+  }
+  return it - ids_;
+}
+
+void GraphCsrShard::build_alias(bool use_alias) {
+  if (!use_alias) {
+    std::vector<AliasEntry>().swap(alias_);
+    return;
+  }
+  alias_.resize(edge_num_);
+  std::vector<float> ones;
+  for (size_t pos = 0; pos < node_num_; pos++) {
+    int n = degree(pos);
+    const float *weights = weights_ + offsets_[pos];
+    if (weights_ == nullptr) {
+      ones.resize(n, 1);
+      weights = ones.data();
+    }
+    build_alias_table(weights, n, &alias_[offsets_[pos]]);
+  }
+}
+
+std::vector<int> GraphCsrShard::sample_k(
+    int64_t pos, int k, const std::shared_ptr<std::mt19937_64> rng) const {
+  int n = degree(pos);
+  std::vector<int> sample_result;
+  if (!alias_.empty()) {
+    if (n > 0) {
+      sample_result.resize(k);
+      for (int i = 0; i < k; i++) {
+        sample_result[i] = sample_alias(&alias_[offsets_[pos]], n, rng.get());
+      }
+    }
+    return sample_result;
+  }
+  if (k >= n) {
+    sample_result.resize(n);
+    std::iota(sample_result.begin(), sample_result.end(), 0);
+    return sample_result;
+  }
+  if (weights_ == nullptr) {
+    sample_k_distinct(n, k, rng.get(), &sample_result);
+    return sample_result;
+  }
+  // weighted sampling without replacement by Efraimidis and Spirakis, the k
+  // largest keys log(u) / weight
+  const float *weights = weights_ + offsets_[pos];
+  std::vector<std::pair<float, int>> keys(n);
+  std::uniform_real_distribution<float> distrib(0, 1.0);
+  for (int i = 0; i < n; i++) {
+    float u = 1.0 - distrib(*rng);
+    keys[i].first = weights[i] > 0
+                        ? std::log(u) / weights[i]
+                        : -std::numeric_limits<float>::infinity();
+    keys[i].second = i;
+  }
+  std::nth_element(keys.begin(),
+                   keys.begin() + k,
+                   keys.end(),
+                   std::greater<std::pair<float, int>>());
+  for (int i = 0; i < k; i++) {
+    sample_result.push_back(keys[i].second);
+  }
+  return sample_result;
+}
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,100 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
+namespace paddle {
+namespace distributed {
+
+struct GraphCsrFileHeader {
+  static constexpr uint64_t kMagic = 0x3130525343475044ULL;  // "PDGCSR01"
+  static constexpr uint32_t kVersion = 1;
+  uint64_t magic;
+  uint32_t version;
+  uint32_t has_weight;
+  uint64_t node_num;
+  uint64_t edge_num;
+};
+
+// The edges of one GraphShard in compressed sparse row layout: the sorted
+// ids of the nodes, the offsets of their neighbors, and the neighbor ids
+// and weights in one array each, 16 bytes per node and 8 or 12 bytes per
+// edge. The weights are only kept when some edge is not of weight 1.
+//
+// A GraphCsrShard is immutable. It is built from the nodes of a shard, or
+// mapped read-only from a file written by save, so that loading it costs
+// no parsing and its pages are shared with the page cache.
+class GraphCsrShard {
+ public:
+  GraphCsrShard() {}
+  ~GraphCsrShard();
+
+  static std::shared_ptr<GraphCsrShard> build(
+      const std::vector<Node *> &nodes);
+  static std::shared_ptr<GraphCsrShard> load(const std::string &path);
+  void save(const std::string &path) const;
+
+  size_t node_num() const { return node_num_; }
+  size_t edge_num() const { return edge_num_; }
+  bool has_weight() const { return weights_ != nullptr; }
+
+  // Returns the position of node id, or -1 if it has no edges here.
+  int64_t find(uint64_t id) const;
+  size_t degree(int64_t pos) const {
+    return offsets_[pos + 1] - offsets_[pos];
+  }
+  uint64_t get_neighbor_id(int64_t pos, int i) const {
+    return neighbors_[offsets_[pos] + i];
+  }
+  float get_neighbor_weight(int64_t pos, int i) const {
+    return weights_ == nullptr ? 1. : weights_[offsets_[pos] + i];
+  }
+  // Samples k distinct neighbors of the node at pos, in proportion to their
+  // weights if there are, and returns their indexes like Node::sample_k.
+  // With an alias table, samples k neighbors with replacement instead, like
+  // AliasSampler.
+  std::vector<int> sample_k(int64_t pos,
+                            int k,
+                            const std::shared_ptr<std::mt19937_64> rng) const;
+  // Builds the alias tables of all the nodes into one array, or releases it.
+  void build_alias(bool use_alias);
+  bool has_alias() const { return !alias_.empty(); }
+
+ private:
+  void set_arrays(const char *data, size_t size);
+
+  size_t node_num_ = 0;
+  size_t edge_num_ = 0;
+  const uint64_t *ids_ = nullptr;
+  const uint64_t *offsets_ = nullptr;
+  const uint64_t *neighbors_ = nullptr;
+  const float *weights_ = nullptr;
+  // the header and the arrays, in buffer_ when built, or in the file mapped
+  // when loaded
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+  std::vector<uint64_t> buffer_;
+  bool mapped_ = false;
+  // the alias table of node pos starts at offsets_[pos]
+  std::vector<AliasEntry> alias_;
+};
+}  // namespace distributed
+}  // namespace paddle
@@ -67,12 +67,15 @@ void GraphNode::build_edges(bool is_weighted) {
 }
 void GraphNode::build_sampler(std::string sample_type) {
   if (sampler != nullptr) {
-    return;
+    delete sampler;
+    sampler = nullptr;
   }
   if (sample_type == "random") {
     sampler = new RandomSampler();
   } else if (sample_type == "weighted") {
     sampler = new WeightedSampler();
+  } else if (sample_type == "alias") {
+    sampler = new AliasSampler();
   }
   sampler->build(edges);
 }
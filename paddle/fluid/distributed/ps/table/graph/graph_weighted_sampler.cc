@@ -14,46 +14,117 @@
 
 #include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "paddle/phi/core/generator.h"
 namespace paddle {
 namespace distributed {
 
+void sample_k_distinct(int n,
+                       int k,
+                       std::mt19937_64 *rng,
+                       std::vector<int> *result) {
+  result->reserve(result->size() + k);
+  size_t begin = result->size();
+  std::unordered_set<int> sampled;
+  for (int j = n - k; j < n; j++) {
+    std::uniform_int_distribution<int> distrib(0, j);
+    int t = distrib(*rng);
+    // a linear search is faster than the set for the usual small k
+    bool exist = k <= 32 ? std::find(result->begin() + begin,
+                                     result->end(),
+                                     t) != result->end()
+                         : sampled.count(t) > 0;
+    if (exist) {
+      t = j;
+    }
+    if (k > 32) {
+      sampled.insert(t);
+    }
+    result->push_back(t);
+  }
+}
+
+void build_alias_table(const float *weights, int n, AliasEntry *table) {
+  double sum = 0;
+  for (int i = 0; i < n; i++) {
+    sum += std::max(weights[i], 0.0f);
+  }
+  std::vector<double> scaled(n);
+  std::vector<int> small, large;
+  for (int i = 0; i < n; i++) {
+    scaled[i] = sum > 0 ? std::max(weights[i], 0.0f) * n / sum : 1;
+    if (scaled[i] < 1) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
+    }
+  }
+  while (!small.empty() && !large.empty()) {
+    int s = small.back();
+    int l = large.back();
+    small.pop_back();
+    table[s].prob = scaled[s];
+    table[s].alias = l;
+    scaled[l] += scaled[s] - 1;
+    if (scaled[l] < 1) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // the rest are 1 up to rounding errors
+  for (int i : large) {
+    table[i].prob = 1;
+    table[i].alias = i;
+  }
+  for (int i : small) {
+    table[i].prob = 1;
+    table[i].alias = i;
+  }
+}
+
 void RandomSampler::build(GraphEdgeBlob *edges) { this->edges = edges; }
 
 std::vector<int> RandomSampler::sample_k(
     int k, const std::shared_ptr<std::mt19937_64> rng) {
   int n = edges->size();
+  std::vector<int> sample_result;
   if (k >= n) {
     k = n;
-    std::vector<int> sample_result;
     for (int i = 0; i < k; i++) {
       sample_result.push_back(i);
     }
     return sample_result;
   }
-  std::vector<int> sample_result;
-  std::unordered_map<int, int> replace_map;
-  while (k--) {
-    std::uniform_int_distribution<int> distrib(0, n - 1);
-    int rand_int = distrib(*rng);
-    auto iter = replace_map.find(rand_int);
-    if (iter == replace_map.end()) {
-      sample_result.push_back(rand_int);
-    } else {
-      sample_result.push_back(iter->second);
-    }
+  sample_k_distinct(n, k, rng.get(), &sample_result);
+  return sample_result;
+}
 
-    iter = replace_map.find(n - 1);
-    if (iter == replace_map.end()) {
-      replace_map[rand_int] = n - 1;
-    } else {
-      replace_map[rand_int] = iter->second;
-    }
-    --n;
+void AliasSampler::build(GraphEdgeBlob *edges) {
+  int n = edges->size();
+  std::vector<float> weights(n);
+  for (int i = 0; i < n; i++) {
+    weights[i] = edges->get_weight(i);
+  }
+  table.resize(n);
+  table.shrink_to_fit();
+  build_alias_table(weights.data(), n, table.data());
+}
+
+std::vector<int> AliasSampler::sample_k(
+    int k, const std::shared_ptr<std::mt19937_64> rng) {
+  std::vector<int> sample_result;
+  int n = table.size();
+  if (n == 0) {
+    return sample_result;
+  }
+  sample_result.resize(k);
+  for (int i = 0; i < k; i++) {
+    sample_result[i] = sample_alias(table.data(), n, rng.get());
   }
   return sample_result;
 }
@@ -23,6 +23,31 @@
 namespace paddle {
 namespace distributed {
 
+// Samples k distinct indexes of [0, n), k < n, with Floyd's algorithm, which
+// draws k times and needs no buffer of n.
+void sample_k_distinct(int n,
+                       int k,
+                       std::mt19937_64 *rng,
+                       std::vector<int> *result);
+
+// An entry of the alias table of Walker and Vose: index i is kept with
+// probability prob, and replaced by alias otherwise.
+struct AliasEntry {
+  float prob;
+  int alias;
+};
+
+// Builds the alias table of n weights into table, in O(n).
+void build_alias_table(const float *weights, int n, AliasEntry *table);
+
+// Draws an index of the alias table in O(1), from one random number.
+inline int sample_alias(const AliasEntry *table, int n, std::mt19937_64 *rng) {
+  uint64_t r = (*rng)();
+  int i = static_cast<int>(((r >> 32) * static_cast<uint64_t>(n)) >> 32);
+  float u = static_cast<float>(r & 0xFFFFFFFFULL) * (1.0f / 4294967296.0f);
+  return u < table[i].prob ? i : table[i].alias;
+}
+
 class Sampler {
  public:
   virtual ~Sampler() {}
@@ -40,6 +65,17 @@ class RandomSampler : public Sampler {
   GraphEdgeBlob *edges;
 };
 
+// Samples k neighbors with replacement, in proportion to their weights, in
+// O(1) per draw from an alias table built once.
+class AliasSampler : public Sampler {
+ public:
+  virtual ~AliasSampler() {}
+  virtual void build(GraphEdgeBlob *edges);
+  virtual std::vector<int> sample_k(int k,
+                                    const std::shared_ptr<std::mt19937_64> rng);
+  std::vector<AliasEntry> table;
+};
+
 class WeightedSampler : public Sampler {
  public:
   WeightedSampler();
@@ -14,6 +14,8 @@
 
 #include "paddle/fluid/distributed/ps/table/memory_dense_table.h"
 
+#include "paddle/fluid/distributed/common/push_quant.h"
+
 #include "paddle/fluid/platform/enforce.h"
 
 namespace paddle {
@@ -139,6 +141,17 @@ int32_t MemoryDenseTable::Pull(TableContext &context) {
 int32_t MemoryDenseTable::Push(TableContext &context) {
   CHECK(context.value_type == Dense);
   if (context.push_context.values != nullptr) {
+    auto quant_type =
+        static_cast<PushQuantType>(context.push_context.quant_type);
+    if (quant_type != PUSH_QUANT_NONE) {
+      std::vector<float> values(context.num);
+      DensePushDequant(
+          quant_type,
+          reinterpret_cast<const char *>(context.push_context.values),
+          context.num,
+          values.data());
+      return PushDense(values.data(), context.num);
+    }
     if (!context.push_context.is_param) {
       return PushDense(context.push_context.values, context.num);
     } else {
@@ -44,6 +44,7 @@ class MemoryDenseTable : public Table {
 
   int32_t Pull(TableContext& context) override;
   int32_t Push(TableContext& context) override;
+  bool SupportPushQuant() const override { return true; }
 
   int32_t PullDense(float* pull_values, size_t num);
   int32_t PushDenseParam(const float* values, size_t num);
@@ -13,13 +13,17 @@
 // limitations under the License.
 
 #include <omp.h>
+
+#include <cstring>
 #include <sstream>
 
 #include "glog/logging.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/common/local_random.h"
+#include "paddle/fluid/distributed/common/push_quant.h"
 #include "paddle/fluid/distributed/common/topk_calculator.h"
 #include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
+#include "paddle/fluid/distributed/ps/table/sparse_table_snapshot.h"
 #include "paddle/fluid/framework/archive.h"
 #include "paddle/fluid/framework/io/fs.h"
 
@@ -150,6 +154,11 @@ int32_t MemorySparseTable::Load(const std::string &path,
     channel_config.path = file_list[file_start_idx + i];
     VLOG(1) << "MemorySparseTable::load begin load " << channel_config.path
             << " into local shard " << i;
+    if (IsSparseSnapshotFile(channel_config.path)) {
+      auto *shard = &_local_shards[i];
+      LoadSnapshot(channel_config, [shard](uint64_t) { return shard; });
+      continue;
+    }
     channel_config.converter = _value_accesor->Converter(load_param).converter;
     channel_config.deconverter =
         _value_accesor->Converter(load_param).deconverter;
@@ -229,6 +238,27 @@ int32_t MemorySparseTable::LoadPatch(const std::vector<std::string> &file_list,
     channel_config.converter = _value_accesor->Converter(load_param).converter;
     channel_config.deconverter =
         _value_accesor->Converter(load_param).deconverter;
+    if (IsSparseSnapshotFile(channel_config.path)) {
+      // keys of the merged shard are dispatched to the original shards
+      std::unordered_set<int> global_shard_idx;
+      for (int j = o_start_idx; j < o_end_idx; ++j) {
+        if ((j % _avg_local_shard_num) % _m_real_local_shard_num ==
+            i % _m_avg_local_shard_num) {
+          global_shard_idx.insert(j);
+        }
+      }
+      LoadSnapshot(channel_config, [&](uint64_t key) -> shard_type * {
+        int idx = key % _sparse_table_shard_num;
+        if (global_shard_idx.count(idx) == 0) {
+          LOG(WARNING) << "MemorySparseTable key:" << key
+                       << " not match shard, file_idx:" << i
+                       << " file:" << channel_config.path;
+          return nullptr;
+        }
+        return &_local_shards[idx % _avg_local_shard_num];
+      });
+      continue;
+    }
 
     bool is_read_failed = false;
     int retry_num = 0;
@@ -338,6 +368,10 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
   std::atomic<uint32_t> feasign_size_all{0};
 
   size_t file_start_idx = _avg_local_shard_num * _shard_idx;
+  // xbox models are consumed outside, only checkpoints are saved in binary
+  bool binary_save =
+      _config.enable_binary_save() && (save_param == 0 || save_param == 3);
+  const char *suffix = binary_save ? kSparseSnapshotSuffix : "";
 
 #ifdef PADDLE_WITH_HETERPS
   int thread_num = _real_local_shard_num;
@@ -350,19 +384,25 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
     FsChannelConfig channel_config;
     if (_config.compress_in_save() && (save_param == 0 || save_param == 3)) {
       channel_config.path =
-          paddle::string::format_string("%s/part-%03d-%05d.gz",
+          paddle::string::format_string("%s/part-%03d-%05d%s.gz",
                                         table_path.c_str(),
                                         _shard_idx,
-                                        file_start_idx + i);
+                                        file_start_idx + i,
+                                        suffix);
     } else {
-      channel_config.path = paddle::string::format_string("%s/part-%03d-%05d",
-                                                          table_path.c_str(),
-                                                          _shard_idx,
-                                                          file_start_idx + i);
+      channel_config.path =
+          paddle::string::format_string("%s/part-%03d-%05d%s",
+                                        table_path.c_str(),
+                                        _shard_idx,
+                                        file_start_idx + i,
+                                        suffix);
+    }
+    if (!binary_save) {
+      channel_config.converter =
+          _value_accesor->Converter(save_param).converter;
+      channel_config.deconverter =
+          _value_accesor->Converter(save_param).deconverter;
     }
-    channel_config.converter = _value_accesor->Converter(save_param).converter;
-    channel_config.deconverter =
-        _value_accesor->Converter(save_param).deconverter;
     bool is_write_failed = false;
     int feasign_size = 0;
     int retry_num = 0;
@@ -374,27 +414,39 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
       is_write_failed = false;
       auto write_channel =
           _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
-      for (auto it = shard.begin(); it != shard.end(); ++it) {
-        if (_config.enable_sparse_table_cache() &&
-            (save_param == 1 || save_param == 2) &&
-            _value_accesor->Save(it.value().data(), 4)) {
-          CostTimer timer10("sprase table top push");
-          tk.push(i, _value_accesor->GetField(it.value().data(), "show"));
+      if (binary_save) {
+        if (0 != SaveSnapshot(write_channel.get(),
+                              {&shard},
+                              save_param,
+                              &feasign_size)) {
+          ++retry_num;
+          is_write_failed = true;
+          LOG(ERROR) << "MemorySparseTable save prefix failed, retry it! path:"
+                     << channel_config.path << " , retry_num=" << retry_num;
         }
+      } else {
+        for (auto it = shard.begin(); it != shard.end(); ++it) {
+          if (_config.enable_sparse_table_cache() &&
+              (save_param == 1 || save_param == 2) &&
+              _value_accesor->Save(it.value().data(), 4)) {
+            CostTimer timer10("sprase table top push");
+            tk.push(i, _value_accesor->GetField(it.value().data(), "show"));
+          }
 
-        if (_value_accesor->Save(it.value().data(), save_param)) {
-          std::string format_value = _value_accesor->ParseToString(
-              it.value().data(), it.value().size());
-          if (0 != write_channel->write_line(paddle::string::format_string(
-                       "%lu %s", it.key(), format_value.c_str()))) {
-            ++retry_num;
-            is_write_failed = true;
-            LOG(ERROR)
-                << "MemorySparseTable save prefix failed, retry it! path:"
-                << channel_config.path << " , retry_num=" << retry_num;
-            break;
+          if (_value_accesor->Save(it.value().data(), save_param)) {
+            std::string format_value = _value_accesor->ParseToString(
+                it.value().data(), it.value().size());
+            if (0 != write_channel->write_line(paddle::string::format_string(
+                         "%lu %s", it.key(), format_value.c_str()))) {
+              ++retry_num;
+              is_write_failed = true;
+              LOG(ERROR)
+                  << "MemorySparseTable save prefix failed, retry it! path:"
+                  << channel_config.path << " , retry_num=" << retry_num;
+              break;
+            }
+            ++feasign_size;
           }
-          ++feasign_size;
         }
       }
       write_channel->close();
@@ -435,6 +487,8 @@ int32_t MemorySparseTable::SavePatch(const std::string &path, int save_param) {
   _afs_client.remove(paddle::string::format_string(
       "%s/part-%03d-*", table_path.c_str(), _shard_idx));
   int thread_num = _m_real_local_shard_num < 20 ? _m_real_local_shard_num : 20;
+  bool binary_save = _config.enable_binary_save();
+  const char *suffix = binary_save ? kSparseSnapshotSuffix : "";
 
   std::atomic<uint32_t> feasign_size_all{0};
 
@@ -442,14 +496,18 @@ int32_t MemorySparseTable::SavePatch(const std::string &path, int save_param) {
 #pragma omp parallel for schedule(dynamic)
   for (int i = 0; i < _m_real_local_shard_num; ++i) {
     FsChannelConfig channel_config;
-    channel_config.path = paddle::string::format_string("%s/part-%03d-%05d",
+    channel_config.path = paddle::string::format_string("%s/part-%03d-%05d%s",
                                                         table_path.c_str(),
                                                         _shard_idx,
-                                                        file_start_idx + i);
-
-    channel_config.converter = _value_accesor->Converter(save_param).converter;
-    channel_config.deconverter =
-        _value_accesor->Converter(save_param).deconverter;
+                                                        file_start_idx + i,
+                                                        suffix);
+
+    if (!binary_save) {
+      channel_config.converter =
+          _value_accesor->Converter(save_param).converter;
+      channel_config.deconverter =
+          _value_accesor->Converter(save_param).deconverter;
+    }
 
     bool is_write_failed = false;
     int feasign_size = 0;
@@ -462,27 +520,43 @@ int32_t MemorySparseTable::SavePatch(const std::string &path, int save_param) {
       auto write_channel =
           _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
 
-      for (int j = 0; j < _real_local_shard_num; ++j) {
-        if (j % _m_real_local_shard_num == i) {
-          auto &shard = _local_shards_patch_model[j];
-          for (auto it = shard.begin(); it != shard.end(); ++it) {
-            if (_value_accesor->Save(it.value().data(), save_param)) {
-              std::string format_value = _value_accesor->ParseToString(
-                  it.value().data(), it.value().size());
-              if (0 != write_channel->write_line(paddle::string::format_string(
-                           "%lu %s", it.key(), format_value.c_str()))) {
-                ++retry_num;
-                is_write_failed = true;
-                LOG(ERROR) << "MemorySparseTable save failed, retry it! path:"
-                           << channel_config.path
-                           << " , retry_num=" << retry_num;
-                break;
+      if (binary_save) {
+        std::vector<shard_type *> shards;
+        for (int j = i; j < _real_local_shard_num;
+             j += _m_real_local_shard_num) {
+          shards.push_back(&_local_shards_patch_model[j]);
+        }
+        if (0 != SaveSnapshot(
+                     write_channel.get(), shards, save_param, &feasign_size)) {
+          ++retry_num;
+          is_write_failed = true;
+          LOG(ERROR) << "MemorySparseTable save failed, retry it! path:"
+                     << channel_config.path << " , retry_num=" << retry_num;
+        }
+      } else {
+        for (int j = 0; j < _real_local_shard_num; ++j) {
+          if (j % _m_real_local_shard_num == i) {
+            auto &shard = _local_shards_patch_model[j];
+            for (auto it = shard.begin(); it != shard.end(); ++it) {
+              if (_value_accesor->Save(it.value().data(), save_param)) {
+                std::string format_value = _value_accesor->ParseToString(
+                    it.value().data(), it.value().size());
+                if (0 !=
+                    write_channel->write_line(paddle::string::format_string(
+                        "%lu %s", it.key(), format_value.c_str()))) {
+                  ++retry_num;
+                  is_write_failed = true;
+                  LOG(ERROR) << "MemorySparseTable save failed, retry it! path:"
+                             << channel_config.path
+                             << " , retry_num=" << retry_num;
+                  break;
+                }
+                ++feasign_size;
               }
-              ++feasign_size;
             }
           }
+          if (is_write_failed) break;
         }
-        if (is_write_failed) break;
       }
       write_channel->close();
       if (err_no == -1) {
@@ -513,6 +587,94 @@ int32_t MemorySparseTable::SavePatch(const std::string &path, int save_param) {
   return 0;
 }
 
+int32_t MemorySparseTable::SaveSnapshot(FsWriteChannel *channel,
+                                        const std::vector<shard_type *> &shards,
+                                        int save_param,
+                                        int *feasign_size) {
+  std::vector<uint64_t> keys;
+  std::vector<const float *> values;
+  std::vector<uint32_t> lengths;
+  for (auto *shard : shards) {
+    keys.reserve(keys.size() + shard->size());
+    values.reserve(values.size() + shard->size());
+    lengths.reserve(lengths.size() + shard->size());
+    for (auto it = shard->begin(); it != shard->end(); ++it) {
+      if (_value_accesor->Save(it.value().data(), save_param)) {
+        keys.push_back(it.key());
+        values.push_back(it.value().data());
+        lengths.push_back(it.value().size());
+      }
+    }
+  }
+  *feasign_size = keys.size();
+  return WriteSparseSnapshot(
+      channel, _value_accesor->GetAccessorInfo(), keys, values, lengths);
+}
+
+int32_t MemorySparseTable::LoadSnapshot(
+    const FsChannelConfig &channel_config,
+    const std::function<shard_type *(uint64_t)> &get_shard) {
+  AccessorInfo info = _value_accesor->GetAccessorInfo();
+  // the snapshot is binary, the text converters do not apply to it
+  FsChannelConfig snapshot_config;
+  snapshot_config.path = channel_config.path;
+  // local uncompressed snapshots are mapped instead of read
+  const std::string &path = snapshot_config.path;
+  bool use_mmap =
+      paddle::framework::fs_select_internal(path) == 0 &&
+      (path.size() < 3 || path.compare(path.size() - 3, 3, ".gz") != 0);
+
+  bool is_read_failed = false;
+  int retry_num = 0;
+  do {
+    is_read_failed = false;
+    int err_no = 0;
+    SparseSnapshotReader reader;
+    int ret = use_mmap ? reader.OpenMmap(snapshot_config.path)
+                       : reader.Open(_afs_client.open_r(
+                             snapshot_config, 0, &err_no));
+    if (ret == 0) {
+      ret = CheckSparseSnapshotHeader(
+          reader.header(), info, snapshot_config.path);
+      if (ret != 0) {
+        // layout mismatch can not be fixed by retrying
+        LOG(ERROR) << "MemorySparseTable load snapshot failed!";
+        exit(-1);
+      }
+    }
+    const uint64_t *keys = nullptr;
+    const uint32_t *lengths = nullptr;
+    const float *values = nullptr;
+    size_t value_dim = reader.header().value_dim;
+    int64_t num = 0;
+    while (ret == 0 &&
+           (num = reader.ReadBatch(4096, &keys, &lengths, &values)) > 0) {
+      for (int64_t k = 0; k < num; ++k) {
+        auto *shard = get_shard(keys[k]);
+        if (shard == nullptr) {
+          continue;
+        }
+        auto &value = (*shard)[keys[k]];
+        value.resize(lengths[k]);
+        memcpy(value.data(),
+               values + k * value_dim,
+               lengths[k] * sizeof(float));
+      }
+    }
+    if (ret != 0 || num < 0 || err_no == -1) {
+      ++retry_num;
+      is_read_failed = true;
+      LOG(ERROR) << "MemorySparseTable load snapshot failed, retry it! path:"
+                 << snapshot_config.path << " , retry_num=" << retry_num;
+    }
+    if (retry_num > FLAGS_pserver_table_save_max_retry) {
+      LOG(ERROR) << "MemorySparseTable load failed reach max limit!";
+      exit(-1);
+    }
+  } while (is_read_failed);
+  return 0;
+}
+
 int64_t MemorySparseTable::CacheShuffle(
     const std::string &path,
     const std::string &param,
@@ -731,11 +893,41 @@ int32_t MemorySparseTable::Pull(TableContext &context) {
   }
 }
 
+const float *MemorySparseTable::DequantPushValues(
+    const TableContext &context, std::vector<float> *buffer) {
+  auto type = static_cast<PushQuantType>(context.push_context.quant_type);
+  if (type == PUSH_QUANT_NONE) {
+    return context.push_context.values;
+  }
+  size_t update_dim = _value_accesor->GetAccessorInfo().update_dim;
+  size_t quant_dim = context.push_context.quant_dim;
+  PADDLE_ENFORCE_LE(quant_dim,
+                    update_dim,
+                    paddle::platform::errors::InvalidArgument(
+                        "The quantized dim %d of the pushed values exceeds "
+                        "their dim %d.",
+                        quant_dim,
+                        update_dim));
+  size_t row_bytes = SparsePushQuantBytes(type, update_dim, quant_dim);
+  const char *in = reinterpret_cast<const char *>(context.push_context.values);
+  buffer->resize(context.num * update_dim);
+  for (size_t i = 0; i < context.num; ++i) {
+    SparsePushDequant(type,
+                      in + i * row_bytes,
+                      update_dim,
+                      quant_dim,
+                      buffer->data() + i * update_dim);
+  }
+  return buffer->data();
+}
+
 int32_t MemorySparseTable::Push(TableContext &context) {
   CHECK(context.value_type == Sparse);
   if (!context.use_ptr) {
-    return PushSparse(
-        context.push_context.keys, context.push_context.values, context.num);
+    std::vector<float> dequant_values;
+    return PushSparse(context.push_context.keys,
+                      DequantPushValues(context, &dequant_values),
+                      context.num);
   } else {
     return PushSparse(context.push_context.keys,
                       context.push_context.ptr_values,
@@ -1061,6 +1253,12 @@ int32_t MemorySparseTable::Shrink(const std::string &param) {
         ++it;
       }
     }
+    // Release the slabs left with the values erased above. Compacting copies
+    // every value of the shard, so it is only done when at least half of
+    // the slab bytes are free.
+    if (shard.arena_free_bytes() * 2 > shard.arena_bytes()) {
+      shard.compact();
+    }
   }
   return 0;
 }
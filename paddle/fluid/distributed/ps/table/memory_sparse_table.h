@@ -18,6 +18,7 @@
 #include <assert.h>
 #include <pthread.h>
 
+#include <functional>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
@@ -60,6 +61,7 @@ class MemorySparseTable : public Table {
 
   int32_t Pull(TableContext& context) override;
   int32_t Push(TableContext& context) override;
+  bool SupportPushQuant() const override { return true; }
 
   int32_t Initialize() override;
   int32_t InitializeShard() override { return 0; }
@@ -112,9 +114,23 @@ class MemorySparseTable : public Table {
   virtual void CheckSavePrePatchDone();
 
  protected:
+  // Returns the pushed values of context, which are dequantized into buffer
+  // if they were pushed with TableParameter.push_quant_type.
+  const float* DequantPushValues(const TableContext& context,
+                                 std::vector<float>* buffer);
   virtual int32_t SavePatch(const std::string& path, int save_param);
   virtual int32_t LoadPatch(const std::vector<std::string>& file_list,
                             int save_param);
+  // Writes the values of shards selected by save_param into channel in the
+  // binary snapshot format, see sparse_table_snapshot.h.
+  int32_t SaveSnapshot(FsWriteChannel* channel,
+                       const std::vector<shard_type*>& shards,
+                       int save_param,
+                       int* feasign_size);
+  // Loads a snapshot part, every key is inserted into the shard returned by
+  // get_shard, or skipped if it returns nullptr.
+  int32_t LoadSnapshot(const FsChannelConfig& channel_config,
+                       const std::function<shard_type*(uint64_t)>& get_shard);
 
   int _task_pool_size = 24;
   int _avg_local_shard_num;
@@ -0,0 +1,353 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/sparse_table_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "glog/logging.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+// Rows of values written or read in one batch.
+constexpr size_t kSnapshotBatchRows = 4096;
+
+inline uint64_t AlignTo8(uint64_t offset) { return (offset + 7) & ~7UL; }
+
+inline int WriteBlock(FsWriteChannel* channel, const void* data, size_t size) {
+  if (size == 0) {
+    return 0;
+  }
+  return channel->write(static_cast<const char*>(data), size) == 0 ? 0 : -1;
+}
+
+// FsReadChannel::read returns int, so large blocks are read in chunks.
+inline int ReadBlock(FsReadChannel* channel, void* data, size_t size) {
+  char* ptr = static_cast<char*>(data);
+  while (size > 0) {
+    size_t chunk = std::min<size_t>(size, 1UL << 30);
+    if (channel->read(ptr, chunk) != static_cast<int>(chunk)) {
+      return -1;
+    }
+    ptr += chunk;
+    size -= chunk;
+  }
+  return 0;
+}
+
+inline bool EndWith(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}  // namespace
+
+bool IsSparseSnapshotFile(const std::string& path) {
+  return EndWith(path, kSparseSnapshotSuffix) ||
+         EndWith(path, std::string(kSparseSnapshotSuffix) + ".gz");
+}
+
+void InitSparseSnapshotHeader(const AccessorInfo& info,
+                              uint64_t num_keys,
+                              SparseSnapshotHeader* header) {
+  memset(header, 0, sizeof(SparseSnapshotHeader));
+  memcpy(header->magic, kSparseSnapshotMagic, sizeof(header->magic));
+  header->version = kSparseSnapshotVersion;
+  header->value_dim = info.size / sizeof(float);
+  header->num_keys = num_keys;
+  header->accessor_dim = info.dim;
+  header->accessor_size = info.size;
+  header->select_dim = info.select_dim;
+  header->update_dim = info.update_dim;
+  header->mf_size = info.mf_size;
+  header->lengths_offset =
+      sizeof(SparseSnapshotHeader) + num_keys * sizeof(uint64_t);
+  header->values_offset =
+      AlignTo8(header->lengths_offset + num_keys * sizeof(uint32_t));
+}
+
+int CheckSparseSnapshotHeader(const SparseSnapshotHeader& header,
+                              const AccessorInfo& info,
+                              const std::string& path) {
+  if (memcmp(header.magic, kSparseSnapshotMagic, sizeof(header.magic)) != 0) {
+    LOG(ERROR) << "SparseSnapshot bad magic, path:" << path;
+    return -1;
+  }
+  if (header.version != kSparseSnapshotVersion) {
+    LOG(ERROR) << "SparseSnapshot version " << header.version
+               << " not supported, expect " << kSparseSnapshotVersion
+               << ", path:" << path;
+    return -1;
+  }
+  if (header.accessor_dim != info.dim || header.accessor_size != info.size ||
+      header.mf_size != info.mf_size ||
+      header.value_dim != info.size / sizeof(float)) {
+    LOG(ERROR) << "SparseSnapshot accessor layout not match, saved [dim:"
+               << header.accessor_dim << " size:" << header.accessor_size
+               << " mf_size:" << header.mf_size << "] vs current [dim:"
+               << info.dim << " size:" << info.size
+               << " mf_size:" << info.mf_size << "], path:" << path;
+    return -1;
+  }
+  return 0;
+}
+
+int WriteSparseSnapshot(FsWriteChannel* channel,
+                        const AccessorInfo& info,
+                        const std::vector<uint64_t>& keys,
+                        const std::vector<const float*>& values,
+                        const std::vector<uint32_t>& lengths) {
+  SparseSnapshotHeader header;
+  InitSparseSnapshotHeader(info, keys.size(), &header);
+  if (WriteBlock(channel, &header, sizeof(header)) != 0 ||
+      WriteBlock(channel, keys.data(), keys.size() * sizeof(uint64_t)) != 0 ||
+      WriteBlock(channel, lengths.data(), lengths.size() * sizeof(uint32_t)) !=
+          0) {
+    return -1;
+  }
+  uint64_t offset = header.lengths_offset + lengths.size() * sizeof(uint32_t);
+  static const char padding[8] = {0};
+  if (WriteBlock(channel, padding, header.values_offset - offset) != 0) {
+    return -1;
+  }
+
+  size_t value_dim = header.value_dim;
+  std::vector<float> rows(kSnapshotBatchRows * value_dim);
+  for (size_t start = 0; start < keys.size(); start += kSnapshotBatchRows) {
+    size_t num = std::min(kSnapshotBatchRows, keys.size() - start);
+    std::fill(rows.begin(), rows.begin() + num * value_dim, 0.0f);
+    for (size_t i = 0; i < num; ++i) {
+      size_t len = std::min<size_t>(lengths[start + i], value_dim);
+      memcpy(rows.data() + i * value_dim,
+             values[start + i],
+             len * sizeof(float));
+    }
+    if (WriteBlock(channel, rows.data(), num * value_dim * sizeof(float)) !=
+        0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+SparseSnapshotReader::~SparseSnapshotReader() {
+  if (_mmap_addr != nullptr) {
+    munmap(_mmap_addr, _mmap_size);
+  }
+}
+
+int SparseSnapshotReader::ReadHeader(const char* data, size_t size) {
+  if (size < sizeof(SparseSnapshotHeader)) {
+    return -1;
+  }
+  memcpy(&_header, data, sizeof(SparseSnapshotHeader));
+  if (memcmp(_header.magic, kSparseSnapshotMagic, sizeof(_header.magic)) !=
+      0) {
+    return -1;
+  }
+  // the offsets follow from num_keys, which is bounded first so that they do
+  // not overflow
+  constexpr uint64_t kMaxKeys =
+      (UINT64_MAX - sizeof(SparseSnapshotHeader) - 8) /
+      (sizeof(uint64_t) + sizeof(uint32_t));
+  if (_header.num_keys > kMaxKeys) {
+    LOG(ERROR) << "SparseSnapshot bad num_keys:" << _header.num_keys;
+    return -1;
+  }
+  uint64_t lengths_offset =
+      sizeof(SparseSnapshotHeader) + _header.num_keys * sizeof(uint64_t);
+  if (_header.lengths_offset != lengths_offset ||
+      _header.values_offset !=
+          AlignTo8(lengths_offset + _header.num_keys * sizeof(uint32_t))) {
+    LOG(ERROR) << "SparseSnapshot bad offsets, num_keys:" << _header.num_keys
+               << " lengths_offset:" << _header.lengths_offset
+               << " values_offset:" << _header.values_offset;
+    return -1;
+  }
+  _next_row = 0;
+  return 0;
+}
+
+int SparseSnapshotReader::Open(std::shared_ptr<FsReadChannel> channel) {
+  _channel = channel;
+  char buffer[sizeof(SparseSnapshotHeader)];
+  if (ReadBlock(_channel.get(), buffer, sizeof(buffer)) != 0 ||
+      ReadHeader(buffer, sizeof(buffer)) != 0) {
+    return -1;
+  }
+  // The size of a channel is unknown, so the blocks grow as they are read,
+  // and a damaged num_keys fails at the end of the file instead of
+  // allocating for all the keys it claims.
+  uint64_t num_keys = _header.num_keys;
+  constexpr uint64_t kChunkKeys = 1 << 20;
+  _keys.clear();
+  for (uint64_t start = 0; start < num_keys; start += kChunkKeys) {
+    uint64_t num = std::min(kChunkKeys, num_keys - start);
+    _keys.resize(start + num);
+    if (ReadBlock(_channel.get(),
+                  _keys.data() + start,
+                  num * sizeof(uint64_t)) != 0) {
+      return -1;
+    }
+  }
+  _lengths.resize(num_keys);
+  if (ReadBlock(_channel.get(),
+                _lengths.data(),
+                num_keys * sizeof(uint32_t)) != 0) {
+    return -1;
+  }
+  char padding[8];
+  uint64_t offset = _header.lengths_offset + num_keys * sizeof(uint32_t);
+  if (ReadBlock(_channel.get(), padding, _header.values_offset - offset) !=
+      0) {
+    return -1;
+  }
+  return 0;
+}
+
+int SparseSnapshotReader::OpenMmap(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(ERROR) << "SparseSnapshot open failed, path:" << path;
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return -1;
+  }
+  _mmap_size = st.st_size;
+  _mmap_addr = mmap(nullptr, _mmap_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (_mmap_addr == MAP_FAILED) {
+    _mmap_addr = nullptr;
+    LOG(ERROR) << "SparseSnapshot mmap failed, path:" << path;
+    return -1;
+  }
+  madvise(_mmap_addr, _mmap_size, MADV_SEQUENTIAL);
+  if (ReadHeader(static_cast<const char*>(_mmap_addr), _mmap_size) != 0) {
+    return -1;
+  }
+  // compared by division, so that a damaged header does not overflow
+  uint64_t row_bytes =
+      static_cast<uint64_t>(_header.value_dim) * sizeof(float);
+  if (_mmap_size < _header.values_offset ||
+      (row_bytes > 0 &&
+       (_mmap_size - _header.values_offset) / row_bytes < _header.num_keys)) {
+    LOG(ERROR) << "SparseSnapshot truncated file, size:" << _mmap_size
+               << " num_keys:" << _header.num_keys
+               << " value_dim:" << _header.value_dim << ", path:" << path;
+    return -1;
+  }
+  return 0;
+}
+
+int64_t SparseSnapshotReader::ReadBatch(size_t max_rows,
+                                        const uint64_t** keys,
+                                        const uint32_t** lengths,
+                                        const float** values) {
+  size_t num = std::min<uint64_t>(max_rows, _header.num_keys - _next_row);
+  if (num == 0) {
+    return 0;
+  }
+  size_t value_dim = _header.value_dim;
+  if (_mmap_addr != nullptr) {
+    const char* base = static_cast<const char*>(_mmap_addr);
+    *keys = reinterpret_cast<const uint64_t*>(base +
+                                              sizeof(SparseSnapshotHeader)) +
+            _next_row;
+    *lengths =
+        reinterpret_cast<const uint32_t*>(base + _header.lengths_offset) +
+        _next_row;
+    *values = reinterpret_cast<const float*>(base + _header.values_offset) +
+              _next_row * value_dim;
+  } else {
+    _values.resize(num * value_dim);
+    if (ReadBlock(_channel.get(),
+                  _values.data(),
+                  num * value_dim * sizeof(float)) != 0) {
+      return -1;
+    }
+    *keys = _keys.data() + _next_row;
+    *lengths = _lengths.data() + _next_row;
+    *values = _values.data();
+  }
+  // a row holds at most value_dim floats
+  for (size_t i = 0; i < num; ++i) {
+    if ((*lengths)[i] > value_dim) {
+      LOG(ERROR) << "SparseSnapshot bad length:" << (*lengths)[i]
+                 << " of row " << _next_row + i << ", value_dim:" << value_dim;
+      return -1;
+    }
+  }
+  _next_row += num;
+  return num;
+}
+
+int64_t ConvertTextToSparseSnapshot(AfsClient* afs_client,
+                                    ValueAccessor* accessor,
+                                    const FsChannelConfig& text_config,
+                                    const FsChannelConfig& snapshot_config) {
+  AccessorInfo info = accessor->GetAccessorInfo();
+  size_t value_dim = info.size / sizeof(float);
+
+  int err_no = 0;
+  auto read_channel = afs_client->open_r(text_config, 0, &err_no);
+  std::vector<uint64_t> keys;
+  std::vector<uint32_t> lengths;
+  std::vector<float> data;
+  std::string line_data;
+  char* end = nullptr;
+  while (read_channel->read_line(line_data) == 0 && line_data.size() > 1) {
+    keys.push_back(std::strtoul(line_data.data(), &end, 10));
+    data.resize(keys.size() * value_dim);
+    float* value = data.data() + (keys.size() - 1) * value_dim;
+    lengths.push_back(accessor->ParseFromString(++end, value));
+  }
+  read_channel->close();
+  if (err_no == -1) {
+    LOG(ERROR) << "SparseSnapshot convert read failed, path:"
+               << text_config.path;
+    return -1;
+  }
+
+  std::vector<const float*> values(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    values[i] = data.data() + i * value_dim;
+  }
+  auto write_channel =
+      afs_client->open_w(snapshot_config, 1024 * 1024 * 40, &err_no);
+  int ret = WriteSparseSnapshot(
+      write_channel.get(), info, keys, values, lengths);
+  write_channel->close();
+  if (ret != 0 || err_no == -1) {
+    LOG(ERROR) << "SparseSnapshot convert write failed, path:"
+               << snapshot_config.path;
+    afs_client->remove(snapshot_config.path);
+    return -1;
+  }
+  return keys.size();
+}
+
+}  // namespace distributed
+}  // namespace paddle
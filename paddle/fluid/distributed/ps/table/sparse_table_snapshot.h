@@ -0,0 +1,134 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/distributed/common/afs_warpper.h"
+#include "paddle/fluid/distributed/ps/table/accessor.h"
+
+namespace paddle {
+namespace distributed {
+
+// Binary snapshot of one sparse table shard, an alternative to the text
+// "key value..." parts which are expensive to format and parse.
+//
+// Layout (host byte order):
+//   SparseSnapshotHeader                     64 bytes
+//   keys      uint64_t[num_keys]
+//   lengths   uint32_t[num_keys]             padded to 8 bytes
+//   values    float[num_keys][value_dim]     zero padded rows
+//
+// Every value row has the fixed width value_dim (the full value size of the
+// accessor), the real length of each value (which is shorter when the mf
+// part is not created) is kept in the lengths block. A local uncompressed
+// snapshot is loaded through mmap without copying the blocks.
+static constexpr char kSparseSnapshotMagic[8] = {
+    'P', 'D', 'S', 'P', 'S', 'N', 'A', 'P'};
+static constexpr uint32_t kSparseSnapshotVersion = 1;
+// Suffix of the snapshot parts, "part-000-00000.snap[.gz]".
+static constexpr char kSparseSnapshotSuffix[] = ".snap";
+
+struct SparseSnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t value_dim;
+  uint64_t num_keys;
+  // layout of the accessor which saves the snapshot
+  uint32_t accessor_dim;
+  uint32_t accessor_size;
+  uint32_t select_dim;
+  uint32_t update_dim;
+  uint32_t mf_size;
+  uint32_t reserved;
+  uint64_t lengths_offset;
+  uint64_t values_offset;
+};
+static_assert(sizeof(SparseSnapshotHeader) == 64,
+              "SparseSnapshotHeader must be 64 bytes.");
+
+// Returns whether path names a snapshot part (".snap" or ".snap.gz").
+bool IsSparseSnapshotFile(const std::string& path);
+
+// Fills the header for num_keys values saved by an accessor with info.
+void InitSparseSnapshotHeader(const AccessorInfo& info,
+                              uint64_t num_keys,
+                              SparseSnapshotHeader* header);
+
+// Checks the header read from a snapshot against the loading accessor,
+// returns 0 if they match.
+int CheckSparseSnapshotHeader(const SparseSnapshotHeader& header,
+                              const AccessorInfo& info,
+                              const std::string& path);
+
+// Writes a snapshot of keys[i] -> values[i][0, lengths[i]) to the channel,
+// returns 0 on success and -1 if any write fails.
+int WriteSparseSnapshot(FsWriteChannel* channel,
+                        const AccessorInfo& info,
+                        const std::vector<uint64_t>& keys,
+                        const std::vector<const float*>& values,
+                        const std::vector<uint32_t>& lengths);
+
+// Reads a snapshot batch by batch. The keys and lengths blocks are read
+// entirely on open, the values block is read in batches of rows, or all of
+// the blocks are mapped when the snapshot is opened through OpenMmap.
+class SparseSnapshotReader {
+ public:
+  SparseSnapshotReader() {}
+  ~SparseSnapshotReader();
+  SparseSnapshotReader(const SparseSnapshotReader&) = delete;
+  SparseSnapshotReader& operator=(const SparseSnapshotReader&) = delete;
+
+  // Both return 0 on success and -1 on error.
+  int Open(std::shared_ptr<FsReadChannel> channel);
+  int OpenMmap(const std::string& path);
+
+  const SparseSnapshotHeader& header() const { return _header; }
+
+  // Reads at most max_rows rows, the i-th row is keys[i] -> values[i *
+  // value_dim, i * value_dim + lengths[i]). The pointers are valid until the
+  // next call. Returns the number of rows read, 0 at the end and -1 on error.
+  int64_t ReadBatch(size_t max_rows,
+                    const uint64_t** keys,
+                    const uint32_t** lengths,
+                    const float** values);
+
+ private:
+  int ReadHeader(const char* data, size_t size);
+
+  SparseSnapshotHeader _header;
+  uint64_t _next_row = 0;
+  std::shared_ptr<FsReadChannel> _channel;
+  std::vector<uint64_t> _keys;
+  std::vector<uint32_t> _lengths;
+  std::vector<float> _values;
+  // mmap mode
+  void* _mmap_addr = nullptr;
+  size_t _mmap_size = 0;
+};
+
+// Converts a text part ("key value..." lines parsed by the accessor) into a
+// snapshot part, so that existing checkpoints can be loaded in the binary
+// format. Returns the number of converted keys, or -1 on error.
+int64_t ConvertTextToSparseSnapshot(AfsClient* afs_client,
+                                    ValueAccessor* accessor,
+                                    const FsChannelConfig& text_config,
+                                    const FsChannelConfig& snapshot_config);
+
+}  // namespace distributed
+}  // namespace paddle
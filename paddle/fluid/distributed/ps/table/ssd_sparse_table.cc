@@ -66,7 +66,8 @@ int32_t SSDSparseTable::Push(TableContext& context) {
                       context.num);
   } else {
     const uint64_t* keys = context.push_context.keys;
-    const float* values = context.push_context.values;
+    std::vector<float> dequant_values;
+    const float* values = DequantPushValues(context, &dequant_values);
     size_t num = context.num;
     return PushSparse(keys, values, num);
   }
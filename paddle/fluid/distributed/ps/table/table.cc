@@ -66,6 +66,12 @@ int32_t Table::Initialize(const TableParameter &config,
     LOG(WARNING) << "Table accessor initialize failed";
     return -1;
   }
+  if (_config.push_quant_type() != PUSH_QUANT_NONE && !SupportPushQuant()) {
+    LOG(ERROR) << "push_quant_type is unsupported by table_class:"
+               << _config.table_class()
+               << ", table_id:" << _config.table_id();
+    return -1;
+  }
 
   if (_afs_client.initialize(fs_config) != 0) {
     LOG(WARNING) << "Table fs_client initialize failed";
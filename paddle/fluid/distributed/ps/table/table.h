@@ -53,6 +53,10 @@ struct TablePushContext {
   const float **ptr_values = nullptr;
   const int64_t *push_steps = nullptr;  // for global step
   bool is_param = false;  // true: push param, false: push gradient
+  // PushQuantType of values, which quantizes the last quant_dim of each
+  // sparse value, see push_quant.h
+  int quant_type = 0;
+  uint32_t quant_dim = 0;
 };
 
 struct TableContext {
@@ -75,6 +79,8 @@ class Table {
 
   virtual int32_t Pull(TableContext &context) = 0;  // NOLINT
   virtual int32_t Push(TableContext &context) = 0;  // NOLINT
+  // whether Push dequantizes the values of TablePushContext.quant_type
+  virtual bool SupportPushQuant() const { return false; }
 
   // only for barrier
   virtual int32_t Barrier(const uint32_t trainer_id,
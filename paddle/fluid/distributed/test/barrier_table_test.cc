@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include <ThreadPool.h>
 
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -63,5 +64,21 @@ TEST(BarrierTable, Barrier) {
   ASSERT_EQ(ret, 0);
 }
 
+TEST(BarrierTable, RejectPushQuant) {
+  TableParameter table_config;
+  table_config.set_table_class("BarrierTable");
+  table_config.set_push_quant_type(PUSH_QUANT_INT8);
+  FsClientParameter fs_config;
+  std::unique_ptr<Table> table(new BarrierTable());
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CommMergeAccessor");
+  CommonAccessorParameter *common_config = table_config.mutable_common();
+  common_config->set_table_name("barrier_table");
+  common_config->set_trainer_num(1);
+  common_config->set_sync(true);
+
+  ASSERT_EQ(table->Initialize(table_config, fs_config), -1);
+}
+
 }  // namespace distributed
 }  // namespace paddle
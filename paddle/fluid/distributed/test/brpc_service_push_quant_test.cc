@@ -0,0 +1,235 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <unistd.h>
+
+#include <cmath>
+#include <map>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_client.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_server.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace paddle {
+namespace distributed {
+class DownpourBrpcClosure;
+class PSClient;
+class PSServer;
+}  // namespace distributed
+}  // namespace paddle
+
+namespace framework = paddle::framework;
+namespace distributed = paddle::distributed;
+
+void GetDownpourDenseTableProto(
+    ::paddle::distributed::TableParameter* dense_table_proto) {
+  dense_table_proto->set_table_id(0);
+  dense_table_proto->set_table_class("MemoryDenseTable");
+  dense_table_proto->set_shard_num(256);
+  dense_table_proto->set_type(::paddle::distributed::PS_DENSE_TABLE);
+  dense_table_proto->set_push_quant_type(
+      ::paddle::distributed::PUSH_QUANT_INT8);
+  ::paddle::distributed::TableAccessorParameter* accessor_proto =
+      dense_table_proto->mutable_accessor();
+  ::paddle::distributed::CommonAccessorParameter* common_proto =
+      dense_table_proto->mutable_common();
+
+  accessor_proto->set_accessor_class("CommMergeAccessor");
+  accessor_proto->set_fea_dim(100);
+  accessor_proto->set_embedx_dim(1);
+
+  common_proto->set_name("sgd");
+  common_proto->set_table_name("MergedDense");
+  common_proto->set_trainer_num(1);
+  common_proto->set_sync(false);
+  common_proto->add_params("Param");
+  common_proto->add_dims(100);
+  common_proto->add_initializers("fill_constant&1.0");
+  common_proto->add_params("LearningRate");
+  common_proto->add_dims(1);
+  common_proto->add_initializers("fill_constant&1.0");
+}
+
+::paddle::distributed::PSParameter GetServerProto() {
+  // Generate server proto desc
+  ::paddle::distributed::PSParameter server_fleet_desc;
+  ::paddle::distributed::ServerParameter* server_proto =
+      server_fleet_desc.mutable_server_param();
+  ::paddle::distributed::DownpourServerParameter* downpour_server_proto =
+      server_proto->mutable_downpour_server_param();
+  ::paddle::distributed::ServerServiceParameter* server_service_proto =
+      downpour_server_proto->mutable_service_param();
+  server_service_proto->set_service_class("BrpcPsService");
+  server_service_proto->set_server_class("BrpcPsServer");
+  server_service_proto->set_client_class("BrpcPsClient");
+  server_service_proto->set_start_server_port(0);
+  server_service_proto->set_server_thread_num(12);
+
+  ::paddle::distributed::TableParameter* dense_table_proto =
+      downpour_server_proto->add_downpour_table_param();
+  GetDownpourDenseTableProto(dense_table_proto);
+  return server_fleet_desc;
+}
+
+::paddle::distributed::PSParameter GetWorkerProto() {
+  ::paddle::distributed::PSParameter worker_fleet_desc;
+  ::paddle::distributed::WorkerParameter* worker_proto =
+      worker_fleet_desc.mutable_worker_param();
+
+  ::paddle::distributed::DownpourWorkerParameter* downpour_worker_proto =
+      worker_proto->mutable_downpour_worker_param();
+
+  ::paddle::distributed::TableParameter* worker_dense_table_proto =
+      downpour_worker_proto->add_downpour_table_param();
+  GetDownpourDenseTableProto(worker_dense_table_proto);
+
+  ::paddle::distributed::ServerParameter* server_proto =
+      worker_fleet_desc.mutable_server_param();
+  ::paddle::distributed::DownpourServerParameter* downpour_server_proto =
+      server_proto->mutable_downpour_server_param();
+  ::paddle::distributed::ServerServiceParameter* server_service_proto =
+      downpour_server_proto->mutable_service_param();
+  server_service_proto->set_service_class("BrpcPsService");
+  server_service_proto->set_server_class("BrpcPsServer");
+  server_service_proto->set_client_class("BrpcPsClient");
+  server_service_proto->set_start_server_port(0);
+  server_service_proto->set_server_thread_num(12);
+
+  ::paddle::distributed::TableParameter* server_dense_table_proto =
+      downpour_server_proto->add_downpour_table_param();
+  GetDownpourDenseTableProto(server_dense_table_proto);
+
+  return worker_fleet_desc;
+}
+
+/*-------------------------------------------------------------------------*/
+
+const char* ip_ = "127.0.0.1";
+uint32_t port_ = 4218;
+
+std::vector<std::string> host_sign_list_;
+
+std::shared_ptr<paddle::distributed::PSServer> pserver_ptr_;
+
+std::shared_ptr<paddle::distributed::PSClient> worker_ptr_;
+
+void RunServer() {
+  ::paddle::distributed::PSParameter server_proto = GetServerProto();
+
+  auto _ps_env = paddle::distributed::PaddlePSEnvironment();
+  LOG(INFO) << "RUN set_ps_servers";
+  _ps_env.SetPsServers(&host_sign_list_, 1);
+  pserver_ptr_ = std::shared_ptr<paddle::distributed::PSServer>(
+      paddle::distributed::PSServerFactory::Create(server_proto));
+  LOG(INFO) << "RUN configure";
+  std::vector<framework::ProgramDesc> empty_vec;
+  framework::ProgramDesc empty_prog;
+  empty_vec.push_back(empty_prog);
+  pserver_ptr_->Configure(server_proto, _ps_env, 0, empty_vec);
+  LOG(INFO) << "RUN start";
+  pserver_ptr_->Start(ip_, port_);
+  LOG(INFO) << "End start";
+}
+
+void RunClient(std::map<uint64_t, std::vector<paddle::distributed::Region>>&
+                   dense_regions) {
+  ::paddle::distributed::PSParameter worker_proto = GetWorkerProto();
+  paddle::distributed::PaddlePSEnvironment _ps_env;
+  auto servers_ = host_sign_list_.size();
+  _ps_env = paddle::distributed::PaddlePSEnvironment();
+  LOG(INFO) << "Run set_ps_servers";
+  _ps_env.SetPsServers(&host_sign_list_, servers_);
+  LOG(INFO) << "Run Create PSClient";
+  worker_ptr_ = std::shared_ptr<paddle::distributed::PSClient>(
+      paddle::distributed::PSClientFactory::Create(worker_proto));
+  LOG(INFO) << "Run configure";
+  worker_ptr_->Configure(worker_proto, dense_regions, _ps_env, 0);
+}
+
+int32_t PushGradient(float* grad, size_t num) {
+  paddle::distributed::DownpourBrpcClosure* closure =
+      new paddle::distributed::DownpourBrpcClosure(1, [&](void* done) {
+        int ret = 0;
+        auto* closure = (paddle::distributed::DownpourBrpcClosure*)done;
+        if (closure->check_response(
+                0, paddle::distributed::PS_PUSH_DENSE_TABLE) != 0) {
+          ret = -1;
+        }
+        closure->set_promise_value(ret);
+      });
+  auto push_status = worker_ptr_->PushDenseRawGradient(0, grad, num, closure);
+  push_status.wait();
+  return push_status.get();
+}
+
+void RunBrpcPushQuantDense() {
+  setenv("http_proxy", "", 1);
+  setenv("https_proxy", "", 1);
+  auto ph_host = paddle::distributed::PSHost(ip_, port_, 0);
+  host_sign_list_.push_back(ph_host.SerializeToString());
+
+  std::thread server_thread(RunServer);
+  sleep(1);
+
+  const size_t numel = 100;
+  std::vector<float> w(numel, 0);
+  std::map<uint64_t, std::vector<paddle::distributed::Region>> dense_regions;
+  dense_regions.insert(
+      std::pair<uint64_t, std::vector<paddle::distributed::Region>>(0, {}));
+  std::vector<paddle::distributed::Region> regions;
+  regions.emplace_back(w.data(), numel);
+  RunClient(dense_regions);
+
+  // The largest gradient sets the int8 scale to 0.01, so the others are
+  // below half a step and are all lost by the first push.
+  std::vector<float> grad(numel, 0.004);
+  grad[0] = 1.27;
+  const float scale = 1.27 / 127;
+
+  /*-----------------------Test Dequantized Push----------------------------*/
+  std::vector<float> send(grad);
+  ASSERT_EQ(PushGradient(send.data(), numel), 0);
+  auto pull_status = worker_ptr_->PullDense(regions.data(), regions.size(), 0);
+  pull_status.wait();
+  EXPECT_NEAR(w[0], 1.0 - 1.27, 1e-5);
+  for (size_t i = 1; i < numel; ++i) {
+    EXPECT_FLOAT_EQ(w[i], 1.0);
+  }
+
+  /*-----------------------Test Error Feedback------------------------------*/
+  // The residual of the first push is added to the second one, which
+  // reaches a step now, so the servers stay within half a step of the
+  // gradients summed without quantization.
+  send = grad;
+  ASSERT_EQ(PushGradient(send.data(), numel), 0);
+  pull_status = worker_ptr_->PullDense(regions.data(), regions.size(), 0);
+  pull_status.wait();
+  EXPECT_NEAR(w[0], 1.0 - 2 * 1.27, 1e-5);
+  for (size_t i = 1; i < numel; ++i) {
+    EXPECT_NEAR(w[i], 1.0 - scale, 1e-5);
+    EXPECT_LE(std::fabs(w[i] - (1.0 - 2 * grad[i])), scale / 2 + 1e-5);
+  }
+
+  LOG(INFO) << "Run stop_server";
+  worker_ptr_->StopServer();
+  LOG(INFO) << "Run finalize_worker";
+  worker_ptr_->FinalizeWorker();
+  server_thread.join();
+}
+
+TEST(RunBrpcPushQuantDense, Run) { RunBrpcPushQuantDense(); }
@@ -46,5 +46,50 @@ TEST(BENCHMARK, LargeScaleKV) {
   ASSERT_FLOAT_EQ(value_data[3], 0.3);
 }
 
+TEST(FixedFeatureValue, ArenaAndCompact) {
+  typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
+  shard_type shard;
+  const size_t dim = 11;
+  const uint64_t key_num = 100000;
+  for (uint64_t key = 0; key < key_num; ++key) {
+    auto& feature_value = shard[key];
+    feature_value.resize(dim);
+    for (size_t i = 0; i < dim; ++i) {
+      feature_value.data()[i] = static_cast<float>(key + i);
+    }
+  }
+  // resize keeps the leading data and fills the tail with zero
+  auto& extended_value = shard[0];
+  extended_value.resize(dim + 4);
+  ASSERT_FLOAT_EQ(extended_value.data()[dim - 1], dim - 1);
+  ASSERT_FLOAT_EQ(extended_value.data()[dim + 3], 0.0);
+  extended_value.resize(dim);
+
+  size_t arena_bytes = shard.arena_bytes();
+  ASSERT_GE(arena_bytes, key_num * dim * sizeof(float));
+
+  for (auto it = shard.begin(); it != shard.end();) {
+    if (it.key() % 10 != 0) {
+      it = shard.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ASSERT_EQ(shard.arena_bytes(), arena_bytes);
+  // 9/10 of the values are erased
+  ASSERT_GT(shard.arena_free_bytes() * 10, arena_bytes * 8);
+  shard.compact();
+  ASSERT_LT(shard.arena_bytes(), arena_bytes);
+  ASSERT_LT(shard.arena_free_bytes(), shard.arena_bytes());
+
+  ASSERT_EQ(shard.size(), key_num / 10);
+  for (auto it = shard.begin(); it != shard.end(); ++it) {
+    ASSERT_EQ(it.value().size(), dim);
+    for (size_t i = 0; i < dim; ++i) {
+      ASSERT_FLOAT_EQ(it.value().data()[i], static_cast<float>(it.key() + i));
+    }
+  }
+}
+
 }  // namespace distributed
 }  // namespace paddle
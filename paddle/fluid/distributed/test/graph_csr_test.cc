@@ -0,0 +1,124 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr.h"
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace distributed = paddle::distributed;
+
+// node i has i neighbors 100 * i + j, of weight j + 1 if weighted
+std::vector<distributed::Node *> make_nodes(int node_num, bool is_weighted) {
+  std::vector<distributed::Node *> nodes;
+  for (int i = node_num - 1; i >= 0; i--) {
+    auto *node = new distributed::GraphNode(i);
+    node->build_edges(is_weighted);
+    for (int j = 0; j < i; j++) {
+      node->add_edge(100 * i + j, is_weighted ? j + 1 : 1);
+    }
+    nodes.push_back(node);
+  }
+  return nodes;
+}
+
+void check_csr(const distributed::GraphCsrShard &csr,
+               int node_num,
+               bool is_weighted) {
+  ASSERT_EQ(csr.node_num(), static_cast<size_t>(node_num - 1));
+  ASSERT_EQ(csr.edge_num(), static_cast<size_t>(node_num * (node_num - 1) / 2));
+  ASSERT_EQ(csr.has_weight(), is_weighted);
+  ASSERT_EQ(csr.find(0), -1);
+  ASSERT_EQ(csr.find(node_num), -1);
+  for (int i = 1; i < node_num; i++) {
+    int64_t pos = csr.find(i);
+    ASSERT_GE(pos, 0);
+    ASSERT_EQ(csr.degree(pos), static_cast<size_t>(i));
+    for (int j = 0; j < i; j++) {
+      ASSERT_EQ(csr.get_neighbor_id(pos, j),
+                static_cast<uint64_t>(100 * i + j));
+      ASSERT_EQ(csr.get_neighbor_weight(pos, j), is_weighted ? j + 1 : 1);
+    }
+  }
+}
+
+TEST(GraphCsrShard, BuildSaveLoad) {
+  const int node_num = 50;
+  for (bool is_weighted : {false, true}) {
+    auto nodes = make_nodes(node_num, is_weighted);
+    auto csr = distributed::GraphCsrShard::build(nodes);
+    for (auto node : nodes) delete node;
+    check_csr(*csr, node_num, is_weighted);
+
+    const char *path = "graph_csr_test.csr";
+    csr->save(path);
+    auto mapped = distributed::GraphCsrShard::load(path);
+    std::remove(path);
+    check_csr(*mapped, node_num, is_weighted);
+  }
+}
+
+TEST(GraphCsrShard, SampleK) {
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  for (bool is_weighted : {false, true}) {
+    auto nodes = make_nodes(200, is_weighted);
+    auto csr = distributed::GraphCsrShard::build(nodes);
+    for (auto node : nodes) delete node;
+
+    int64_t pos = csr->find(10);
+    ASSERT_EQ(csr->sample_k(pos, 20, rng).size(), 10UL);
+    // small and large k, which are sampled differently
+    for (int k : {5, 100}) {
+      pos = csr->find(199);
+      for (int t = 0; t < 100; t++) {
+        auto res = csr->sample_k(pos, k, rng);
+        ASSERT_EQ(res.size(), static_cast<size_t>(k));
+        std::set<int> distinct(res.begin(), res.end());
+        ASSERT_EQ(distinct.size(), static_cast<size_t>(k));
+        ASSERT_GE(*distinct.begin(), 0);
+        ASSERT_LT(*distinct.rbegin(), 199);
+      }
+    }
+    // the neighbors of larger weights are sampled more often
+    if (is_weighted) {
+      pos = csr->find(100);
+      int high = 0;
+      for (int t = 0; t < 1000; t++) {
+        for (int x : csr->sample_k(pos, 1, rng)) {
+          high += x >= 50;
+        }
+      }
+      ASSERT_GT(high, 600);
+    }
+
+    // with replacement from the alias tables
+    csr->build_alias(true);
+    ASSERT_TRUE(csr->has_alias());
+    pos = csr->find(100);
+    auto res = csr->sample_k(pos, 1000, rng);
+    ASSERT_EQ(res.size(), 1000UL);
+    int high = 0;
+    for (int x : res) {
+      ASSERT_GE(x, 0);
+      ASSERT_LT(x, 100);
+      high += x >= 50;
+    }
+    // 3/4 of the weight is in the upper half when weighted
+    ASSERT_NEAR(high / 1000.0, is_weighted ? 0.75 : 0.5, 0.06);
+    csr->build_alias(false);
+    ASSERT_FALSE(csr->has_alias());
+  }
+}
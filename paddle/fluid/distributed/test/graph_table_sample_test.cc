@@ -14,10 +14,14 @@
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>  // NOLINT
+#include <cstring>
 #include <fstream>
 #include <iomanip>
+#include <map>
+#include <set>
 #include <string>
 #include <thread>  // NOLINT
 #include <unordered_set>
@@ -27,6 +31,7 @@
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/ps/table/common_graph_table.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/framework/io/fs.h"
 namespace framework = paddle::framework;
 namespace platform = paddle::platform;
 namespace operators = paddle::operators;
@@ -86,3 +91,106 @@ void testGraphSample() {
 }
 
 TEST(testGraphSample, Run) { testGraphSample(); }
+
+// Samples the neighbors of the edge type u2i from its csr shards, and checks
+// them against the edge file.
+void testSampleFromCsr(distributed::GraphTable *graph_table) {
+  std::map<uint64_t, std::map<uint64_t, float>> neighbors = {
+      {37, {{45, 0.34}, {145, 0.31}, {112, 0.21}}},
+      {96, {{48, 1.4}, {247, 0.31}, {111, 1.21}}},
+      {59, {{45, 0.34}, {145, 0.31}, {122, 0.21}}},
+      {97, {{48, 0.34}, {247, 0.31}, {111, 0.21}}}};
+  std::vector<uint64_t> ids = {37, 96, 59, 97, 45};
+  for (int sample_size : {2, 5}) {
+    std::vector<std::shared_ptr<char>> buffers(ids.size());
+    std::vector<int> actual_sizes(ids.size(), 0);
+    graph_table->random_sample_neighbors(
+        0, ids.data(), sample_size, buffers, actual_sizes, true);
+    int item_size = distributed::Node::id_size +
+                    distributed::Node::weight_size;
+    for (size_t i = 0; i + 1 < ids.size(); i++) {
+      auto *csr = graph_table->find_csr_shard(0, ids[i]);
+      ASSERT_NE(csr, nullptr);
+      ASSERT_GE(csr->find(ids[i]), 0);
+      auto &expected = neighbors[ids[i]];
+      int num = std::min(sample_size, static_cast<int>(expected.size()));
+      ASSERT_EQ(actual_sizes[i], num * item_size);
+      std::set<uint64_t> sampled;
+      for (int j = 0; j < num; j++) {
+        uint64_t id;
+        float weight;
+        char *addr = buffers[i].get() + j * item_size;
+        memcpy(&id, addr, distributed::Node::id_size);
+        memcpy(&weight,
+               addr + distributed::Node::id_size,
+               distributed::Node::weight_size);
+        ASSERT_EQ(expected.count(id), 1UL);
+        ASSERT_NEAR(weight, expected[id], 1e-6);
+        sampled.insert(id);
+      }
+      ASSERT_EQ(sampled.size(), static_cast<size_t>(num));
+    }
+    ASSERT_EQ(actual_sizes.back(), 0);
+  }
+}
+
+TEST(testGraphSample, SampleFromCsr) {
+  prepare_file(edge_file_name, edges);
+  ::paddle::distributed::GraphParameter table_proto;
+  table_proto.set_task_pool_size(4);
+  table_proto.set_shard_num(4);
+  table_proto.add_edge_types("u2i");
+  table_proto.set_build_csr(true);
+
+  distributed::GraphTable graph_table;
+  graph_table.Initialize(table_proto);
+  graph_table.load_edges(edge_file_name, false, "u2i");
+  testSampleFromCsr(&graph_table);
+
+  // the loaded table has no edges in its GraphShards, so every sample comes
+  // from the mapped csr shards.
+  std::string csr_dir = "graph_table_sample_test_csr";
+  ASSERT_EQ(graph_table.save_csr(0, csr_dir), 0);
+  table_proto.set_build_csr(false);
+  distributed::GraphTable loaded_table;
+  loaded_table.Initialize(table_proto);
+  ASSERT_EQ(loaded_table.Load(csr_dir, "cu2i"), 0);
+  testSampleFromCsr(&loaded_table);
+  ASSERT_EQ(loaded_table.Load(csr_dir, "cunknown"), -1);
+  ::paddle::framework::localfs_remove(csr_dir);
+}
+
+TEST(testGraphSample, AliasSampleType) {
+  prepare_file(edge_file_name, edges);
+  ::paddle::distributed::GraphParameter table_proto;
+  table_proto.set_task_pool_size(4);
+  table_proto.set_shard_num(4);
+  table_proto.add_edge_types("u2i");
+  table_proto.set_build_csr(true);
+  table_proto.set_sample_type("alias");
+
+  distributed::GraphTable graph_table;
+  graph_table.Initialize(table_proto);
+  graph_table.load_edges(edge_file_name, false, "u2i");
+  ASSERT_TRUE(graph_table.find_csr_shard(0, 96)->has_alias());
+
+  // alias samples with replacement, so it returns sample_size neighbors
+  std::vector<uint64_t> ids = {96};
+  std::vector<std::shared_ptr<char>> buffers(ids.size());
+  std::vector<int> actual_sizes(ids.size(), 0);
+  graph_table.random_sample_neighbors(
+      0, ids.data(), 10, buffers, actual_sizes, false);
+  ASSERT_EQ(actual_sizes[0], 10 * distributed::Node::id_size);
+  std::set<uint64_t> expected = {48, 247, 111};
+  for (int j = 0; j < 10; j++) {
+    uint64_t id;
+    memcpy(&id,
+           buffers[0].get() + j * distributed::Node::id_size,
+           distributed::Node::id_size);
+    ASSERT_EQ(expected.count(id), 1UL);
+  }
+
+  // the sampler may be rebuilt after loading
+  graph_table.build_sampler(0, "random");
+  ASSERT_FALSE(graph_table.find_csr_shard(0, 96)->has_alias());
+}
@@ -0,0 +1,117 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace distributed = paddle::distributed;
+
+TEST(AliasSampler, Distribution) {
+  distributed::WeightedGraphEdgeBlob edges;
+  std::vector<float> weights = {1, 0, 2, 3, 4};
+  for (size_t i = 0; i < weights.size(); i++) {
+    edges.add_edge(i, weights[i]);
+  }
+  distributed::AliasSampler sampler;
+  sampler.build(&edges);
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  const int draws = 100000;
+  auto res = sampler.sample_k(draws, rng);
+  ASSERT_EQ(res.size(), static_cast<size_t>(draws));
+  std::vector<int> count(weights.size());
+  for (int x : res) {
+    count[x]++;
+  }
+  ASSERT_EQ(count[1], 0);
+  for (size_t i = 0; i < weights.size(); i++) {
+    ASSERT_NEAR(count[i] / static_cast<double>(draws), weights[i] / 10, 0.01);
+  }
+
+  distributed::GraphEdgeBlob empty;
+  sampler.build(&empty);
+  ASSERT_TRUE(sampler.sample_k(10, rng).empty());
+}
+
+TEST(RandomSampler, Distinct) {
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  for (int k : {1, 10, 100}) {
+    std::vector<int> count(200);
+    for (int t = 0; t < 2000; t++) {
+      std::vector<int> res;
+      distributed::sample_k_distinct(200, k, rng.get(), &res);
+      std::set<int> distinct(res.begin(), res.end());
+      ASSERT_EQ(distinct.size(), static_cast<size_t>(k));
+      ASSERT_GE(*distinct.begin(), 0);
+      ASSERT_LT(*distinct.rbegin(), 200);
+      for (int x : res) {
+        count[x]++;
+      }
+    }
+    // every index is sampled with probability k / 200
+    for (int c : count) {
+      ASSERT_NEAR(c / 2000.0, k / 200.0, 0.05);
+    }
+  }
+}
+
+// Samples k neighbors of nodes of degree d many times, with the tree of
+// WeightedSampler, the alias table, and Floyd's algorithm.
+TEST(GraphSampler, SampleBenchmark) {
+  const int degree = 1000;
+  const int node_num = 100;
+  const int rounds = 200;
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  std::uniform_real_distribution<float> distrib(0.1, 10);
+  std::vector<distributed::WeightedGraphEdgeBlob> edges(node_num);
+  for (auto &blob : edges) {
+    for (int j = 0; j < degree; j++) {
+      blob.add_edge(j, distrib(*rng));
+    }
+  }
+  auto bench = [&](const char *name, auto *samplers, int k) {
+    auto start = std::chrono::steady_clock::now();
+    size_t total = 0;
+    for (int r = 0; r < rounds; r++) {
+      for (int i = 0; i < node_num; i++) {
+        total += samplers[i].sample_k(k, rng).size();
+      }
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    std::printf("%s, degree %d, k %d: %.2f M neighbors/s\n",
+                name,
+                degree,
+                k,
+                total / seconds / 1e6);
+  };
+  std::vector<distributed::WeightedSampler> weighted(node_num);
+  std::vector<distributed::AliasSampler> alias(node_num);
+  std::vector<distributed::RandomSampler> random(node_num);
+  for (int i = 0; i < node_num; i++) {
+    weighted[i].build(&edges[i]);
+    alias[i].build(&edges[i]);
+    random[i].build(&edges[i]);
+  }
+  for (int k : {5, 25}) {
+    bench("WeightedSampler", weighted.data(), k);
+    bench("AliasSampler", alias.data(), k);
+    bench("RandomSampler", random.data(), k);
+  }
+}
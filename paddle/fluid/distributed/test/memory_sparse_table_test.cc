@@ -17,13 +17,17 @@ limitations under the License. */
 #include <ThreadPool.h>
 #include <unistd.h>
 
+#include <cstdio>
+#include <functional>
 #include <string>
 #include <thread>  // NOLINT
 
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/sparse_table_snapshot.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/framework/io/fs.h"
 
 namespace paddle {
 namespace distributed {
@@ -152,5 +156,173 @@ TEST(MemorySparseTable, SGD) {
   }
 }
 
+static Table *CreateSnapshotTestTable(bool enable_binary_save) {
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(10);
+  table_config.set_enable_binary_save(enable_binary_save);
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(0);
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  accessor_config->mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+
+  FsClientParameter fs_config;
+  Table *table = new MemorySparseTable();
+  table->SetShard(0, 1);
+  EXPECT_EQ(table->Initialize(table_config, fs_config), 0);
+  return table;
+}
+
+static std::vector<float> PullSnapshotTestTable(
+    Table *table, std::vector<uint64_t> keys, int emb_dim) {
+  std::vector<uint32_t> fres(keys.size(), 1);
+  auto value = PullSparseValue(keys, fres, emb_dim);
+  std::vector<float> values(keys.size() * (emb_dim + 3));
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.pull_context.pull_value = value;
+  table_context.pull_context.values = values.data();
+  table->Pull(table_context);
+  return values;
+}
+
+TEST(MemorySparseTable, BinarySnapshot) {
+  int emb_dim = 8;
+  std::vector<uint64_t> keys;
+  for (uint64_t key = 0; key < 100; ++key) {
+    keys.push_back(key);
+  }
+  std::unique_ptr<Table> table(CreateSnapshotTestTable(true));
+  auto expect_values = PullSnapshotTestTable(table.get(), keys, emb_dim);
+
+  std::string binary_path = "./memory_sparse_table_test_binary";
+  ASSERT_EQ(table->Save(binary_path, "0"), 0);
+  auto file_list = paddle::framework::localfs_list(binary_path + "/000/");
+  ASSERT_EQ(file_list.size(), 10UL);
+  for (auto &file : file_list) {
+    ASSERT_TRUE(IsSparseSnapshotFile(file));
+  }
+
+  std::unique_ptr<Table> binary_table(CreateSnapshotTestTable(false));
+  ASSERT_EQ(binary_table->Load(binary_path, "0"), 0);
+  // the binary snapshot is lossless
+  ASSERT_EQ(PullSnapshotTestTable(binary_table.get(), keys, emb_dim),
+            expect_values);
+
+  // convert the text parts of a checkpoint into snapshot parts
+  std::string text_path = "./memory_sparse_table_test_text";
+  std::string convert_path = "./memory_sparse_table_test_convert";
+  ASSERT_EQ(binary_table->Save(text_path, "0"), 0);
+  paddle::framework::localfs_mkdir(convert_path + "/000/");
+  AfsClient afs_client;
+  auto *accessor = binary_table->ValueAccesor().get();
+  int64_t converted = 0;
+  for (auto &file : paddle::framework::localfs_list(text_path + "/000/")) {
+    ASSERT_FALSE(IsSparseSnapshotFile(file));
+    FsChannelConfig text_config;
+    text_config.path = file;
+    FsChannelConfig snapshot_config;
+    snapshot_config.path = convert_path + "/000/" +
+                           file.substr(file.rfind('/') + 1) +
+                           kSparseSnapshotSuffix;
+    int64_t num = ConvertTextToSparseSnapshot(
+        &afs_client, accessor, text_config, snapshot_config);
+    ASSERT_GE(num, 0);
+    converted += num;
+  }
+  ASSERT_EQ(converted, static_cast<int64_t>(keys.size()));
+
+  std::unique_ptr<Table> convert_table(CreateSnapshotTestTable(false));
+  ASSERT_EQ(convert_table->Load(convert_path, "0"), 0);
+  // text parts keep 6 significant digits only
+  auto convert_values =
+      PullSnapshotTestTable(convert_table.get(), keys, emb_dim);
+  ASSERT_EQ(convert_values.size(), expect_values.size());
+  for (size_t i = 0; i < expect_values.size(); ++i) {
+    ASSERT_NEAR(convert_values[i], expect_values[i], 1e-4);
+  }
+
+  paddle::framework::localfs_remove(binary_path);
+  paddle::framework::localfs_remove(text_path);
+  paddle::framework::localfs_remove(convert_path);
+}
+
+
+// Writes a snapshot of num_keys rows of value_dim floats, the i-th row of
+// length i % value_dim + 1, with the header patched by patch.
+static void WriteTestSnapshot(
+    const std::string &path,
+    uint64_t num_keys,
+    const std::function<void(SparseSnapshotHeader *, uint32_t *)> &patch) {
+  AccessorInfo info = AccessorInfo();
+  info.dim = 4;
+  info.size = 4 * sizeof(float);
+  info.mf_size = 0;
+  SparseSnapshotHeader header;
+  InitSparseSnapshotHeader(info, num_keys, &header);
+  std::vector<uint64_t> keys(num_keys);
+  std::vector<uint32_t> lengths(num_keys);
+  for (uint64_t i = 0; i < num_keys; ++i) {
+    keys[i] = i;
+    lengths[i] = i % 4 + 1;
+  }
+  patch(&header, lengths.data());
+  std::vector<float> values(num_keys * 4, 1.0f);
+  FILE *fp = fopen(path.c_str(), "wb");
+  ASSERT_NE(fp, nullptr);
+  fwrite(&header, sizeof(header), 1, fp);
+  fwrite(keys.data(), sizeof(uint64_t), num_keys, fp);
+  fwrite(lengths.data(), sizeof(uint32_t), num_keys, fp);
+  uint64_t offset = sizeof(header) + num_keys * 12;
+  for (; offset < header.values_offset; ++offset) {
+    fputc(0, fp);
+  }
+  fwrite(values.data(), sizeof(float), values.size(), fp);
+  fclose(fp);
+}
+
+static int64_t ReadTestSnapshot(const std::string &path) {
+  SparseSnapshotReader reader;
+  if (reader.OpenMmap(path) != 0) {
+    return -1;
+  }
+  const uint64_t *keys = nullptr;
+  const uint32_t *lengths = nullptr;
+  const float *values = nullptr;
+  int64_t total = 0;
+  int64_t num = 0;
+  while ((num = reader.ReadBatch(16, &keys, &lengths, &values)) > 0) {
+    total += num;
+  }
+  return num < 0 ? -1 : total;
+}
+
+TEST(SparseSnapshotReader, DamagedFile) {
+  std::string path = "./sparse_snapshot_reader_test.snap";
+  WriteTestSnapshot(path, 100, [](SparseSnapshotHeader *, uint32_t *) {});
+  ASSERT_EQ(ReadTestSnapshot(path), 100);
+
+  // a row longer than value_dim
+  WriteTestSnapshot(path, 100, [](SparseSnapshotHeader *, uint32_t *lengths) {
+    lengths[99] = 5;
+  });
+  ASSERT_EQ(ReadTestSnapshot(path), -1);
+
+  // num_keys larger than the file
+  WriteTestSnapshot(path, 100, [](SparseSnapshotHeader *header, uint32_t *) {
+    header->num_keys = 1UL << 40;
+  });
+  ASSERT_EQ(ReadTestSnapshot(path), -1);
+  WriteTestSnapshot(path, 100, [](SparseSnapshotHeader *header, uint32_t *) {
+    InitSparseSnapshotHeader(AccessorInfo(), 1000, header);
+    header->value_dim = 4;
+  });
+  ASSERT_EQ(ReadTestSnapshot(path), -1);
+  std::remove(path.c_str());
+}
+
 }  // namespace distributed
 }  // namespace paddle
@@ -0,0 +1,82 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/common/push_quant.h"
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+TEST(PushQuant, SparseKeepsLeadingValues) {
+  // slot, show, click, embed_g and 8 embedx_g
+  const size_t update_dim = 12;
+  const size_t quant_dim = 8;
+  std::vector<float> value = {
+      3, 1, 1, 0.5, 0.01, -0.02, 0.03, -0.04, 0.05, -0.06, 0.07, -0.08};
+  for (auto type : {PUSH_QUANT_FP16, PUSH_QUANT_INT8}) {
+    std::vector<char> buffer(SparsePushQuantBytes(type, update_dim, quant_dim));
+    std::vector<float> residual(quant_dim, 0);
+    SparsePushQuant(type,
+                    value.data(),
+                    update_dim,
+                    quant_dim,
+                    residual.data(),
+                    buffer.data());
+    std::vector<float> out(update_dim);
+    SparsePushDequant(type, buffer.data(), update_dim, quant_dim, out.data());
+    for (size_t i = 0; i < 4; ++i) {
+      ASSERT_EQ(out[i], value[i]);
+    }
+    for (size_t i = 4; i < update_dim; ++i) {
+      ASSERT_NEAR(out[i], value[i], 0.08 / 127);
+      ASSERT_NEAR(out[i] + residual[i - 4], value[i], 1e-7);
+    }
+  }
+  // 4 floats, the scale and 8 bytes.
+  ASSERT_EQ(SparsePushQuantBytes(PUSH_QUANT_INT8, update_dim, quant_dim),
+            28UL);
+}
+
+TEST(PushQuant, DenseErrorFeedback) {
+  const size_t num = 1000;
+  const int steps = 100;
+  std::vector<float> grad(num);
+  for (size_t i = 0; i < num; ++i) {
+    grad[i] = std::sin(i) * (i % 7 == 0 ? 1 : 1e-3);
+  }
+  std::vector<float> residual(num, 0);
+  std::vector<float> sum(num, 0);
+  std::vector<float> out(num);
+  std::vector<char> buffer(DensePushQuantBytes(PUSH_QUANT_INT8, num));
+  for (int step = 0; step < steps; ++step) {
+    DensePushQuant(
+        PUSH_QUANT_INT8, grad.data(), num, residual.data(), buffer.data());
+    DensePushDequant(PUSH_QUANT_INT8, buffer.data(), num, out.data());
+    for (size_t i = 0; i < num; ++i) {
+      sum[i] += out[i];
+    }
+  }
+  // The small gradients are lost by a single push, but not by the sum of
+  // the pushes.
+  for (size_t i = 0; i < num; ++i) {
+    ASSERT_NEAR(sum[i], grad[i] * steps, 1.0 / 127);
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
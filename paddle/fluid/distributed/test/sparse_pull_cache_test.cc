@@ -0,0 +1,112 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/sparse_pull_cache.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+TEST(SparsePullCache, Staleness) {
+  SparsePullCache cache(4, 64, 1, 0, 4);
+  std::vector<float> value = {1, 2, 3, 4};
+  std::vector<float> out(4, 0);
+
+  ASSERT_FALSE(cache.Get(7, out.data()));
+  cache.Put(7, value.data(), cache.version());
+  ASSERT_TRUE(cache.Get(7, out.data()));
+  ASSERT_EQ(out, value);
+
+  // One push may be missed, two may not.
+  cache.AdvanceVersion();
+  ASSERT_TRUE(cache.Get(7, out.data()));
+  cache.AdvanceVersion();
+  ASSERT_FALSE(cache.Get(7, out.data()));
+
+  // A value pulled before the pushes does not refresh the entry.
+  cache.Put(7, value.data(), 0);
+  ASSERT_FALSE(cache.Get(7, out.data()));
+  value[0] = 5;
+  cache.Put(7, value.data(), cache.version());
+  ASSERT_TRUE(cache.Get(7, out.data()));
+  ASSERT_EQ(out[0], 5);
+
+  SparsePullCache timed_cache(4, 64, 100, 20, 4);
+  timed_cache.Put(7, value.data(), timed_cache.version());
+  ASSERT_TRUE(timed_cache.Get(7, out.data()));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_FALSE(timed_cache.Get(7, out.data()));
+}
+
+TEST(SparsePullCache, Admission) {
+  // A single shard of 8 keys.
+  SparsePullCache cache(1, 8, 100, 0, 1);
+  float value = 1;
+  float out = 0;
+  for (uint64_t key = 0; key < 8; ++key) {
+    for (int i = 0; i < 5; ++i) {
+      cache.Get(key, &out);
+    }
+    cache.Put(key, &value, cache.version());
+  }
+  ASSERT_EQ(cache.Size(), 8UL);
+
+  // A cold key does not evict the hot ones.
+  cache.Get(100, &out);
+  cache.Put(100, &value, cache.version());
+  ASSERT_FALSE(cache.Get(100, &out));
+  ASSERT_EQ(cache.Size(), 8UL);
+
+  // A key looked up more often than the least recently used one does.
+  for (int i = 0; i < 10; ++i) {
+    cache.Get(200, &out);
+  }
+  cache.Put(200, &value, cache.version());
+  ASSERT_TRUE(cache.Get(200, &out));
+  ASSERT_FALSE(cache.Get(0, &out));
+  ASSERT_EQ(cache.Size(), 8UL);
+}
+
+TEST(SparsePullCache, Concurrent) {
+  SparsePullCache cache(2, 1024, 1000, 0, 16);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&cache, t] {
+      float value[2];
+      for (uint64_t i = 0; i < 10000; ++i) {
+        uint64_t key = (i * 31 + t) % 512;
+        if (cache.Get(key, value)) {
+          EXPECT_EQ(value[0], static_cast<float>(key));
+          EXPECT_EQ(value[1], static_cast<float>(key) * 2);
+        } else {
+          value[0] = key;
+          value[1] = key * 2;
+          cache.Put(key, value, cache.version());
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_LE(cache.Size(), 1024UL);
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -14,9 +14,19 @@
 
 #include "paddle/fluid/eager/backward.h"
 
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+
 #include "paddle/fluid/eager/general_grad.h"
+#include "paddle/phi/core/threadpool.h"
 #include "paddle/phi/kernels/autotune/switch_autotune.h"
 
+DECLARE_int32(eager_backward_num_threads);
+DECLARE_bool(eager_backward_deterministic);
+
 namespace egr {
 
 std::unordered_map<GradNodeBase*, int> getInDegreeMap(
@@ -99,6 +109,307 @@ void DuplicateCheck(const std::vector<paddle::Tensor>& inputs, bool is_input) {
   }
 }
 
+using GradOutputs =
+    paddle::small_vector<std::vector<paddle::Tensor>, kSlotSmallVectorSize>;
+using NodeInputBuffers =
+    std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>;
+
+// Sums the grad outputs of a finished node into the GradTensorHolders of its
+// pending nodes, and calls on_ready for each pending node whose in-degree
+// drops to zero.
+static void PassGradToNextNodes(
+    GradNodeBase* node,
+    GradOutputs* grad_output_tensors,
+    bool create_graph,
+    NodeInputBuffers* node_input_buffers_dict,
+    std::unordered_map<GradNodeBase*, int>* node_in_degree_map,
+    const std::function<void(GradNodeBase*)>& on_ready) {
+  const paddle::small_vector<std::vector<GradSlotMeta>, kSlotSmallVectorSize>&
+      metas = node->OutputMeta();
+  PADDLE_ENFORCE(metas.size() == grad_output_tensors->size() || metas.empty(),
+                 paddle::platform::errors::Fatal(
+                     "Number of edges should be either empty ( for leaf node "
+                     ") or the same as number of output grad tensors, but we "
+                     "got edges size is: %d, grad_output size is: %d",
+                     metas.size(),
+                     grad_output_tensors->size()));
+
+  for (size_t i = 0; i < metas.size(); i++) {
+    for (size_t j = 0; j < metas[i].size(); j++) {
+      const Edge& edge = metas[i][j].GetEdge();
+      if (!edge.IsInitialized()) {
+        continue;
+      }
+      auto edge_rank = edge.GetEdgeRankInfo();
+      // Since we make edge has as same rank as bwd outputs, we indexing them
+      // with the same rank(i, j)
+      auto next_node_shared = edge.GetMutableGradNode();
+      VLOG(3) << "Node: " << node->name() << " addr:" << node
+              << ", Found pending node: " << next_node_shared->name()
+              << " addr: " << next_node_shared.get();
+      // Next node could be nullptr if it is leaf tensor with no
+      // AccumulationNode attached
+      // Or it could also originated from dispensable inputs
+      if (!next_node_shared || !next_node_shared.get() ||
+          (*grad_output_tensors)[i].empty()) {
+        continue;
+      }
+
+      PADDLE_ENFORCE_LT(
+          j,
+          (*grad_output_tensors)[i].size(),
+          paddle::platform::errors::Fatal(
+              "Rank of grad_output_tensors should be less than "
+              "grad_output_tensors[i].size(), which is: %d. This error may "
+              "indicate autoprune or autograd api error. ",
+              grad_output_tensors->size()));
+      paddle::Tensor& grad_output_tensor = (*grad_output_tensors)[i][j];
+
+      if ((!grad_output_tensor.defined() ||
+           !grad_output_tensor.initialized())) {
+        VLOG(7) << "We get grad_output_tensor with slot: " << i
+                << ", rank: " << j << " as uninitialized or undefined tensor";
+      }
+
+      VLOG(7) << "Get Edge and grad_output_tensor with slot: " << i
+              << ", rank: " << j
+              << " 's name is: " << grad_output_tensor.name();
+
+      auto* next_node = next_node_shared.get();
+      if (!node_input_buffers_dict->count(next_node)) {
+        const auto& input_meta = next_node->InputMeta();
+        auto grad_tensor_holder =
+            std::make_unique<GradTensorHolder>(input_meta);
+        VLOG(7) << "Construct GradTensorHolder for grad node: "
+                << next_node->name();
+        (*node_input_buffers_dict)[next_node] = std::move(grad_tensor_holder);
+      }
+
+      VLOG(3) << "Sum or Move grad inputs for edge slot: " << edge_rank.first
+              << ", rank: " << edge_rank.second;
+
+      (*node_input_buffers_dict)[next_node]->add(edge_rank.first,
+                                                 edge_rank.second,
+                                                 grad_output_tensor,
+                                                 create_graph);
+
+      // Update queue
+      (*node_in_degree_map)[next_node]--;
+      VLOG(7) << next_node->name()
+              << " ref_cnt is: " << (*node_in_degree_map)[next_node];
+
+      PADDLE_ENFORCE(
+          (*node_in_degree_map)[next_node] >= 0,
+          paddle::platform::errors::Fatal(
+              "Detected in-degree value smaller than zero. For Node: %s"
+              "Node's in-degree cannot be negative.",
+              next_node->name()));
+
+      if ((*node_in_degree_map)[next_node] == 0) {
+        on_ready(next_node);
+      }
+    }
+  }
+}
+
+// Set in the threads of the backward thread pool, so that a backward started
+// inside a grad node (e.g. by a PyLayer) runs sequentially instead of waiting
+// for the threads it occupies.
+static thread_local bool in_backward_worker = false;
+
+static phi::ThreadPool* GetBackwardThreadPool(int num_threads) {
+  static std::mutex mutex;
+  static std::unordered_map<int, std::unique_ptr<phi::ThreadPool>> pools;
+  std::lock_guard<std::mutex> guard(mutex);
+  auto& pool = pools[num_threads];
+  if (!pool) {
+    VLOG(3) << "Create backward thread pool with " << num_threads
+            << " threads";
+    pool = std::make_unique<phi::ThreadPool>(num_threads);
+  }
+  return pool.get();
+}
+
+// Runs the grad graph with the ready grad nodes dispatched to a thread pool.
+// Only the execution of the nodes happens in the pool: the GradTensorHolders
+// and in-degrees are updated by the calling thread once a node finishes, and
+// GradNodeAccumulation nodes, which write the grad of leaf tensors and fire
+// their reduce hooks, are run by the calling thread as well, so neither needs
+// any locking. When deterministic is set, finished nodes are handled in the
+// order they were dispatched, which makes the order of every gradient sum
+// independent of thread timing.
+static void RunBackwardInThreadPool(
+    const std::deque<GradNodeBase*>& startup_nodes,
+    NodeInputBuffers* node_input_buffers_dict,
+    std::unordered_map<GradNodeBase*, int>* node_in_degree_map,
+    bool retain_graph,
+    bool create_graph,
+    int num_threads,
+    bool deterministic) {
+  struct NodeTask {
+    GradNodeBase* node;
+    std::unique_ptr<GradTensorHolder> input_buffer;
+    GradOutputs grad_output_tensors;
+    std::exception_ptr error;
+  };
+
+  auto run_node = [retain_graph, create_graph](NodeTask* task) {
+    GradNodeBase* node = task->node;
+    VLOG(3) << "Preparing GradNode:" << node->name() << " addr:" << node;
+    paddle::platform::RecordEvent node_record_event(
+        std::string((*node).name()),
+        paddle::platform::TracerEventType::Operator,
+        1);
+    EnforceGradNodeHasInput(node);
+    task->grad_output_tensors = (*node)(task->input_buffer->Buffers(),
+                                        create_graph,
+                                        /*is_new_grad=*/false);
+    if (!retain_graph) {
+      node->ClearTensorWrappers();
+    }
+    task->input_buffer.reset();
+  };
+
+  auto take_input_buffer = [node_input_buffers_dict](GradNodeBase* node) {
+    auto iter = node_input_buffers_dict->find(node);
+    PADDLE_ENFORCE_NE(
+        iter,
+        node_input_buffers_dict->end(),
+        paddle::platform::errors::Fatal(
+            "Unable to find next node in the GradTensorHolder \n"
+            "Trying to run Node without configuring its GradTensorHolder."));
+    std::unique_ptr<GradTensorHolder> input_buffer = std::move(iter->second);
+    node_input_buffers_dict->erase(iter);
+    return input_buffer;
+  };
+
+  std::deque<GradNodeBase*> ready_queue;
+  auto on_ready = [&ready_queue](GradNodeBase* next_node) {
+    if (dynamic_cast<egr::GradNodeAccumulation*>(next_node)) {
+      ready_queue.push_front(next_node);
+    } else {
+      ready_queue.push_back(next_node);
+    }
+  };
+  std::unordered_set<GradNodeBase*> visited;
+  for (GradNodeBase* node : startup_nodes) {
+    if ((*node_in_degree_map)[node] == 0 && visited.insert(node).second) {
+      ready_queue.push_back(node);
+    }
+  }
+
+  // The tracer keeps these flags per thread, the grad nodes running in the
+  // pool should see the ones of the thread calling backward.
+  auto& controller = egr::Controller::Instance();
+  const bool has_grad = controller.HasGrad();
+  const auto amp_level = controller.GetAMPLevel();
+  const std::string amp_dtype = controller.GetCurrentTracer()->GetAmpDtype();
+
+  phi::ThreadPool* pool = GetBackwardThreadPool(num_threads);
+  std::mutex mutex;
+  std::condition_variable cv;
+  // Finished tasks, keyed by the order they were dispatched in.
+  std::map<size_t, std::unique_ptr<NodeTask>> finished_tasks;
+  size_t num_dispatched = 0;
+  size_t num_handled = 0;
+  std::exception_ptr error;
+  // The running nodes refer to the locals here, so an error raised in this
+  // thread is also rethrown only after all of them finish.
+  auto catch_error = [&error](const std::function<void()>& fn) {
+    try {
+      fn();
+    } catch (...) {
+      if (!error) error = std::current_exception();
+    }
+  };
+
+  while (true) {
+    while (!ready_queue.empty() && !error) {
+      GradNodeBase* node = ready_queue.front();
+      if (dynamic_cast<egr::GradNodeAccumulation*>(node)) {
+        ready_queue.pop_front();
+        catch_error([&] {
+          NodeTask task{node, take_input_buffer(node), {}, nullptr};
+          run_node(&task);
+          PassGradToNextNodes(node,
+                              &task.grad_output_tensors,
+                              create_graph,
+                              node_input_buffers_dict,
+                              node_in_degree_map,
+                              on_ready);
+        });
+        continue;
+      }
+      if (num_dispatched - num_handled >= static_cast<size_t>(num_threads)) {
+        break;
+      }
+      ready_queue.pop_front();
+      auto* task = new NodeTask{node, nullptr, {}, nullptr};
+      catch_error([&] { task->input_buffer = take_input_buffer(node); });
+      if (error) {
+        delete task;
+        break;
+      }
+      size_t task_id = num_dispatched++;
+      pool->Run([&, task, task_id]() {
+        auto& tracer = egr::Controller::Instance().GetCurrentTracer();
+        tracer->SetHasGrad(has_grad);
+        tracer->SetAmpLevel(amp_level);
+        tracer->SetAmpDtype(amp_dtype);
+        in_backward_worker = true;
+        try {
+          run_node(task);
+        } catch (...) {
+          task->error = std::current_exception();
+        }
+        in_backward_worker = false;
+        // Notify under the lock, the calling thread may return and destroy
+        // cv as soon as it sees the last task finished.
+        std::lock_guard<std::mutex> guard(mutex);
+        finished_tasks.emplace(task_id, std::unique_ptr<NodeTask>(task));
+        cv.notify_one();
+      });
+    }
+    if (num_handled == num_dispatched) {
+      break;
+    }
+
+    std::unique_ptr<NodeTask> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&] {
+        return deterministic ? finished_tasks.count(num_handled) > 0
+                             : !finished_tasks.empty();
+      });
+      auto iter = deterministic ? finished_tasks.find(num_handled)
+                                : finished_tasks.begin();
+      task = std::move(iter->second);
+      finished_tasks.erase(iter);
+    }
+    ++num_handled;
+
+    if (task->error) {
+      // Keep the first error, and wait for the running nodes to finish
+      // before rethrowing it.
+      if (!error) error = task->error;
+      continue;
+    }
+    if (error) continue;
+    catch_error([&] {
+      PassGradToNextNodes(task->node,
+                          &task->grad_output_tensors,
+                          create_graph,
+                          node_input_buffers_dict,
+                          node_in_degree_map,
+                          on_ready);
+    });
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
 GeneralGrad* GeneralGrad::general_grad_ = new GeneralGrad();
 
 std::vector<paddle::Tensor> RunBackward(
@@ -231,6 +542,28 @@ std::vector<paddle::Tensor> RunBackward(
 
   VLOG(5) << "Startup_ops's size is " << queue.size();
 
+  const int num_threads = FLAGS_eager_backward_num_threads;
+  if (num_threads > 1 && !is_general_grad &&
+      force_sequential_nodes_set.empty() && !in_backward_worker) {
+    VLOG(3) << "Run backward with " << num_threads << " threads";
+    RunBackwardInThreadPool(queue,
+                            &node_input_buffers_dict,
+                            &node_in_degree_map,
+                            retain_graph,
+                            create_graph,
+                            num_threads,
+                            FLAGS_eager_backward_deterministic);
+    queue.clear();
+  }
+
+  auto add_next_node_func = [&queue](GradNodeBase* next_node) {
+    if (dynamic_cast<egr::GradNodeAccumulation*>(next_node)) {
+      queue.push_front(std::move(next_node));
+    } else {
+      queue.push_back(std::move(next_node));
+    }
+  };
+
   /* --- Topological Visit --- */
   // 1. Pop queue
   // 2. Run node
@@ -289,96 +622,13 @@ std::vector<paddle::Tensor> RunBackward(
     node_input_buffers_dict.erase(node_input_buffer_iter);
 
     // Prepare GradTensorHolder for next node
-    const paddle::small_vector<std::vector<GradSlotMeta>, kSlotSmallVectorSize>&
-        metas = node->OutputMeta();
-    PADDLE_ENFORCE(metas.size() == grad_output_tensors.size() || metas.empty(),
-                   paddle::platform::errors::Fatal(
-                       "Number of edges should be either empty ( for leaf node "
-                       ") or the same as number of output grad tensors, but we "
-                       "got edges size is: %d, grad_output size is: %d",
-                       metas.size(),
-                       grad_output_tensors.size()));
-
-    for (size_t i = 0; i < metas.size(); i++) {
-      for (size_t j = 0; j < metas[i].size(); j++) {
-        const Edge& edge = metas[i][j].GetEdge();
-        if (!edge.IsInitialized()) {
-          continue;
-        }
-        auto edge_rank = edge.GetEdgeRankInfo();
-        // Since we make edge has as same rank as bwd outputs, we indexing them
-        // with the same rank(i, j)
-        auto next_node_shared = edge.GetMutableGradNode();
-        VLOG(3) << "Node: " << node->name() << " addr:" << node
-                << ", Found pending node: " << next_node_shared->name()
-                << " addr: " << next_node_shared.get();
-        // Next node could be nullptr if it is leaf tensor with no
-        // AccumulationNode attached
-        // Or it could also originated from dispensable inputs
-        if (!next_node_shared || !next_node_shared.get() ||
-            grad_output_tensors[i].empty()) {
-          continue;
-        }
-
-        PADDLE_ENFORCE_LT(
-            j,
-            grad_output_tensors[i].size(),
-            paddle::platform::errors::Fatal(
-                "Rank of grad_output_tensors should be less than "
-                "grad_output_tensors[i].size(), which is: %d. This error may "
-                "indicate autoprune or autograd api error. ",
-                grad_output_tensors.size()));
-        paddle::Tensor& grad_output_tensor = grad_output_tensors[i][j];
-
-        if ((!grad_output_tensor.defined() ||
-             !grad_output_tensor.initialized())) {
-          VLOG(7) << "We get grad_output_tensor with slot: " << i
-                  << ", rank: " << j << " as uninitialized or undefined tensor";
-        }
-
-        VLOG(7) << "Get Edge and grad_output_tensor with slot: " << i
-                << ", rank: " << j
-                << " 's name is: " << grad_output_tensor.name();
-
-        auto* next_node = next_node_shared.get();
-        if (!node_input_buffers_dict.count(next_node)) {
-          const auto& input_meta = next_node->InputMeta();
-          auto grad_tensor_holder =
-              std::make_unique<GradTensorHolder>(input_meta);
-          VLOG(7) << "Construct GradTensorHolder for grad node: "
-                  << next_node->name();
-          node_input_buffers_dict[next_node] = std::move(grad_tensor_holder);
-        }
-
-        VLOG(3) << "Sum or Move grad inputs for edge slot: " << edge_rank.first
-                << ", rank: " << edge_rank.second;
-
-        node_input_buffers_dict[next_node]->add(edge_rank.first,
-                                                edge_rank.second,
-                                                grad_output_tensor,
-                                                create_graph);
-
-        // Update queue
-        node_in_degree_map[next_node]--;
-        VLOG(7) << next_node->name()
-                << " ref_cnt is: " << node_in_degree_map[next_node];
-
-        PADDLE_ENFORCE(
-            node_in_degree_map[next_node] >= 0,
-            paddle::platform::errors::Fatal(
-                "Detected in-degree value smaller than zero. For Node: %s"
-                "Node's in-degree cannot be negative.",
-                next_node->name()));
-
-        auto add_next_node_func = [&node_in_degree_map,
-                                   &queue](GradNodeBase* next_node) {
-          if (dynamic_cast<egr::GradNodeAccumulation*>(next_node)) {
-            queue.push_front(std::move(next_node));
-          } else {
-            queue.push_back(std::move(next_node));
-          }
-        };
-        if (node_in_degree_map[next_node] == 0) {
+    PassGradToNextNodes(
+        node,
+        &grad_output_tensors,
+        create_graph,
+        &node_input_buffers_dict,
+        &node_in_degree_map,
+        [&](GradNodeBase* next_node) {
           if (force_sequential_nodes_set.count(next_node)) {
             if (force_sequential_nodes_queue.front() == next_node) {
               force_sequential_nodes_queue.pop_front();
@@ -392,14 +642,11 @@ std::vector<paddle::Tensor> RunBackward(
               }
             } else {
               ready_force_sequential_nodes.insert(next_node);
-              continue;
             }
           } else {
             add_next_node_func(next_node);
           }
-        }
-      }
-    }
+        });
   }
 
   VLOG(7) << "Run Backward Final hook size: "
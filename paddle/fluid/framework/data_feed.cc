@@ -21,11 +21,14 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/fleet/ps_gpu_wrapper.h"
 #ifdef _LINUX
+#include <fcntl.h>
 #include <stdio_ext.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #endif
 #include "io/fs.h"
+#include "paddle/fluid/framework/data_feed_text_scanner.h"
 #include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/timer.h"
 
@@ -846,7 +849,7 @@ bool MultiSlotDataFeed::ParseOneInstanceFromPipe(
     int use_slots_num = use_slots_.size();
     instance->resize(use_slots_num);
     const char* str = reader.get();
-    std::string line = std::string(str);
+    const char* end = str + reader.length();
 
     char* endptr = const_cast<char*>(str);
     int pos = 0;
@@ -861,7 +864,7 @@ bool MultiSlotDataFeed::ParseOneInstanceFromPipe(
         ss << "The Origin Input Data:\n";
         ss << "----------------------\n";
 
-        ss << line << "\n";
+        ss << str << "\n";
 
         ss << "\n----------------------\n";
         ss << "Some Possible Errors:\n";
@@ -879,23 +882,22 @@ bool MultiSlotDataFeed::ParseOneInstanceFromPipe(
         (*instance)[idx].Init(all_slots_type_[i]);
         if ((*instance)[idx].GetType()[0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign;
+            endptr = const_cast<char*>(
+                text_scanner::ScanFloat(endptr, end, &feasign));
             (*instance)[idx].AddValue(feasign);
           }
         } else if ((*instance)[idx].GetType()[0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign;
+            endptr = const_cast<char*>(
+                text_scanner::ScanUint64(endptr, end, &feasign));
             (*instance)[idx].AddValue(feasign);
           }
         }
         pos = endptr - str;
       } else {
-        for (int j = 0; j <= num; ++j) {
-          // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
-            pos++;
-          }
-        }
+        pos = text_scanner::SkipTokens(endptr, end, num) - str;
       }
     }
     return true;
@@ -913,6 +915,7 @@ bool MultiSlotDataFeed::ParseOneInstance(std::vector<MultiSlotType>* instance) {
     instance->resize(use_slots_num);
     // parse line
     const char* str = line.c_str();
+    const char* end = str + line.size();
     char* endptr = const_cast<char*>(str);
     int pos = 0;
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
@@ -939,20 +942,22 @@ bool MultiSlotDataFeed::ParseOneInstance(std::vector<MultiSlotType>* instance) {
         (*instance)[idx].Init(all_slots_type_[i]);
         if ((*instance)[idx].GetType()[0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign;
+            endptr = const_cast<char*>(
+                text_scanner::ScanFloat(endptr, end, &feasign));
             (*instance)[idx].AddValue(feasign);
           }
         } else if ((*instance)[idx].GetType()[0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign;
+            endptr = const_cast<char*>(
+                text_scanner::ScanUint64(endptr, end, &feasign));
             (*instance)[idx].AddValue(feasign);
           }
         }
         pos = endptr - str;
       } else {
-        for (int j = 0; j <= num; ++j) {
-          pos = line.find_first_of(' ', pos + 1);
-        }
+        pos = text_scanner::SkipTokens(endptr, end, num) - str;
       }
     }
   } else {
@@ -1132,7 +1137,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
     return false;
   } else {
     const char* str = reader.get();
-    std::string line = std::string(str);
+    const char* end = str + reader.length();
     // VLOG(3) << line;
     char* endptr = const_cast<char*>(str);
     int pos = 0;
@@ -1216,7 +1221,9 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
       if (idx != -1) {
         if (all_slots_type_[i][0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign;
+            endptr = const_cast<char*>(
+                text_scanner::ScanFloat(endptr, end, &feasign));
             // if float feasign is equal to zero, ignore it
             // except when slot is dense
             if (fabs(feasign) < 1e-6 && !use_slots_is_dense_[i]) {
@@ -1228,7 +1235,9 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign;
+            endptr = const_cast<char*>(
+                text_scanner::ScanUint64(endptr, end, &feasign));
             // if uint64 feasign is equal to zero, ignore it
             // except when slot is dense
             if (feasign == 0 && !use_slots_is_dense_[i]) {
@@ -1241,12 +1250,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
         }
         pos = endptr - str;
       } else {
-        for (int j = 0; j <= num; ++j) {
-          // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
-            pos++;
-          }
-        }
+        pos = text_scanner::SkipTokens(endptr, end, num) - str;
       }
     }
     instance->float_feasigns_.shrink_to_fit();
@@ -1266,6 +1270,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
     VLOG(3) << line;
     // parse line
     const char* str = line.c_str();
+    const char* end = str + line.size();
     char* endptr = const_cast<char*>(str);
     int pos = 0;
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
@@ -1291,7 +1296,9 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
       if (idx != -1) {
         if (all_slots_type_[i][0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign;
+            endptr = const_cast<char*>(
+                text_scanner::ScanFloat(endptr, end, &feasign));
             if (fabs(feasign) < 1e-6) {
               continue;
             }
@@ -1301,7 +1308,9 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign;
+            endptr = const_cast<char*>(
+                text_scanner::ScanUint64(endptr, end, &feasign));
             if (feasign == 0) {
               continue;
             }
@@ -1312,9 +1321,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
         }
         pos = endptr - str;
       } else {
-        for (int j = 0; j <= num; ++j) {
-          pos = line.find_first_of(' ', pos + 1);
-        }
+        pos = text_scanner::SkipTokens(endptr, end, num) - str;
       }
     }
     instance->float_feasigns_.shrink_to_fit();
@@ -2147,6 +2154,261 @@ void SlotRecordInMemoryDataFeed::InitGraphTrainResource() {
 }
 #endif
 
+namespace {
+
+size_t SlotRecordBinaryRecordSize(const SlotRecordBinaryHeader& header,
+                                  uint32_t uint64_slot_num,
+                                  uint32_t float_slot_num) {
+  size_t size = header.uint64_num * sizeof(uint64_t) +
+                header.float_num * sizeof(float) +
+                (uint64_slot_num + float_slot_num + 2) * sizeof(uint32_t) +
+                header.ins_id_len;
+  return (size + 7) / 8 * 8;
+}
+
+}  // namespace
+
+SlotRecordBinaryWriter::SlotRecordBinaryWriter(std::shared_ptr<FILE> fp,
+                                               uint32_t uint64_slot_num,
+                                               uint32_t float_slot_num)
+    : fp_(fp),
+      uint64_slot_num_(uint64_slot_num),
+      float_slot_num_(float_slot_num) {
+  SlotRecordBinaryFileHeader header;
+  header.magic = SlotRecordBinaryFileHeader::kMagic;
+  header.version = SlotRecordBinaryFileHeader::kVersion;
+  header.uint64_slot_num = uint64_slot_num;
+  header.float_slot_num = float_slot_num;
+  header.reserved = 0;
+  PADDLE_ENFORCE_EQ(
+      fwrite(&header, sizeof(header), 1, fp_.get()),
+      1,
+      platform::errors::Unavailable("Failed to write SlotRecord file header."));
+}
+
+void SlotRecordBinaryWriter::Write(const SlotRecordObject& rec) {
+  auto& uint64_feasigns = rec.slot_uint64_feasigns_;
+  auto& float_feasigns = rec.slot_float_feasigns_;
+  PADDLE_ENFORCE_EQ(
+      uint64_feasigns.slot_offsets.size() == uint64_slot_num_ + 1 &&
+          float_feasigns.slot_offsets.size() == float_slot_num_ + 1,
+      true,
+      platform::errors::InvalidArgument(
+          "The SlotRecord has %d uint64 and %d float slot offsets, but the "
+          "file has %d uint64 and %d float slots.",
+          uint64_feasigns.slot_offsets.size(),
+          float_feasigns.slot_offsets.size(),
+          uint64_slot_num_,
+          float_slot_num_));
+  SlotRecordBinaryHeader header;
+  header.search_id = rec.search_id;
+  header.rank = rec.rank;
+  header.cmatch = rec.cmatch;
+  header.uint64_num = uint64_feasigns.slot_values.size();
+  header.float_num = float_feasigns.slot_values.size();
+  header.ins_id_len = rec.ins_id_.size();
+  header.size =
+      SlotRecordBinaryRecordSize(header, uint64_slot_num_, float_slot_num_);
+
+  buffer_.assign(sizeof(header) + header.size, 0);
+  char* ptr = buffer_.data();
+  auto append = [&ptr](const void* data, size_t len) {
+    if (len > 0) {
+      memcpy(ptr, data, len);
+      ptr += len;
+    }
+  };
+  append(&header, sizeof(header));
+  append(uint64_feasigns.slot_values.data(),
+         header.uint64_num * sizeof(uint64_t));
+  append(float_feasigns.slot_values.data(), header.float_num * sizeof(float));
+  append(uint64_feasigns.slot_offsets.data(),
+         (uint64_slot_num_ + 1) * sizeof(uint32_t));
+  append(float_feasigns.slot_offsets.data(),
+         (float_slot_num_ + 1) * sizeof(uint32_t));
+  append(rec.ins_id_.data(), header.ins_id_len);
+  PADDLE_ENFORCE_EQ(
+      fwrite(buffer_.data(), buffer_.size(), 1, fp_.get()),
+      1,
+      platform::errors::Unavailable("Failed to write SlotRecord."));
+}
+
+bool SlotRecordBinaryReader::IsBinaryFile(const std::string& path) {
+#ifdef _LINUX
+  uint64_t magic = 0;
+  if (fs_select_internal(path) != 0) {
+    int err_no = 0;
+    auto fp = fs_open_read(path, &err_no, "");
+    return fp != nullptr &&
+           fread(&magic, sizeof(magic), 1, fp.get()) == 1 &&
+           magic == SlotRecordBinaryFileHeader::kMagic;
+  }
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  bool is_binary = read(fd, &magic, sizeof(magic)) == sizeof(magic) &&
+                   magic == SlotRecordBinaryFileHeader::kMagic;
+  close(fd);
+  return is_binary;
+#else
+  return false;
+#endif
+}
+
+SlotRecordBinaryReader::SlotRecordBinaryReader(const std::string& path,
+                                               uint32_t uint64_slot_num,
+                                               uint32_t float_slot_num)
+    : path_(path),
+      uint64_slot_num_(uint64_slot_num),
+      float_slot_num_(float_slot_num) {
+#ifdef _LINUX
+  if (fs_select_internal(path) != 0) {
+    ReadRemoteFile();
+  } else {
+    MapLocalFile();
+  }
+  SlotRecordBinaryFileHeader header;
+  if (size_ < sizeof(header)) {
+    PADDLE_THROW(platform::errors::InvalidArgument(
+        "SlotRecord file %s is truncated.", path));
+  }
+  memcpy(&header, data_, sizeof(header));
+  PADDLE_ENFORCE_EQ(
+      header.magic == SlotRecordBinaryFileHeader::kMagic &&
+          header.version == SlotRecordBinaryFileHeader::kVersion,
+      true,
+      platform::errors::InvalidArgument(
+          "%s is not a SlotRecord file of version %d.",
+          path,
+          SlotRecordBinaryFileHeader::kVersion));
+  PADDLE_ENFORCE_EQ(
+      header.uint64_slot_num == uint64_slot_num &&
+          header.float_slot_num == float_slot_num,
+      true,
+      platform::errors::InvalidArgument(
+          "SlotRecord file %s has %d uint64 and %d float slots, but the data "
+          "feed uses %d uint64 and %d float slots. Please convert it again "
+          "with the used slots of the data feed.",
+          path,
+          header.uint64_slot_num,
+          header.float_slot_num,
+          uint64_slot_num,
+          float_slot_num));
+  pos_ = sizeof(header);
+#else
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "SlotRecordBinaryReader is only supported on Linux."));
+#endif
+}
+
+SlotRecordBinaryReader::~SlotRecordBinaryReader() {
+#ifdef _LINUX
+  if (mapped_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+#endif
+}
+
+void SlotRecordBinaryReader::MapLocalFile() {
+#ifdef _LINUX
+  int fd = open(path_.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_GE(fd,
+                    0,
+                    platform::errors::Unavailable(
+                        "Failed to open SlotRecord file %s.", path_));
+  struct stat st;
+  fstat(fd, &st);
+  size_ = st.st_size;
+  if (size_ == 0) {
+    close(fd);
+    return;
+  }
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  PADDLE_ENFORCE_NE(data,
+                    MAP_FAILED,
+                    platform::errors::Unavailable(
+                        "Failed to mmap SlotRecord file %s.", path_));
+  madvise(data, size_, MADV_SEQUENTIAL);
+  data_ = static_cast<const char*>(data);
+  mapped_ = true;
+#endif
+}
+
+void SlotRecordBinaryReader::ReadRemoteFile() {
+  int err_no = 0;
+  auto fp = fs_open_read(path_, &err_no, "");
+  PADDLE_ENFORCE_NOT_NULL(
+      fp,
+      platform::errors::Unavailable("Failed to open SlotRecord file %s.",
+                                    path_));
+  const size_t kReadBytes = 1 << 20;
+  size_t read_bytes = 0;
+  do {
+    buffer_.resize(size_ + kReadBytes);
+    read_bytes = fread(buffer_.data() + size_, 1, kReadBytes, fp.get());
+    size_ += read_bytes;
+  } while (read_bytes == kReadBytes);
+  PADDLE_ENFORCE_EQ(
+      ferror(fp.get()) == 0 && err_no == 0,
+      true,
+      platform::errors::Unavailable("Failed to read SlotRecord file %s.",
+                                    path_));
+  buffer_.resize(size_);
+  data_ = buffer_.data();
+}
+
+bool SlotRecordBinaryReader::Next(SlotRecord rec) {
+  if (pos_ >= size_) {
+    return false;
+  }
+  SlotRecordBinaryHeader header;
+  PADDLE_ENFORCE_GE(size_ - pos_,
+                    sizeof(header),
+                    platform::errors::InvalidArgument(
+                        "SlotRecord file %s is truncated.", path_));
+  memcpy(&header, data_ + pos_, sizeof(header));
+  pos_ += sizeof(header);
+  PADDLE_ENFORCE_EQ(
+      header.size <= size_ - pos_ &&
+          header.size == SlotRecordBinaryRecordSize(
+                             header, uint64_slot_num_, float_slot_num_),
+      true,
+      platform::errors::InvalidArgument(
+          "SlotRecord file %s is truncated or corrupted.", path_));
+  const char* ptr = data_ + pos_;
+  pos_ += header.size;
+
+  auto& uint64_feasigns = rec->slot_uint64_feasigns_;
+  auto& float_feasigns = rec->slot_float_feasigns_;
+  rec->search_id = header.search_id;
+  rec->rank = header.rank;
+  rec->cmatch = header.cmatch;
+  auto* uint64_values = reinterpret_cast<const uint64_t*>(ptr);
+  uint64_feasigns.slot_values.assign(uint64_values,
+                                     uint64_values + header.uint64_num);
+  ptr += header.uint64_num * sizeof(uint64_t);
+  auto* float_values = reinterpret_cast<const float*>(ptr);
+  float_feasigns.slot_values.assign(float_values,
+                                    float_values + header.float_num);
+  ptr += header.float_num * sizeof(float);
+  auto* offsets = reinterpret_cast<const uint32_t*>(ptr);
+  uint64_feasigns.slot_offsets.assign(offsets,
+                                      offsets + uint64_slot_num_ + 1);
+  offsets += uint64_slot_num_ + 1;
+  float_feasigns.slot_offsets.assign(offsets, offsets + float_slot_num_ + 1);
+  ptr = reinterpret_cast<const char*>(offsets + float_slot_num_ + 1);
+  rec->ins_id_.assign(ptr, header.ins_id_len);
+  PADDLE_ENFORCE_EQ(
+      uint64_feasigns.slot_offsets.back() == header.uint64_num &&
+          float_feasigns.slot_offsets.back() == header.float_num,
+      true,
+      platform::errors::InvalidArgument(
+          "SlotRecord file %s is corrupted.", path_));
+  return true;
+}
+
 void SlotRecordInMemoryDataFeed::LoadIntoMemory() {
   VLOG(3) << "SlotRecord LoadIntoMemory() begin, thread_id=" << thread_id_;
   if (!so_parser_name_.empty()) {
@@ -2342,6 +2604,10 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand(void) {
   while (this->PickOneFile(&filename)) {
     VLOG(3) << "PickOneFile, filename=" << filename
             << ", thread_id=" << thread_id_;
+    if (SlotRecordBinaryReader::IsBinaryFile(filename)) {
+      LoadIntoMemoryByBinary(filename);
+      continue;
+    }
     int lines = 0;
     std::vector<SlotRecord> record_vec;
     platform::Timer timeline;
@@ -2398,16 +2664,122 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand(void) {
 #endif
 }
 
-static void parser_log_key(const std::string& log_key,
+void SlotRecordInMemoryDataFeed::LoadIntoMemoryByBinary(
+    const std::string& filename) {
+#ifdef _LINUX
+  platform::Timer timeline;
+  timeline.Start();
+  SlotRecordBinaryReader reader(
+      filename, uint64_use_slot_size_, float_use_slot_size_);
+  bool sample = std::abs(sample_rate_ - 1.0f) >= 1e-5f;
+  std::default_random_engine random_engine{std::random_device()()};
+  std::uniform_real_distribution<float> uniform_distribution(0.0f, 1.0f);
+
+  std::vector<SlotRecord> record_vec;
+  SlotRecordPool().get(&record_vec, OBJPOOL_BLOCK_SIZE);
+  int offset = 0;
+  int records = 0;
+  while (reader.Next(record_vec[offset])) {
+    ++records;
+    // a record which is not sampled is overwritten by the next one
+    if (sample && uniform_distribution(random_engine) >= sample_rate_) {
+      continue;
+    }
+    if (++offset >= OBJPOOL_BLOCK_SIZE) {
+      input_channel_->Write(std::move(record_vec));
+      record_vec.clear();
+      SlotRecordPool().get(&record_vec, OBJPOOL_BLOCK_SIZE);
+      offset = 0;
+    }
+  }
+  if (offset > 0) {
+    input_channel_->WriteMove(offset, &record_vec[0]);
+    if (offset < OBJPOOL_BLOCK_SIZE) {
+      SlotRecordPool().put(&record_vec[offset], (OBJPOOL_BLOCK_SIZE - offset));
+    }
+  } else {
+    SlotRecordPool().put(&record_vec);
+  }
+  timeline.Pause();
+  VLOG(3) << "LoadIntoMemoryByBinary() read all records, file=" << filename
+          << ", records=" << records << ", cost time=" << timeline.ElapsedSec()
+          << " seconds, thread_id=" << thread_id_
+          << ", filesize=" << reader.file_size() / 1024.0 / 1024.0 << "MB";
+#endif
+}
+
+void SlotRecordInMemoryDataFeed::ConvertToBinary(
+    const std::string& output_dir) {
+#ifdef _LINUX
+  std::string filename;
+  BufferedLineFileReader line_reader;
+  std::vector<SlotRecord> record_vec;
+  SlotRecordPool().get(&record_vec, 1);
+  SlotRecord rec = record_vec[0];
+
+  while (this->PickOneFile(&filename)) {
+    std::string output =
+        output_dir + "/" + filename.substr(filename.find_last_of('/') + 1);
+    VLOG(3) << "ConvertToBinary() begin, filename=" << filename
+            << ", output=" << output << ", thread_id=" << thread_id_;
+    platform::Timer timeline;
+    timeline.Start();
+    int err_no = 0;
+    this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_, true);
+    PADDLE_ENFORCE_NOT_NULL(
+        this->fp_,
+        platform::errors::Unavailable("Failed to open file %s.", filename));
+    __fsetlocking(&*(this->fp_), FSETLOCKING_BYCALLER);
+    auto output_fp = fs_open_write(output, &err_no, "");
+    PADDLE_ENFORCE_NOT_NULL(
+        output_fp,
+        platform::errors::Unavailable("Failed to open file %s.", output));
+    SlotRecordBinaryWriter writer(
+        output_fp, uint64_use_slot_size_, float_use_slot_size_);
+
+    int records = 0;
+    int lines = line_reader.read_file(
+        this->fp_.get(),
+        [this, &rec, &writer, &records, &filename](const std::string& line) {
+          rec->reset();
+          if (!ParseOneInstance(line, &rec)) {
+            LOG(WARNING) << "read file:[" << filename << "] item error, line:["
+                         << line << "]";
+            return false;
+          }
+          writer.Write(*rec);
+          ++records;
+          return true;
+        },
+        0);
+    PADDLE_ENFORCE_EQ(
+        line_reader.is_error(),
+        false,
+        platform::errors::InvalidArgument(
+            "Too many error lines in file %s, it is not converted.",
+            filename));
+    timeline.Pause();
+    VLOG(3) << "ConvertToBinary() end, filename=" << filename
+            << ", lines=" << lines << ", records=" << records
+            << ", cost time=" << timeline.ElapsedSec() << " seconds";
+  }
+  SlotRecordPool().put(&record_vec);
+#endif
+}
+
+static void parser_log_key(const char* log_key,
+                           size_t len,
                            uint64_t* search_id,
                            uint32_t* cmatch,
                            uint32_t* rank) {
-  std::string searchid_str = log_key.substr(16, 16);
-  *search_id = static_cast<uint64_t>(strtoull(searchid_str.c_str(), NULL, 16));
-  std::string cmatch_str = log_key.substr(11, 3);
-  *cmatch = static_cast<uint32_t>(strtoul(cmatch_str.c_str(), NULL, 16));
-  std::string rank_str = log_key.substr(14, 2);
-  *rank = static_cast<uint32_t>(strtoul(rank_str.c_str(), NULL, 16));
+  auto parse_hex = [log_key, len](size_t pos, size_t num) -> uint64_t {
+    return pos < len ? text_scanner::ParseHex(log_key + pos,
+                                              std::min(num, len - pos))
+                     : 0;
+  };
+  *search_id = parse_hex(16, 16);
+  *cmatch = static_cast<uint32_t>(parse_hex(11, 3));
+  *rank = static_cast<uint32_t>(parse_hex(14, 2));
 }
 
 bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
@@ -2415,14 +2787,10 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
   SlotRecord& rec = (*ins);
   // parse line
   const char* str = line.c_str();
+  const char* end = str + line.size();
   char* endptr = const_cast<char*>(str);
   int pos = 0;
 
-  thread_local std::vector<std::vector<float>> slot_float_feasigns;
-  thread_local std::vector<std::vector<uint64_t>> slot_uint64_feasigns;
-  slot_float_feasigns.resize(float_use_slot_size_);
-  slot_uint64_feasigns.resize(uint64_use_slot_size_);
-
   if (parse_ins_id_) {
     int num = strtol(&str[pos], &endptr, 10);
     CHECK(num == 1);  // NOLINT
@@ -2431,7 +2799,7 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
     while (str[pos + len] != ' ') {
       ++len;
     }
-    rec->ins_id_ = std::string(str + pos, len);
+    rec->ins_id_.assign(str + pos, len);
     pos += len + 1;
   }
   if (parse_logkey_) {
@@ -2443,69 +2811,66 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
       ++len;
     }
     // parse_logkey
-    std::string log_key = std::string(str + pos, len);
-    uint64_t search_id;
-    uint32_t cmatch;
-    uint32_t rank;
-    parser_log_key(log_key, &search_id, &cmatch, &rank);
-
-    rec->ins_id_ = log_key;
-    rec->search_id = search_id;
-    rec->cmatch = cmatch;
-    rec->rank = rank;
+    rec->ins_id_.assign(str + pos, len);
+    parser_log_key(
+        str + pos, len, &rec->search_id, &rec->cmatch, &rec->rank);
     pos += len + 1;
   }
 
-  int float_total_slot_num = 0;
-  int uint64_total_slot_num = 0;
+  // The slots are parsed straight into the feasigns of the record, whose
+  // buffers are kept by SlotRecordPool, in the order of slot_value_idx.
+  auto& float_feasigns = rec->slot_float_feasigns_;
+  auto& uint64_feasigns = rec->slot_uint64_feasigns_;
+  float_feasigns.slot_values.clear();
+  float_feasigns.slot_offsets.resize(float_use_slot_size_ + 1);
+  uint64_feasigns.slot_values.clear();
+  uint64_feasigns.slot_offsets.resize(uint64_use_slot_size_ + 1);
 
+  const char* p = str + pos;
   for (size_t i = 0; i < all_slots_info_.size(); ++i) {
     auto& info = all_slots_info_[i];
-    int num = strtol(&str[pos], &endptr, 10);
+    int num = strtol(p, &endptr, 10);
     PADDLE_ENFORCE(num,
                    "The number of ids can not be zero, you need padding "
                    "it in data generator; or if there is something wrong with "
                    "the data, please check if the data contains unresolvable "
                    "characters.\nplease check this error line: %s",
                    str);
+    p = endptr;
     if (info.used_idx != -1) {
       if (info.type[0] == 'f') {  // float
-        auto& slot_fea = slot_float_feasigns[info.slot_value_idx];
-        slot_fea.clear();
+        auto& values = float_feasigns.slot_values;
+        float_feasigns.slot_offsets[info.slot_value_idx] =
+            static_cast<uint32_t>(values.size());
+        bool dense = used_slots_info_[info.used_idx].dense;
         for (int j = 0; j < num; ++j) {
-          float feasign = strtof(endptr, &endptr);
-          if (fabs(feasign) < 1e-6 && !used_slots_info_[info.used_idx].dense) {
+          float feasign;
+          p = text_scanner::ScanFloat(p, end, &feasign);
+          if (fabs(feasign) < 1e-6 && !dense) {
             continue;
           }
-          slot_fea.push_back(feasign);
-          ++float_total_slot_num;
+          values.push_back(feasign);
         }
       } else if (info.type[0] == 'u') {  // uint64
-        auto& slot_fea = slot_uint64_feasigns[info.slot_value_idx];
-        slot_fea.clear();
+        auto& values = uint64_feasigns.slot_values;
+        uint64_feasigns.slot_offsets[info.slot_value_idx] =
+            static_cast<uint32_t>(values.size());
         for (int j = 0; j < num; ++j) {
-          uint64_t feasign =
-              static_cast<uint64_t>(strtoull(endptr, &endptr, 10));
-          slot_fea.push_back(feasign);
-          ++uint64_total_slot_num;
+          uint64_t feasign;
+          p = text_scanner::ScanUint64(p, end, &feasign);
+          values.push_back(feasign);
         }
       }
-      pos = endptr - str;
     } else {
-      for (int j = 0; j <= num; ++j) {
-        // pos = line.find_first_of(' ', pos + 1);
-        while (line[pos + 1] != ' ') {
-          pos++;
-        }
-      }
+      p = text_scanner::SkipTokens(p, end, num);
     }
   }
-  rec->slot_float_feasigns_.add_slot_feasigns(slot_float_feasigns,
-                                              float_total_slot_num);
-  rec->slot_uint64_feasigns_.add_slot_feasigns(slot_uint64_feasigns,
-                                               uint64_total_slot_num);
+  float_feasigns.slot_offsets[float_use_slot_size_] =
+      static_cast<uint32_t>(float_feasigns.slot_values.size());
+  uint64_feasigns.slot_offsets[uint64_use_slot_size_] =
+      static_cast<uint32_t>(uint64_feasigns.slot_values.size());
 
-  return (uint64_total_slot_num > 0);
+  return !uint64_feasigns.slot_values.empty();
 }
 
 void SlotRecordInMemoryDataFeed::AssignFeedVar(const Scope& scope) {
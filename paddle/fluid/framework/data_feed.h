@@ -378,6 +378,80 @@ inline SlotObjPool& SlotRecordPool() {
   static SlotObjPool pool;
   return pool;
 }
+
+// Binary SlotRecord files, written by SlotRecordInMemoryDataFeed::
+// ConvertToBinary so that the later passes load them without parsing.
+// A file is a SlotRecordBinaryFileHeader followed by the records. A record is
+// a SlotRecordBinaryHeader followed by its uint64 feasigns, float feasigns,
+// uint64 slot offsets, float slot offsets and ins_id, padded to 8 bytes. The
+// layout is the one of the host, and the slots are the used slots of the
+// feed which wrote the file.
+struct SlotRecordBinaryFileHeader {
+  static constexpr uint64_t kMagic = 0x314345524c534450ULL;  // "PDSLREC1"
+  static constexpr uint32_t kVersion = 1;
+  uint64_t magic;
+  uint32_t version;
+  uint32_t uint64_slot_num;
+  uint32_t float_slot_num;
+  uint32_t reserved;
+};
+struct SlotRecordBinaryHeader {
+  uint64_t search_id;
+  uint32_t rank;
+  uint32_t cmatch;
+  uint32_t uint64_num;
+  uint32_t float_num;
+  uint32_t ins_id_len;
+  // bytes of the record after this header
+  uint32_t size;
+};
+
+class SlotRecordBinaryWriter {
+ public:
+  SlotRecordBinaryWriter(std::shared_ptr<FILE> fp,
+                         uint32_t uint64_slot_num,
+                         uint32_t float_slot_num);
+  void Write(const SlotRecordObject& rec);
+
+ private:
+  std::shared_ptr<FILE> fp_;
+  uint32_t uint64_slot_num_;
+  uint32_t float_slot_num_;
+  std::vector<char> buffer_;
+};
+
+// Maps a local binary SlotRecord file into memory, or reads a file of HDFS or
+// AFS into a buffer, and copies its records into the buffers of pooled
+// SlotRecords, which keep their capacity.
+class SlotRecordBinaryReader {
+ public:
+  // Whether path is a file starting with the magic of the format.
+  static bool IsBinaryFile(const std::string& path);
+
+  SlotRecordBinaryReader(const std::string& path,
+                         uint32_t uint64_slot_num,
+                         uint32_t float_slot_num);
+  ~SlotRecordBinaryReader();
+
+  // Returns false at the end of the file.
+  bool Next(SlotRecord rec);
+  size_t file_size() const { return size_; }
+
+ private:
+  void MapLocalFile();
+  void ReadRemoteFile();
+
+  std::string path_;
+  uint32_t uint64_slot_num_;
+  uint32_t float_slot_num_;
+  // the file is either mapped or read into buffer_
+  bool mapped_ = false;
+  std::vector<char> buffer_;
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  size_t pos_ = 0;
+};
+
 struct PvInstanceObject {
   std::vector<Record*> ads;
   void merge_instance(Record* ins) { ads.push_back(ins); }
@@ -1271,6 +1345,13 @@ class DataFeed {
         "This function(DumpWalkPath) is not implemented."));
   }
 
+  // Converts the files picked from the filelist into binary files of the
+  // same names under output_dir, which LoadIntoMemory reads without parsing.
+  virtual void ConvertToBinary(const std::string& output_dir) {
+    PADDLE_THROW(platform::errors::Unimplemented(
+        "This function(ConvertToBinary) is not implemented."));
+  }
+
  protected:
   // The following three functions are used to check if it is executed in this
   // order:
@@ -1824,6 +1905,7 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   void Init(const DataFeedDesc& data_feed_desc) override;
   void LoadIntoMemory() override;
   void ExpandSlotRecord(SlotRecord* ins);
+  void ConvertToBinary(const std::string& output_dir) override;
 
  protected:
   bool Start() override;
@@ -1840,6 +1922,7 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   virtual void LoadIntoMemoryByLib(void);
   virtual void LoadIntoMemoryByLine(void);
   virtual void LoadIntoMemoryByFile(void);
+  virtual void LoadIntoMemoryByBinary(const std::string& filename);
   void SetInputChannel(void* channel) override {
     input_channel_ = static_cast<ChannelObject<SlotRecord>*>(channel);
   }
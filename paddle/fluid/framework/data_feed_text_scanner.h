@@ -0,0 +1,171 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace paddle {
+namespace framework {
+namespace text_scanner {
+
+/*
+ * Number scanner of the MultiSlot text format, a line of
+ * "<num> <feasign> ... <num> <feasign> ...".
+ *
+ * ScanUint64 and ScanFloat return the same values and end pointers as
+ * strtoull and strtof in the C locale. They take the common inputs, plain
+ * decimals, without calling into libc: the digits of an uint64 are
+ * converted 8 at a time in a 64-bit register (SWAR), and a float whose
+ * digits fit in 24 bits and which has at most 10 decimals is one exact
+ * division. Everything else, like exponents, hex or too many digits, falls
+ * back to strtoull or strtof, so the line has to be null terminated at end.
+ */
+
+inline bool IsSpace(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline bool IsDigit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+inline const char* SkipSpaces(const char* p, const char* end) {
+  while (p < end && IsSpace(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+// Skips num tokens separated by spaces, and returns the end of the last one.
+inline const char* SkipTokens(const char* p, const char* end, int num) {
+  for (int i = 0; i < num && p < end; ++i) {
+    p = SkipSpaces(p, end);
+    auto* space = static_cast<const char*>(memchr(p, ' ', end - p));
+    p = space == nullptr ? end : space;
+  }
+  return p;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+inline bool IsEightDigits(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+          (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+         0x3333333333333333ULL;
+}
+
+inline uint64_t ParseEightDigits(const char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  v = (v & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+  v = (v & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+  return (v & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32;
+}
+#else
+inline bool IsEightDigits(const char* p) { return false; }
+inline uint64_t ParseEightDigits(const char* p) { return 0; }
+#endif
+
+inline bool IsTokenEnd(const char* p, const char* end) {
+  return p == end || IsSpace(*p) || *p == '\0';
+}
+
+inline const char* ScanUint64(const char* p, const char* end, uint64_t* out) {
+  const char* begin = SkipSpaces(p, end);
+  const char* q = begin;
+  uint64_t value = 0;
+  while (end - q >= 8 && q - begin <= 8 && IsEightDigits(q)) {
+    value = value * 100000000 + ParseEightDigits(q);
+    q += 8;
+  }
+  while (q < end && q - begin < 19 && IsDigit(*q)) {
+    value = value * 10 + (*q - '0');
+    ++q;
+  }
+  // The 20th digit may overflow.
+  if (q < end && IsDigit(*q) && value <= (UINT64_MAX - (*q - '0')) / 10) {
+    value = value * 10 + (*q - '0');
+    ++q;
+  }
+  if (q == begin || !IsTokenEnd(q, end)) {
+    char* endptr = nullptr;
+    *out = static_cast<uint64_t>(strtoull(p, &endptr, 10));
+    return endptr;
+  }
+  *out = value;
+  return q;
+}
+
+inline const char* ScanFloat(const char* p, const char* end, float* out) {
+  static const float kPow10[] = {
+      1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+  const char* q = SkipSpaces(p, end);
+  bool negative = false;
+  if (q < end && (*q == '-' || *q == '+')) {
+    negative = *q == '-';
+    ++q;
+  }
+  const char* digits = q;
+  uint64_t mantissa = 0;
+  int decimals = 0;
+  while (q < end && q - digits < 19 && IsDigit(*q)) {
+    mantissa = mantissa * 10 + (*q - '0');
+    ++q;
+  }
+  bool has_digits = q > digits;
+  if (q < end && *q == '.') {
+    const char* fraction = ++q;
+    while (q < end && q - digits < 20 && IsDigit(*q)) {
+      mantissa = mantissa * 10 + (*q - '0');
+      ++q;
+    }
+    decimals = static_cast<int>(q - fraction);
+    has_digits = has_digits || decimals > 0;
+  }
+  if (!has_digits || !IsTokenEnd(q, end) || mantissa > (1ULL << 24) ||
+      decimals > 10) {
+    char* endptr = nullptr;
+    *out = strtof(p, &endptr);
+    return endptr;
+  }
+  float value = static_cast<float>(mantissa) / kPow10[decimals];
+  *out = negative ? -value : value;
+  return q;
+}
+
+// Parses len hex digits, like the fields of a log key.
+inline uint64_t ParseHex(const char* p, size_t len) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < len; ++i) {
+    char c = p[i];
+    uint64_t digit = 0;
+    if (IsDigit(c)) {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      break;
+    }
+    value = value * 16 + digit;
+  }
+  return value;
+}
+
+}  // namespace text_scanner
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,192 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/data_feed_text_scanner.h"
+
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+using text_scanner::ScanFloat;
+using text_scanner::ScanUint64;
+using text_scanner::SkipTokens;
+
+TEST(DataFeedTextScanner, SameAsLibc) {
+  std::vector<std::string> tokens = {"0",
+                                     "7",
+                                     "12345678",
+                                     "123456789",
+                                     "18446744073709551615",
+                                     "18446744073709551616",
+                                     "99999999999999999999999",
+                                     "0.5",
+                                     "-0.25",
+                                     "+3.75",
+                                     "16777216",
+                                     "16777217",
+                                     "0.0000000001",
+                                     "0.00000000001",
+                                     "1e-3",
+                                     "2.5E2",
+                                     "0x1f",
+                                     "-12",
+                                     ".5",
+                                     "5.",
+                                     "-0",
+                                     "nan",
+                                     "inf"};
+  std::mt19937_64 rng(0);
+  for (int i = 0; i < 10000; ++i) {
+    tokens.push_back(std::to_string(rng()));
+    tokens.push_back(std::to_string(rng() % 100000000));
+    std::ostringstream os;
+    os.precision(1 + rng() % 9);
+    os << std::fixed
+       << std::uniform_real_distribution<float>(-1000, 1000)(rng);
+    tokens.push_back(os.str());
+  }
+  for (auto& token : tokens) {
+    std::string line = "  " + token + " 1";
+    const char* begin = line.c_str();
+    const char* end = begin + line.size();
+
+    char* expected_end = nullptr;
+    uint64_t expected_uint64 = strtoull(begin, &expected_end, 10);
+    uint64_t uint64_value = 0;
+    ASSERT_EQ(ScanUint64(begin, end, &uint64_value), expected_end) << token;
+    ASSERT_EQ(uint64_value, expected_uint64) << token;
+
+    float expected_float = strtof(begin, &expected_end);
+    float float_value = 0;
+    ASSERT_EQ(ScanFloat(begin, end, &float_value), expected_end) << token;
+    if (std::isnan(expected_float)) {
+      ASSERT_TRUE(std::isnan(float_value)) << token;
+    } else {
+      ASSERT_EQ(float_value, expected_float) << token;
+      ASSERT_EQ(std::signbit(float_value), std::signbit(expected_float))
+          << token;
+    }
+  }
+}
+
+TEST(DataFeedTextScanner, SkipTokens) {
+  std::string line = "3 1 22 333 2 4 5";
+  const char* begin = line.c_str();
+  const char* end = begin + line.size();
+  const char* p = SkipTokens(begin + 1, end, 3);
+  ASSERT_EQ(p - begin, 10);
+  uint64_t num = 0;
+  p = ScanUint64(p, end, &num);
+  ASSERT_EQ(num, 2UL);
+  ASSERT_EQ(SkipTokens(p, end, 2), end);
+}
+
+// Parses synthetic MultiSlot files the way the data feeds do, with libc and
+// with the scanner, into buffers reused across instances.
+TEST(DataFeedTextScanner, ParseBenchmark) {
+  const int kInstanceNum = 10000;
+  const int kUint64SlotNum = 100;
+  const int kFloatSlotNum = 10;
+  std::mt19937_64 rng(0);
+  std::string path = "data_feed_text_scanner_bench.txt";
+  {
+    std::ofstream fout(path);
+    for (int i = 0; i < kInstanceNum; ++i) {
+      for (int slot = 0; slot < kUint64SlotNum; ++slot) {
+        int num = 1 + rng() % 5;
+        fout << num;
+        for (int j = 0; j < num; ++j) {
+          fout << ' ' << rng();
+        }
+        fout << ' ';
+      }
+      for (int slot = 0; slot < kFloatSlotNum; ++slot) {
+        fout << "1 " << (rng() % 100000) / 1000.0 << ' ';
+      }
+      fout << '\n';
+    }
+  }
+  std::vector<std::string> lines;
+  size_t bytes = 0;
+  {
+    std::ifstream fin(path);
+    std::string line;
+    while (std::getline(fin, line)) {
+      bytes += line.size() + 1;
+      lines.push_back(line);
+    }
+  }
+  std::remove(path.c_str());
+
+  std::vector<uint64_t> uint64_values;
+  std::vector<float> float_values;
+  auto parse = [&](bool use_scanner) {
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto& line : lines) {
+      uint64_values.clear();
+      float_values.clear();
+      const char* str = line.c_str();
+      const char* end = str + line.size();
+      char* endptr = const_cast<char*>(str);
+      for (int slot = 0; slot < kUint64SlotNum + kFloatSlotNum; ++slot) {
+        int num = strtol(endptr, &endptr, 10);
+        for (int j = 0; j < num; ++j) {
+          if (slot < kUint64SlotNum) {
+            uint64_t feasign;
+            if (use_scanner) {
+              endptr = const_cast<char*>(ScanUint64(endptr, end, &feasign));
+            } else {
+              feasign = strtoull(endptr, &endptr, 10);
+            }
+            uint64_values.push_back(feasign);
+          } else {
+            float feasign;
+            if (use_scanner) {
+              endptr = const_cast<char*>(ScanFloat(endptr, end, &feasign));
+            } else {
+              feasign = strtof(endptr, &endptr);
+            }
+            float_values.push_back(feasign);
+          }
+        }
+      }
+      for (auto value : uint64_values) checksum += value;
+      for (auto value : float_values) checksum += value * 1000;
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    std::printf("%s: %.1f MB/s, %.0f instances/s\n",
+                use_scanner ? "text_scanner" : "strtoull/strtof",
+                bytes / seconds / 1024 / 1024,
+                lines.size() / seconds);
+    return checksum;
+  };
+  uint64_t libc_checksum = parse(false);
+  ASSERT_EQ(parse(true), libc_checksum);
+}
+
+}  // namespace framework
+}  // namespace paddle
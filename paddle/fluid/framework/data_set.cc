@@ -20,6 +20,7 @@
 #include "paddle/fluid/distributed/index_dataset/index_sampler.h"
 #endif
 #include "paddle/fluid/framework/data_feed_factory.h"
+#include "paddle/fluid/framework/data_shuffle_spill.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
 #include "paddle/fluid/framework/io/fs.h"
 #include "paddle/fluid/platform/monitor.h"
@@ -677,6 +678,34 @@ void DatasetImpl<T>::DumpWalkPath(std::string dump_path, size_t dump_rate) {
 #endif
 }
 
+template <typename T>
+void DatasetImpl<T>::ConvertToBinary(const std::string& output_dir) {
+  VLOG(3) << "DatasetImpl<T>::ConvertToBinary() begin";
+  PADDLE_ENFORCE_EQ(readers_.empty(),
+                    false,
+                    platform::errors::PreconditionNotMet(
+                        "The readers have to be created before "
+                        "ConvertToBinary."));
+  platform::Timer timeline;
+  timeline.Start();
+  fs_mkdir(output_dir);
+  file_idx_ = 0;
+  std::vector<std::thread> convert_threads;
+  for (int64_t i = 0; i < thread_num_; ++i) {
+    convert_threads.push_back(
+        std::thread(&paddle::framework::DataFeed::ConvertToBinary,
+                    readers_[i].get(),
+                    output_dir));
+  }
+  for (std::thread& t : convert_threads) {
+    t.join();
+  }
+  file_idx_ = 0;
+  timeline.Pause();
+  VLOG(3) << "DatasetImpl<T>::ConvertToBinary() end, cost time="
+          << timeline.ElapsedSec() << " seconds";
+}
+
 // do tdm sample
 void MultiSlotDataset::TDMSample(const std::string tree_name,
                                  const std::string tree_path,
@@ -862,6 +891,100 @@ void MultiSlotDataset::GlobalShuffle(int thread_num) {
           << timeline.ElapsedSec() << " seconds";
 }
 
+void MultiSlotDataset::ExternalGlobalShuffle(const std::string& spill_dir,
+                                             int trainer_id,
+                                             int thread_num) {
+  VLOG(3) << "MultiSlotDataset::ExternalGlobalShuffle() begin";
+  platform::Timer timeline;
+  timeline.Start();
+#ifdef PADDLE_WITH_PSCORE
+  auto fleet_ptr = distributed::FleetWrapper::GetInstance();
+#else
+  auto fleet_ptr = framework::FleetWrapper::GetInstance();
+#endif
+  CHECK(static_cast<size_t>(thread_num_) == readers_.size());
+  if (thread_num == -1) {
+    thread_num = thread_num_;
+  }
+  // at least 8 partitions, so that the records read together are spread
+  // over several blocks even on a single trainer
+  int partition_num = trainer_num_ * ((8 + trainer_num_ - 1) / trainer_num_);
+  SpillShuffler<Record> shuffler(
+      spill_dir, trainer_id, trainer_num_, partition_num);
+  auto get_partition = [this, fleet_ptr, partition_num](
+                           const Record& data) -> size_t {
+    if (this->merge_by_insid_) {
+      return XXH64(data.ins_id_.data(), data.ins_id_.length(), 0) %
+             partition_num;
+    } else if (this->shuffle_by_uid_) {
+      return XXH64(data.uid_.data(), data.uid_.length(), 0) % partition_num;
+    } else {
+      return fleet_ptr->LocalRandomEngine()() % partition_num;
+    }
+  };
+
+  // the readers block on the bounded input channel while the spill threads
+  // move its records into the spill files
+  size_t capacity = input_channel_->Capacity();
+  input_channel_->Open();
+  input_channel_->SetCapacity(fleet_send_batch_size_ * thread_num * 2);
+  input_channel_->SetBlockSize(fleet_send_batch_size_);
+  std::vector<std::thread> load_threads;
+  for (int64_t i = 0; i < thread_num_; ++i) {
+    load_threads.push_back(std::thread(
+        &paddle::framework::DataFeed::LoadIntoMemory, readers_[i].get()));
+  }
+  std::vector<std::thread> spill_threads;
+  for (int i = 0; i < thread_num; ++i) {
+    spill_threads.push_back(std::thread([this, &shuffler, &get_partition] {
+      std::vector<Record> data;
+      while (this->input_channel_->Read(data)) {
+        shuffler.Spill(&data, get_partition);
+      }
+    }));
+  }
+  for (std::thread& t : load_threads) {
+    t.join();
+  }
+  input_channel_->Close();
+  for (std::thread& t : spill_threads) {
+    t.join();
+  }
+  shuffler.FinishSpill();
+  timeline.Pause();
+  VLOG(3) << "MultiSlotDataset::ExternalGlobalShuffle() spill done, cost time="
+          << timeline.ElapsedSec() << " seconds";
+  timeline.Resume();
+  shuffler.WaitAllSpilled();
+
+  // the in-memory dataset keeps its whole share, so ReadBack fills the
+  // input channel with its former capacity, and closes it
+  input_channel_->SetCapacity(capacity);
+  input_channel_->Open();
+  shuffler.ReadBack(
+      input_channel_, thread_num, 4, fleet_ptr->LocalRandomEngine()());
+  int64_t in_chan_size = input_channel_->Size();
+  input_channel_->SetBlockSize(in_chan_size / thread_num_ + 1);
+  timeline.Pause();
+  VLOG(3) << "MultiSlotDataset::ExternalGlobalShuffle() end"
+          << ", memory data size=" << input_channel_->Size()
+          << ", cost time=" << timeline.ElapsedSec() << " seconds";
+}
+
+void MultiSlotDataset::PreExternalGlobalShuffle(const std::string& spill_dir,
+                                                int trainer_id,
+                                                int thread_num) {
+  VLOG(3) << "MultiSlotDataset::PreExternalGlobalShuffle() begin";
+  preload_threads_.clear();
+  preload_threads_.push_back(
+      std::thread(&MultiSlotDataset::ExternalGlobalShuffle,
+                  this,
+                  spill_dir,
+                  trainer_id,
+                  thread_num));
+  VLOG(3) << "MultiSlotDataset::PreExternalGlobalShuffle() end";
+}
+
 template <typename T>
 void DatasetImpl<T>::DynamicAdjustChannelNum(int channel_num,
                                              bool discard_remaining_ins) {
@@ -125,6 +125,15 @@ class Dataset {
   virtual void LocalShuffle() = 0;
   // global shuffle data
   virtual void GlobalShuffle(int thread_num = -1) = 0;
+  // load all data and global shuffle it through spill files in spill_dir,
+  // for the data which does not fit in memory before it is shuffled
+  virtual void ExternalGlobalShuffle(const std::string& spill_dir,
+                                     int trainer_id,
+                                     int thread_num = -1) = 0;
+  // ExternalGlobalShuffle in async mode, wait it with WaitPreLoadDone
+  virtual void PreExternalGlobalShuffle(const std::string& spill_dir,
+                                        int trainer_id,
+                                        int thread_num = -1) = 0;
   virtual void SlotsShuffle(const std::set<std::string>& slots_to_replace) = 0;
   // create readers
   virtual void CreateReaders() = 0;
@@ -173,6 +182,9 @@ class Dataset {
   virtual uint32_t GetPassID() = 0;
 
   virtual void DumpWalkPath(std::string dump_path, size_t dump_rate) = 0;
+  // convert the text files of filelist into binary SlotRecord files under
+  // output_dir
+  virtual void ConvertToBinary(const std::string& output_dir) = 0;
 
  protected:
   virtual int ReceiveFromClient(int msg_type,
@@ -239,6 +251,12 @@ class DatasetImpl : public Dataset {
   virtual void ReleaseMemory();
   virtual void LocalShuffle();
   virtual void GlobalShuffle(int thread_num = -1) {}
+  virtual void ExternalGlobalShuffle(const std::string& spill_dir,
+                                     int trainer_id,
+                                     int thread_num = -1) {}
+  virtual void PreExternalGlobalShuffle(const std::string& spill_dir,
+                                        int trainer_id,
+                                        int thread_num = -1) {}
   virtual void SlotsShuffle(const std::set<std::string>& slots_to_replace) {}
   virtual const std::vector<T>& GetSlotsOriginalData() {
     return slots_shuffle_original_data_;
@@ -268,6 +286,7 @@ class DatasetImpl : public Dataset {
   virtual std::vector<std::string> GetSlots();
   virtual bool GetEpochFinish();
   virtual void DumpWalkPath(std::string dump_path, size_t dump_rate);
+  virtual void ConvertToBinary(const std::string& output_dir);
 
   std::vector<paddle::framework::Channel<T>>& GetMultiOutputChannel() {
     return multi_output_channel_;
@@ -387,6 +406,12 @@ class MultiSlotDataset : public DatasetImpl<Record> {
       std::vector<Record>* result);
   virtual ~MultiSlotDataset() {}
   virtual void GlobalShuffle(int thread_num = -1);
+  virtual void ExternalGlobalShuffle(const std::string& spill_dir,
+                                     int trainer_id,
+                                     int thread_num = -1);
+  virtual void PreExternalGlobalShuffle(const std::string& spill_dir,
+                                        int trainer_id,
+                                        int thread_num = -1);
   virtual void DynamicAdjustReadersNum(int thread_num);
   virtual void PrepareTrain();
 
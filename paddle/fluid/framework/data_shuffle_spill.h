@@ -0,0 +1,346 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/framework/archive.h"
+#include "paddle/fluid/framework/channel.h"
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/string/string_helper.h"
+
+namespace paddle {
+namespace framework {
+
+// Global shuffle of records through partitioned spill files, for the data
+// which does not fit in the memory of one trainer before it is shuffled.
+//
+// Every trainer spills its records into partition_num partitions, each of
+// which is buffered in a BinaryArchive and written out as a block file of
+// about block_bytes once it is full, so a trainer holds at most
+// partition_num * block_bytes of them at a time. Partition p belongs to
+// trainer p % trainer_num. When all trainers finished spilling, which is
+// seen from their done markers in spill_dir, every trainer reads the blocks
+// of its partitions back in a random order, a few blocks at a time, and
+// shuffles the records of those blocks before writing them to a channel.
+// With a bounded channel which is consumed while the blocks are read back,
+// a trainer never holds its whole share of the records either.
+//
+// spill_dir has to be shared by all the trainers, like a HDFS path, unless
+// there is only one, and has to be a new directory for every shuffle.
+template <class T>
+class SpillShuffler {
+ public:
+  SpillShuffler(const std::string& spill_dir,
+                int trainer_id,
+                int trainer_num,
+                int partition_num,
+                size_t block_bytes = 4 << 20)
+      : spill_dir_(spill_dir),
+        trainer_id_(trainer_id),
+        trainer_num_(trainer_num),
+        block_bytes_(block_bytes) {
+    PADDLE_ENFORCE_EQ(
+        trainer_id >= 0 && trainer_id < trainer_num,
+        true,
+        platform::errors::InvalidArgument(
+            "trainer_id should be in [0, %d), but got %d.",
+            trainer_num,
+            trainer_id));
+    PADDLE_ENFORCE_EQ(partition_num > 0 && partition_num % trainer_num == 0,
+                      true,
+                      platform::errors::InvalidArgument(
+                          "partition_num should be a positive multiple of "
+                          "trainer_num %d, but got %d.",
+                          trainer_num,
+                          partition_num));
+    partitions_.resize(partition_num);
+    for (auto& partition : partitions_) {
+      partition.reset(new Partition);
+    }
+    fs_mkdir(spill_dir_);
+  }
+
+  ~SpillShuffler() { JoinReadBack(); }
+
+  int PartitionNum() const { return static_cast<int>(partitions_.size()); }
+
+  // Appends the records to the partitions given by partitioner, which maps a
+  // record to [0, PartitionNum()), and clears them. Thread safe.
+  template <class Partitioner>
+  void Spill(std::vector<T>* records, Partitioner partitioner) {
+    std::vector<std::vector<size_t>> indexes(partitions_.size());
+    for (size_t i = 0; i < records->size(); ++i) {
+      indexes[partitioner((*records)[i])].push_back(i);
+    }
+    for (size_t p = 0; p < partitions_.size(); ++p) {
+      if (indexes[p].empty()) {
+        continue;
+      }
+      Partition* partition = partitions_[p].get();
+      BinaryArchive full;
+      int block = 0;
+      {
+        std::lock_guard<std::mutex> lock(partition->mutex);
+        for (auto i : indexes[p]) {
+          partition->ar << (*records)[i];
+        }
+        if (partition->ar.Length() < block_bytes_) {
+          continue;
+        }
+        full = std::move(partition->ar);
+        block = partition->block_num++;
+      }
+      WriteBlock(p, block, &full);
+    }
+    records->clear();
+  }
+
+  // Writes the partially filled blocks, then the done marker of this trainer.
+  void FinishSpill() {
+    for (size_t p = 0; p < partitions_.size(); ++p) {
+      Partition* partition = partitions_[p].get();
+      std::lock_guard<std::mutex> lock(partition->mutex);
+      if (partition->ar.Length() > 0) {
+        WriteBlock(p, partition->block_num++, &partition->ar);
+      }
+      partition->ar.Reset();
+    }
+    int err_no = 0;
+    fs_open_write(DoneMarkerPath(trainer_id_), &err_no, "");
+    PADDLE_ENFORCE_EQ(err_no,
+                      0,
+                      platform::errors::Unavailable(
+                          "Failed to write %s.", DoneMarkerPath(trainer_id_)));
+  }
+
+  // Blocks until every trainer has written its done marker, or throws after
+  // timeout_seconds, e.g. when another trainer failed.
+  void WaitAllSpilled(int timeout_seconds = 3600) {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::seconds(timeout_seconds);
+    for (int i = 0; i < trainer_num_; ++i) {
+      while (!fs_exists(DoneMarkerPath(i))) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+          PADDLE_THROW(platform::errors::ExecutionTimeout(
+              "Trainer %d did not finish spilling to %s in %d seconds.",
+              i,
+              spill_dir_,
+              timeout_seconds));
+        }
+        VLOG(3) << "waiting for trainer " << i << " to finish spilling";
+        sleep(1);
+      }
+    }
+  }
+
+  // Reads the blocks of the partitions of this trainer into channel with
+  // thread_num threads, merge_block_num blocks at a time, removes them and
+  // closes channel. Blocks until all are read, see StartReadBack.
+  void ReadBack(Channel<T> channel,
+                int thread_num,
+                int merge_block_num,
+                uint64_t seed) {
+    StartReadBack(channel, thread_num, merge_block_num, seed);
+    FinishReadBack();
+  }
+
+  // ReadBack in background threads, which block on a full channel, so that
+  // the records are streamed to the readers of a bounded channel. Wait for
+  // the threads with FinishReadBack, which rethrows the first error of
+  // them; the channel is closed all the same.
+  void StartReadBack(Channel<T> channel,
+                     int thread_num,
+                     int merge_block_num,
+                     uint64_t seed) {
+    PADDLE_ENFORCE_EQ(read_back_threads_.empty(),
+                      true,
+                      platform::errors::PreconditionNotMet(
+                          "The blocks of %s are being read back already.",
+                          spill_dir_));
+    PADDLE_ENFORCE_GT(thread_num,
+                      0,
+                      platform::errors::InvalidArgument(
+                          "thread_num should be positive, but got %d.",
+                          thread_num));
+    std::vector<std::string> blocks;
+    for (auto& path : fs_list(spill_dir_)) {
+      int partition = -1;
+      int trainer = -1;
+      int block = -1;
+      std::string name = path.substr(path.find_last_of('/') + 1);
+      if (sscanf(name.c_str(),
+                 "block-p%d-t%d-%d",
+                 &partition,
+                 &trainer,
+                 &block) == 3 &&
+          partition % trainer_num_ == trainer_id_) {
+        blocks.push_back(path);
+      }
+    }
+    std::default_random_engine engine(seed);
+    std::shuffle(blocks.begin(), blocks.end(), engine);
+    VLOG(3) << "SpillShuffler::ReadBack() " << blocks.size() << " blocks";
+
+    read_back_blocks_ = std::move(blocks);
+    read_back_next_ = 0;
+    read_back_running_ = thread_num;
+    read_back_error_ = nullptr;
+    auto read_func = [this, channel, merge_block_num, seed](int thread_id) {
+      auto& blocks = read_back_blocks_;
+      std::default_random_engine local_engine(seed + thread_id + 1);
+      std::vector<T> records;
+      try {
+        while (true) {
+          size_t begin = read_back_next_.fetch_add(merge_block_num);
+          if (begin >= blocks.size()) {
+            break;
+          }
+          size_t end = std::min(blocks.size(), begin + merge_block_num);
+          for (size_t i = begin; i < end; ++i) {
+            ReadBlock(blocks[i], &records);
+            fs_remove(blocks[i]);
+          }
+          std::shuffle(records.begin(), records.end(), local_engine);
+          if (!records.empty()) {
+            channel->Write(std::move(records));
+            records.clear();
+          }
+        }
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(read_back_error_mutex_);
+        if (read_back_error_ == nullptr) {
+          read_back_error_ = std::current_exception();
+        }
+      }
+      // the last thread tells the readers of channel that it is done
+      if (--read_back_running_ == 0) {
+        channel->Close();
+      }
+    };
+    for (int i = 0; i < thread_num; ++i) {
+      read_back_threads_.push_back(std::thread(read_func, i));
+    }
+  }
+
+  void FinishReadBack() {
+    JoinReadBack();
+    std::exception_ptr error = nullptr;
+    std::swap(error, read_back_error_);
+    if (error != nullptr) {
+      std::rethrow_exception(error);
+    }
+  }
+
+ private:
+  void JoinReadBack() {
+    for (std::thread& t : read_back_threads_) {
+      t.join();
+    }
+    read_back_threads_.clear();
+    read_back_blocks_.clear();
+  }
+
+  struct Partition {
+    std::mutex mutex;
+    BinaryArchive ar;
+    int block_num = 0;
+  };
+
+  std::string BlockPath(int partition, int block) const {
+    return string::format_string("%s/block-p%05d-t%05d-%08d",
+                                 spill_dir_.c_str(),
+                                 partition,
+                                 trainer_id_,
+                                 block);
+  }
+
+  std::string DoneMarkerPath(int trainer_id) const {
+    return string::format_string(
+        "%s/_SPILL_DONE-trainer-%05d", spill_dir_.c_str(), trainer_id);
+  }
+
+  void WriteBlock(int partition, int block, BinaryArchive* ar) {
+    std::string path = BlockPath(partition, block);
+    int err_no = 0;
+    std::shared_ptr<FILE> fp = fs_open_write(path, &err_no, "");
+    PADDLE_ENFORCE_EQ(
+        err_no,
+        0,
+        platform::errors::Unavailable("Failed to open spill file %s.", path));
+    size_t length = ar->Length();
+    PADDLE_ENFORCE_EQ(
+        fwrite(ar->Buffer(), 1, length, fp.get()),
+        length,
+        platform::errors::Unavailable("Failed to write spill file %s.", path));
+    ar->Clear();
+  }
+
+  void ReadBlock(const std::string& path, std::vector<T>* records) {
+    int err_no = 0;
+    std::shared_ptr<FILE> fp = fs_open_read(path, &err_no, "");
+    PADDLE_ENFORCE_EQ(
+        err_no,
+        0,
+        platform::errors::Unavailable("Failed to read spill file %s.", path));
+    std::string buffer;
+    size_t length = 0;
+    while (true) {
+      buffer.resize(std::max(buffer.size() * 2, length + (1 << 20)));
+      size_t n = fread(&buffer[length], 1, buffer.size() - length, fp.get());
+      length += n;
+      if (n == 0) {
+        break;
+      }
+    }
+    BinaryArchive ar;
+    ar.SetReadBuffer(&buffer[0], length, nullptr);
+    while (ar.Cursor() < ar.Finish()) {
+      records->emplace_back();
+      ar >> records->back();
+    }
+  }
+
+  std::string spill_dir_;
+  int trainer_id_;
+  int trainer_num_;
+  size_t block_bytes_;
+  std::vector<std::unique_ptr<Partition>> partitions_;
+
+  std::vector<std::string> read_back_blocks_;
+  std::atomic<size_t> read_back_next_{0};
+  std::atomic<int> read_back_running_{0};
+  std::vector<std::thread> read_back_threads_;
+  std::mutex read_back_error_mutex_;
+  std::exception_ptr read_back_error_;
+};
+
+}  // namespace framework
+}  // namespace paddle
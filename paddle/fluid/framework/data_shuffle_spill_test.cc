@@ -0,0 +1,181 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/data_shuffle_spill.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(SpillShuffler, TwoTrainers) {
+  const int kTrainerNum = 2;
+  const int kRecordNum = 10000;
+  std::string spill_dir = "./test_spill_shuffle";
+  fs_remove(spill_dir);
+
+  // small blocks, so that every partition is spilled as several files
+  std::vector<std::unique_ptr<SpillShuffler<std::string>>> shufflers;
+  for (int i = 0; i < kTrainerNum; ++i) {
+    shufflers.emplace_back(new SpillShuffler<std::string>(
+        spill_dir, i, kTrainerNum, kTrainerNum * 4, 1024));
+  }
+  auto get_partition = [](const std::string& record) -> size_t {
+    return std::stoi(record) % 8;
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kTrainerNum; ++i) {
+    threads.emplace_back([&, i] {
+      auto& shuffler = *shufflers[i];
+      std::vector<std::string> records;
+      for (int j = i; j < kRecordNum; j += kTrainerNum) {
+        records.push_back(std::to_string(j));
+        if (records.size() == 100) {
+          shuffler.Spill(&records, get_partition);
+          ASSERT_TRUE(records.empty());
+        }
+      }
+      shuffler.Spill(&records, get_partition);
+      shuffler.FinishSpill();
+      shuffler.WaitAllSpilled();
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  std::vector<int> all;
+  for (int i = 0; i < kTrainerNum; ++i) {
+    auto channel = MakeChannel<std::string>();
+    shufflers[i]->ReadBack(channel, 3, 2, i);
+    channel->Close();
+    std::vector<std::string> records;
+    channel->ReadAll(records);
+    std::vector<int> values;
+    for (auto& record : records) {
+      values.push_back(std::stoi(record));
+      ASSERT_EQ(values.back() % kTrainerNum, i);
+    }
+    ASSERT_FALSE(std::is_sorted(values.begin(), values.end()));
+    all.insert(all.end(), values.begin(), values.end());
+  }
+  std::sort(all.begin(), all.end());
+  ASSERT_EQ(all.size(), static_cast<size_t>(kRecordNum));
+  for (int i = 0; i < kRecordNum; ++i) {
+    ASSERT_EQ(all[i], i);
+  }
+  fs_remove(spill_dir);
+}
+
+TEST(SpillShuffler, StreamReadBack) {
+  const int kRecordNum = 10000;
+  const size_t kCapacity = 64;
+  std::string spill_dir = "./test_spill_shuffle_stream";
+  fs_remove(spill_dir);
+  SpillShuffler<std::string> shuffler(spill_dir, 0, 1, 8, 1024);
+  std::vector<std::string> records;
+  for (int i = 0; i < kRecordNum; ++i) {
+    records.push_back(std::to_string(i));
+  }
+  shuffler.Spill(&records,
+                 [](const std::string& record) -> size_t {
+                   return std::stoi(record) % 8;
+                 });
+  shuffler.FinishSpill();
+  shuffler.WaitAllSpilled();
+
+  // the read back threads wait for the consumer of the bounded channel,
+  // which ends when they close it
+  auto channel = MakeChannel<std::string>(kCapacity);
+  channel->SetBlockSize(16);
+  shuffler.StartReadBack(channel, 3, 1, 0);
+  std::vector<int> values;
+  std::vector<std::string> batch;
+  while (channel->Read(batch) > 0) {
+    ASSERT_LE(channel->Size(), kCapacity);
+    for (auto& record : batch) {
+      values.push_back(std::stoi(record));
+    }
+  }
+  shuffler.FinishReadBack();
+  std::sort(values.begin(), values.end());
+  ASSERT_EQ(values.size(), static_cast<size_t>(kRecordNum));
+  for (int i = 0; i < kRecordNum; ++i) {
+    ASSERT_EQ(values[i], i);
+  }
+  fs_remove(spill_dir);
+}
+
+// a record which fails to be read back if it is negative
+struct CheckedRecord {
+  int value = 0;
+};
+
+inline BinaryArchive& operator<<(BinaryArchive& ar, const CheckedRecord& r) {
+  return ar << r.value;
+}
+
+inline BinaryArchive& operator>>(BinaryArchive& ar, CheckedRecord& r) {
+  ar >> r.value;
+  PADDLE_ENFORCE_GE(
+      r.value,
+      0,
+      platform::errors::InvalidArgument("Bad record %d.", r.value));
+  return ar;
+}
+
+TEST(SpillShuffler, ReadBackError) {
+  std::string spill_dir = "./test_spill_shuffle_error";
+  fs_remove(spill_dir);
+  SpillShuffler<CheckedRecord> shuffler(spill_dir, 0, 1, 4, 64);
+  std::vector<CheckedRecord> records(1000);
+  for (int i = 0; i < 1000; ++i) {
+    records[i].value = (i == 500) ? -1 : i;
+  }
+  shuffler.Spill(&records,
+                 [](const CheckedRecord& record) -> size_t {
+                   return (record.value + 4) % 4;
+                 });
+  shuffler.FinishSpill();
+  shuffler.WaitAllSpilled();
+
+  // the channel is closed though a thread fails, and the error is thrown
+  // when the threads are joined
+  auto channel = MakeChannel<CheckedRecord>(16);
+  shuffler.StartReadBack(channel, 2, 1, 0);
+  std::vector<CheckedRecord> batch;
+  while (channel->Read(batch) > 0) {
+  }
+  ASSERT_THROW(shuffler.FinishReadBack(), platform::EnforceNotMet);
+  shuffler.FinishReadBack();
+  fs_remove(spill_dir);
+}
+
+TEST(SpillShuffler, WaitTimeout) {
+  std::string spill_dir = "./test_spill_shuffle_timeout";
+  fs_remove(spill_dir);
+  // trainer 1 never finishes spilling
+  SpillShuffler<std::string> shuffler(spill_dir, 0, 2, 2);
+  shuffler.FinishSpill();
+  ASSERT_THROW(shuffler.WaitAllSpilled(1), platform::EnforceNotMet);
+  fs_remove(spill_dir);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -15,6 +15,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/ir/fusion_group/code_generator.h"
 
 #include "paddle/fluid/framework/ir/fusion_group/code_generator_helper.h"
+#include "paddle/fluid/framework/ir/fusion_group/cpu_resources.h"
 #include "paddle/fluid/framework/ir/fusion_group/cuda_resources.h"
 
 namespace paddle {
@@ -43,11 +44,12 @@ std::string ExtractDataType(const std::vector<Node*>& nodes) {
   return dtype_str;
 }
 
-CodeGenerator::CodeGenerator() {
+CodeGenerator::CodeGenerator(bool use_gpu) : use_gpu_(use_gpu) {
   // Only support elementwise operations now.
   code_templates_.resize(1);
 
-  CodeTemplate elementwise_t(cuda_kernel_template_1d);
+  CodeTemplate elementwise_t(use_gpu ? cuda_kernel_template_1d
+                                     : cpu_kernel_template_1d);
   code_templates_[0] = elementwise_t;
 }
 
@@ -183,7 +185,10 @@ std::string CodeGenerator::Generate(
   template_var.Add("func_name", func_name);
   template_var.Add(
       "parameters",
-      EmitParameters(input_ids, output_ids, intermediate_output_ids, dtypes));
+      use_gpu_ ? EmitParameters(
+                     input_ids, output_ids, intermediate_output_ids, dtypes)
+               : EmitUnpackedParameters(
+                     input_ids, output_ids, intermediate_output_ids, dtypes));
   template_var.Add(
       "compute_body",
       EmitComputeBody(
@@ -193,6 +198,21 @@ std::string CodeGenerator::Generate(
   for (const auto& type : dtypes) {
     all_dtype.insert(type.second);
   }
+  if (!use_gpu_) {
+    PADDLE_ENFORCE_EQ(all_dtype.find("__half"),
+                      all_dtype.end(),
+                      platform::errors::Unimplemented(
+                          "The CPU code of fusion_group does not support "
+                          "float16 yet."));
+    std::string predefined_cpu_functions = "";
+    if (all_dtype.find("float") != all_dtype.end()) {
+      predefined_cpu_functions += predefined_cpu_functions_fp32;
+    }
+    if (all_dtype.find("double") != all_dtype.end()) {
+      predefined_cpu_functions += predefined_cpu_functions_fp64;
+    }
+    return predefined_cpu_functions + code_templates_[0].Format(template_var);
+  }
   std::string predefined_cuda_functions = "";
   if (all_dtype.find("float") != all_dtype.end() &&
       all_dtype.find("__half") == all_dtype.end()) {
@@ -313,6 +333,32 @@ std::string CodeGenerator::EmitParameters(
   return ret.str();
 }
 
+std::string CodeGenerator::EmitUnpackedParameters(
+    const std::set<int>& input_ids,
+    const std::set<int>& output_ids,
+    const std::set<int>& intermediate_ids,
+    const std::unordered_map<int, std::string>& dtypes) const {
+  std::stringstream ret;
+  ret << "int N = *static_cast<int*>(args[0]);";
+
+  size_t index = 1;
+  for (auto id : input_ids) {
+    if (output_ids.find(id) == output_ids.end()) {
+      ret << "const " << dtypes.at(id) << "* __restrict__ " << ArgName(id)
+          << " = static_cast<const " << dtypes.at(id)
+          << "*>(*static_cast<void**>(args[" << index++ << "]));";
+    }
+  }
+  for (auto id : output_ids) {
+    if (intermediate_ids.find(id) == intermediate_ids.end()) {
+      ret << dtypes.at(id) << "* " << ArgName(id) << " = static_cast<"
+          << dtypes.at(id) << "*>(*static_cast<void**>(args[" << index++
+          << "]));";
+    }
+  }
+  return ret.str();
+}
+
 std::string CodeGenerator::EmitComputeBody(
     const std::vector<OperationExpression>& expressions,
     const std::set<int>& input_ids,
@@ -331,9 +377,14 @@ std::string CodeGenerator::EmitComputeBody(
   for (auto id : input_ids) {
     if (output_ids.find(id) == output_ids.end() &&
         used.find(id) != used.end()) {
-      load << dtypes.at(id) << " " << TmpName(id) << " = "
-           << "__ldg(&" << VarName(id) << ")"
-           << ";";
+      if (use_gpu_) {
+        load << dtypes.at(id) << " " << TmpName(id) << " = "
+             << "__ldg(&" << VarName(id) << ")"
+             << ";";
+      } else {
+        load << dtypes.at(id) << " " << TmpName(id) << " = " << VarName(id)
+             << ";";
+      }
     }
   }
   // Store temporal variables to memory.
@@ -32,7 +32,9 @@ class SubGraph;
 
 class CodeGenerator {
  public:
-  CodeGenerator();
+  // Generates CUDA kernels if use_gpu, or C++ functions for CPUDeviceCode
+  // otherwise.
+  explicit CodeGenerator(bool use_gpu = true);
 
   std::string Generate(std::string func_name,
                        const std::vector<OperationExpression>& expressions);
@@ -58,6 +60,14 @@ class CodeGenerator {
       const std::set<int>& intermediate_ids,
       const std::unordered_map<int, std::string>& dtypes) const;
 
+  // we get the code to unpack the arguments of the C++ function from the
+  // array of pointers to them, in the same order as the parameter list
+  std::string EmitUnpackedParameters(
+      const std::set<int>& input_ids,
+      const std::set<int>& output_ids,
+      const std::set<int>& intermediate_ids,
+      const std::unordered_map<int, std::string>& dtypes) const;
+
   std::string EmitComputeBody(
       const std::vector<OperationExpression>& expressions,
       const std::set<int>& input_ids,
@@ -69,6 +79,7 @@ class CodeGenerator {
   std::unordered_map<Node*, int> EncodeVarNodes(SubGraph* subgraph);
 
  private:
+  bool use_gpu_;
   std::vector<CodeTemplate> code_templates_;
 };
 
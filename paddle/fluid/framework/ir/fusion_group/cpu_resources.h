@@ -0,0 +1,56 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+// The builtins need no header, which keeps the compiling of the code fast.
+static constexpr char predefined_cpu_functions_fp32[] = R"(
+static inline float Max(float x, float y) { return __builtin_fmaxf(x, y); }
+static inline float Exp(float x) { return __builtin_expf(x); }
+static inline float Log(float x) { return __builtin_logf(x); }
+static inline float Sqrt(float x) { return __builtin_sqrtf(x); }
+
+)";
+
+static constexpr char predefined_cpu_functions_fp64[] = R"(
+static inline double Max(double x, double y) { return __builtin_fmax(x, y); }
+static inline double Exp(double x) { return __builtin_exp(x); }
+static inline double Log(double x) { return __builtin_log(x); }
+static inline double Sqrt(double x) { return __builtin_sqrt(x); }
+
+)";
+
+// The arguments are passed as an array of pointers to them, like those of
+// cuLaunchKernel, and are unpacked in $parameters. The loop over the
+// elements is left to the compiler to vectorize.
+static constexpr char cpu_kernel_template_1d[] = R"(
+extern "C" void $func_name(void** args) {
+  $parameters
+  for (int idx = 0;
+       idx < N;
+       ++idx) {
+    $compute_body
+  }
+}
+)";
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
@@ -19,6 +19,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/ir/fuse_pass_base.h"
 #include "paddle/fluid/framework/ir/fusion_group/subgraph.h"
+#include "paddle/fluid/platform/place.h"
 
 namespace paddle {
 namespace framework {
@@ -35,6 +36,8 @@ class FusionGroupPass : public FusePassBase {
   void ApplyImpl(Graph* graph) const override;
 
  private:
+  // CUDAPlace(0) if use_gpu, otherwise CPUPlace.
+  platform::Place GetPlace() const;
   int DetectFusionGroup(Graph* graph, int type = 0) const;
   bool GenerateCode(fusion_group::SubGraph* subgraph) const;
   void InsertFusionGroupOp(Graph* graph,
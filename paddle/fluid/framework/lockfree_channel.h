@@ -0,0 +1,342 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// A bounded multi-producer multi-consumer channel with the interface of
+// ChannelObject, for the producers and consumers which contend on the lock of
+// ChannelObject.
+//
+// The data is kept in a ring of cells with sequence numbers (the bounded
+// queue of D. Vyukov): a writer or reader claims a range of consecutive cells
+// with one CAS on the write or read position, and publishes every cell by its
+// sequence number, so they never take a lock while the channel is neither
+// full nor empty. Only a writer to a full channel or a reader of an empty
+// one, after spinning for a while, waits on a condition variable.
+//
+// Like ChannelObject, a Read blocks until n values are read or the channel is
+// closed and empty, and a Write blocks until n values are written or the
+// channel is closed. Close sets a bit of the write position, so a writer
+// claims its cells either before Close, and they are still read, or not at
+// all. Unlike ChannelObject, the capacity is fixed at construction and
+// rounded up to a power of two.
+template <class T>
+class LockFreeChannelObject {
+ public:
+  explicit LockFreeChannelObject(size_t capacity = 1 << 16) {
+    CHECK(capacity >= 1) << "capacity must be >= 1";
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    cells_.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  size_t Capacity() { return mask_ + 1; }
+
+  size_t BlockSize() { return block_size_; }
+
+  void SetBlockSize(size_t x) {
+    CHECK(x >= 1) << "block size must be >= 1";
+    block_size_ = x;
+  }
+
+  bool Closed() {
+    return (write_pos_.load(std::memory_order_acquire) & kClosedBit) != 0;
+  }
+
+  // open channel, then data can be write() to channel
+  void Open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_pos_.fetch_and(~kClosedBit, std::memory_order_seq_cst);
+  }
+
+  // close channel, then no more data can be write() to channel
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_pos_.fetch_or(kClosedBit, std::memory_order_seq_cst);
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+  // The values claimed by writers, which may not all be readable yet.
+  size_t Size() {
+    size_t read_pos = read_pos_.load(std::memory_order_acquire);
+    size_t write_pos = WritePos();
+    return write_pos > read_pos ? write_pos - read_pos : 0;
+  }
+
+  bool Empty() { return Size() == 0; }
+
+  // blocking operation
+  bool Get(T& val) { return Read(1, &val) != 0; }  // NOLINT
+
+  // blocking operation
+  bool Put(T&& val) { return WriteMove(1, &val) != 0; }
+
+  // blocking operation
+  bool Put(const T& val) { return Write(1, &val) != 0; }
+
+  // blocking operation
+  // returns 0 if the channel is closed and empty
+  size_t Read(size_t n, T* p) { return Read(n, p, false); }
+
+  // reads what is available once, and blocks only while nothing is
+  size_t ReadOnce(std::vector<T>& p, size_t size) {  // NOLINT
+    p.resize(size);
+    size_t finished = size == 0 ? 0 : Read(size, &p[0], true);
+    p.resize(finished);
+    return finished;
+  }
+
+  // read data of block size from channel to vector
+  size_t Read(std::vector<T>& p) {  // NOLINT
+    p.resize(block_size_);
+    size_t finished = Read(p.size(), &p[0]);
+    p.resize(finished);
+    return finished;
+  }
+
+  size_t ReadAll(std::vector<T>& p) {  // NOLINT
+    p.clear();
+    size_t finished = 0;
+    size_t n = 0;
+    do {
+      n = block_size_;
+      p.resize(finished + n);
+      n = Read(n, &p[finished]);
+      finished += n;
+    } while (n != 0);
+    p.resize(finished);
+    return finished;
+  }
+
+  // blocking operation
+  // returns value less than n if the channel is closed
+  size_t Write(size_t n, const T* p) {
+    return WriteImpl(n, [p](size_t i, T* cell) { *cell = p[i]; });
+  }
+
+  // WriteMove() will clear original contents of input array
+  size_t WriteMove(size_t n, T* p) {
+    return WriteImpl(n, [p](size_t i, T* cell) { *cell = std::move(p[i]); });
+  }
+
+  // write data from vector to channel
+  size_t Write(const std::vector<T>& p) { return Write(p.size(), p.data()); }
+
+  // write data from vector to channel
+  size_t Write(std::vector<T>&& p) { return WriteMove(p.size(), p.data()); }
+
+ private:
+  struct alignas(64) Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  static constexpr int kSpinCount = 64;
+  // set in write_pos_ by Close
+  static constexpr size_t kClosedBit = ~(~static_cast<size_t>(0) >> 1);
+
+  size_t WritePos() {
+    return write_pos_.load(std::memory_order_acquire) & ~kClosedBit;
+  }
+
+  // Claims up to n consecutive cells, which are free for a writer, or full
+  // for a reader, at pos. Returns the number of cells claimed, which is 0
+  // for a writer once the channel is closed.
+  size_t Claim(std::atomic<size_t>* position,
+               size_t lap_offset,
+               size_t n,
+               size_t* pos) {
+    size_t current = position->load(std::memory_order_relaxed);
+    while (true) {
+      if (current & kClosedBit) {
+        return 0;
+      }
+      size_t ready = 0;
+      while (ready < n) {
+        const Cell& cell = cells_[(current + ready) & mask_];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (sequence != current + ready + lap_offset) {
+          break;
+        }
+        ++ready;
+      }
+      if (ready == 0) {
+        size_t sequence =
+            cells_[current & mask_].sequence.load(std::memory_order_acquire);
+        // The cell was not released by the previous lap yet.
+        if (static_cast<std::ptrdiff_t>(sequence - current - lap_offset) <
+            0) {
+          return 0;
+        }
+        // Another thread claimed it, retry at the new position.
+        current = position->load(std::memory_order_relaxed);
+        continue;
+      }
+      // fails when Close set kClosedBit since current was loaded
+      if (position->compare_exchange_weak(current,
+                                          current + ready,
+                                          std::memory_order_relaxed,
+                                          std::memory_order_relaxed)) {
+        *pos = current;
+        return ready;
+      }
+    }
+  }
+
+  template <class Assign>
+  size_t WriteImpl(size_t n, Assign assign) {
+    size_t finished = 0;
+    while (finished < n) {
+      size_t pos = 0;
+      size_t m = Claim(&write_pos_, 0, n - finished, &pos);
+      if (m == 0) {
+        if (Closed()) {
+          break;
+        }
+        Wait(&not_full_, &full_waiters_, [this] {
+          return Closed() || HasFreeCell();
+        });
+        continue;
+      }
+      for (size_t i = 0; i < m; ++i) {
+        Cell& cell = cells_[(pos + i) & mask_];
+        assign(finished + i, &cell.data);
+        cell.sequence.store(pos + i + 1, std::memory_order_release);
+      }
+      finished += m;
+      Notify(&not_empty_, &empty_waiters_);
+    }
+    return finished;
+  }
+
+  size_t Read(size_t n, T* p, bool once) {
+    size_t finished = 0;
+    while (finished < n) {
+      size_t pos = 0;
+      size_t m = Claim(&read_pos_, 1, n - finished, &pos);
+      if (m == 0) {
+        if (once && finished > 0) {
+          break;
+        }
+        // The cells claimed by writers before the close are still read.
+        if (Closed() &&
+            read_pos_.load(std::memory_order_acquire) >= WritePos()) {
+          break;
+        }
+        Wait(&not_empty_, &empty_waiters_, [this] {
+          return Closed() || HasFullCell();
+        });
+        continue;
+      }
+      for (size_t i = 0; i < m; ++i) {
+        Cell& cell = cells_[(pos + i) & mask_];
+        p[finished + i] = std::move(cell.data);
+        cell.sequence.store(pos + i + mask_ + 1, std::memory_order_release);
+      }
+      finished += m;
+      Notify(&not_full_, &full_waiters_);
+      if (once) {
+        break;
+      }
+    }
+    return finished;
+  }
+
+  bool HasFreeCell() {
+    size_t pos = WritePos();
+    return cells_[pos & mask_].sequence.load(std::memory_order_acquire) ==
+           pos;
+  }
+
+  bool HasFullCell() {
+    size_t pos = read_pos_.load(std::memory_order_relaxed);
+    return cells_[pos & mask_].sequence.load(std::memory_order_acquire) ==
+           pos + 1;
+  }
+
+  // Spins for a while, then sleeps on cond until ready() or a notify. A
+  // notifier checks waiters after publishing its cells, and a waiter checks
+  // ready() after adding itself to waiters, both with a full fence, so that
+  // no wakeup is lost.
+  template <class Ready>
+  void Wait(std::condition_variable* cond,
+            std::atomic<int>* waiters,
+            Ready ready) {
+    for (int i = 0; i < kSpinCount; ++i) {
+      if (ready()) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiters->fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!ready()) {
+      cond->wait(lock);
+    }
+    waiters->fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void Notify(std::condition_variable* cond, std::atomic<int>* waiters) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters->load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cond->notify_all();
+    }
+  }
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  size_t block_size_ = 1024;
+  alignas(64) std::atomic<size_t> write_pos_{0};
+  alignas(64) std::atomic<size_t> read_pos_{0};
+
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::atomic<int> empty_waiters_{0};
+  std::atomic<int> full_waiters_{0};
+};  // NOLINT
+
+template <class T>
+using LockFreeChannel = std::shared_ptr<LockFreeChannelObject<T>>;
+
+template <class T>
+LockFreeChannel<T> MakeLockFreeChannel(size_t capacity = 1 << 16) {
+  return std::make_shared<LockFreeChannelObject<T>>(capacity);
+}
+
+}  // namespace framework
+}  // namespace paddle
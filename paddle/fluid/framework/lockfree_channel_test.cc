@@ -0,0 +1,183 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/lockfree_channel.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/channel.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(LockFreeChannel, ReadWrite) {
+  auto chan = MakeLockFreeChannel<int>(5);
+  ASSERT_EQ(chan->Capacity(), 8UL);
+  std::vector<int> values = {1, 2, 3, 4, 5, 6};
+  ASSERT_EQ(chan->Write(values), 6UL);
+  ASSERT_EQ(chan->Size(), 6UL);
+
+  std::vector<int> out;
+  ASSERT_EQ(chan->ReadOnce(out, 4), 4UL);
+  ASSERT_EQ(out, std::vector<int>({1, 2, 3, 4}));
+  int value = 0;
+  ASSERT_TRUE(chan->Get(value));
+  ASSERT_EQ(value, 5);
+
+  // The remaining values are read after the close, then reads return 0.
+  chan->Close();
+  ASSERT_FALSE(chan->Put(7));
+  ASSERT_EQ(chan->ReadAll(out), 1UL);
+  ASSERT_EQ(out[0], 6);
+  ASSERT_FALSE(chan->Get(value));
+
+  chan->Open();
+  ASSERT_TRUE(chan->Put(8));
+  ASSERT_TRUE(chan->Get(value));
+  ASSERT_EQ(value, 8);
+}
+
+TEST(LockFreeChannel, BlockOnFull) {
+  auto chan = MakeLockFreeChannel<int>(4);
+  std::vector<int> values(100);
+  for (int i = 0; i < 100; ++i) {
+    values[i] = i;
+  }
+  std::thread writer([&] { ASSERT_EQ(chan->Write(values), 100UL); });
+  std::vector<int> out(100);
+  ASSERT_EQ(chan->Read(100, out.data()), 100UL);
+  writer.join();
+  ASSERT_EQ(out, values);
+
+  // A writer blocked on a full channel returns when it is closed.
+  ASSERT_EQ(chan->Write(4, values.data()), 4UL);
+  std::thread blocked([&] { ASSERT_EQ(chan->Write(4, values.data()), 0UL); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  chan->Close();
+  blocked.join();
+}
+
+// Every value a Write reports as written is read, even when the writers
+// race with Close, and none is put after the readers returned.
+TEST(LockFreeChannel, WriteRacingClose) {
+  for (int round = 0; round < 100; ++round) {
+    auto chan = MakeLockFreeChannel<int>(64);
+    std::atomic<size_t> written{0};
+    std::vector<std::thread> writers;
+    for (int i = 0; i < 4; ++i) {
+      writers.emplace_back([&chan, &written] {
+        int value = 1;
+        while (chan->Write(1, &value) == 1) {
+          ++written;
+        }
+      });
+    }
+    size_t read = 0;
+    std::thread reader([&chan, &read] {
+      std::vector<int> batch;
+      while (chan->Read(batch) > 0) {
+        read += batch.size();
+      }
+    });
+    std::this_thread::sleep_for(std::chrono::microseconds(100 * round));
+    chan->Close();
+    for (auto& writer : writers) {
+      writer.join();
+    }
+    reader.join();
+    ASSERT_EQ(read, written.load());
+    ASSERT_EQ(chan->Size(), 0UL);
+  }
+}
+
+// Passes count values from writers to readers, in batches of block_size,
+// and returns the seconds taken.
+template <class Channel>
+double RunChannel(Channel chan, int writer_num, int reader_num, int count) {
+  std::atomic<int64_t> sum{0};
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> writers;
+  for (int i = 0; i < writer_num; ++i) {
+    writers.emplace_back([&chan, i, writer_num, count] {
+      std::vector<int64_t> batch;
+      for (int64_t v = i; v < count; v += writer_num) {
+        batch.push_back(v);
+        if (batch.size() == chan->BlockSize()) {
+          chan->WriteMove(batch.size(), batch.data());
+          batch.clear();
+        }
+      }
+      chan->WriteMove(batch.size(), batch.data());
+    });
+  }
+  std::vector<std::thread> readers;
+  for (int i = 0; i < reader_num; ++i) {
+    readers.emplace_back([&chan, &sum] {
+      std::vector<int64_t> batch;
+      int64_t local_sum = 0;
+      while (chan->Read(batch) > 0) {
+        for (auto v : batch) {
+          local_sum += v;
+        }
+      }
+      sum += local_sum;
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  chan->Close();
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  EXPECT_EQ(sum.load(), static_cast<int64_t>(count) * (count - 1) / 2);
+  return seconds;
+}
+
+// Disabled by default, run with --gtest_also_run_disabled_tests.
+TEST(LockFreeChannel, DISABLED_ContentionBenchmark) {
+  const int kCount = 1 << 20;
+  const size_t kBlockSize = 16;
+  // 1 to 64 writers, and as many readers.
+  for (int threads = 1; threads <= 64; threads *= 2) {
+    int writer_num = threads;
+    int reader_num = threads;
+    auto mutex_chan = MakeChannel<int64_t>(4096);
+    mutex_chan->SetBlockSize(kBlockSize);
+    auto lockfree_chan = MakeLockFreeChannel<int64_t>(4096);
+    lockfree_chan->SetBlockSize(kBlockSize);
+    double mutex_seconds =
+        RunChannel(mutex_chan, writer_num, reader_num, kCount);
+    double lockfree_seconds =
+        RunChannel(lockfree_chan, writer_num, reader_num, kCount);
+    std::printf(
+        "%d writers, %d readers: ChannelObject %.1f M/s, "
+        "LockFreeChannelObject %.1f M/s\n",
+        writer_num,
+        reader_num,
+        kCount / mutex_seconds / 1e6,
+        kCount / lockfree_seconds / 1e6);
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
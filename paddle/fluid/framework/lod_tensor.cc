@@ -18,6 +18,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/framework/version.h"
+#include "paddle/fluid/memory/allocation/mmap_allocator.h"
 
 namespace paddle {
 namespace framework {
@@ -203,6 +204,22 @@ LoDAndOffset GetSubLoDAndAbsoluteOffset(const LoD &lod,
   return LoDAndOffset{sub_lod, {start_idx, end_idx}};
 }
 
+static void LoDToStream(std::ostream &os, const LoD &lod) {
+  // uint64_t lod_level
+  // uint64_t lod_level_1 size in byte.
+  // int*     lod_level_1 data
+  // ...
+  uint64_t size = lod.size();
+  os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+
+  for (auto &each : lod) {
+    size = each.size() * sizeof(framework::LoD::value_type::value_type);
+    os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    os.write(reinterpret_cast<const char *>(each.data()),
+             static_cast<std::streamsize>(size));
+  }
+}
+
 void SerializeToStream(std::ostream &os,
                        const phi::DenseTensor &tensor,
                        const platform::DeviceContext &dev_ctx) {
@@ -211,27 +228,159 @@ void SerializeToStream(std::ostream &os,
         reinterpret_cast<const char *>(&paddle::framework::kCurTensorVersion),
         sizeof(paddle::framework::kCurTensorVersion));
   }
+  // the 2st field, LoD information
+  LoDToStream(os, tensor.lod());
+  // the 3st field, Tensor
+  paddle::framework::TensorToStream(
+      os, static_cast<phi::DenseTensor>(tensor), dev_ctx);
+}
+
+void SerializeToAlignedStream(std::ostream &os,
+                              const phi::DenseTensor &tensor,
+                              const platform::DeviceContext &dev_ctx) {
+  phi::DenseTensor cpu_tensor;
+  if (platform::is_cpu_place(tensor.place())) {
+    cpu_tensor.ShareDataWith(tensor);
+  } else {
+    TensorCopySync(tensor, platform::CPUPlace(), &cpu_tensor);
+  }
+  {  // the 1st field, uint32_t version for DenseTensor of the aligned layout
+    os.write(reinterpret_cast<const char *>(&kAlignedTensorVersion),
+             sizeof(kAlignedTensorVersion));
+  }
+  // the 2st field, LoD information
+  LoDToStream(os, tensor.lod());
+  // the 3st field, Tensor, of which the data is aligned
   {
-    // the 2st field, LoD information
-    // uint64_t lod_level
-    // uint64_t lod_level_1 size in byte.
-    // int*     lod_level_1 data
-    // ...
-    auto lod = tensor.lod();
-    uint64_t size = lod.size();
+    constexpr uint32_t version = 0;
+    os.write(reinterpret_cast<const char *>(&version), sizeof(version));
+  }
+  {
+    proto::VarType::TensorDesc desc;
+    desc.set_data_type(framework::TransToProtoVarType(cpu_tensor.dtype()));
+    auto dims = phi::vectorize(cpu_tensor.dims());
+    auto *pb_dims = desc.mutable_dims();
+    pb_dims->Resize(static_cast<int>(dims.size()), 0);
+    std::copy(dims.begin(), dims.end(), pb_dims->begin());
+    int32_t size = desc.ByteSize();
     os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    auto out = desc.SerializeAsString();
+    os.write(out.data(), size);
+  }
+  {
+    auto pos = static_cast<int64_t>(os.tellp());
+    PADDLE_ENFORCE_GE(
+        pos,
+        0,
+        platform::errors::Unavailable(
+            "Cannot get the position of the stream to align the tensor."));
+    size_t padding = (kAlignedTensorAlignment -
+                      static_cast<size_t>(pos) % kAlignedTensorAlignment) %
+                     kAlignedTensorAlignment;
+    char zeros[kAlignedTensorAlignment] = {0};
+    os.write(zeros, static_cast<std::streamsize>(padding));
+  }
+  {
+    uint64_t size = cpu_tensor.numel() * phi::SizeOf(cpu_tensor.dtype());
+    os.write(static_cast<const char *>(cpu_tensor.data()),
+             static_cast<std::streamsize>(size));
+  }
+}
 
-    for (auto &each : lod) {
-      size = each.size() * sizeof(framework::LoD::value_type::value_type);
-      os.write(reinterpret_cast<const char *>(&size), sizeof(size));
-      os.write(reinterpret_cast<const char *>(each.data()),
-               static_cast<std::streamsize>(size));
+#ifndef _WIN32
+void DeserializeFromMappedFile(
+    const std::shared_ptr<memory::allocation::FileMemoryMapAllocation> &file,
+    size_t *offset,
+    phi::DenseTensor *tensor) {
+  char *base = static_cast<char *>(file->ptr());
+  size_t file_size = file->size();
+  auto read = [&](void *dst, size_t size) {
+    PADDLE_ENFORCE_LE(
+        *offset + size,
+        file_size,
+        platform::errors::InvalidArgument(
+            "The file %s is truncated when reading %d bytes at offset %d.",
+            file->ipc_name(),
+            size,
+            *offset));
+    memcpy(dst, base + *offset, size);
+    *offset += size;
+  };
+  {
+    // the 1st field, unit32_t version for DenseTensor
+    uint32_t version;
+    read(&version, sizeof(version));
+    PADDLE_ENFORCE_EQ(version,
+                      kAlignedTensorVersion,
+                      platform::errors::InvalidArgument(
+                          "The tensor at offset %d of %s is not of the "
+                          "aligned layout (expected version %u, but %u found).",
+                          *offset - sizeof(version),
+                          file->ipc_name(),
+                          kAlignedTensorVersion,
+                          version));
+  }
+  {
+    // the 2st field, LoD information
+    uint64_t lod_level;
+    read(&lod_level, sizeof(lod_level));
+    LoD lod(lod_level);
+    for (uint64_t i = 0; i < lod_level; ++i) {
+      uint64_t size;
+      read(&size, sizeof(size));
+      std::vector<size_t> tmp(size / sizeof(size_t));
+      read(tmp.data(), size);
+      lod[i] = tmp;
     }
+    tensor->clear();
+    tensor->set_lod(lod);
+  }
+  // the 3st filed, Tensor
+  proto::VarType::TensorDesc desc;
+  {
+    uint32_t version;
+    read(&version, sizeof(version));
+    PADDLE_ENFORCE_EQ(
+        version,
+        0U,
+        platform::errors::InvalidArgument(
+            "tensor version %u is not supported, Only version 0 is supported",
+            version));
+    int32_t size = -1;
+    read(&size, sizeof(size));
+    PADDLE_ENFORCE_GE(size,
+                      0,
+                      platform::errors::InvalidArgument(
+                          "phi::DenseTensor desc size should >= 0"));
+    PADDLE_ENFORCE_LE(*offset + size,
+                      file_size,
+                      platform::errors::InvalidArgument(
+                          "The file %s is truncated.", file->ipc_name()));
+    PADDLE_ENFORCE_EQ(
+        desc.ParseFromArray(base + *offset, size),
+        true,
+        platform::errors::InvalidArgument("Cannot parse tensor desc"));
+    *offset += size;
+  }
+  {
+    *offset = (*offset + kAlignedTensorAlignment - 1) /
+              kAlignedTensorAlignment * kAlignedTensorAlignment;
+    std::vector<int64_t> dims(desc.dims().begin(), desc.dims().end());
+    tensor->Resize(phi::make_ddim(dims));
+    auto dtype = framework::TransToPhiDataType(desc.data_type());
+    size_t size = tensor->numel() * phi::SizeOf(dtype);
+    PADDLE_ENFORCE_LE(*offset + size,
+                      file_size,
+                      platform::errors::InvalidArgument(
+                          "The file %s is truncated.", file->ipc_name()));
+    tensor->ResetHolderWithType(
+        std::make_shared<memory::allocation::FileMemoryMapSliceAllocation>(
+            base + *offset, size, file),
+        dtype);
+    *offset += size;
   }
-  // the 3st field, Tensor
-  paddle::framework::TensorToStream(
-      os, static_cast<phi::DenseTensor>(tensor), dev_ctx);
 }
+#endif
 
 void SerializeToStream(std::ostream &os, const phi::DenseTensor &tensor) {
   platform::DeviceContextPool &pool = platform::DeviceContextPool::Instance();
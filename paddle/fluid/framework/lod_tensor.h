@@ -29,6 +29,12 @@ limitations under the License. */
 #include "paddle/phi/core/mixed_vector.h"
 
 namespace paddle {
+namespace memory {
+namespace allocation {
+class FileMemoryMapAllocation;
+}  // namespace allocation
+}  // namespace memory
+
 namespace framework {
 
 // Split phi::DenseTensor and copy to each place specified in places.
@@ -182,6 +188,34 @@ void DeserializeFromStream(std::istream& is,
                            const size_t& seek,
                            const std::vector<int64_t>& shape);
 
+/*
+ * Serialize phi::DenseTensor to std::ostream in the aligned layout, which is
+ * the layout of SerializeToStream with kAlignedTensorVersion as the version
+ * of DenseTensor, and zero padding before the data of the tensor so that it
+ * starts at a multiple of kAlignedTensorAlignment bytes from the beginning of
+ * the stream. The tensors in a file of this layout can be loaded by
+ * DeserializeFromMappedFile without copying.
+ */
+constexpr uint32_t kAlignedTensorVersion = 0x4c415044;  // "DPAL"
+constexpr size_t kAlignedTensorAlignment = 64;
+
+void SerializeToAlignedStream(std::ostream& os,
+                              const phi::DenseTensor& tensor,
+                              const platform::DeviceContext& dev_ctx);
+
+#ifndef _WIN32
+/*
+ * Deserialize the phi::DenseTensor of the aligned layout at *offset of the
+ * mapped file, and move *offset to the end of it. The tensor holds its data
+ * in the pages of the mapping, which are shared with the other processes
+ * mapping the same file until written.
+ */
+void DeserializeFromMappedFile(
+    const std::shared_ptr<memory::allocation::FileMemoryMapAllocation>& file,
+    size_t* offset,
+    phi::DenseTensor* tensor);
+#endif
+
 LoD ConvertToOffsetBasedLoD(const LoD& length_lod);
 
 void SerializeToStream(std::ostream& os, const phi::DenseTensor& tensor);
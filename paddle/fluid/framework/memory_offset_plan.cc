@@ -0,0 +1,104 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/memory_offset_plan.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+struct PlannedVar {
+  const std::string* name;
+  size_t size;
+  std::pair<int, int> lifetime;
+  size_t offset;
+};
+
+}  // namespace
+
+MemoryOffsetPlan MakeMemoryOffsetPlan(
+    const std::unordered_map<std::string, std::pair<int, int>>& lifecycles,
+    const std::unordered_map<std::string, size_t>& sizes,
+    size_t alignment) {
+  PADDLE_ENFORCE_GT(alignment,
+                    0UL,
+                    platform::errors::InvalidArgument(
+                        "The alignment of the memory plan should be > 0."));
+  auto align = [alignment](size_t x) {
+    return (x + alignment - 1) / alignment * alignment;
+  };
+
+  std::vector<PlannedVar> vars;
+  for (auto& it : lifecycles) {
+    auto size_it = sizes.find(it.first);
+    if (size_it == sizes.end()) continue;
+    vars.push_back({&it.first, align(size_it->second), it.second, 0});
+  }
+  // Largest first, ties broken by name so the plan is reproducible.
+  std::sort(vars.begin(),
+            vars.end(),
+            [](const PlannedVar& a, const PlannedVar& b) {
+              if (a.size != b.size) return a.size > b.size;
+              return *a.name < *b.name;
+            });
+
+  MemoryOffsetPlan plan;
+  std::vector<const PlannedVar*> placed;
+  std::vector<const PlannedVar*> live;
+  for (auto& var : vars) {
+    live.clear();
+    for (auto* other : placed) {
+      if (other->lifetime.second >= var.lifetime.first &&
+          var.lifetime.second >= other->lifetime.first) {
+        live.push_back(other);
+      }
+    }
+    std::sort(live.begin(),
+              live.end(),
+              [](const PlannedVar* a, const PlannedVar* b) {
+                return a->offset < b->offset;
+              });
+
+    size_t best_offset = 0;
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t prev_end = 0;
+    for (auto* other : live) {
+      if (other->offset > prev_end) {
+        size_t gap = other->offset - prev_end;
+        if (gap >= var.size && gap < best_gap) {
+          best_gap = gap;
+          best_offset = prev_end;
+        }
+      }
+      prev_end = std::max(prev_end, other->offset + other->size);
+    }
+    var.offset =
+        best_gap == std::numeric_limits<size_t>::max() ? prev_end : best_offset;
+
+    plan.offsets[*var.name] = var.offset;
+    plan.arena_size = std::max(plan.arena_size, var.offset + var.size);
+    placed.push_back(&var);
+  }
+  return plan;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,50 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace paddle {
+namespace framework {
+
+/*
+ * Places every variable at a byte offset inside one arena, so that two
+ * variables whose lifetimes overlap never share bytes. Unlike the name-based
+ * clusters of the reuse plan, whose size is that of their largest member, a
+ * small variable can take the gap left below a larger one.
+ *
+ * The variables are placed from the largest to the smallest, each one into
+ * the smallest gap, between the variables already placed with an overlapping
+ * lifetime, that fits it (best fit), or above all of them if none does.
+ */
+struct MemoryOffsetPlan {
+  // The offset of each variable, a multiple of the alignment.
+  std::unordered_map<std::string, size_t> offsets;
+  // The bytes the arena needs to hold all the variables.
+  size_t arena_size{0};
+};
+
+// lifecycles: the first and the last step, both inclusive, at which each
+// variable is alive. sizes: the bytes of each variable; variables missing
+// from either map are not planned.
+MemoryOffsetPlan MakeMemoryOffsetPlan(
+    const std::unordered_map<std::string, std::pair<int, int>>& lifecycles,
+    const std::unordered_map<std::string, size_t>& sizes,
+    size_t alignment = 64);
+
+}  // namespace framework
+}  // namespace paddle
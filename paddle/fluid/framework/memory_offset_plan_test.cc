@@ -0,0 +1,100 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/memory_offset_plan.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace paddle {
+namespace framework {
+
+using Lifecycles = std::unordered_map<std::string, std::pair<int, int>>;
+using Sizes = std::unordered_map<std::string, size_t>;
+
+static void CheckNoConflict(const Lifecycles& lifecycles,
+                            const Sizes& sizes,
+                            const MemoryOffsetPlan& plan,
+                            size_t alignment) {
+  for (auto& a : plan.offsets) {
+    EXPECT_EQ(a.second % alignment, 0UL);
+    EXPECT_LE(a.second + sizes.at(a.first), plan.arena_size);
+    for (auto& b : plan.offsets) {
+      if (a.first >= b.first) continue;
+      auto la = lifecycles.at(a.first);
+      auto lb = lifecycles.at(b.first);
+      if (la.second < lb.first || lb.second < la.first) continue;
+      bool disjoint = a.second + sizes.at(a.first) <= b.second ||
+                      b.second + sizes.at(b.first) <= a.second;
+      EXPECT_TRUE(disjoint) << a.first << " and " << b.first << " overlap";
+    }
+  }
+}
+
+TEST(MemoryOffsetPlan, Basic) {
+  // a: [0, 1] 256B, b: [1, 2] 64B, c: [2, 3] 128B, d: [3, 4] 256B
+  Lifecycles lifecycles{{"a", {0, 1}}, {"b", {1, 2}}, {"c", {2, 3}}};
+  lifecycles["d"] = {3, 4};
+  lifecycles["persistable"] = {0, 4};
+  Sizes sizes{{"a", 256}, {"b", 64}, {"c", 128}, {"d", 256}};
+
+  auto plan = MakeMemoryOffsetPlan(lifecycles, sizes, 64);
+  CheckNoConflict(lifecycles, sizes, plan, 64);
+  // Variables without a size are not planned.
+  EXPECT_EQ(plan.offsets.count("persistable"), 0UL);
+  // a and d never live together, so they share the bottom of the arena.
+  EXPECT_EQ(plan.offsets["a"], 0UL);
+  EXPECT_EQ(plan.offsets["d"], 0UL);
+  EXPECT_EQ(plan.arena_size, 448UL);
+}
+
+TEST(MemoryOffsetPlan, BestFit) {
+  // p dies early, and leaves a hole below q that s, r and t fill instead of
+  // growing the arena.
+  Lifecycles lifecycles{
+      {"p", {0, 3}}, {"q", {0, 9}}, {"r", {5, 9}}, {"s", {5, 9}}};
+  lifecycles["t"] = {6, 9};
+  Sizes sizes{{"p", 1024}, {"q", 512}, {"r", 256}, {"s", 500}, {"t", 128}};
+  auto plan = MakeMemoryOffsetPlan(lifecycles, sizes, 64);
+  CheckNoConflict(lifecycles, sizes, plan, 64);
+  EXPECT_EQ(plan.offsets["q"], 1024UL);
+  EXPECT_EQ(plan.offsets["s"], 0UL);
+  EXPECT_EQ(plan.offsets["r"], 512UL);
+  EXPECT_EQ(plan.offsets["t"], 768UL);
+  EXPECT_EQ(plan.arena_size, 1536UL);
+}
+
+TEST(MemoryOffsetPlan, Random) {
+  std::mt19937 rng(0);
+  for (int round = 0; round < 20; round++) {
+    Lifecycles lifecycles;
+    Sizes sizes;
+    size_t peak_bound = 0;
+    for (int i = 0; i < 100; i++) {
+      std::string name = "var" + std::to_string(i);
+      int begin = rng() % 50;
+      lifecycles[name] = {begin, begin + static_cast<int>(rng() % 10)};
+      sizes[name] = 1 + rng() % 4096;
+      peak_bound += (sizes[name] + 31) / 32 * 32;
+    }
+    auto plan = MakeMemoryOffsetPlan(lifecycles, sizes, 32);
+    EXPECT_EQ(plan.offsets.size(), 100UL);
+    EXPECT_LE(plan.arena_size, peak_bound);
+    CheckNoConflict(lifecycles, sizes, plan, 32);
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
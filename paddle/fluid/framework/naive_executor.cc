@@ -14,13 +14,16 @@
 
 #include "paddle/fluid/framework/naive_executor.h"
 
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 
+#include "paddle/fluid/framework/memory_offset_plan.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/variable_helper.h"
+#include "paddle/fluid/memory/malloc.h"
 #include "paddle/fluid/platform/denormal.h"
 #ifdef PADDLE_WITH_MKLDNN
 #include "paddle/fluid/platform/mkldnn_helper.h"
@@ -34,6 +37,27 @@
 
 namespace paddle {
 namespace framework {
+
+namespace {
+
+// A slot of the arena. It holds the arena, so tensors still sharing a slot
+// stay valid after the arena is re-planned.
+class ArenaSlotAllocation : public phi::Allocation {
+ public:
+  ArenaSlotAllocation(std::shared_ptr<phi::Allocation> arena,
+                      size_t offset,
+                      size_t size)
+      : phi::Allocation(static_cast<uint8_t *>(arena->ptr()) + offset,
+                        size,
+                        arena->place()),
+        arena_(std::move(arena)) {}
+
+ private:
+  std::shared_ptr<phi::Allocation> arena_;
+};
+
+}  // namespace
+
 void NaiveExecutor::Prepare(Scope *scope,
                             const ProgramDesc &program_desc,
                             int block_id,
@@ -57,6 +81,9 @@ void NaiveExecutor::Run() {
 #ifdef PADDLE_WITH_INFERENCE_NVTX
   platform::CudaNvtxRangePush("model", platform::NvtxRangeColor::Yellow);
 #endif
+  if (arena_replan_) {
+    PlanArena();
+  }
   for (auto &op : ops_) {
     VLOG(4) << std::this_thread::get_id() << " run "
             << op->DebugStringEx(scope_) << " on scope " << scope_;
@@ -72,6 +99,12 @@ void NaiveExecutor::Run() {
         it.first->ShareBufferWith(*cluster_buffer_[it.second], true);
       }
     }
+    auto arena_it = arena_outputs_.find(op.get());
+    if (arena_it != arena_outputs_.end()) {
+      for (auto *var : arena_it->second) {
+        var->tensor->ShareBufferWith(var->slot, true);
+      }
+    }
 
     op->Run(*scope_, place_);
 
@@ -84,6 +117,18 @@ void NaiveExecutor::Run() {
         }
       }
     }
+    // A var larger than its slot has been given its own memory by the op,
+    // record the size it needs for the next plan.
+    if (arena_it != arena_outputs_.end()) {
+      for (auto *var : arena_it->second) {
+        if (!var->tensor->initialized()) continue;
+        size_t bytes = var->tensor->numel() * phi::SizeOf(var->tensor->dtype());
+        if (bytes > var->size) {
+          var->size = bytes;
+          arena_replan_ = true;
+        }
+      }
+    }
 
 #ifdef PADDLE_WITH_INFERENCE_NVTX
     platform::CudaNvtxRangePop();
@@ -211,6 +256,64 @@ void NaiveExecutor::MakeReusePlan(
   }
 }
 
+void NaiveExecutor::MakeArenaPlan(
+    const std::unordered_map<std::string, size_t> &var_sizes) {
+  // Vars read before being written are fed from outside, leave them alone.
+  std::unordered_set<std::string> external_vars;
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    auto *op = ops_[i].get();
+    for (auto &name : op->InputVars()) {
+      auto it = arena_vars_.find(name);
+      if (it != arena_vars_.end()) {
+        it->second.lifetime.second = static_cast<int>(i);
+      } else if (var_sizes.count(name)) {
+        external_vars.insert(name);
+      }
+    }
+    for (auto &name : op->OutputVars(true)) {
+      if (!var_sizes.count(name) || external_vars.count(name)) continue;
+      auto it = arena_vars_.find(name);
+      if (it != arena_vars_.end()) {
+        it->second.lifetime.second = static_cast<int>(i);
+        continue;
+      }
+      auto *var = scope_->FindVar(name);
+      if (!var || !var->IsType<phi::DenseTensor>()) continue;
+      auto &arena_var = arena_vars_[name];
+      arena_var.tensor = var->GetMutable<phi::DenseTensor>();
+      arena_var.lifetime = {static_cast<int>(i), static_cast<int>(i)};
+      arena_var.size = var_sizes.at(name);
+      // Only the first writer binds the slot, later writers may update the
+      // var in place.
+      arena_outputs_[op].push_back(&arena_var);
+    }
+  }
+  arena_replan_ = !arena_vars_.empty();
+}
+
+void NaiveExecutor::PlanArena() {
+  std::unordered_map<std::string, std::pair<int, int>> lifecycles;
+  std::unordered_map<std::string, size_t> sizes;
+  for (auto &it : arena_vars_) {
+    lifecycles.emplace(it.first, it.second.lifetime);
+    sizes.emplace(it.first, std::max<size_t>(it.second.size, 1));
+  }
+  auto plan = MakeMemoryOffsetPlan(lifecycles, sizes);
+  std::shared_ptr<phi::Allocation> arena =
+      memory::AllocShared(place_, plan.arena_size);
+  for (auto &it : arena_vars_) {
+    auto &var = it.second;
+    var.slot = phi::DenseTensor();
+    var.slot.ResetHolder(std::make_shared<ArenaSlotAllocation>(
+        arena, plan.offsets.at(it.first), sizes.at(it.first)));
+    // Release the memory the var may have been given in the last run.
+    var.tensor->ShareBufferWith(var.slot, true);
+  }
+  arena_replan_ = false;
+  VLOG(3) << "NaiveExecutor places " << arena_vars_.size()
+          << " vars in an arena of " << plan.arena_size << " bytes";
+}
+
 NaiveExecutor::~NaiveExecutor() {
 #ifdef PADDLE_WITH_MKLDNN
   // Clear mkl-dnn cache,
@@ -18,6 +18,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "paddle/fluid/framework/operator.h"
@@ -71,6 +72,12 @@ class NaiveExecutor {
   void MakeReusePlan(
       const std::unordered_map<std::string, std::string>& reuse_table);
 
+  // Place the outputs of the ops in var_sizes at fixed offsets of a single
+  // arena, planned from their lifetimes in the op order. var_sizes holds the
+  // estimated bytes of each var; when a var outgrows its slot, it falls back
+  // to its own memory and the arena is re-planned on the next Run.
+  void MakeArenaPlan(const std::unordered_map<std::string, size_t>& var_sizes);
+
   void ResetTrtOps(int num);
 
   void RegisterOutputHook(const HookFunc& hookfunc);
@@ -80,6 +87,8 @@ class NaiveExecutor {
                  int block_id,
                  bool with_feed_fetch_ops);
 
+  void PlanArena();
+
  private:
   const platform::Place place_;
   // Catch the required resource to avoid recreate.
@@ -92,6 +101,18 @@ class NaiveExecutor {
   std::unordered_map<OperatorBase*, std::unordered_map<phi::DenseTensor*, int>>
       reuse_cache_;
   std::vector<phi::DenseTensor*> cluster_buffer_;
+
+  // The arena mode of memory reuse, see MakeArenaPlan.
+  struct ArenaVar {
+    phi::DenseTensor* tensor{nullptr};
+    std::pair<int, int> lifetime;
+    size_t size{0};
+    // A tensor viewing the slot of the var in the arena.
+    phi::DenseTensor slot;
+  };
+  std::unordered_map<std::string, ArenaVar> arena_vars_;
+  std::unordered_map<OperatorBase*, std::vector<ArenaVar*>> arena_outputs_;
+  bool arena_replan_{false};
 };
 
 }  // namespace framework
@@ -0,0 +1,213 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/analysis_cache.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+#include "glog/logging.h"
+#include "paddle/phi/core/flags.h"
+
+PADDLE_DEFINE_EXPORTED_string(
+    new_executor_analysis_cache_dir,
+    "",
+    "The directory to cache the dependencies and garbage collection plan "
+    "of the instructions analysed by standalone executor, which are reused "
+    "by the executors of the same program in later processes. Empty to "
+    "disable the cache.");
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+namespace {
+
+constexpr uint64_t kAnalysisCacheMagic = 0x3148434149454450ULL;  // PDEIACH1
+constexpr uint64_t kAnalysisCacheVersion = 2;
+
+class CacheWriter {
+ public:
+  explicit CacheWriter(FILE* fp) : fp_(fp) {}
+  void Write(uint64_t value) {
+    ok_ = ok_ && fwrite(&value, sizeof(value), 1, fp_) == 1;
+  }
+  void Write(const std::set<size_t>& values) {
+    Write(values.size());
+    for (size_t value : values) {
+      Write(value);
+    }
+  }
+  bool ok() const { return ok_; }
+
+ private:
+  FILE* fp_;
+  bool ok_{true};
+};
+
+class CacheReader {
+ public:
+  explicit CacheReader(FILE* fp) : fp_(fp) {}
+  uint64_t Read() {
+    uint64_t value = 0;
+    ok_ = ok_ && fread(&value, sizeof(value), 1, fp_) == 1;
+    return value;
+  }
+  // Reads an id less than bound.
+  uint64_t ReadId(size_t bound) {
+    uint64_t value = Read();
+    ok_ = ok_ && value < bound;
+    return value;
+  }
+  // Reads a set of ids less than bound.
+  void Read(size_t bound, std::set<size_t>* values) {
+    uint64_t size = Read();
+    for (uint64_t i = 0; ok_ && i < size; ++i) {
+      values->insert(ReadId(bound));
+    }
+  }
+  bool ok() const { return ok_; }
+
+ private:
+  FILE* fp_;
+  bool ok_{true};
+};
+
+}  // namespace
+
+std::string AnalysisCachePath(uint64_t key) {
+  if (FLAGS_new_executor_analysis_cache_dir.empty()) {
+    return "";
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.analysis", (unsigned long long)key);
+  return FLAGS_new_executor_analysis_cache_dir + "/" + name;
+}
+
+bool LoadInstructionAnalysis(const std::string& path,
+                             uint64_t key,
+                             size_t op_num,
+                             size_t var_num,
+                             InstructionAnalysis* analysis) {
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (fp == nullptr) {
+    return false;
+  }
+  CacheReader reader(fp);
+  bool matched = reader.Read() == kAnalysisCacheMagic &&
+                 reader.Read() == kAnalysisCacheVersion &&
+                 reader.Read() == key && reader.Read() == op_num;
+  if (!matched || !reader.ok()) {
+    fclose(fp);
+    VLOG(4) << "Analysis cache " << path << " does not match, ignore it.";
+    return false;
+  }
+
+  InstructionAnalysis result;
+  uint64_t downstream_num = reader.Read();
+  for (uint64_t i = 0; reader.ok() && i < downstream_num; ++i) {
+    uint64_t op_idx = reader.ReadId(op_num);
+    if (reader.ok()) {
+      reader.Read(op_num, &result.op_downstream_map[op_idx]);
+    }
+  }
+  // the rows of op_happens_before, packed in 64-bit words
+  result.op_happens_before.assign(op_num, std::vector<bool>(op_num, false));
+  for (size_t i = 0; reader.ok() && i < op_num; ++i) {
+    for (size_t j = 0; j < op_num; j += 64) {
+      uint64_t word = reader.Read();
+      for (size_t k = j; k < std::min(op_num, j + 64); ++k) {
+        result.op_happens_before[i][k] = (word >> (k - j)) & 1;
+      }
+    }
+  }
+  uint64_t live_var_num = reader.Read();
+  for (uint64_t i = 0; reader.ok() && i < live_var_num; ++i) {
+    uint64_t var_id = reader.ReadId(var_num);
+    if (reader.ok()) {
+      reader.Read(op_num, &result.last_live_ops[var_id]);
+    }
+  }
+  uint64_t event_num = reader.Read();
+  for (uint64_t i = 0; reader.ok() && i < event_num; ++i) {
+    uint64_t recorder = reader.ReadId(op_num);
+    uint64_t waiter = reader.ReadId(op_num);
+    result.events.emplace_back(recorder, waiter);
+  }
+  bool ok = reader.ok() && fgetc(fp) == EOF;
+  fclose(fp);
+  if (!ok) {
+    LOG(WARNING) << "Analysis cache " << path << " is corrupted, ignore it.";
+    return false;
+  }
+  *analysis = std::move(result);
+  return true;
+}
+
+void SaveInstructionAnalysis(const std::string& path,
+                             uint64_t key,
+                             const InstructionAnalysis& analysis) {
+  std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+  FILE* fp = fopen(tmp_path.c_str(), "wb");
+  if (fp == nullptr) {
+    LOG(WARNING) << "Failed to open " << tmp_path << " to save the analysis.";
+    return;
+  }
+  size_t op_num = analysis.op_happens_before.size();
+  CacheWriter writer(fp);
+  writer.Write(kAnalysisCacheMagic);
+  writer.Write(kAnalysisCacheVersion);
+  writer.Write(key);
+  writer.Write(op_num);
+  writer.Write(analysis.op_downstream_map.size());
+  for (auto& pair : analysis.op_downstream_map) {
+    writer.Write(pair.first);
+    writer.Write(pair.second);
+  }
+  for (size_t i = 0; i < op_num; ++i) {
+    for (size_t j = 0; j < op_num; j += 64) {
+      uint64_t word = 0;
+      for (size_t k = j; k < std::min(op_num, j + 64); ++k) {
+        word |= static_cast<uint64_t>(analysis.op_happens_before[i][k])
+                << (k - j);
+      }
+      writer.Write(word);
+    }
+  }
+  writer.Write(analysis.last_live_ops.size());
+  for (auto& pair : analysis.last_live_ops) {
+    writer.Write(pair.first);
+    writer.Write(pair.second);
+  }
+  writer.Write(analysis.events.size());
+  for (auto& event : analysis.events) {
+    writer.Write(event.first);
+    writer.Write(event.second);
+  }
+  bool ok = writer.ok();
+  ok = fclose(fp) == 0 && ok;
+  if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Failed to save the analysis to " << path << ".";
+    unlink(tmp_path.c_str());
+    return;
+  }
+  VLOG(4) << "Save the analysis of " << op_num << " instructions to " << path;
+}
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
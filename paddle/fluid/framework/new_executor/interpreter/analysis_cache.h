@@ -0,0 +1,70 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gflags/gflags.h"
+
+DECLARE_string(new_executor_analysis_cache_dir);
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+// The part of the analysis of an instruction list by InterpreterCore that is
+// quadratic in the number of instructions, and is the same for every
+// InterpreterCore of the same program, place and flags: the dependencies
+// between the instructions, the plan of garbage collection and the events
+// between the streams.
+struct InstructionAnalysis {
+  std::map<size_t, std::set<size_t>> op_downstream_map;
+  std::vector<std::vector<bool>> op_happens_before;
+  // last_live_ops[i] is the set of instructions after which the i-th var is
+  // checked for garbage collection
+  std::map<size_t, std::set<size_t>> last_live_ops;
+  // the (recorder, waiter) instructions of StreamAnalyzer::AnalyseEvents
+  std::vector<std::pair<size_t, size_t>> events;
+};
+
+// Returns the path of the cache file of key in
+// FLAGS_new_executor_analysis_cache_dir, or an empty string if the cache is
+// disabled.
+std::string AnalysisCachePath(uint64_t key);
+
+// Loads the analysis of op_num instructions and var_num vars saved with key
+// to path. Returns false if there is no such file, it is of another key,
+// version or number of instructions, or it has an id out of range.
+bool LoadInstructionAnalysis(const std::string& path,
+                             uint64_t key,
+                             size_t op_num,
+                             size_t var_num,
+                             InstructionAnalysis* analysis);
+
+// Saves the analysis to path, through a temporary file renamed in the end so
+// that processes sharing the cache never read a partial file. Failing to
+// save is only warned, as the cache is an optimization.
+void SaveInstructionAnalysis(const std::string& path,
+                             uint64_t key,
+                             const InstructionAnalysis& analysis);
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
@@ -115,6 +115,25 @@ const std::map<size_t, std::set<size_t>>& DependencyBuilder::OpDownstreamMap()
   return op_downstream_map_;
 }
 
+void DependencyBuilder::Restore(
+    const std::vector<Instruction>& instructions,
+    std::map<size_t, std::set<size_t>>&& op_downstream_map,
+    std::vector<std::vector<bool>>&& op_happens_before) {
+  PADDLE_ENFORCE_EQ(
+      op_happens_before.size(),
+      instructions.size(),
+      phi::errors::InvalidArgument(
+          "The dependencies to restore are of %d instructions, but there are "
+          "%d instructions.",
+          op_happens_before.size(),
+          instructions.size()));
+  instructions_ = &instructions;
+  op_num_ = instructions.size();
+  op_downstream_map_ = std::move(op_downstream_map);
+  op_happens_before_ = std::move(op_happens_before);
+  is_build_ = true;
+}
+
 void DependencyBuilder::AddDependencyForCoalesceTensorOp() {
   for (size_t op_idx = 0; op_idx < op_num_; ++op_idx) {
     if (instructions_->at(op_idx).OpBase()->Type() == kCoalesceTensor) {
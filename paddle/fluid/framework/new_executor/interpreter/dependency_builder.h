@@ -42,6 +42,16 @@ class DependencyBuilder {
 
   const std::map<size_t, std::set<size_t>>& OpDownstreamMap() const;
 
+  // restore the dependencies built for the same instructions before, e.g.
+  // loaded from the analysis cache, instead of building them
+  void Restore(const std::vector<Instruction>& instructions,
+               std::map<size_t, std::set<size_t>>&& op_downstream_map,
+               std::vector<std::vector<bool>>&& op_happens_before);
+
+  const std::vector<std::vector<bool>>& OpHappensBeforeMatrix() const {
+    return op_happens_before_;
+  }
+
   bool OpHappensBefore(size_t prior_op_idx, size_t posterior_op_idx) const {
     PADDLE_ENFORCE_GE(
         op_happens_before_.size(),
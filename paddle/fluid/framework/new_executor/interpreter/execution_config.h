@@ -30,6 +30,11 @@ struct ExecutionConfig {
   bool used_for_control_flow_op{false};
   bool used_for_jit{false};
 
+  // Dispatch host instructions through a WorkStealingThreadPool: the first
+  // ready successor runs inline, the others are pushed onto the current
+  // worker's own queue and idle workers steal from others.
+  bool use_work_stealing{false};
+
   size_t device_num_threads{0};
   size_t host_num_threads{0};
 
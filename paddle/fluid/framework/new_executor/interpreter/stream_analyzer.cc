@@ -72,10 +72,10 @@ inline std::string RunTypeToString(DownstreamRunType run_type) {
   }
 }
 
-void StreamAnalyzer::ConstructEvents(
-    std::vector<Instruction>* instructions) const {
-  std::vector<Instruction> cross_step_merged_instructions = *instructions;
-  for (const Instruction& instr : *instructions) {
+std::vector<std::pair<size_t, size_t>> StreamAnalyzer::AnalyseEvents(
+    const std::vector<Instruction>& instructions) const {
+  std::vector<Instruction> cross_step_merged_instructions = instructions;
+  for (const Instruction& instr : instructions) {
     cross_step_merged_instructions.emplace_back(instr);
   }
 
@@ -99,45 +99,53 @@ void StreamAnalyzer::ConstructEvents(
       cross_step_merged_instructions, run_type_info, &event_info);
   ShrinkEventInfo(dependency_builder, &event_info);
 
-  // Construct events
-  std::map<size_t, std::shared_ptr<DeviceEvent>> instr2event;
+  std::vector<std::pair<size_t, size_t>> events;
   for (auto& context_item : event_info) {
     for (auto& waiter_item : context_item.second) {
       size_t waiter_instr_id = waiter_item.first;
       std::set<size_t>& recorder_instr_ids = waiter_item.second;
 
-      if (waiter_instr_id >= instructions->size()) {
-        waiter_instr_id -= instructions->size();
+      if (waiter_instr_id >= instructions.size()) {
+        waiter_instr_id -= instructions.size();
       }
 
       for (size_t recorder_instr_id : recorder_instr_ids) {
         // Redundant record
-        if (recorder_instr_id >= instructions->size()) {
+        if (recorder_instr_id >= instructions.size()) {
           continue;
         }
-
-        Instruction& recorder_instr = instructions->at(recorder_instr_id);
-        Instruction& waiter_instr = instructions->at(waiter_instr_id);
-        platform::DeviceType waiter_type = GetWaiterType(waiter_instr);
-
-        if (instr2event.find(recorder_instr_id) == instr2event.end()) {
-          std::shared_ptr<DeviceEvent> device_event =
-              std::make_shared<DeviceEvent>(
-                  recorder_instr.DeviceContext().GetPlace(),
-                  platform::GenerateDeviceEventFlag());
-          recorder_instr.AddEventToRecord(device_event,
-                                          platform::kCUDA /*unused*/);
-          instr2event.emplace(recorder_instr_id, device_event);
-        }
-
-        waiter_instr.AddEventToWait(
-            recorder_instr_id, instr2event.at(recorder_instr_id), waiter_type);
-        VLOG(6) << "Add event: " << recorder_instr.OpBase()->Type() << "("
-                << recorder_instr_id << ") -> " << waiter_instr.OpBase()->Type()
-                << "(" << waiter_instr_id << "), waiter type = " << waiter_type;
+        events.emplace_back(recorder_instr_id, waiter_instr_id);
       }
     }
   }
+  return events;
+}
+
+void StreamAnalyzer::ConstructEvents(
+    const std::vector<std::pair<size_t, size_t>>& events,
+    std::vector<Instruction>* instructions) const {
+  std::map<size_t, std::shared_ptr<DeviceEvent>> instr2event;
+  for (auto& event : events) {
+    size_t recorder_instr_id = event.first;
+    size_t waiter_instr_id = event.second;
+    Instruction& recorder_instr = instructions->at(recorder_instr_id);
+    Instruction& waiter_instr = instructions->at(waiter_instr_id);
+    platform::DeviceType waiter_type = GetWaiterType(waiter_instr);
+
+    if (instr2event.find(recorder_instr_id) == instr2event.end()) {
+      std::shared_ptr<DeviceEvent> device_event = std::make_shared<DeviceEvent>(
+          recorder_instr.DeviceContext().GetPlace(),
+          platform::GenerateDeviceEventFlag());
+      recorder_instr.AddEventToRecord(device_event, platform::kCUDA /*unused*/);
+      instr2event.emplace(recorder_instr_id, device_event);
+    }
+
+    waiter_instr.AddEventToWait(
+        recorder_instr_id, instr2event.at(recorder_instr_id), waiter_type);
+    VLOG(6) << "Add event: " << recorder_instr.OpBase()->Type() << "("
+            << recorder_instr_id << ") -> " << waiter_instr.OpBase()->Type()
+            << "(" << waiter_instr_id << "), waiter type = " << waiter_type;
+  }
 }
 
 DeviceContext* StreamAnalyzer::ParseDeviceContext(
@@ -15,6 +15,7 @@
 #pragma once
 #include <future>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "paddle/fluid/framework/new_executor/interpreter/dependency_builder.h"
@@ -37,7 +38,13 @@ class StreamAnalyzer {
 
   ~StreamAnalyzer() {}
 
-  void ConstructEvents(std::vector<Instruction>* instructions) const;
+  // Returns the (recorder, waiter) instruction pairs to add events between,
+  // analysed from two consecutive steps of the instructions.
+  std::vector<std::pair<size_t, size_t>> AnalyseEvents(
+      const std::vector<Instruction>& instructions) const;
+
+  void ConstructEvents(const std::vector<std::pair<size_t, size_t>>& events,
+                       std::vector<Instruction>* instructions) const;
 
   platform::DeviceContext* ParseDeviceContext(
       const OpFuncNode& op_func_node) const;
@@ -14,12 +14,16 @@
 
 #include "paddle/fluid/framework/new_executor/interpretercore.h"
 
+#include <xxhash.h>
+
+#include <sstream>
 #include <unordered_set>
 
 #include "gflags/gflags.h"
 
 #include "paddle/fluid/framework/details/nan_inf_utils.h"
 #include "paddle/fluid/framework/details/share_tensor_buffer_functor.h"
+#include "paddle/fluid/framework/new_executor/interpreter/analysis_cache.h"
 #include "paddle/fluid/framework/new_executor/interpreter/interpreter_util.h"
 #include "paddle/fluid/framework/new_executor/interpreter/static_build.h"
 #include "paddle/fluid/framework/operator.h"
@@ -50,10 +54,16 @@ PADDLE_DEFINE_EXPORTED_bool(new_executor_use_local_scope,
                             true,
                             "Use local_scope in new executor(especially used "
                             "in UT), can turn off for better performance");
+PADDLE_DEFINE_EXPORTED_bool(new_executor_use_work_stealing,
+                            false,
+                            "Use work-stealing scheduling for host "
+                            "instructions in new executor");
 
 DECLARE_bool(check_nan_inf);
 DECLARE_bool(benchmark);
 DECLARE_bool(new_executor_use_cuda_graph);
+DECLARE_bool(new_executor_sequential_run);
+DECLARE_bool(add_dependency_for_communication_op);
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 DECLARE_bool(sync_nccl_allreduce);
 #endif
@@ -120,6 +130,13 @@ InterpreterCore::InterpreterCore(const platform::Place& place,
   if (!FLAGS_new_executor_use_local_scope) {
     execution_config_.create_local_scope = false;
   }
+  if (FLAGS_new_executor_use_work_stealing) {
+    execution_config_.use_work_stealing = true;
+  }
+  // In serial run, all instructions are executed in the same thread
+  if (FLAGS_new_executor_serial_run) {
+    execution_config_.use_work_stealing = false;
+  }
   execution_config_.AnalyzeThreadPoolConfig(place, block.OpSize());
   execution_config_.Log(/*log_level=*/8);
 
@@ -147,6 +164,7 @@ InterpreterCore::~InterpreterCore() {
   // cancle gc's thread
   gc_.reset(nullptr);
   async_work_queue_.reset();
+  work_stealing_pool_.reset();
   VLOG(4) << "~InterpreterCore(): " << this << " on " << place_;
 
 #ifdef PADDLE_WITH_MKLDNN
@@ -652,6 +670,60 @@ void InterpreterCore::ClearLoDTensorArrayInLocalScope() {
   }
 }
 
+uint64_t InterpreterCore::AnalysisCacheKey() const {
+  // everything the dependencies and the gc plan are analysed from, besides
+  // the ops and vars in the program
+  std::ostringstream os;
+  os << block_.Program()->CachedHashString() << "/" << block_.ID() << "/"
+     << place_ << "/" << FLAGS_new_executor_sequential_run << "/"
+     << FLAGS_add_dependency_for_communication_op << "\n";
+  for (const std::string& skip_gc_var : execution_config_.skip_gc_vars) {
+    os << skip_gc_var << " ";
+  }
+  os << "\n";
+  auto print_ids = [&os](const std::map<std::string, std::vector<int>>& ids) {
+    for (auto& pair : ids) {
+      os << pair.first << ":";
+      for (int id : pair.second) {
+        os << id << ",";
+      }
+      os << ";";
+    }
+  };
+  // the events between the instructions depend on their kernel types and
+  // on which of them share a device context
+  std::map<const platform::DeviceContext*, size_t> dev_ctx_ids;
+  for (const Instruction& instr : vec_instruction_) {
+    auto dev_ctx_id =
+        dev_ctx_ids.emplace(&instr.DeviceContext(), dev_ctx_ids.size());
+    os << instr.OpBase()->Type() << "["
+       << static_cast<int>(instr.KernelType()) << "@"
+       << dev_ctx_id.first->second << "](";
+    print_ids(instr.Inputs());
+    os << ")(";
+    print_ids(instr.Outputs());
+    os << ")(";
+    for (auto& pair : instr.InplaceBackMap()) {
+      os << pair.first << "=" << pair.second << ",";
+    }
+    os << ")\n";
+  }
+  // whether a var is gc-ed depends on its owner block and its type
+  Scope* inner_scope =
+      HasLocalScope() ? local_scope_ : var_scope_.GetMutableScope();
+  for (size_t i = 0; i < var_scope_.VarSize(); ++i) {
+    const std::string& name = var_scope_.GetNameById(static_cast<int>(i));
+    Variable* var = inner_scope->FindVar(name);
+    os << name << ":" << block_.HasVar(name) << ":"
+       << (var ? static_cast<int>(var->Type()) : -1) << "\n";
+  }
+  for (auto& pair : var_scope_.DataTransferAddedVars()) {
+    os << pair.first << ":" << pair.second << "\n";
+  }
+  std::string str = os.str();
+  return XXH64(str.c_str(), str.size(), 1);
+}
+
 void InterpreterCore::Convert(
     std::vector<paddle::framework::OpFuncNode>* op_func_nodes) {
   auto& vec_meta_info = var_scope_.MutableVecMetaInfo();
@@ -687,6 +759,24 @@ void InterpreterCore::Convert(
 #endif
   }
 
+  // reuse the analysis cached by an InterpreterCore of the same program
+  interpreter::InstructionAnalysis analysis;
+  uint64_t analysis_key = 0;
+  std::string analysis_path;
+  bool analysis_cached = false;
+  if (!FLAGS_new_executor_analysis_cache_dir.empty()) {
+    analysis_key = AnalysisCacheKey();
+    analysis_path = interpreter::AnalysisCachePath(analysis_key);
+    analysis_cached = interpreter::LoadInstructionAnalysis(
+        analysis_path, analysis_key, op_nums, var_scope_.VarSize(), &analysis);
+  }
+  if (analysis_cached) {
+    VLOG(4) << "Reuse the analysis cached in " << analysis_path;
+    dependency_builder_.Restore(vec_instruction_,
+                                std::move(analysis.op_downstream_map),
+                                std::move(analysis.op_happens_before));
+  }
+
   BuildOperatorDependences();
 
   // NOTE(Ruibiao): For cross-step stream synchronization, an event may be
@@ -695,7 +785,10 @@ void InterpreterCore::Convert(
   // before the first call to RecordEvent, an Event represents an empty set of
   // work and WaitEvent always return succeed immediately, we omit the
   // prelude-record for the first step here.
-  stream_analyzer_.ConstructEvents(&vec_instruction_);
+  if (!analysis_cached) {
+    analysis.events = stream_analyzer_.AnalyseEvents(vec_instruction_);
+  }
+  stream_analyzer_.ConstructEvents(analysis.events, &vec_instruction_);
 
   // add event for the input var of jit program, since there are async copied
   // from gpu_pinned place to gpu place on compute stream.
@@ -721,105 +814,124 @@ void InterpreterCore::Convert(
     }
   }
 
-  // calculate last_live_ops_
-  for (size_t op_idx = 0; op_idx < op_nums; ++op_idx) {
-    Instruction& instr = vec_instruction_[op_idx];
-    OpInOutInfo info;
-    info.Build(instr.OpBase());
+  if (analysis_cached) {
+    last_live_ops_ = std::move(analysis.last_live_ops);
+    for (auto& pair : last_live_ops_) {
+      for (size_t item : pair.second) {
+        vec_instruction_[item].AddGCCheckVar(pair.first);
+      }
+      vec_meta_info[pair.first].var_ref_count_ = pair.second.size();
+    }
+  } else {
+    // calculate last_live_ops_
+    for (size_t op_idx = 0; op_idx < op_nums; ++op_idx) {
+      Instruction& instr = vec_instruction_[op_idx];
+      OpInOutInfo info;
+      info.Build(instr.OpBase());
 
-    std::set<size_t> gc_check_vars;
+      std::set<size_t> gc_check_vars;
 
-    const std::map<std::string, std::vector<int>>& ins = instr.Inputs();
-    const std::map<std::string, std::vector<int>>& outs = instr.Outputs();
-    std::multimap<std::string, std::vector<int>> ins_and_outs{ins.begin(),
-                                                              ins.end()};
-    ins_and_outs.insert(outs.begin(), outs.end());
+      const std::map<std::string, std::vector<int>>& ins = instr.Inputs();
+      const std::map<std::string, std::vector<int>>& outs = instr.Outputs();
+      std::multimap<std::string, std::vector<int>> ins_and_outs{ins.begin(),
+                                                                ins.end()};
+      ins_and_outs.insert(outs.begin(), outs.end());
 
-    for (auto& item : ins_and_outs) {
-      for (auto id : item.second) {
-        if (id == kEmptyVarIndex) {
-          continue;
-        }
-        auto* var_desc = var_scope_.VarDesc(id);
-        // skip no_need_buffer input vars
-        if (var_desc && ins.count(item.first) &&
-            !info.IsInArgBufferNeeded(var_desc->Name())) {
-          continue;
-        }
-        // skip when this var is not in block and not a data_transferred var,
-        // which means this var is managed by other block
-        const auto& var_name = var_scope_.GetNameById(id);
-        bool not_owned = !block_.HasVar(var_name);
-        const auto& transferred_vars = var_scope_.DataTransferAddedVars();
-        bool not_transferred =
-            std::all_of(transferred_vars.begin(),
-                        transferred_vars.end(),
-                        [&](const std::pair<std::string, int>& elem) {
-                          return elem.first != var_name;
-                        });
-        if (not_owned && not_transferred) {
-          VLOG(10) << "[gc_check_inputs] skip gc: " << var_name;
-          continue;
+      for (auto& item : ins_and_outs) {
+        for (auto id : item.second) {
+          if (id == kEmptyVarIndex) {
+            continue;
+          }
+          auto* var_desc = var_scope_.VarDesc(id);
+          // skip no_need_buffer input vars
+          if (var_desc && ins.count(item.first) &&
+              !info.IsInArgBufferNeeded(var_desc->Name())) {
+            continue;
+          }
+          // skip when this var is not in block and not a data_transferred var,
+          // which means this var is managed by other block
+          const auto& var_name = var_scope_.GetNameById(id);
+          bool not_owned = !block_.HasVar(var_name);
+          const auto& transferred_vars = var_scope_.DataTransferAddedVars();
+          bool not_transferred =
+              std::all_of(transferred_vars.begin(),
+                          transferred_vars.end(),
+                          [&](const std::pair<std::string, int>& elem) {
+                            return elem.first != var_name;
+                          });
+          if (not_owned && not_transferred) {
+            VLOG(10) << "[gc_check_inputs] skip gc: " << var_name;
+            continue;
+          }
+          gc_check_vars.insert(id);
         }
-        gc_check_vars.insert(id);
       }
-    }
 
-    for (auto var_id : gc_check_vars) {
-      Scope* inner_scope =
-          HasLocalScope() ? local_scope_ : var_scope_.GetMutableScope();
-      paddle::framework::Variable* var =
-          inner_scope->FindVar(var_scope_.GetNameById(var_id));
-      if (var->IsType<phi::DenseTensor>() || var->IsType<phi::SelectedRows>() ||
-          var->IsType<LoDTensorArray>()) {
-        last_live_ops_[var_id].insert(op_idx);
-      } else {
-        VLOG(4) << "not clear " << var_scope_.GetNameById(var_id) << " after "
-                << instr.OpBase()->Type() << " because its type is "
-                << framework::ToTypeName(var->Type());
+      for (auto var_id : gc_check_vars) {
+        Scope* inner_scope =
+            HasLocalScope() ? local_scope_ : var_scope_.GetMutableScope();
+        paddle::framework::Variable* var =
+            inner_scope->FindVar(var_scope_.GetNameById(var_id));
+        if (var->IsType<phi::DenseTensor>() ||
+            var->IsType<phi::SelectedRows>() ||
+            var->IsType<LoDTensorArray>()) {
+          last_live_ops_[var_id].insert(op_idx);
+        } else {
+          VLOG(4) << "not clear " << var_scope_.GetNameById(var_id) << " after "
+                  << instr.OpBase()->Type() << " because its type is "
+                  << framework::ToTypeName(var->Type());
+        }
       }
     }
-  }
 
-  // clear the last_live_ops list for all vars in skip_gc_vars
-  for (const std::string& skip_gc_var : execution_config_.skip_gc_vars) {
-    int var_id = var_scope_.GetIdByName(skip_gc_var);
-    if (var_id != -1) {
-      last_live_ops_[var_id].clear();
-      VLOG(8) << "Skip gc for var: " << skip_gc_var;
+    // clear the last_live_ops list for all vars in skip_gc_vars
+    for (const std::string& skip_gc_var : execution_config_.skip_gc_vars) {
+      int var_id = var_scope_.GetIdByName(skip_gc_var);
+      if (var_id != -1) {
+        last_live_ops_[var_id].clear();
+        VLOG(8) << "Skip gc for var: " << skip_gc_var;
+      }
     }
-  }
 
-  // shrink, find the downstream op that has no other op in the
-  // downstream list happens before it
-  // For example,
-  // b = op1(a)
-  // c = op2(a, b)
-  // in this case, a is the input of op1 and op2, we only need to check
-  // a after op2, because op2 always uses a after op1.
-  for (size_t i = 0; i < last_live_ops_.size(); ++i) {
-    std::set<size_t> minumum_last_live_ops;
-    for (size_t item : last_live_ops_[i]) {
-      bool not_before_any = true;
-      // find the op that is not executed before any
-      for (size_t other_item : last_live_ops_[i]) {
-        if (dependency_builder_.OpHappensBefore(item, other_item)) {
-          VLOG(8) << "happens_before: " << item << "->" << other_item
-                  << ", so skip " << item;
-          not_before_any = false;
-          break;
+    // shrink, find the downstream op that has no other op in the
+    // downstream list happens before it
+    // For example,
+    // b = op1(a)
+    // c = op2(a, b)
+    // in this case, a is the input of op1 and op2, we only need to check
+    // a after op2, because op2 always uses a after op1.
+    for (size_t i = 0; i < last_live_ops_.size(); ++i) {
+      std::set<size_t> minumum_last_live_ops;
+      for (size_t item : last_live_ops_[i]) {
+        bool not_before_any = true;
+        // find the op that is not executed before any
+        for (size_t other_item : last_live_ops_[i]) {
+          if (dependency_builder_.OpHappensBefore(item, other_item)) {
+            VLOG(8) << "happens_before: " << item << "->" << other_item
+                    << ", so skip " << item;
+            not_before_any = false;
+            break;
+          }
+        }
+        if (not_before_any) {
+          VLOG(8) << "last live op of var " << i << " "
+                  << var_scope_.GetNameById(i) << " : " << item << " "
+                  << vec_instruction_[item].OpBase()->Type();
+          minumum_last_live_ops.insert(item);
+          vec_instruction_[item].AddGCCheckVar(i);
         }
       }
-      if (not_before_any) {
-        VLOG(8) << "last live op of var " << i << " "
-                << var_scope_.GetNameById(i) << " : " << item << " "
-                << vec_instruction_[item].OpBase()->Type();
-        minumum_last_live_ops.insert(item);
-        vec_instruction_[item].AddGCCheckVar(i);
-      }
+      last_live_ops_[i] = minumum_last_live_ops;
+      vec_meta_info[i].var_ref_count_ = last_live_ops_[i].size();
+    }
+
+    if (!analysis_path.empty()) {
+      analysis.op_downstream_map = dependency_builder_.OpDownstreamMap();
+      analysis.op_happens_before = dependency_builder_.OpHappensBeforeMatrix();
+      analysis.last_live_ops = last_live_ops_;
+      interpreter::SaveInstructionAnalysis(
+          analysis_path, analysis_key, analysis);
     }
-    last_live_ops_[i] = minumum_last_live_ops;
-    vec_meta_info[i].var_ref_count_ = last_live_ops_[i].size();
   }
 
   for (size_t i = 0; i < vec_instruction_.size(); ++i) {
@@ -1040,12 +1152,22 @@ void InterpreterCore::ExecuteInstructionList(
 
   exception_holder_.Clear();
 
+  if (execution_config_.use_work_stealing && work_stealing_pool_ == nullptr) {
+    work_stealing_pool_ = std::make_unique<WorkStealingThreadPool>(
+        "WorkStealingPool",
+        execution_config_.host_num_threads,
+        [this](size_t instr_id) { RunInstructionAsync(instr_id); });
+  }
+
   for (size_t i = 0; i < dependecy_count_.size(); ++i) {
     if (dependecy_count_[i] == 0) {
       // NOTE(zhiqiu): hot fix for jit input var
       RecordMemcpyD2H(vec_instr.at(i));
       if (FLAGS_new_executor_serial_run) {
         RunInstructionAsync(i);
+      } else if (execution_config_.use_work_stealing &&
+                 vec_instr.at(i).KernelType() != OpFuncType::kGpuAsync) {
+        work_stealing_pool_->AddTask(i);
       } else {
         async_work_queue_->AddTask(vec_instr.at(i).KernelType(),
                                    [this, i] { RunInstructionAsync(i); });
@@ -1064,6 +1186,10 @@ void InterpreterCore::ExecuteInstructionList(
     if (exception_holder_.Type() != "EOF") {
       async_work_queue_->Cancel();
       async_work_queue_.reset();
+      if (work_stealing_pool_ != nullptr) {
+        work_stealing_pool_->Cancel();
+        work_stealing_pool_.reset();
+      }
     }
     VLOG(4) << "Cancel ok";
     PADDLE_ENFORCE_EQ(
@@ -1087,6 +1213,38 @@ void InterpreterCore::RunNextInstructions(const Instruction& instr,
     return deps_[next_id]->CheckAndDecrease();
   };
 
+  if (execution_config_.use_work_stealing &&
+      instr.KernelType() != OpFuncType::kGpuAsync) {
+    // Keep the first ready host instruction in the current thread, and push
+    // the others onto the current worker's queue of the work-stealing pool,
+    // where they can be stolen by idle workers.
+    bool has_instr_in_same_thread = !reserved_next_ops->empty();
+    auto Dispatch = [&](size_t next_instr_id) {
+      if (vec_instruction_[next_instr_id].KernelType() ==
+          OpFuncType::kGpuAsync) {
+        async_work_queue_->AddTask(
+            OpFuncType::kGpuAsync,
+            [this, next_instr_id]() { RunInstructionAsync(next_instr_id); });
+      } else if (!has_instr_in_same_thread) {
+        reserved_next_ops->push(next_instr_id);
+        has_instr_in_same_thread = true;
+      } else {
+        work_stealing_pool_->AddTask(next_instr_id);
+      }
+    };
+    for (size_t next_instr_id : instr.NextInstrsInSameThread()) {
+      if (IsReady(next_instr_id)) {
+        Dispatch(next_instr_id);
+      }
+    }
+    for (size_t next_instr_id : instr.NextInstrsInDifferenceThread()) {
+      if (IsReady(next_instr_id)) {
+        Dispatch(next_instr_id);
+      }
+    }
+    return;
+  }
+
   for (size_t next_instr_id : instr.NextInstrsInDifferenceThread()) {
     if (IsReady(next_instr_id)) {
       async_work_queue_->AddTask(
@@ -27,6 +27,7 @@
 #include "paddle/fluid/framework/new_executor/interpreter/stream_analyzer.h"
 #include "paddle/fluid/framework/new_executor/new_executor_defs.h"
 #include "paddle/fluid/framework/new_executor/profiler.h"
+#include "paddle/fluid/framework/new_executor/workqueue/work_stealing_threadpool.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/framework/variable.h"
@@ -90,6 +91,8 @@ class InterpreterCore {
   void BuildSkipShareLoDInfo();
   void UpdateSyncOpNum();
   void AnalyseExecuteOrderForTrace();
+  // the key of the analysis of the instructions in the analysis cache
+  uint64_t AnalysisCacheKey() const;
 
   // inplace
   void BuildInplace();
@@ -162,6 +165,8 @@ class InterpreterCore {
 
   EventsWaiter main_thread_blocker_;
   std::shared_ptr<interpreter::AsyncWorkQueue> async_work_queue_;
+  // only created when execution_config_.use_work_stealing is set
+  std::unique_ptr<WorkStealingThreadPool> work_stealing_pool_;
 
   details::ExceptionHolder exception_holder_;
   std::shared_ptr<EventsWaiter::EventNotifier> exception_notifier_{nullptr};
@@ -0,0 +1,188 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/workqueue/work_stealing_threadpool.h"
+
+#include <thread>
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/os_info.h"
+#include "paddle/fluid/platform/profiler/event_tracing.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+inline unsigned Rand(uint64_t* state) {
+  uint64_t current = *state;
+  // Update the internal state
+  *state = current * 6364136223846793005ULL + 0xda3e39cb94b95bdbULL;
+  // Generate the random output (using the PCG-XSH-RS scheme)
+  return static_cast<unsigned>((current ^ (current >> 22)) >>
+                               (22 + (current >> 61)));
+}
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(const std::string& name,
+                                               size_t num_threads,
+                                               TaskHandler handler)
+    : name_(name),
+      num_threads_(num_threads),
+      handler_(std::move(handler)),
+      ec_(num_threads),
+      thread_data_(num_threads) {
+  PADDLE_ENFORCE_GT(num_threads,
+                    0u,
+                    platform::errors::InvalidArgument(
+                        "The number of threads of WorkStealingThreadPool must "
+                        "be greater than 0."));
+  PADDLE_ENFORCE_NOT_NULL(
+      handler_,
+      platform::errors::InvalidArgument(
+          "The task handler of WorkStealingThreadPool must not be empty."));
+  StlThreadEnvironment env;
+  for (size_t i = 0; i < num_threads_; ++i) {
+    thread_data_[i].thread.reset(env.CreateThread(
+        [this, i]() { WorkerLoop(static_cast<int>(i)); }));
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  done_ = true;
+  ec_.Notify(true);
+  // Join threads explicitly (by destroying) to avoid destruction order within
+  // this class.
+  for (auto& data : thread_data_) {
+    data.thread.reset();
+  }
+  for (auto& data : thread_data_) {
+    data.queue.Flush();
+  }
+}
+
+void WorkStealingThreadPool::AddTask(size_t task_id) {
+  Task t{task_id};
+  PerThread* pt = GetPerThread();
+  if (pt->pool == this) {
+    // Worker thread of this pool, push onto the front of its own queue so
+    // that it is the first one to be popped by the owner.
+    t = thread_data_[pt->thread_id].queue.PushFront(t);
+  } else {
+    size_t idx =
+        next_queue_.fetch_add(1, std::memory_order_relaxed) % num_threads_;
+    t = thread_data_[idx].queue.PushBack(t);
+  }
+  if (t.IsValid()) {
+    // Push failed because the queue is full, execute directly.
+    handler_(t.id);
+    return;
+  }
+  ec_.Notify(false);
+}
+
+void WorkStealingThreadPool::Cancel() {
+  cancelled_ = true;
+  done_ = true;
+  // Wake up the threads without work to let them exit on their own.
+  ec_.Notify(true);
+  for (auto& data : thread_data_) {
+    data.thread->WaitExit();
+  }
+}
+
+int WorkStealingThreadPool::CurrentThreadId() const {
+  const PerThread* pt = GetPerThread();
+  return pt->pool == this ? pt->thread_id : -1;
+}
+
+void WorkStealingThreadPool::WorkerLoop(int thread_id) {
+  std::string thr_name = name_ + "_thread_" + std::to_string(thread_id);
+  VLOG(1) << thr_name << " started ";
+  platform::SetCurrentThreadName(thr_name);
+  PerThread* pt = GetPerThread();
+  pt->pool = this;
+  pt->rand = std::hash<std::thread::id>()(std::this_thread::get_id());
+  pt->thread_id = thread_id;
+  Queue& q = thread_data_[thread_id].queue;
+  EventCount::Waiter* waiter = ec_.GetWaiter(thread_id);
+
+  while (!cancelled_) {
+    Task t = q.PopFront();
+    if (!t.IsValid()) {
+      t = Steal(pt);
+    }
+    if (!t.IsValid() && !WaitForWork(waiter, &t)) {
+      return;
+    }
+    if (t.IsValid()) {
+      handler_(t.id);
+    }
+  }
+}
+
+WorkStealingThreadPool::Task WorkStealingThreadPool::Steal(PerThread* pt) {
+  if (num_threads_ == 1) {
+    return Task();
+  }
+  size_t victim = Rand(&pt->rand) % num_threads_;
+  for (size_t i = 0; i < num_threads_; ++i) {
+    if (victim != static_cast<size_t>(pt->thread_id)) {
+      Task t = thread_data_[victim].queue.PopBack();
+      if (t.IsValid()) {
+        return t;
+      }
+    }
+    victim = victim + 1 == num_threads_ ? 0 : victim + 1;
+  }
+  return Task();
+}
+
+bool WorkStealingThreadPool::WaitForWork(EventCount::Waiter* waiter, Task* t) {
+  ec_.Prewait();
+  if (cancelled_) {
+    ec_.CancelWait();
+    return false;
+  }
+
+  // Reliable emptiness check after Prewait, a task added before this point
+  // is either found here or its Notify wakes us up from CommitWait.
+  for (auto& data : thread_data_) {
+    if (!data.queue.Empty()) {
+      ec_.CancelWait();
+      *t = data.queue.PopBack();
+      return true;
+    }
+  }
+
+  if (done_) {
+    ec_.CancelWait();
+    return false;
+  }
+
+  platform::RecordEvent record(
+      "WaitForWork", platform::TracerEventType::UserDefined, 10);
+  ec_.CommitWait(waiter);
+  return true;
+}
+
+WorkStealingThreadPool::PerThread* WorkStealingThreadPool::GetPerThread() {
+  static thread_local PerThread per_thread;
+  return &per_thread;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,111 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/new_executor/workqueue/event_count.h"
+#include "paddle/fluid/framework/new_executor/workqueue/run_queue.h"
+#include "paddle/fluid/framework/new_executor/workqueue/thread_environment.h"
+
+namespace paddle {
+namespace framework {
+
+// A thread pool that schedules integral task ids (e.g. instruction ids of an
+// InterpreterCore) instead of std::function closures.
+//
+// Every worker owns a RunQueue used as a deque: tasks added by a worker are
+// pushed to the front of its own queue and popped LIFO by the owner, which
+// keeps the cache hot for dependent ops. Idle workers steal from the back of
+// the other workers' queues. Tasks added by threads outside the pool are
+// distributed round-robin.
+//
+// Compared with NonblockingThreadPool, adding a task does not allocate and
+// there is no per-task tracking, which matters when the tasks are very
+// fine-grained.
+class WorkStealingThreadPool {
+ public:
+  using TaskHandler = std::function<void(size_t)>;
+
+  WorkStealingThreadPool(const std::string& name,
+                         size_t num_threads,
+                         TaskHandler handler);
+
+  WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+
+  WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+  ~WorkStealingThreadPool();
+
+  // Thread-safe. The handler is invoked with task_id by one of the workers.
+  void AddTask(size_t task_id);
+
+  // Stop all workers as soon as possible, the tasks left in the queues are
+  // dropped. The pool can not be used anymore after Cancel.
+  void Cancel();
+
+  size_t NumThreads() const { return num_threads_; }
+
+  // Returns the worker index of the calling thread, or -1 if the calling
+  // thread does not belong to this pool.
+  int CurrentThreadId() const;
+
+ private:
+  static constexpr size_t kInvalidTaskId = std::numeric_limits<size_t>::max();
+
+  struct Task {
+    size_t id{kInvalidTaskId};
+    bool IsValid() const { return id != kInvalidTaskId; }
+  };
+
+  using Queue = RunQueue<Task, 1024>;
+  using Thread = StlThreadEnvironment::EnvThread;
+
+  struct PerThread {
+    const WorkStealingThreadPool* pool{nullptr};
+    uint64_t rand{0};
+    int thread_id{-1};
+  };
+
+  struct ThreadData {
+    std::unique_ptr<Thread> thread;
+    Queue queue;
+  };
+
+  void WorkerLoop(int thread_id);
+
+  Task Steal(PerThread* pt);
+
+  bool WaitForWork(EventCount::Waiter* waiter, Task* t);
+
+  static PerThread* GetPerThread();
+
+  const std::string name_;
+  const size_t num_threads_;
+  TaskHandler handler_;
+  std::atomic<bool> done_{false};
+  std::atomic<bool> cancelled_{false};
+  std::atomic<size_t> next_queue_{0};
+  EventCount ec_;
+  std::vector<ThreadData> thread_data_;
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -19,6 +19,7 @@
 
 #include "glog/logging.h"
 #include "gtest/gtest.h"
+#include "paddle/fluid/framework/new_executor/workqueue/work_stealing_threadpool.h"
 #include "paddle/fluid/framework/new_executor/workqueue/workqueue_utils.h"
 
 TEST(WorkQueueUtils, TestEventsWaiter) {
@@ -204,3 +205,32 @@ TEST(WorkQueue, TestWorkQueueGroup) {
   queue_group.reset();
   waiter_thread.join();
 }
+
+TEST(WorkQueue, TestWorkStealingThreadPool) {
+  using paddle::framework::WorkStealingThreadPool;
+  // Tasks form a binary tree, each task adds its children from inside the
+  // pool, so the tasks are spread over the workers by stealing.
+  constexpr size_t kTaskNum = 100000;
+  std::atomic<size_t> counter{0};
+  std::unique_ptr<WorkStealingThreadPool> pool;
+  pool.reset(new WorkStealingThreadPool(
+      "WorkStealingThreadPoolForTesting", 4, [&](size_t task_id) {
+        EXPECT_GE(pool->CurrentThreadId(), 0);
+        for (size_t child = 2 * task_id + 1;
+             child <= 2 * task_id + 2 && child < kTaskNum;
+             ++child) {
+          pool->AddTask(child);
+        }
+        ++counter;
+      }));
+  EXPECT_EQ(pool->NumThreads(), 4u);
+  EXPECT_EQ(pool->CurrentThreadId(), -1);
+  pool->AddTask(0);
+  while (counter.load() < kTaskNum) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(counter.load(), kTaskNum);
+  // Cancel
+  pool->Cancel();
+  pool.reset();
+}
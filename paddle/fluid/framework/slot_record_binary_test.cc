@@ -0,0 +1,134 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <fstream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/data_feed.h"
+#include "paddle/fluid/framework/io/fs.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+DataFeedDesc MakeSlotRecordDesc() {
+  DataFeedDesc desc;
+  desc.set_name("SlotRecordInMemoryDataFeed");
+  desc.set_batch_size(2);
+  auto* multi_slot_desc = desc.mutable_multi_slot_desc();
+  auto add_slot = [multi_slot_desc](const std::string& name,
+                                    const std::string& type,
+                                    bool is_used) {
+    auto* slot = multi_slot_desc->add_slots();
+    slot->set_name(name);
+    slot->set_type(type);
+    slot->set_is_dense(false);
+    slot->set_is_used(is_used);
+  };
+  add_slot("click", "uint64", true);
+  add_slot("weight", "float", true);
+  add_slot("unused", "uint64", false);
+  add_slot("query", "uint64", true);
+  return desc;
+}
+
+// Reads the files with a SlotRecordInMemoryDataFeed, into records when
+// output_dir is empty and into binary files under output_dir otherwise.
+std::vector<SlotRecord> RunSlotRecordFeed(
+    const std::vector<std::string>& files, const std::string& output_dir) {
+  std::unique_ptr<DataFeed> feed(new SlotRecordInMemoryDataFeed());
+  std::mutex mutex;
+  size_t file_idx = 0;
+  feed->Init(MakeSlotRecordDesc());
+  feed->SetFileListMutex(&mutex);
+  feed->SetFileListIndex(&file_idx);
+  feed->SetFileList(files);
+  feed->SetThreadId(0);
+  feed->SetParseInsId(true);
+  feed->SetParseLogKey(true);
+  auto channel = MakeChannel<SlotRecord>();
+  feed->SetInputChannel(channel.get());
+
+  std::vector<SlotRecord> records;
+  if (output_dir.empty()) {
+    feed->LoadIntoMemory();
+    channel->Close();
+    channel->ReadAll(records);
+  } else {
+    feed->ConvertToBinary(output_dir);
+  }
+  return records;
+}
+
+}  // namespace
+
+TEST(SlotRecordBinary, SameAsText) {
+  std::string text_path = "slot_record_binary_test.txt";
+  std::string output_dir = "slot_record_binary_test_dir";
+  {
+    // the log key holds cmatch at 11, rank at 14 and search_id at 16
+    std::ofstream fout(text_path);
+    fout << "1 ins_0 1 000000000000de05000000deadbeef01 "
+         << "2 11 12 1 0.5 3 7 8 9 1 18446744073709551615\n";
+    fout << "1 ins_1 1 000000000000df0100000000000000ff "
+         << "1 13 2 0.25 -1.5 1 10 2 20 21\n";
+  }
+  localfs_mkdir(output_dir);
+
+  auto text_records = RunSlotRecordFeed({text_path}, "");
+  RunSlotRecordFeed({text_path}, output_dir);
+  std::string binary_path = output_dir + "/" + text_path;
+  ASSERT_TRUE(SlotRecordBinaryReader::IsBinaryFile(binary_path));
+  ASSERT_FALSE(SlotRecordBinaryReader::IsBinaryFile(text_path));
+  auto binary_records = RunSlotRecordFeed({binary_path}, "");
+
+  ASSERT_EQ(text_records.size(), 2UL);
+  ASSERT_EQ(binary_records.size(), text_records.size());
+  EXPECT_EQ(text_records[0]->search_id, 0xdeadbeef01UL);
+  EXPECT_EQ(text_records[0]->cmatch, 0xdeU);
+  EXPECT_EQ(text_records[0]->rank, 5U);
+  for (size_t i = 0; i < text_records.size(); ++i) {
+    auto& text = text_records[i];
+    auto& binary = binary_records[i];
+    EXPECT_EQ(binary->ins_id_, text->ins_id_);
+    EXPECT_EQ(binary->search_id, text->search_id);
+    EXPECT_EQ(binary->cmatch, text->cmatch);
+    EXPECT_EQ(binary->rank, text->rank);
+    EXPECT_EQ(binary->slot_uint64_feasigns_.slot_values,
+              text->slot_uint64_feasigns_.slot_values);
+    EXPECT_EQ(binary->slot_uint64_feasigns_.slot_offsets,
+              text->slot_uint64_feasigns_.slot_offsets);
+    EXPECT_EQ(binary->slot_float_feasigns_.slot_values,
+              text->slot_float_feasigns_.slot_values);
+    EXPECT_EQ(binary->slot_float_feasigns_.slot_offsets,
+              text->slot_float_feasigns_.slot_offsets);
+  }
+  EXPECT_EQ(text_records[1]->slot_uint64_feasigns_.slot_values,
+            std::vector<uint64_t>({13, 20, 21}));
+  EXPECT_EQ(text_records[1]->slot_float_feasigns_.slot_values,
+            std::vector<float>({0.25, -1.5}));
+
+  SlotRecordPool().put(&text_records);
+  SlotRecordPool().put(&binary_records);
+  localfs_remove(output_dir);
+  localfs_remove(text_path);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -31,7 +31,8 @@ class PassResultInfoForRuntime {
   using PassInfo =
       paddle::variant<std::string,
                       std::vector<std::string>,
-                      std::unordered_map<std::string, std::string>>;
+                      std::unordered_map<std::string, std::string>,
+                      std::unordered_map<std::string, size_t>>;
 
   static PassResultInfoForRuntime* Instance() {
     static PassResultInfoForRuntime info;
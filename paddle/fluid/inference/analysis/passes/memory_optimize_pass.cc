@@ -19,6 +19,7 @@
 
 #include "glog/logging.h"
 #include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/memory_offset_plan.h"
 #include "paddle/fluid/inference/analysis/pass_result_info.h"
 #include "paddle/fluid/platform/enforce.h"
 
@@ -375,6 +376,30 @@ void MemoryOptimizePass::RunImpl(Argument* argument) {
   pass_res_info->Set(
       argument->root_predictor_id(), "memory_optimize_pass", node2cluster);
 
+  // In the arena mode, the vars of the reuse plan are placed at offsets of one
+  // arena instead, which the executor refines with the sizes seen at runtime.
+  if (argument->Has("memory_optim_arena") && argument->memory_optim_arena()) {
+    space_table_t arena_sizes;
+    for (auto& it : node2cluster) {
+      arena_sizes[it.first] = space_table.at(it.first);
+    }
+    if (VLOG_IS_ON(3)) {
+      std::unordered_set<std::string> clusters;
+      size_t cluster_total = 0;
+      for (auto& it : node2cluster) {
+        if (clusters.insert(it.second).second) {
+          cluster_total += space_table.at(it.second);
+        }
+      }
+      auto plan = framework::MakeMemoryOffsetPlan(lifecycles, arena_sizes);
+      VLOG(3) << "Memory arena size: " << plan.arena_size
+              << ", size of reuse clusters: " << cluster_total;
+    }
+    pass_res_info->Set(argument->root_predictor_id(),
+                       "memory_optimize_pass_sizes",
+                       arena_sizes);
+  }
+
   return;
 }
 
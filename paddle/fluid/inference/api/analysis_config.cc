@@ -422,6 +422,7 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(mixed_precision_mode_);
 
   CP_MEMBER(enable_memory_optim_);
+  CP_MEMBER(memory_optim_arena_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -1054,6 +1055,7 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << trt_dla_core_;
 
   ss << enable_memory_optim_;
+  ss << memory_optim_arena_;
   ss << trt_engine_memory_sharing_;
 
   ss << use_mkldnn_;
@@ -1148,6 +1150,11 @@ void AnalysisConfig::EnableMemoryOptim(bool x) {
   Update();
 }
 
+void AnalysisConfig::EnableMemoryOptimArena(bool x) {
+  memory_optim_arena_ = x;
+  Update();
+}
+
 bool AnalysisConfig::enable_memory_optim() const {
   return enable_memory_optim_;
 }
@@ -1344,6 +1351,10 @@ std::string AnalysisConfig::Summary() {
   os.InsertRow({"ir_optim", enable_ir_optim_ ? "true" : "false"});
   os.InsertRow({"ir_debug", ir_debug_ ? "true" : "false"});
   os.InsertRow({"memory_optim", enable_memory_optim_ ? "true" : "false"});
+  if (enable_memory_optim_) {
+    os.InsertRow(
+        {"memory_optim_arena", memory_optim_arena_ ? "true" : "false"});
+  }
   os.InsertRow({"enable_profile", with_profile_ ? "true" : "false"});
   os.InsertRow({"enable_log", with_glog_info_ ? "true" : "false"});
   os.InsertRow({"collect_shape_range_info",
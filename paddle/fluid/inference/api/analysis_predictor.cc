@@ -643,7 +643,14 @@ bool AnalysisPredictor::PrepareExecutor() {
     auto reuse_table =
         pass_res_info->Get<std::unordered_map<std::string, std::string>>(
             root_predictor_id_, "memory_optimize_pass");
-    executor_->MakeReusePlan(reuse_table);
+    if (config_.memory_optim_arena_enabled()) {
+      auto var_sizes =
+          pass_res_info->Get<std::unordered_map<std::string, size_t>>(
+              root_predictor_id_, "memory_optimize_pass_sizes");
+      executor_->MakeArenaPlan(var_sizes);
+    } else {
+      executor_->MakeReusePlan(reuse_table);
+    }
   }
 
   PADDLE_ENFORCE_NOT_NULL(sub_scope_,
@@ -1256,6 +1263,7 @@ void AnalysisPredictor::PrepareArgument() {
   argument_->SetGPUDeviceId(config_.gpu_device_id());
   argument_->SetEnableIrOptim(config_.enable_ir_optim_);
   argument_->SetEnableMemoryOptim(config_.enable_memory_optim());
+  argument_->SetMemoryOptimArena(config_.memory_optim_arena_enabled());
   argument_->SetModelFromMemory(config_.model_from_memory_);
   // Analyze inference_program
   argument_->SetPredictorID(predictor_id_);
@@ -2801,6 +2809,14 @@ int GetNumBytesOfDataType(DataType dtype) {
       return sizeof(int32_t);
     case DataType::UINT8:
       return sizeof(uint8_t);
+    case DataType::INT8:
+      return sizeof(int8_t);
+    case DataType::FLOAT16:
+      return sizeof(paddle::platform::float16);
+    case DataType::BOOL:
+      return sizeof(bool);
+    case DataType::FLOAT64:
+      return sizeof(double);
     default:
       assert(false);
       return -1;
@@ -0,0 +1,453 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "glog/logging.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle_infer {
+namespace services {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using HostTensor = BatchingPredictor::HostTensor;
+
+constexpr size_t kLatencyBuckets = 32;
+
+int64_t RowBytes(const HostTensor& t) {
+  int64_t row_numel = 1;
+  for (size_t i = 1; i < t.shape.size(); ++i) {
+    row_numel *= t.shape[i];
+  }
+  return row_numel * GetNumBytesOfDataType(t.dtype);
+}
+
+template <typename T>
+void CopyFromHostImpl(Tensor* dst, const uint8_t* src) {
+  dst->CopyFromCpu(reinterpret_cast<const T*>(src));
+}
+
+template <typename T>
+void CopyToHostImpl(const Tensor& src, uint8_t* dst) {
+  src.CopyToCpu(reinterpret_cast<T*>(dst));
+}
+
+void CopyFromHost(Tensor* dst, DataType dtype, const uint8_t* src) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      return CopyFromHostImpl<float>(dst, src);
+    case DataType::INT64:
+      return CopyFromHostImpl<int64_t>(dst, src);
+    case DataType::INT32:
+      return CopyFromHostImpl<int32_t>(dst, src);
+    case DataType::UINT8:
+      return CopyFromHostImpl<uint8_t>(dst, src);
+    case DataType::INT8:
+      return CopyFromHostImpl<int8_t>(dst, src);
+    case DataType::FLOAT16:
+      return CopyFromHostImpl<paddle::platform::float16>(dst, src);
+    case DataType::BOOL:
+      return CopyFromHostImpl<bool>(dst, src);
+    case DataType::FLOAT64:
+      return CopyFromHostImpl<double>(dst, src);
+    default:
+      PADDLE_THROW(paddle::platform::errors::Unimplemented(
+          "Unsupported data type (%d) for BatchingPredictor.",
+          static_cast<int>(dtype)));
+  }
+}
+
+void CopyToHost(const Tensor& src, DataType dtype, uint8_t* dst) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      return CopyToHostImpl<float>(src, dst);
+    case DataType::INT64:
+      return CopyToHostImpl<int64_t>(src, dst);
+    case DataType::INT32:
+      return CopyToHostImpl<int32_t>(src, dst);
+    case DataType::UINT8:
+      return CopyToHostImpl<uint8_t>(src, dst);
+    case DataType::INT8:
+      return CopyToHostImpl<int8_t>(src, dst);
+    case DataType::FLOAT16:
+      return CopyToHostImpl<paddle::platform::float16>(src, dst);
+    case DataType::BOOL:
+      return CopyToHostImpl<bool>(src, dst);
+    case DataType::FLOAT64:
+      return CopyToHostImpl<double>(src, dst);
+    default:
+      PADDLE_THROW(paddle::platform::errors::Unimplemented(
+          "Unsupported data type (%d) for BatchingPredictor.",
+          static_cast<int>(dtype)));
+  }
+}
+
+}  // namespace
+
+struct BatchingPredictor::Impl {
+  struct Request {
+    std::vector<HostTensor> inputs;
+    std::promise<std::vector<HostTensor>> promise;
+    Clock::time_point arrival;
+    int rows;
+  };
+  using RequestPtr = std::unique_ptr<Request>;
+
+  // Two requests can share a batch if their inputs only differ in rows.
+  static bool Mergeable(const Request& a, const Request& b) {
+    if (a.inputs.size() != b.inputs.size()) return false;
+    for (size_t i = 0; i < a.inputs.size(); ++i) {
+      const HostTensor& x = a.inputs[i];
+      const HostTensor& y = b.inputs[i];
+      if (x.name != y.name || x.dtype != y.dtype ||
+          x.shape.size() != y.shape.size() ||
+          !std::equal(x.shape.begin() + 1, x.shape.end(), y.shape.begin() + 1))
+        return false;
+    }
+    return true;
+  }
+
+  void CheckInputs(std::vector<HostTensor>* inputs) {
+    PADDLE_ENFORCE_EQ(inputs->size(),
+                      input_names.size(),
+                      paddle::platform::errors::InvalidArgument(
+                          "The model has %d inputs, but the request has %d.",
+                          input_names.size(),
+                          inputs->size()));
+    // Sort by name, so the inputs of mergeable requests line up.
+    std::sort(inputs->begin(),
+              inputs->end(),
+              [](const HostTensor& a, const HostTensor& b) {
+                return a.name < b.name;
+              });
+    int rows = -1;
+    for (size_t i = 0; i < inputs->size(); ++i) {
+      const HostTensor& t = (*inputs)[i];
+      PADDLE_ENFORCE_EQ(
+          t.name,
+          input_names[i],
+          paddle::platform::errors::InvalidArgument(
+              "The request has no input named %s, or has duplicated inputs.",
+              input_names[i]));
+      PADDLE_ENFORCE_GE(
+          t.shape.size(),
+          1UL,
+          paddle::platform::errors::InvalidArgument(
+              "Input %s should have the batch dimension.", t.name));
+      PADDLE_ENFORCE_EQ(
+          rows == -1 || rows == t.shape[0],
+          true,
+          paddle::platform::errors::InvalidArgument(
+              "All the inputs of a request should have the same batch size, "
+              "but input %s has %d rows while the others have %d.",
+              t.name,
+              t.shape[0],
+              rows));
+      rows = t.shape[0];
+      PADDLE_ENFORCE_GT(rows,
+                        0,
+                        paddle::platform::errors::InvalidArgument(
+                            "Input %s should have at least one row.", t.name));
+      PADDLE_ENFORCE_EQ(
+          static_cast<int64_t>(t.data.size()),
+          RowBytes(t) * rows,
+          paddle::platform::errors::InvalidArgument(
+              "The data of input %s has %d bytes, but its shape needs %d.",
+              t.name,
+              t.data.size(),
+              RowBytes(t) * rows));
+    }
+  }
+
+  // Rows that the front request could be merged with right now.
+  int MergeableRows() const {
+    const Request& front = *queue.front();
+    int rows = 0;
+    for (const RequestPtr& r : queue) {
+      if (!Mergeable(front, *r)) continue;
+      if (rows > 0 && rows + r->rows > options.max_batch_size) break;
+      rows += r->rows;
+    }
+    return rows;
+  }
+
+  // Blocks until a batch is due, returns an empty batch when stopped.
+  std::vector<RequestPtr> NextBatch() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      if (queue.empty()) {
+        if (stop) return {};
+        cv.wait(lock);
+        continue;
+      }
+      auto deadline = queue.front()->arrival +
+                      std::chrono::microseconds(options.batch_timeout_us);
+      if (stop || Clock::now() >= deadline ||
+          MergeableRows() >= options.max_batch_size) {
+        break;
+      }
+      cv.wait_until(lock, deadline);
+    }
+
+    // Take the front request and the mergeable ones that follow it, in
+    // arrival order, the rest keep their place in the queue.
+    std::vector<RequestPtr> batch;
+    std::deque<RequestPtr> rest;
+    int rows = 0;
+    bool full = false;
+    for (RequestPtr& r : queue) {
+      if (!full && (batch.empty() || Mergeable(*batch.front(), *r))) {
+        if (rows > 0 && rows + r->rows > options.max_batch_size) {
+          full = true;
+        } else {
+          rows += r->rows;
+          batch.emplace_back(std::move(r));
+          continue;
+        }
+      }
+      rest.emplace_back(std::move(r));
+    }
+    queue.swap(rest);
+    if (!queue.empty()) cv.notify_all();
+    return batch;
+  }
+
+  void RunBatch(Predictor* predictor, std::vector<RequestPtr>* batch) {
+    int total_rows = 0;
+    for (const RequestPtr& r : *batch) total_rows += r->rows;
+    VLOG(4) << "BatchingPredictor runs " << batch->size() << " requests with "
+            << total_rows << " rows";
+
+    std::vector<std::vector<HostTensor>> outputs(batch->size());
+    try {
+      const Request& front = *batch->front();
+      std::vector<uint8_t> buffer;
+      for (size_t i = 0; i < front.inputs.size(); ++i) {
+        const HostTensor& input = front.inputs[i];
+        const uint8_t* data = input.data.data();
+        if (batch->size() > 1) {
+          buffer.clear();
+          for (const RequestPtr& r : *batch) {
+            const std::vector<uint8_t>& part = r->inputs[i].data;
+            buffer.insert(buffer.end(), part.begin(), part.end());
+          }
+          data = buffer.data();
+        }
+        std::vector<int> shape = input.shape;
+        shape[0] = total_rows;
+        auto handle = predictor->GetInputHandle(input.name);
+        handle->Reshape(shape);
+        CopyFromHost(handle.get(), input.dtype, data);
+      }
+
+      PADDLE_ENFORCE_EQ(predictor->Run(),
+                        true,
+                        paddle::platform::errors::Fatal(
+                            "BatchingPredictor failed to run the batch."));
+
+      for (const std::string& name : output_names) {
+        auto handle = predictor->GetOutputHandle(name);
+        HostTensor merged;
+        merged.name = name;
+        merged.shape = handle->shape();
+        merged.dtype = handle->type();
+        PADDLE_ENFORCE_EQ(
+            !merged.shape.empty() && merged.shape[0] == total_rows,
+            true,
+            paddle::platform::errors::PreconditionNotMet(
+                "BatchingPredictor needs the outputs to have the batch as "
+                "their first dimension, but output %s of a %d rows batch "
+                "has %d rows.",
+                name,
+                total_rows,
+                merged.shape.empty() ? 0 : merged.shape[0]));
+        int64_t row_bytes = RowBytes(merged);
+        merged.data.resize(row_bytes * total_rows);
+        CopyToHost(*handle, merged.dtype, merged.data.data());
+
+        int64_t offset = 0;
+        for (size_t i = 0; i < batch->size(); ++i) {
+          int rows = (*batch)[i]->rows;
+          HostTensor out;
+          out.name = name;
+          out.shape = merged.shape;
+          out.shape[0] = rows;
+          out.dtype = merged.dtype;
+          out.data.assign(merged.data.begin() + offset,
+                          merged.data.begin() + offset + row_bytes * rows);
+          offset += row_bytes * rows;
+          outputs[i].emplace_back(std::move(out));
+        }
+      }
+    } catch (...) {
+      // The stats are updated before any caller is woken up, so a caller
+      // reading them after its future is ready sees its own request.
+      auto error = std::current_exception();
+      UpdateStats(*batch, total_rows);
+      for (RequestPtr& r : *batch) r->promise.set_exception(error);
+      return;
+    }
+
+    UpdateStats(*batch, total_rows);
+    for (size_t i = 0; i < batch->size(); ++i) {
+      (*batch)[i]->promise.set_value(std::move(outputs[i]));
+    }
+  }
+
+  void UpdateStats(const std::vector<RequestPtr>& batch, int total_rows) {
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> guard(stats_mutex);
+    stats.num_requests += batch.size();
+    stats.num_batches += 1;
+    stats.batch_size_histogram[std::min(total_rows, options.max_batch_size)]++;
+    for (const RequestPtr& r : batch) {
+      auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    now - r->arrival)
+                    .count();
+      size_t bucket = 0;
+      while (us > 1 && bucket + 1 < kLatencyBuckets) {
+        us >>= 1;
+        ++bucket;
+      }
+      stats.latency_us_histogram[bucket]++;
+    }
+  }
+
+  void WorkerLoop(Predictor* predictor) {
+    while (true) {
+      std::vector<RequestPtr> batch = NextBatch();
+      if (batch.empty()) return;
+      RunBatch(predictor, &batch);
+    }
+  }
+
+  Options options;
+  std::vector<std::string> input_names;
+  std::vector<std::string> output_names;
+  std::shared_ptr<Predictor> main_pred;
+  std::vector<std::unique_ptr<Predictor>> preds;
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<RequestPtr> queue;
+  bool stop{false};
+
+  mutable std::mutex stats_mutex;
+  Stats stats;
+};
+
+BatchingPredictor::BatchingPredictor(const Config& config,
+                                     const Options& options)
+    : impl_(new Impl) {
+  PADDLE_ENFORCE_GE(options.max_batch_size,
+                    1,
+                    paddle::platform::errors::InvalidArgument(
+                        "The max_batch_size should be at least 1, but got %d.",
+                        options.max_batch_size));
+  PADDLE_ENFORCE_GE(options.num_workers,
+                    1,
+                    paddle::platform::errors::InvalidArgument(
+                        "The num_workers should be at least 1, but got %d.",
+                        options.num_workers));
+  PADDLE_ENFORCE_GE(
+      options.batch_timeout_us,
+      0,
+      paddle::platform::errors::InvalidArgument(
+          "The batch_timeout_us should not be negative, but got %d.",
+          options.batch_timeout_us));
+  impl_->options = options;
+  impl_->stats.latency_us_histogram.resize(kLatencyBuckets);
+  impl_->stats.batch_size_histogram.resize(options.max_batch_size + 1);
+
+  impl_->main_pred.reset(new Predictor(config));
+  impl_->input_names = impl_->main_pred->GetInputNames();
+  std::sort(impl_->input_names.begin(), impl_->input_names.end());
+  impl_->output_names = impl_->main_pred->GetOutputNames();
+
+  std::vector<Predictor*> predictors{impl_->main_pred.get()};
+  for (int i = 1; i < options.num_workers; ++i) {
+    if (config.tensorrt_engine_enabled()) {
+      Config config_tmp(config);
+      impl_->preds.emplace_back(new Predictor(config_tmp));
+    } else {
+      impl_->preds.emplace_back(impl_->main_pred->Clone());
+    }
+    predictors.push_back(impl_->preds.back().get());
+  }
+  for (Predictor* predictor : predictors) {
+    impl_->workers.emplace_back(&Impl::WorkerLoop, impl_.get(), predictor);
+  }
+}
+
+BatchingPredictor::~BatchingPredictor() {
+  {
+    std::lock_guard<std::mutex> guard(impl_->mutex);
+    impl_->stop = true;
+  }
+  impl_->cv.notify_all();
+  for (std::thread& worker : impl_->workers) {
+    worker.join();
+  }
+}
+
+std::future<std::vector<HostTensor>> BatchingPredictor::Run(
+    std::vector<HostTensor> inputs) {
+  std::unique_ptr<Impl::Request> request(new Impl::Request);
+  auto future = request->promise.get_future();
+  try {
+    impl_->CheckInputs(&inputs);
+  } catch (...) {
+    request->promise.set_exception(std::current_exception());
+    return future;
+  }
+  request->rows = inputs.front().shape[0];
+  request->inputs = std::move(inputs);
+  request->arrival = Clock::now();
+  {
+    std::lock_guard<std::mutex> guard(impl_->mutex);
+    PADDLE_ENFORCE_EQ(impl_->stop,
+                      false,
+                      paddle::platform::errors::Unavailable(
+                          "The BatchingPredictor has been stopped."));
+    impl_->queue.emplace_back(std::move(request));
+  }
+  // Wake all the workers, the one collecting a batch should see it.
+  impl_->cv.notify_all();
+  return future;
+}
+
+std::vector<std::string> BatchingPredictor::GetOutputNames() const {
+  return impl_->output_names;
+}
+
+BatchingPredictor::Stats BatchingPredictor::GetStats() const {
+  std::lock_guard<std::mutex> guard(impl_->stats_mutex);
+  return impl_->stats;
+}
+
+}  // namespace services
+}  // namespace paddle_infer
@@ -947,6 +947,21 @@ struct PD_INFER_DECL AnalysisConfig {
   /// \return bool Whether the memory optimization is activated.
   ///
   bool enable_memory_optim() const;
+  ///
+  /// \brief Place the reused intermediate tensors at offsets of one arena,
+  /// planned from their lifetimes, instead of sharing buffers by clusters.
+  /// It takes effect only when the memory optimization is enabled.
+  ///
+  /// \param x Whether to use the arena for memory optimize.
+  ///
+  void EnableMemoryOptimArena(bool x = true);
+  ///
+  /// \brief A boolean state telling whether the memory optimization uses
+  /// the arena.
+  ///
+  /// \return bool Whether the memory optimization uses the arena.
+  ///
+  bool memory_optim_arena_enabled() const { return memory_optim_arena_; }
 
   ///
   /// \brief Turn on profiling report.
@@ -1137,6 +1152,7 @@ struct PD_INFER_DECL AnalysisConfig {
 
   // memory reuse related.
   bool enable_memory_optim_{false};
+  bool memory_optim_arena_{false};
   bool trt_engine_memory_sharing_{false};
   int trt_engine_memory_sharing_identifier_{0};
 
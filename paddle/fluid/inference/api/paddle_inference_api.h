@@ -22,6 +22,8 @@ limitations under the License. */
 #pragma once
 
 #include <cassert>
+#include <cstdint>
+#include <future>
 #include <map>
 #include <memory>
 #include <string>
@@ -268,6 +270,87 @@ class PD_INFER_DECL PredictorPool {
   std::shared_ptr<Predictor> main_pred_;
   std::vector<std::unique_ptr<Predictor>> preds_;
 };
+
+///
+/// \class BatchingPredictor
+///
+/// \brief BatchingPredictor serves concurrent requests by merging them along
+/// the batch dimension, so that the model runs at a larger batch size than
+/// each caller has. A request is queued until its worker has gathered
+/// max_batch_size rows, or batch_timeout_us has passed since the oldest
+/// queued request arrived. The merged batch is run once, and each request
+/// gets its rows of the outputs back through a future.
+///
+/// All the inputs and outputs of the model must have the batch as their
+/// first dimension, and LoD inputs are not supported. Only requests whose
+/// inputs agree on names, data types and all but the first dimension are
+/// merged together.
+///
+/// \code{cpp}
+///   services::BatchingPredictor::Options options;
+///   options.max_batch_size = 32;
+///   services::BatchingPredictor batching_predictor(config, options);
+///   // In each serving thread.
+///   auto outputs = batching_predictor.Run(std::move(inputs)).get();
+/// \endcode
+///
+class PD_INFER_DECL BatchingPredictor {
+ public:
+  struct Options {
+    /// Maximum number of rows in a merged batch. A request with more rows
+    /// runs alone.
+    int max_batch_size{32};
+    /// Maximum time a request waits for others to fill its batch.
+    int64_t batch_timeout_us{1000};
+    /// Number of predictors running merged batches concurrently.
+    int num_workers{1};
+  };
+
+  /// \brief A named host tensor, the first dimension of shape is the batch.
+  struct HostTensor {
+    std::string name;
+    std::vector<int> shape;
+    DataType dtype{DataType::FLOAT32};
+    std::vector<uint8_t> data;
+  };
+
+  struct Stats {
+    uint64_t num_requests{0};
+    uint64_t num_batches{0};
+    /// latency_us_histogram[i] counts the requests that took [2^i, 2^(i+1))
+    /// microseconds from Run to the outputs being ready, the first bucket
+    /// also counts the ones under 1us and the last one everything above.
+    std::vector<uint64_t> latency_us_histogram;
+    /// batch_size_histogram[i] counts the batches run with i rows, the last
+    /// bucket also counts the batches of oversized requests.
+    std::vector<uint64_t> batch_size_histogram;
+  };
+
+  BatchingPredictor() = delete;
+  BatchingPredictor(const BatchingPredictor&) = delete;
+  BatchingPredictor& operator=(const BatchingPredictor&) = delete;
+
+  BatchingPredictor(const Config& config, const Options& options);
+
+  /// \brief Stop accepting requests, finish the queued ones and join the
+  /// workers.
+  ~BatchingPredictor();
+
+  /// \brief Queue a request, thread safe.
+  ///
+  /// \param[in] inputs All the inputs of the model.
+  /// \return The outputs of the request, in the order of GetOutputNames(),
+  /// or the exception raised when checking or running its batch.
+  std::future<std::vector<HostTensor>> Run(std::vector<HostTensor> inputs);
+
+  std::vector<std::string> GetOutputNames() const;
+
+  Stats GetStats() const;
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
 }  // namespace services
 
 }  // namespace paddle_infer
@@ -22,6 +22,7 @@
 #include "paddle/fluid/memory/allocation/cpu_allocator.h"
 #include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
 #include "paddle/fluid/memory/allocation/retry_allocator.h"
+#include "paddle/fluid/memory/allocation/size_class_cpu_allocator.h"
 #include "paddle/fluid/memory/allocation/stat_allocator.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/place.h"
@@ -157,6 +158,12 @@ static bool IsCUDAGraphCapturing() {
 #endif
 }
 
+// The size_class strategy only differs from auto_growth in CPU allocator.
+static bool IsAutoGrowthStrategy(AllocatorStrategy strategy) {
+  return strategy == AllocatorStrategy::kAutoGrowth ||
+         strategy == AllocatorStrategy::kSizeClass;
+}
+
 class AllocatorFacadePrivate {
  public:
   using AllocatorMap = std::map<platform::Place, std::shared_ptr<Allocator>>;
@@ -204,8 +211,13 @@ class AllocatorFacadePrivate {
         break;
       }
 
+      case AllocatorStrategy::kSizeClass:
       case AllocatorStrategy::kAutoGrowth: {
-        InitNaiveBestFitCPUAllocator();
+        if (strategy_ == AllocatorStrategy::kSizeClass) {
+          InitSizeClassCPUAllocator();
+        } else {
+          InitNaiveBestFitCPUAllocator();
+        }
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
         allow_free_idle_chunk_ = allow_free_idle_chunk;
         for (int dev_id = 0; dev_id < platform::GetGPUDeviceCount(); ++dev_id) {
@@ -471,6 +483,12 @@ class AllocatorFacadePrivate {
 #endif
   }
 
+  void InitSizeClassCPUAllocator() {
+    allocators_[platform::CPUPlace()] =
+        std::make_shared<SizeClassCPUAllocator>(
+            std::make_shared<CPUAllocator>());
+  }
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   void InitNaiveBestFitCUDAPinnedAllocator() {
     allocators_[platform::CUDAPinnedPlace()] =
@@ -485,8 +503,8 @@ class AllocatorFacadePrivate {
   std::shared_ptr<Allocator> CreateCUDAAllocator(platform::CUDAPlace p) {
     if (FLAGS_use_cuda_managed_memory) {
       PADDLE_ENFORCE_EQ(
-          strategy_,
-          AllocatorStrategy::kAutoGrowth,
+          IsAutoGrowthStrategy(strategy_),
+          true,
           platform::errors::InvalidArgument(
               "CUDA managed memory is only implemented for auto_growth "
               "strategy, not support %s strategy.\n"
@@ -512,8 +530,8 @@ class AllocatorFacadePrivate {
 
   void InitStreamSafeCUDAAllocator(platform::CUDAPlace p, gpuStream_t stream) {
     PADDLE_ENFORCE_EQ(
-        strategy_,
-        AllocatorStrategy::kAutoGrowth,
+        IsAutoGrowthStrategy(strategy_),
+        true,
         platform::errors::Unimplemented(
             "Only support auto-growth strategey for StreamSafeCUDAAllocator, "
             "the allocator strategy %d is unsupported for multi-stream",
@@ -977,8 +995,8 @@ const std::shared_ptr<Allocator>& AllocatorFacade::GetAllocator(
 
 void* AllocatorFacade::GetBasePtr(
     const std::shared_ptr<phi::Allocation>& allocation) {
-  PADDLE_ENFORCE_EQ(GetAllocatorStrategy(),
-                    AllocatorStrategy::kAutoGrowth,
+  PADDLE_ENFORCE_EQ(IsAutoGrowthStrategy(GetAllocatorStrategy()),
+                    true,
                     paddle::platform::errors::Unimplemented(
                         "GetBasePtr() is only implemented for auto_growth "
                         "strategy, not support allocator strategy: %d",
@@ -1107,8 +1125,8 @@ void AllocatorFacade::SetDefaultStream(const platform::CUDAPlace& place,
 
 #ifdef PADDLE_WITH_CUDA
 void AllocatorFacade::PrepareMemoryPoolForCUDAGraph(int64_t id) {
-  PADDLE_ENFORCE_EQ(GetAllocatorStrategy(),
-                    AllocatorStrategy::kAutoGrowth,
+  PADDLE_ENFORCE_EQ(IsAutoGrowthStrategy(GetAllocatorStrategy()),
+                    true,
                     platform::errors::InvalidArgument(
                         "CUDA Graph is only supported when the "
                         "FLAGS_allocator_strategy=\"auto_growth\", but got "
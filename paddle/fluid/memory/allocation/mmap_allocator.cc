@@ -19,6 +19,7 @@
 #include <fcntl.h>
 #include <stdlib.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <atomic>
 #include <random>
@@ -219,6 +220,47 @@ void RefcountedMemoryMapAllocation::close() {
   }
 }
 
+void FileMemoryMapAllocation::close() {
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+  if (munmap(map_ptr_, map_size_) == -1) {
+    LOG(WARNING) << "Could not unmap the file " << ipc_name_ << ": "
+                 << strerror(errno);
+  }
+}
+
+std::shared_ptr<FileMemoryMapAllocation> AllocateFileMemoryMapAllocation(
+    const std::string &file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(fd,
+                    -1,
+                    platform::errors::Unavailable(
+                        "Cannot open file %s to map: %s.",
+                        file_name,
+                        strerror(errno)));
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size == 0) {
+    ::close(fd);
+    PADDLE_THROW(platform::errors::Unavailable(
+        "Cannot map file %s, which is empty or not a regular file.",
+        file_name));
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  // written pages are copied, so the file is never modified
+  void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  PADDLE_ENFORCE_NE(ptr,
+                    MAP_FAILED,
+                    platform::errors::Unavailable(
+                        "Memory map failed when map file %s: %s.",
+                        file_name,
+                        strerror(errno)));
+  VLOG(4) << "Map file " << file_name << " of " << size << " bytes";
+  return std::make_shared<FileMemoryMapAllocation>(ptr, size, file_name);
+}
+
 MemoryMapWriterAllocation::~MemoryMapWriterAllocation() {
   if (munmap(this->ptr(), this->size()) == -1) {
     platform::errors::Unavailable("could not unmap the shared memory file %s",
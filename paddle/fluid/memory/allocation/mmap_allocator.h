@@ -102,6 +102,37 @@ AllocateRefcountedMemoryMapAllocation(std::string filename,
                                       size_t size,
                                       int buffer_id = -1);
 
+// A regular file opened read-only and mapped privately. Its pages stay shared
+// with the page cache, and so with the other processes mapping the same
+// file, until they are written, which copies them.
+class FileMemoryMapAllocation : public MemoryMapAllocation {
+ public:
+  explicit FileMemoryMapAllocation(void *ptr,
+                                   size_t size,
+                                   std::string file_name)
+      : MemoryMapAllocation(ptr, size, std::move(file_name)) {}
+
+  void close() override;
+
+  ~FileMemoryMapAllocation() override { close(); }
+};
+
+// A part of a mapped file, which keeps the mapping alive as long as it is
+// held, e.g. by a tensor loaded from the file.
+class FileMemoryMapSliceAllocation : public MemoryMapAllocation {
+ public:
+  explicit FileMemoryMapSliceAllocation(
+      void *ptr, size_t size, std::shared_ptr<FileMemoryMapAllocation> file)
+      : MemoryMapAllocation(ptr, size, file->ipc_name()),
+        file_(std::move(file)) {}
+
+ private:
+  std::shared_ptr<FileMemoryMapAllocation> file_;
+};
+
+std::shared_ptr<FileMemoryMapAllocation> AllocateFileMemoryMapAllocation(
+    const std::string &file_name);
+
 class MemoryMapWriterAllocation : public Allocation {
  public:
   explicit MemoryMapWriterAllocation(void *ptr,
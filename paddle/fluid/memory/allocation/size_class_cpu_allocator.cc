@@ -0,0 +1,318 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/size_class_cpu_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>  // NOLINT
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+namespace {
+
+// Slabs are at least 256KB and hold at least 8 blocks.
+constexpr size_t kMinSlabSize = 256 << 10;
+constexpr size_t kMinBlocksPerSlab = 8;
+// A thread caches at most 1MB (and at most 256 blocks) of each size class.
+constexpr size_t kThreadCacheBytesPerClass = 1 << 20;
+constexpr size_t kMaxCachedBlocks = 256;
+constexpr size_t kMinCachedBlocks = 4;
+// Number of size classes below 1KB, which are multiples of kAlignment.
+constexpr size_t kNumLinearClasses = 1024 / SizeClassCPUAllocator::kAlignment;
+
+inline size_t MaxCachedBlocks(size_t size_class) {
+  size_t num =
+      kThreadCacheBytesPerClass / SizeClassCPUAllocator::ClassToSize(size_class);
+  return std::min(std::max(num, kMinCachedBlocks), kMaxCachedBlocks);
+}
+
+}  // namespace
+
+size_t SizeClassCPUAllocator::SizeToClass(size_t size) {
+  if (size <= 1024) {
+    return size == 0 ? 0 : (size + kAlignment - 1) / kAlignment - 1;
+  }
+  size_t lg = 10;
+  while ((size - 1) >> (lg + 1)) {
+    ++lg;
+  }
+  return kNumLinearClasses + (lg - 10) * 4 + ((size - 1) >> (lg - 2)) - 4;
+}
+
+size_t SizeClassCPUAllocator::ClassToSize(size_t size_class) {
+  if (size_class < kNumLinearClasses) {
+    return (size_class + 1) * kAlignment;
+  }
+  size_t idx = size_class - kNumLinearClasses;
+  size_t lg = 10 + idx / 4;
+  return (5 + idx % 4) << (lg - 2);
+}
+
+// Free lists of blocks shared by all threads, one per size class.
+class SizeClassCPUAllocator::CentralCache {
+ public:
+  explicit CentralCache(const std::shared_ptr<Allocator> &underlying_allocator)
+      : underlying_allocator_(underlying_allocator) {}
+
+  // Fetch at most num blocks of size_class into blocks, return the number of
+  // fetched blocks, which is at least 1.
+  size_t FetchBatch(size_t size_class, size_t num, void **blocks) {
+    auto &free_list = free_lists_[size_class];
+    {
+      std::lock_guard<SpinLock> guard(free_list.lock);
+      size_t fetched = std::min(num, free_list.blocks.size());
+      if (fetched > 0) {
+        auto begin = free_list.blocks.end() - fetched;
+        std::copy(begin, free_list.blocks.end(), blocks);
+        free_list.blocks.erase(begin, free_list.blocks.end());
+        return fetched;
+      }
+    }
+    return AllocateSlab(size_class, num, blocks);
+  }
+
+  void ReturnBatch(size_t size_class, void *const *blocks, size_t num) {
+    auto &free_list = free_lists_[size_class];
+    std::lock_guard<SpinLock> guard(free_list.lock);
+    free_list.blocks.insert(free_list.blocks.end(), blocks, blocks + num);
+  }
+
+ private:
+  size_t AllocateSlab(size_t size_class, size_t num, void **blocks) {
+    size_t block_size = ClassToSize(size_class);
+    size_t slab_size =
+        std::max(kMinSlabSize, AlignedSize(block_size * kMinBlocksPerSlab,
+                                           kMinSlabSize));
+    auto slab = static_unique_ptr_cast<Allocation>(
+        underlying_allocator_->Allocate(slab_size));
+    auto *base = static_cast<uint8_t *>(slab->ptr());
+    size_t offset = AlignedPtrOffset(base, kAlignment);
+    size_t block_num = (slab_size - offset) / block_size;
+    base += offset;
+    PADDLE_ENFORCE_GT(
+        block_num,
+        0UL,
+        platform::errors::ResourceExhausted(
+            "The slab of %d bytes is too small for size class %d bytes.",
+            slab_size,
+            block_size));
+    {
+      std::lock_guard<SpinLock> guard(slabs_lock_);
+      slabs_.emplace_back(std::move(slab));
+    }
+
+    size_t fetched = std::min(num, block_num);
+    for (size_t i = 0; i < fetched; ++i) {
+      blocks[i] = base + i * block_size;
+    }
+    auto &free_list = free_lists_[size_class];
+    std::lock_guard<SpinLock> guard(free_list.lock);
+    for (size_t i = fetched; i < block_num; ++i) {
+      free_list.blocks.push_back(base + i * block_size);
+    }
+    return fetched;
+  }
+
+  struct alignas(64) FreeList {
+    SpinLock lock;
+    std::vector<void *> blocks;
+  };
+
+  std::shared_ptr<Allocator> underlying_allocator_;
+  std::array<FreeList, kNumSizeClasses> free_lists_;
+  SpinLock slabs_lock_;
+  std::vector<DecoratedAllocationPtr> slabs_;
+};
+
+// Blocks cached by one thread for one SizeClassCPUAllocator. Free blocks are
+// linked through their first word, so caching a block needs no memory.
+class SizeClassCPUAllocator::ThreadCache {
+ public:
+  ThreadCache(uint64_t id, const std::shared_ptr<CentralCache> &central_cache)
+      : id_(id), central_cache_(central_cache) {}
+
+  ~ThreadCache() { FlushAll(); }
+
+  uint64_t Id() const { return id_; }
+
+  void *Allocate(size_t size_class) {
+    auto &free_list = free_lists_[size_class];
+    if (UNLIKELY(free_list.head == nullptr)) {
+      void *blocks[kMaxCachedBlocks];
+      size_t num = central_cache_->FetchBatch(
+          size_class, MaxCachedBlocks(size_class) / 2, blocks);
+      for (size_t i = 0; i < num; ++i) {
+        Push(&free_list, blocks[i]);
+      }
+    }
+    return Pop(&free_list);
+  }
+
+  void Free(size_t size_class, void *ptr) {
+    auto &free_list = free_lists_[size_class];
+    Push(&free_list, ptr);
+    size_t max_cached_blocks = MaxCachedBlocks(size_class);
+    if (UNLIKELY(free_list.length > max_cached_blocks)) {
+      Flush(size_class, max_cached_blocks / 2);
+    }
+  }
+
+  void FlushAll() {
+    for (size_t size_class = 0; size_class < kNumSizeClasses; ++size_class) {
+      Flush(size_class, free_lists_[size_class].length);
+    }
+  }
+
+ private:
+  struct FreeList {
+    void *head{nullptr};
+    size_t length{0};
+  };
+
+  static void Push(FreeList *free_list, void *ptr) {
+    *static_cast<void **>(ptr) = free_list->head;
+    free_list->head = ptr;
+    ++free_list->length;
+  }
+
+  static void *Pop(FreeList *free_list) {
+    void *ptr = free_list->head;
+    free_list->head = *static_cast<void **>(ptr);
+    --free_list->length;
+    return ptr;
+  }
+
+  void Flush(size_t size_class, size_t num) {
+    auto &free_list = free_lists_[size_class];
+    void *blocks[kMaxCachedBlocks];
+    while (num > 0) {
+      size_t batch = std::min(num, kMaxCachedBlocks);
+      for (size_t i = 0; i < batch; ++i) {
+        blocks[i] = Pop(&free_list);
+      }
+      central_cache_->ReturnBatch(size_class, blocks, batch);
+      num -= batch;
+    }
+  }
+
+  uint64_t id_;
+  std::shared_ptr<CentralCache> central_cache_;
+  std::array<FreeList, kNumSizeClasses> free_lists_;
+};
+
+SizeClassCPUAllocator::SizeClassCPUAllocator(
+    const std::shared_ptr<Allocator> &underlying_allocator)
+    : underlying_allocator_(underlying_allocator),
+      central_cache_(std::make_shared<CentralCache>(underlying_allocator)) {
+  static std::atomic<uint64_t> next_id{1};
+  id_ = next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+// NOTE: the thread caches of other threads hold central_cache_, so the slabs
+// are released when the last of these threads exits.
+SizeClassCPUAllocator::~SizeClassCPUAllocator() = default;
+
+namespace {
+
+// Thread caches of the calling thread, the last used one is remembered in
+// trivially destructible thread_local variables for the fast path.
+thread_local uint64_t last_thread_cache_id = 0;
+thread_local void *last_thread_cache = nullptr;
+thread_local bool thread_caches_destroyed = false;
+
+}  // namespace
+
+SizeClassCPUAllocator::ThreadCache *SizeClassCPUAllocator::GetThreadCache() {
+  if (LIKELY(last_thread_cache_id == id_)) {
+    return static_cast<ThreadCache *>(last_thread_cache);
+  }
+  // Allocations may be freed by destructors of other thread_local objects
+  // after the thread caches are destroyed, use the central cache then.
+  if (UNLIKELY(thread_caches_destroyed)) {
+    return nullptr;
+  }
+
+  struct ThreadCacheRegistry {
+    ~ThreadCacheRegistry() {
+      last_thread_cache_id = 0;
+      last_thread_cache = nullptr;
+      thread_caches_destroyed = true;
+    }
+    std::vector<std::unique_ptr<ThreadCache>> caches;
+  };
+  static thread_local ThreadCacheRegistry registry;
+
+  ThreadCache *cache = nullptr;
+  for (auto &c : registry.caches) {
+    if (c->Id() == id_) {
+      cache = c.get();
+      break;
+    }
+  }
+  if (cache == nullptr) {
+    registry.caches.emplace_back(new ThreadCache(id_, central_cache_));
+    cache = registry.caches.back().get();
+  }
+  last_thread_cache_id = id_;
+  last_thread_cache = cache;
+  return cache;
+}
+
+phi::Allocation *SizeClassCPUAllocator::AllocateImpl(size_t size) {
+  if (size > kMaxSmallSize) {
+    return new SizeClassAllocation(static_unique_ptr_cast<Allocation>(
+        underlying_allocator_->Allocate(size)));
+  }
+  size_t size_class = SizeToClass(size);
+  void *ptr = nullptr;
+  ThreadCache *cache = GetThreadCache();
+  if (LIKELY(cache != nullptr)) {
+    ptr = cache->Allocate(size_class);
+  } else {
+    central_cache_->FetchBatch(size_class, 1, &ptr);
+  }
+  return new SizeClassAllocation(ptr, size, size_class);
+}
+
+void SizeClassCPUAllocator::FreeImpl(phi::Allocation *allocation) {
+  auto *size_class_allocation = static_cast<SizeClassAllocation *>(allocation);
+  size_t size_class = size_class_allocation->size_class_;
+  if (size_class < kNumSizeClasses) {
+    void *ptr = size_class_allocation->ptr();
+    ThreadCache *cache = GetThreadCache();
+    if (LIKELY(cache != nullptr)) {
+      cache->Free(size_class, ptr);
+    } else {
+      central_cache_->ReturnBatch(size_class, &ptr, 1);
+    }
+  }
+  delete size_class_allocation;
+}
+
+uint64_t SizeClassCPUAllocator::ReleaseImpl(const platform::Place &place) {
+  ThreadCache *cache = GetThreadCache();
+  if (cache != nullptr) {
+    cache->FlushAll();
+  }
+  return 0;
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
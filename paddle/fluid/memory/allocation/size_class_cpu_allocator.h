@@ -0,0 +1,98 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/memory/allocation/spin_lock.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// SizeClassCPUAllocator is a tcmalloc-like allocator for CPU memory.
+//
+// Small requests are rounded up to one of kNumSizeClasses size classes and
+// served from a per-thread cache without any lock. When a thread cache runs
+// empty (or grows too large) it moves a batch of blocks from (or to) a
+// central free list of that size class, which is guarded by its own SpinLock.
+// The central free lists are refilled by carving slabs obtained from the
+// underlying allocator. Requests larger than kMaxSmallSize go to the
+// underlying allocator directly.
+//
+// Memory of the slabs is kept until the allocator is destroyed, so
+// ReleaseImpl only returns the blocks cached by the calling thread to the
+// central free lists.
+class SizeClassCPUAllocator : public Allocator {
+ public:
+  static constexpr size_t kAlignment = 64;
+  static constexpr size_t kMaxSmallSize = 256 << 10;
+  static constexpr size_t kNumSizeClasses = 48;
+
+  explicit SizeClassCPUAllocator(
+      const std::shared_ptr<Allocator> &underlying_allocator);
+
+  ~SizeClassCPUAllocator();
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+  // Size classes are multiples of 64 bytes up to 1KB, then 4 classes per
+  // power of two up to kMaxSmallSize.
+  static size_t SizeToClass(size_t size);
+  static size_t ClassToSize(size_t size_class);
+
+ protected:
+  phi::Allocation *AllocateImpl(size_t size) override;
+
+  void FreeImpl(phi::Allocation *allocation) override;
+
+  uint64_t ReleaseImpl(const platform::Place &place) override;
+
+ private:
+  class CentralCache;
+  class ThreadCache;
+
+  struct SizeClassAllocation : public Allocation {
+    SizeClassAllocation(void *ptr, size_t size, size_t size_class)
+        : Allocation(ptr, size, platform::CPUPlace()),
+          size_class_(size_class) {}
+
+    explicit SizeClassAllocation(DecoratedAllocationPtr large_allocation)
+        : Allocation(large_allocation->ptr(),
+                     large_allocation->base_ptr(),
+                     large_allocation->size(),
+                     platform::CPUPlace()),
+          size_class_(kNumSizeClasses),
+          large_allocation_(std::move(large_allocation)) {}
+
+    size_t size_class_;
+    DecoratedAllocationPtr large_allocation_;
+  };
+
+  ThreadCache *GetThreadCache();
+
+  std::shared_ptr<Allocator> underlying_allocator_;
+  std::shared_ptr<CentralCache> central_cache_;
+  // Unique id of this allocator, used to look up the thread cache. Pointer
+  // of this can not be used since it may be reused after destruction.
+  uint64_t id_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,135 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/size_class_cpu_allocator.h"
+
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/allocation/aligned_allocator.h"
+#include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/cpu_allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+TEST(SizeClassCPUAllocator, size_class) {
+  size_t last_size = 0;
+  for (size_t size_class = 0;
+       size_class < SizeClassCPUAllocator::kNumSizeClasses;
+       ++size_class) {
+    size_t size = SizeClassCPUAllocator::ClassToSize(size_class);
+    ASSERT_GT(size, last_size);
+    ASSERT_EQ(size % SizeClassCPUAllocator::kAlignment, 0UL);
+    ASSERT_EQ(SizeClassCPUAllocator::SizeToClass(size), size_class);
+    ASSERT_EQ(SizeClassCPUAllocator::SizeToClass(last_size + 1), size_class);
+    last_size = size;
+  }
+  ASSERT_EQ(last_size, SizeClassCPUAllocator::kMaxSmallSize);
+}
+
+TEST(SizeClassCPUAllocator, alloc_and_free) {
+  auto allocator =
+      std::make_shared<SizeClassCPUAllocator>(std::make_shared<CPUAllocator>());
+  std::vector<size_t> sizes = {1, 63, 64, 65, 1000, 4096, 100000, 1 << 20};
+  std::vector<AllocationPtr> allocations;
+  for (size_t size : sizes) {
+    auto allocation = allocator->Allocate(size);
+    ASSERT_NE(allocation->ptr(), nullptr);
+    ASSERT_EQ(allocation->size(), size);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(allocation->ptr()) %
+                  SizeClassCPUAllocator::kAlignment,
+              0UL);
+    memset(allocation->ptr(), 0xff, size);
+    allocations.emplace_back(std::move(allocation));
+  }
+  // The freed block is reused by the next allocation of the same size class.
+  void* ptr = allocations[3]->ptr();
+  allocations[3].reset();
+  ASSERT_EQ(allocator->Allocate(sizes[3])->ptr(), ptr);
+  allocations.clear();
+  allocator->Release(platform::CPUPlace());
+}
+
+// Blocks allocated in one thread and freed in another one must be reusable.
+TEST(SizeClassCPUAllocator, cross_thread_free) {
+  auto allocator =
+      std::make_shared<SizeClassCPUAllocator>(std::make_shared<CPUAllocator>());
+  constexpr size_t kNum = 10000;
+  std::vector<AllocationPtr> allocations(kNum);
+  std::thread producer([&] {
+    for (size_t i = 0; i < kNum; ++i) {
+      allocations[i] = allocator->Allocate(128);
+    }
+  });
+  producer.join();
+  std::thread consumer([&] { allocations.clear(); });
+  consumer.join();
+  for (size_t i = 0; i < kNum; ++i) {
+    allocations.emplace_back(allocator->Allocate(128));
+  }
+}
+
+// Multi-threaded alloc/free benchmark, compared with
+// AutoGrowthBestFitAllocator which is guarded by a single SpinLock.
+static double BenchmarkAllocFree(const std::shared_ptr<Allocator>& allocator,
+                                 size_t thread_num) {
+  constexpr size_t kIterNum = 200000;
+  constexpr size_t kLiveNum = 64;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&allocator, t] {
+      std::mt19937 rng(t);
+      std::uniform_int_distribution<size_t> dist(1, 16 << 10);
+      std::vector<AllocationPtr> live(kLiveNum);
+      for (size_t i = 0; i < kIterNum; ++i) {
+        live[i % kLiveNum] = allocator->Allocate(dist(rng));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return thread_num * kIterNum / elapsed.count();
+}
+
+// Disabled by default, run with --gtest_also_run_disabled_tests.
+TEST(SizeClassCPUAllocator, DISABLED_multi_thread_benchmark) {
+  for (size_t thread_num : {1, 2, 4, 8, 16}) {
+    auto size_class_allocator = std::make_shared<SizeClassCPUAllocator>(
+        std::make_shared<CPUAllocator>());
+    auto auto_growth_allocator = std::make_shared<AutoGrowthBestFitAllocator>(
+        std::make_shared<CPUAllocator>(), SizeClassCPUAllocator::kAlignment);
+    double size_class_ops = BenchmarkAllocFree(size_class_allocator, thread_num);
+    double auto_growth_ops =
+        BenchmarkAllocFree(auto_growth_allocator, thread_num);
+    std::cout << "threads: " << thread_num
+              << ", size_class: " << size_class_ops / 1e6 << " Mops/s"
+              << ", auto_growth: " << auto_growth_ops / 1e6 << " Mops/s"
+              << std::endl;
+  }
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -12,11 +12,17 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "Eigen/Core"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/op_version_registry.h"
+#include "paddle/phi/kernels/funcs/blas/blas.h"
 
 namespace paddle {
 namespace operators {
@@ -294,6 +300,726 @@ class FusedMultiTransformerOpOpMaker
   }
 };
 
+// ============================ CPU kernel ===================================
+// The CPU kernel keeps the residual stream of the valid tokens in a
+// [token_num, dim_embed] buffer, runs the qkv/out_linear/ffn projections as
+// single GEMMs over all the tokens and computes the attention per
+// (batch, head) in parallel. CacheKV has the same layout as the CUDA kernel,
+// cache_k is [bsz, num_head, dim_head / x, max_seq_len, x] with x elements in
+// 16 bytes and cache_v is [bsz, num_head, max_seq_len, dim_head], so the
+// scores of a query against all the cached keys read cache_k sequentially.
+
+template <typename T>
+using FMTMatrix =
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+template <typename T>
+using FMTRows =
+    Eigen::Map<FMTMatrix<T>, Eigen::Unaligned, Eigen::OuterStride<>>;
+template <typename T>
+using ConstFMTRows =
+    Eigen::Map<const FMTMatrix<T>, Eigen::Unaligned, Eigen::OuterStride<>>;
+template <typename T>
+using FMTVector = Eigen::Map<Eigen::Matrix<T, 1, Eigen::Dynamic>>;
+
+// residual_out = src + residual + bias, ln_out = layer_norm(residual_out).
+// residual_out may alias src or residual, bias and ln_out may be nullptr.
+template <typename T>
+void ResidualBiasLayerNormCPU(const T *src,
+                              const T *residual,
+                              const T *bias,
+                              const T *ln_scale,
+                              const T *ln_bias,
+                              int rows,
+                              int cols,
+                              float epsilon,
+                              T *residual_out,
+                              T *ln_out) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < rows; ++i) {
+    int64_t offset = static_cast<int64_t>(i) * cols;
+    T *r = residual_out + offset;
+    T sum = 0;
+    for (int j = 0; j < cols; ++j) {
+      T val = src[offset + j] + (residual ? residual[offset + j] : 0) +
+              (bias ? bias[j] : 0);
+      r[j] = val;
+      sum += val;
+    }
+    if (ln_out == nullptr) continue;
+    T mean = sum / cols;
+    T var = 0;
+    for (int j = 0; j < cols; ++j) {
+      var += (r[j] - mean) * (r[j] - mean);
+    }
+    T inv_std = 1 / std::sqrt(var / cols + static_cast<T>(epsilon));
+    T *out = ln_out + offset;
+    for (int j = 0; j < cols; ++j) {
+      out[j] = (r[j] - mean) * inv_std * ln_scale[j] + ln_bias[j];
+    }
+  }
+}
+
+template <typename T>
+void LayerNormCPU(const T *x,
+                  const T *ln_scale,
+                  const T *ln_bias,
+                  int rows,
+                  int cols,
+                  float epsilon,
+                  T *residual_buf,
+                  T *ln_out) {
+  ResidualBiasLayerNormCPU<T>(x,
+                              nullptr,
+                              nullptr,
+                              ln_scale,
+                              ln_bias,
+                              rows,
+                              cols,
+                              epsilon,
+                              residual_buf,
+                              ln_out);
+}
+
+// x = act(x + bias) inplace, act is gelu, relu or none.
+template <typename T>
+void BiasActCPU(
+    T *x, const T *bias, int rows, int cols, const std::string &act_method) {
+  const bool gelu = act_method == "gelu";
+  const bool relu = act_method == "relu";
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < rows; ++i) {
+    T *row = x + static_cast<int64_t>(i) * cols;
+    for (int j = 0; j < cols; ++j) {
+      T val = row[j] + (bias ? bias[j] : 0);
+      if (gelu) {
+        val = val * static_cast<T>(0.5) *
+              (1 + std::erf(val * static_cast<T>(M_SQRT1_2)));
+      } else if (relu) {
+        val = val > 0 ? val : 0;
+      }
+      row[j] = val;
+    }
+  }
+}
+
+// Rotates the halves of every dim_head / rotary_emb_dims chunk of x, which
+// is the same as rotary_qk and the decoder fmha of the CUDA kernel.
+template <typename T>
+void RotaryEmbCPU(
+    T *x, const T *cos, const T *sin, int dim_head, int rotary_emb_dims) {
+  int last_dim = dim_head / rotary_emb_dims;
+  int half_lastdim = last_dim / 2;
+  for (int base = 0; base < dim_head; base += last_dim) {
+    for (int i = base; i < base + half_lastdim; ++i) {
+      T left = x[i];
+      T right = x[i + half_lastdim];
+      x[i] = left * cos[i] - right * sin[i];
+      x[i + half_lastdim] = right * cos[i] + left * sin[i];
+    }
+  }
+}
+
+// Softmax of the scores inplace, an all -inf row gives zeros.
+template <typename T>
+void SoftmaxRowCPU(T *scores, int len, T eps) {
+  FMTVector<T> row(scores, len);
+  T max_val = row.maxCoeff();
+  if (max_val == -std::numeric_limits<T>::infinity()) {
+    row.setZero();
+    return;
+  }
+  row = (row.array() - max_val).exp().matrix();
+  row /= (row.sum() + eps);
+}
+
+// The keys in CacheKV are grouped by 16 bytes, see write_cache_kv.
+constexpr int kFMTCacheVecBytes = 16;
+
+struct FMTCPUAttnParams {
+  int bsz;
+  int seq_len;
+  int num_head;
+  int dim_head;
+  int cache_offset;
+  int max_seq_len;
+  int rotary_emb_dims;
+  int rotary_seq_len;
+  int mask_heads;
+  int mask_rows;
+  int mask_cols;
+  const int *seq_lens;    // nullptr if no padding
+  const int *token_begin;  // first token of each batch in qkv/fmha_out
+};
+
+template <typename T, typename DeviceContext>
+class FusedMultiTransformerCPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext &ctx) const override {
+    auto &dev_ctx = ctx.template device_context<DeviceContext>();
+    auto blas = phi::funcs::GetBlas<DeviceContext, T>(dev_ctx);
+
+    auto *time_step = ctx.Input<phi::DenseTensor>("TimeStep");
+    // 0. input
+    auto *input_x = ctx.Input<phi::DenseTensor>("X");
+    const auto input_x_dims = input_x->dims();
+    int bsz = input_x_dims[0];
+    int seq_len = input_x_dims[1];
+    int dim_embed = input_x_dims[2];
+    const std::string act_method = ctx.Attr<std::string>("act_method");
+    const bool pre_layer_norm = ctx.Attr<bool>("pre_layer_norm");
+    const float epsilon = ctx.Attr<float>("epsilon");
+    const int ring_id = ctx.Attr<int>("ring_id");
+    PADDLE_ENFORCE_EQ(ring_id,
+                      -1,
+                      platform::errors::Unimplemented(
+                          "The CPU kernel of fused_multi_transformer does not "
+                          "support tensor model parallel, ring_id is %d.",
+                          ring_id));
+
+    auto *sequence_lengths = ctx.Input<phi::DenseTensor>("SeqLengths");
+    const int *seq_lens_data =
+        sequence_lengths ? sequence_lengths->data<int>() : nullptr;
+    bool encoder_remove_padding = (seq_lens_data != nullptr && !time_step);
+
+    // tokens of batch b are [token_begin[b], token_begin[b + 1]), padding
+    // tokens are skipped in the encoder.
+    std::vector<int> token_begin(bsz + 1, 0);
+    for (int b = 0; b < bsz; ++b) {
+      int len = encoder_remove_padding ? seq_lens_data[b] : seq_len;
+      token_begin[b + 1] = token_begin[b] + len;
+    }
+    int token_num = token_begin[bsz];
+
+    // 1. weights
+    auto ln_scales = ctx.MultiInput<phi::DenseTensor>("LnScale");
+    auto ln_biases = ctx.MultiInput<phi::DenseTensor>("LnBias");
+    auto qkv_weights = ctx.MultiInput<phi::DenseTensor>("QKVW");
+    auto qkv_biases = ctx.MultiInput<phi::DenseTensor>("QKVBias");
+    auto out_linear_weights = ctx.MultiInput<phi::DenseTensor>("OutLinearW");
+    auto out_linear_biases = ctx.MultiInput<phi::DenseTensor>("OutLinearBias");
+    auto ffn_ln_scales = ctx.MultiInput<phi::DenseTensor>("FFNLnScale");
+    auto ffn_ln_biases = ctx.MultiInput<phi::DenseTensor>("FFNLnBias");
+    auto ffn1_weights = ctx.MultiInput<phi::DenseTensor>("FFN1Weight");
+    auto ffn1_biases = ctx.MultiInput<phi::DenseTensor>("FFN1Bias");
+    auto ffn2_weights = ctx.MultiInput<phi::DenseTensor>("FFN2Weight");
+    auto ffn2_biases = ctx.MultiInput<phi::DenseTensor>("FFN2Bias");
+
+    const bool trans_qkvw = ctx.Attr<bool>("trans_qkvw");
+    const auto qkv_w_dims = qkv_weights[0]->dims();
+    int num_head = trans_qkvw ? qkv_w_dims[1] : qkv_w_dims[2];
+    int dim_head = trans_qkvw ? qkv_w_dims[2] : qkv_w_dims[3];
+    int hidden_size = num_head * dim_head;
+    int dim_ffn = ffn1_weights[0]->dims()[1];
+    const int cache_elems = kFMTCacheVecBytes / sizeof(T);
+    PADDLE_ENFORCE_EQ(
+        dim_head % cache_elems,
+        0,
+        platform::errors::InvalidArgument(
+            "dim_head=%d must be divisible by %d, the number of elements in "
+            "%d bytes of CacheKV.",
+            dim_head,
+            cache_elems,
+            kFMTCacheVecBytes));
+
+    // 2. attention inputs
+    auto *rotary_tensor = ctx.Input<phi::DenseTensor>("RotaryPosEmb");
+    const int rotary_emb_dims = ctx.Attr<int>("rotary_emb_dims");
+    auto *src_mask = ctx.Input<phi::DenseTensor>("SrcMask");
+    auto cache_kvs = ctx.MultiInput<phi::DenseTensor>("CacheKV");
+    auto cache_kv_outs = ctx.MultiOutput<phi::DenseTensor>("CacheKVOut");
+    auto pre_caches = ctx.MultiInput<phi::DenseTensor>("PreCaches");
+
+    FMTCPUAttnParams params;
+    params.bsz = bsz;
+    params.seq_len = seq_len;
+    params.num_head = num_head;
+    params.dim_head = dim_head;
+    params.cache_offset = pre_caches.size() > 0 ? pre_caches[0]->dims()[3] : 0;
+    params.max_seq_len = cache_kvs.size() > 0 ? cache_kvs[0]->dims()[3] : 0;
+    params.rotary_emb_dims = rotary_emb_dims;
+    params.rotary_seq_len =
+        rotary_emb_dims != 0 ? rotary_tensor->dims()[3] : 0;
+    params.mask_heads = 1;
+    params.mask_rows = 1;
+    params.mask_cols = 0;
+    if (src_mask) {
+      auto mask_dims = src_mask->dims();
+      int rank = mask_dims.size();
+      params.mask_heads = rank == 4 ? mask_dims[1] : 1;
+      params.mask_rows = mask_dims[rank - 2];
+      params.mask_cols = mask_dims[rank - 1];
+    }
+    params.seq_lens = seq_lens_data;
+    params.token_begin = token_begin.data();
+
+    int time_step_value = 0;
+    if (time_step) {
+      PADDLE_ENFORCE_EQ(time_step->place(),
+                        platform::CPUPlace(),
+                        platform::errors::PreconditionNotMet(
+                            "The place of input(TimeStep) must be CPUPlace."));
+      time_step_value = time_step->data<int>()[0];
+      PADDLE_ENFORCE_GT(time_step_value,
+                        0,
+                        platform::errors::PreconditionNotMet(
+                            "The value of time_step must > 0, but now is %d",
+                            time_step_value));
+      PADDLE_ENFORCE_EQ(
+          seq_len,
+          1,
+          platform::errors::PreconditionNotMet(
+              "In decode stage, the seq_len of input must be 1, but now is %d",
+              seq_len));
+    } else if (cache_kv_outs.size() > 0) {
+      PADDLE_ENFORCE_LE(params.cache_offset + seq_len,
+                        params.max_seq_len,
+                        platform::errors::PreconditionNotMet(
+                            "The length of PreCaches and input %d exceeds the "
+                            "max_seq_len %d of CacheKV.",
+                            params.cache_offset + seq_len,
+                            params.max_seq_len));
+    }
+
+    // 3. buffers
+    phi::DenseTensor x_buf, ln_out, qkv_out, fmha_out, ffn1_out, tmp_out;
+    x_buf.Resize({{token_num, dim_embed}});
+    T *x_data = dev_ctx.template Alloc<T>(&x_buf);
+    ln_out.Resize({{token_num, dim_embed}});
+    T *ln_out_data = dev_ctx.template Alloc<T>(&ln_out);
+    qkv_out.Resize({{token_num, 3, num_head, dim_head}});
+    T *qkv_out_data = dev_ctx.template Alloc<T>(&qkv_out);
+    fmha_out.Resize({{token_num, num_head, dim_head}});
+    T *fmha_out_data = dev_ctx.template Alloc<T>(&fmha_out);
+    ffn1_out.Resize({{token_num, dim_ffn}});
+    T *ffn1_out_data = dev_ctx.template Alloc<T>(&ffn1_out);
+    tmp_out.Resize({{token_num, dim_embed}});
+    T *tmp_out_data = dev_ctx.template Alloc<T>(&tmp_out);
+
+    const T *input_x_data = input_x->data<T>();
+    for (int b = 0; b < bsz; ++b) {
+      int len = token_begin[b + 1] - token_begin[b];
+      std::memcpy(x_data + static_cast<int64_t>(token_begin[b]) * dim_embed,
+                  input_x_data + static_cast<int64_t>(b) * seq_len * dim_embed,
+                  sizeof(T) * len * dim_embed);
+    }
+
+    int layers = qkv_weights.size();
+    for (int i = 0; i < layers; ++i) {
+      // step1. layer_norm
+      const T *attn_in = x_data;
+      if (pre_layer_norm) {
+        LayerNormCPU<T>(x_data,
+                        ln_scales[i]->data<T>(),
+                        ln_biases[i]->data<T>(),
+                        token_num,
+                        dim_embed,
+                        epsilon,
+                        tmp_out_data,
+                        ln_out_data);
+        attn_in = ln_out_data;
+      }
+
+      // step2. qkv, the bias is added together with the rotary embedding
+      blas.GEMM(CblasNoTrans,
+                trans_qkvw ? CblasTrans : CblasNoTrans,
+                token_num,
+                3 * hidden_size,
+                dim_embed,
+                static_cast<T>(1),
+                attn_in,
+                qkv_weights[i]->data<T>(),
+                static_cast<T>(0),
+                qkv_out_data);
+
+      // step3. fmha
+      const T *qkv_bias =
+          qkv_biases.size() > 0 ? qkv_biases[i]->data<T>() : nullptr;
+      T *cache_kv_data =
+          cache_kv_outs.size() > 0 ? cache_kv_outs[i]->data<T>() : nullptr;
+      const T *rotary_data =
+          rotary_emb_dims != 0 ? rotary_tensor->data<T>() : nullptr;
+      const T *mask_data = src_mask ? src_mask->data<T>() : nullptr;
+      if (time_step) {
+        DecoderAttention(params,
+                         time_step_value,
+                         qkv_out_data,
+                         qkv_bias,
+                         rotary_data,
+                         mask_data,
+                         cache_kv_data,
+                         fmha_out_data);
+      } else {
+        const T *pre_cache_data =
+            pre_caches.size() > 0 ? pre_caches[i]->data<T>() : nullptr;
+        EncoderAttention(params,
+                         qkv_out_data,
+                         qkv_bias,
+                         rotary_data,
+                         mask_data,
+                         pre_cache_data,
+                         cache_kv_data,
+                         fmha_out_data);
+      }
+
+      // step4. out_linear
+      blas.GEMM(CblasNoTrans,
+                CblasNoTrans,
+                token_num,
+                dim_embed,
+                hidden_size,
+                static_cast<T>(1),
+                fmha_out_data,
+                out_linear_weights[i]->data<T>(),
+                static_cast<T>(0),
+                tmp_out_data);
+
+      // step5. ln(residual + bias)
+      const T *out_linear_bias = out_linear_biases.size() > 0
+                                     ? out_linear_biases[i]->data<T>()
+                                     : nullptr;
+      const T *ffn_in = nullptr;
+      if (pre_layer_norm) {
+        ResidualBiasLayerNormCPU<T>(tmp_out_data,
+                                    x_data,
+                                    out_linear_bias,
+                                    ffn_ln_scales[i]->data<T>(),
+                                    ffn_ln_biases[i]->data<T>(),
+                                    token_num,
+                                    dim_embed,
+                                    epsilon,
+                                    x_data,
+                                    ln_out_data);
+        ffn_in = ln_out_data;
+      } else {
+        ResidualBiasLayerNormCPU<T>(tmp_out_data,
+                                    x_data,
+                                    out_linear_bias,
+                                    ln_scales[i]->data<T>(),
+                                    ln_biases[i]->data<T>(),
+                                    token_num,
+                                    dim_embed,
+                                    epsilon,
+                                    tmp_out_data,
+                                    x_data);
+        ffn_in = x_data;
+      }
+
+      // step6. ffn matmul1 + act bias
+      blas.GEMM(CblasNoTrans,
+                CblasNoTrans,
+                token_num,
+                dim_ffn,
+                dim_embed,
+                static_cast<T>(1),
+                ffn_in,
+                ffn1_weights[i]->data<T>(),
+                static_cast<T>(0),
+                ffn1_out_data);
+      BiasActCPU<T>(ffn1_out_data,
+                    ffn1_biases.size() > 0 ? ffn1_biases[i]->data<T>()
+                                           : nullptr,
+                    token_num,
+                    dim_ffn,
+                    act_method);
+
+      // step7. ffn matmul2 + residual bias
+      blas.GEMM(CblasNoTrans,
+                CblasNoTrans,
+                token_num,
+                dim_embed,
+                dim_ffn,
+                static_cast<T>(1),
+                ffn1_out_data,
+                ffn2_weights[i]->data<T>(),
+                static_cast<T>(0),
+                tmp_out_data);
+      const T *ffn2_bias =
+          ffn2_biases.size() > 0 ? ffn2_biases[i]->data<T>() : nullptr;
+      if (pre_layer_norm) {
+        ResidualBiasLayerNormCPU<T>(tmp_out_data,
+                                    x_data,
+                                    ffn2_bias,
+                                    nullptr,
+                                    nullptr,
+                                    token_num,
+                                    dim_embed,
+                                    epsilon,
+                                    x_data,
+                                    nullptr);
+      } else {
+        ResidualBiasLayerNormCPU<T>(tmp_out_data,
+                                    x_data,
+                                    ffn2_bias,
+                                    ffn_ln_scales[i]->data<T>(),
+                                    ffn_ln_biases[i]->data<T>(),
+                                    token_num,
+                                    dim_embed,
+                                    epsilon,
+                                    tmp_out_data,
+                                    x_data);
+      }
+    }
+
+    // rebuild padding, the padding tokens of the output are zeros.
+    auto *out = ctx.Output<phi::DenseTensor>("Out");
+    T *out_data = dev_ctx.template Alloc<T>(out);
+    if (encoder_remove_padding) {
+      std::memset(out_data, 0, sizeof(T) * out->numel());
+    }
+    for (int b = 0; b < bsz; ++b) {
+      int len = token_begin[b + 1] - token_begin[b];
+      std::memcpy(out_data + static_cast<int64_t>(b) * seq_len * dim_embed,
+                  x_data + static_cast<int64_t>(token_begin[b]) * dim_embed,
+                  sizeof(T) * len * dim_embed);
+    }
+  }
+
+ private:
+  // Adds the bias of q/k/v of token and applies the rotary embedding to
+  // q/k, the q of the token is also scaled by 1 / sqrt(dim_head).
+  static void PrepareQKV(const FMTCPUAttnParams &params,
+                         T *qkv,
+                         const T *qkv_bias,
+                         const T *rotary,
+                         int b,
+                         int s,
+                         int h) {
+    int dim_head = params.dim_head;
+    int hidden_size = params.num_head * dim_head;
+    T *q = qkv + h * dim_head;
+    T *k = q + hidden_size;
+    T *v = k + hidden_size;
+    if (qkv_bias) {
+      const T *bias = qkv_bias + h * dim_head;
+      for (int d = 0; d < dim_head; ++d) {
+        q[d] += bias[d];
+        k[d] += bias[hidden_size + d];
+        v[d] += bias[2 * hidden_size + d];
+      }
+    }
+    if (rotary) {
+      // rotary [2, bsz, 1, rotary_seq_len, dim_head]
+      int64_t emb_size =
+          static_cast<int64_t>(params.bsz) * params.rotary_seq_len * dim_head;
+      const T *cos =
+          rotary +
+          (static_cast<int64_t>(b) * params.rotary_seq_len + s) * dim_head;
+      RotaryEmbCPU<T>(q, cos, cos + emb_size, dim_head, params.rotary_emb_dims);
+      RotaryEmbCPU<T>(k, cos, cos + emb_size, dim_head, params.rotary_emb_dims);
+    }
+    FMTVector<T>(q, dim_head) *= static_cast<T>(1.0 / std::sqrt(dim_head));
+  }
+
+  static const T *MaskRow(const FMTCPUAttnParams &params,
+                          const T *mask,
+                          int b,
+                          int h,
+                          int s) {
+    if (mask == nullptr) return nullptr;
+    int mask_h = params.mask_heads > 1 ? h : 0;
+    return mask + ((static_cast<int64_t>(b) * params.mask_heads + mask_h) *
+                       params.mask_rows +
+                   s) *
+                      params.mask_cols;
+  }
+
+  // Writes the keys and values [len, dim_head] of a (batch, head) into
+  // CacheKV from position begin.
+  static void WriteCacheKV(const FMTCPUAttnParams &params,
+                           const T *k,
+                           const T *v,
+                           int begin,
+                           int len,
+                           T *cache_k,
+                           T *cache_v) {
+    constexpr int kElems = kFMTCacheVecBytes / sizeof(T);
+    const int dim_head = params.dim_head;
+    for (int c = 0; c < dim_head / kElems; ++c) {
+      T *dst = cache_k + (static_cast<int64_t>(c) * params.max_seq_len +
+                          begin) *
+                             kElems;
+      for (int t = 0; t < len; ++t) {
+        std::memcpy(dst + t * kElems,
+                    k + static_cast<int64_t>(t) * dim_head + c * kElems,
+                    sizeof(T) * kElems);
+      }
+    }
+    std::memcpy(cache_v + static_cast<int64_t>(begin) * dim_head,
+                v,
+                sizeof(T) * len * dim_head);
+  }
+
+  // Attention of the whole sequences, the keys are the PreCaches followed by
+  // the tokens of the sequence, which are written to CacheKV if it is given.
+  static void EncoderAttention(const FMTCPUAttnParams &params,
+                               T *qkv,
+                               const T *qkv_bias,
+                               const T *rotary,
+                               const T *mask,
+                               const T *pre_cache,
+                               T *cache_kv,
+                               T *fmha_out) {
+    const int num_head = params.num_head;
+    const int dim_head = params.dim_head;
+    const int hidden_size = num_head * dim_head;
+    const int cache_offset = params.cache_offset;
+    const int64_t cache_k_size = static_cast<int64_t>(params.bsz) * num_head *
+                                 params.max_seq_len * dim_head;
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int task = 0; task < params.bsz * num_head; ++task) {
+      int b = task / num_head;
+      int h = task % num_head;
+      int tok_begin = params.token_begin[b];
+      int len = params.token_begin[b + 1] - tok_begin;
+      int kv_len = cache_offset + len;
+
+      FMTMatrix<T> q(len, dim_head);
+      FMTMatrix<T> k(kv_len, dim_head);
+      FMTMatrix<T> v(kv_len, dim_head);
+      if (cache_offset > 0) {
+        // pre_cache [2, bsz, num_head, cache_offset, dim_head]
+        int64_t pre_k_size = static_cast<int64_t>(params.bsz) * num_head *
+                             cache_offset * dim_head;
+        const T *pre_k =
+            pre_cache + static_cast<int64_t>(task) * cache_offset * dim_head;
+        std::memcpy(k.data(), pre_k, sizeof(T) * cache_offset * dim_head);
+        std::memcpy(
+            v.data(), pre_k + pre_k_size, sizeof(T) * cache_offset * dim_head);
+      }
+      for (int s = 0; s < len; ++s) {
+        T *token_qkv =
+            qkv + static_cast<int64_t>(tok_begin + s) * 3 * hidden_size;
+        PrepareQKV(params, token_qkv, qkv_bias, rotary, b, s, h);
+        const T *q_src = token_qkv + h * dim_head;
+        std::memcpy(q.row(s).data(), q_src, sizeof(T) * dim_head);
+        std::memcpy(k.row(cache_offset + s).data(),
+                    q_src + hidden_size,
+                    sizeof(T) * dim_head);
+        std::memcpy(v.row(cache_offset + s).data(),
+                    q_src + 2 * hidden_size,
+                    sizeof(T) * dim_head);
+      }
+
+      FMTMatrix<T> scores = q * k.transpose();
+      for (int s = 0; s < len; ++s) {
+        const T *mask_row = MaskRow(params, mask, b, h, s);
+        if (mask_row) {
+          scores.row(s) += FMTVector<T>(const_cast<T *>(mask_row), kv_len);
+        }
+        SoftmaxRowCPU<T>(scores.row(s).data(), kv_len, static_cast<T>(0));
+      }
+      FMTRows<T> out(fmha_out + static_cast<int64_t>(tok_begin) * hidden_size +
+                         h * dim_head,
+                     len,
+                     dim_head,
+                     Eigen::OuterStride<>(hidden_size));
+      out.noalias() = scores * v;
+
+      if (cache_kv) {
+        T *cache_k = cache_kv + static_cast<int64_t>(task) *
+                                    params.max_seq_len * dim_head;
+        WriteCacheKV(params,
+                     k.data(),
+                     v.data(),
+                     0,
+                     kv_len,
+                     cache_k,
+                     cache_k + cache_k_size);
+      }
+    }
+  }
+
+  // Attention of one new token against the cache. The key and value of the
+  // token are appended to CacheKV at its time step inplace.
+  static void DecoderAttention(const FMTCPUAttnParams &params,
+                               int time_step,
+                               T *qkv,
+                               const T *qkv_bias,
+                               const T *rotary,
+                               const T *mask,
+                               T *cache_kv,
+                               T *fmha_out) {
+    constexpr int kElems = kFMTCacheVecBytes / sizeof(T);
+    using KSliceMatrix =
+        Eigen::Matrix<T, Eigen::Dynamic, kElems, Eigen::RowMajor>;
+    const int num_head = params.num_head;
+    const int dim_head = params.dim_head;
+    const int hidden_size = num_head * dim_head;
+    const int64_t cache_k_size = static_cast<int64_t>(params.bsz) * num_head *
+                                 params.max_seq_len * dim_head;
+
+    for (int b = 0; b < params.bsz; ++b) {
+      int act_time_step = params.seq_lens ? params.seq_lens[b] : time_step;
+      PADDLE_ENFORCE_LT(act_time_step,
+                        params.max_seq_len,
+                        platform::errors::PreconditionNotMet(
+                            "The time step %d of batch %d exceeds the "
+                            "max_seq_len %d of CacheKV.",
+                            act_time_step,
+                            b,
+                            params.max_seq_len));
+    }
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int task = 0; task < params.bsz * num_head; ++task) {
+      int b = task / num_head;
+      int h = task % num_head;
+      int act_time_step = params.seq_lens ? params.seq_lens[b] : time_step;
+      int kv_len = act_time_step + 1;
+
+      T *token_qkv = qkv + static_cast<int64_t>(b) * 3 * hidden_size;
+      PrepareQKV(params, token_qkv, qkv_bias, rotary, b, 0, h);
+      const T *q = token_qkv + h * dim_head;
+
+      T *cache_k =
+          cache_kv + static_cast<int64_t>(task) * params.max_seq_len * dim_head;
+      T *cache_v = cache_k + cache_k_size;
+      WriteCacheKV(params,
+                   q + hidden_size,
+                   q + 2 * hidden_size,
+                   act_time_step,
+                   1,
+                   cache_k,
+                   cache_v);
+
+      // scores[t] = sum_c dot(q[c], cache_k[c][t]), each [max_seq_len, x]
+      // slice of cache_k is read sequentially.
+      Eigen::Matrix<T, 1, Eigen::Dynamic> scores =
+          Eigen::Matrix<T, 1, Eigen::Dynamic>::Zero(kv_len);
+      for (int c = 0; c < dim_head / kElems; ++c) {
+        Eigen::Map<const KSliceMatrix> k_slice(
+            cache_k + static_cast<int64_t>(c) * params.max_seq_len * kElems,
+            kv_len,
+            kElems);
+        Eigen::Map<const Eigen::Matrix<T, kElems, 1>> q_slice(q + c * kElems);
+        scores.noalias() += (k_slice * q_slice).transpose();
+      }
+      // NOTE: like the CUDA kernel, the token itself is never masked.
+      const T *mask_row = MaskRow(params, mask, b, h, 0);
+      if (mask_row) {
+        for (int t = 0; t < act_time_step; ++t) {
+          scores[t] += mask_row[t];
+        }
+      }
+      SoftmaxRowCPU<T>(scores.data(), kv_len, static_cast<T>(1e-6));
+      Eigen::Map<const FMTMatrix<T>> v_mat(cache_v, kv_len, dim_head);
+      FMTVector<T>(fmha_out + static_cast<int64_t>(b) * hidden_size +
+                       h * dim_head,
+                   dim_head)
+          .noalias() = scores * v_mat;
+    }
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
 
@@ -313,3 +1039,10 @@ REGISTER_OP_VERSION(fused_multi_transformer)
             "trans_qkvw",
             "A flag to indicate whether to transpose for weights of qkv.",
             true));
+
+PD_REGISTER_STRUCT_KERNEL(fused_multi_transformer,
+                          CPU,
+                          ALL_LAYOUT,
+                          ops::FusedMultiTransformerCPUKernel,
+                          float,
+                          double) {}
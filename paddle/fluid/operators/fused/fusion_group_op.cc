@@ -78,8 +78,7 @@ class FusionGroupOp : public framework::OperatorWithKernel {
  protected:
   phi::KernelKey GetExpectedKernelType(
       const framework::ExecutionContext& ctx) const override {
-    return phi::KernelKey(framework::proto::VarType::FP32,
-                          platform::CUDAPlace(0));
+    return phi::KernelKey(framework::proto::VarType::FP32, ctx.GetPlace());
   };
 };
 
@@ -117,3 +116,5 @@ multiple operators into one. It supports several types:
 
 namespace ops = paddle::operators;
 REGISTER_OPERATOR(fusion_group, ops::FusionGroupOp, ops::FusionGroupOpMaker);
+PD_REGISTER_STRUCT_KERNEL(
+    fusion_group, CPU, ALL_LAYOUT, ops::FusionGroupKernel, float, double) {}
@@ -24,6 +24,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/string_array.h"
 #include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/memory/allocation/mmap_allocator.h"
 #include "paddle/fluid/platform/device_context.h"
 
 namespace paddle {
@@ -53,6 +54,17 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
               "LoadCombine operator fails to open file %s, please check "
               "whether the model file is complete or damaged.",
               filename));
+      // the file saved by save_combine in the aligned layout is mapped
+      uint32_t version = 0;
+      fin.read(reinterpret_cast<char *>(&version), sizeof(version));
+      if (fin && version == framework::kAlignedTensorVersion) {
+        fin.close();
+        LoadParamsFromMappedFile(
+            ctx, place, filename, load_as_fp16, out_var_names);
+        return;
+      }
+      fin.clear();
+      fin.seekg(0, std::ios::beg);
       LoadParamsFromBuffer(ctx, place, &fin, load_as_fp16, out_var_names);
     } else {
       PADDLE_ENFORCE_NE(
@@ -67,6 +79,81 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
     }
   }
 
+  // Loads the tensors from the file of the aligned layout mapped into memory.
+  // On CPU the tensors share the pages of the mapping, which are shared with
+  // the other processes loading the same file, otherwise they are copied.
+  void LoadParamsFromMappedFile(
+      const framework::ExecutionContext &context,
+      const platform::Place &place,
+      const std::string &filename,
+      bool load_as_fp16,
+      const std::vector<std::string> &out_var_names) const {
+#ifndef _WIN32
+    auto file = memory::allocation::AllocateFileMemoryMapAllocation(filename);
+    auto out_vars = context.MultiOutputVar("Out");
+    size_t offset = 0;
+
+    for (size_t i = 0; i < out_var_names.size(); i++) {
+      VLOG(4) << "mapping tensor: " << out_var_names[i];
+      PADDLE_ENFORCE_NOT_NULL(
+          out_vars[i],
+          platform::errors::InvalidArgument(
+              "The variable %s to be loaded cannot be found.",
+              out_var_names[i]));
+      PADDLE_ENFORCE_EQ(
+          out_vars[i]->IsType<framework::Vocab>(),
+          false,
+          platform::errors::InvalidArgument(
+              "The variable %s is a Vocab, which cannot be loaded from the "
+              "file %s of the aligned layout.",
+              out_var_names[i],
+              filename));
+      PADDLE_ENFORCE_LT(offset,
+                        file->size(),
+                        platform::errors::Unavailable(
+                            "An error occurred while loading model parameters. "
+                            "Please check whether the model file is complete "
+                            "or damaged."));
+      phi::DenseTensor mapped;
+      framework::DeserializeFromMappedFile(file, &offset, &mapped);
+
+      auto in_dtype = mapped.dtype();
+      auto out_dtype = load_as_fp16 ? phi::DataType::FLOAT16 : in_dtype;
+      if (in_dtype != out_dtype) {
+        // convert to float16 tensor
+        platform::CPUPlace cpu;
+        auto in_kernel_type =
+            phi::KernelKey(cpu, phi::DataLayout::ALL_LAYOUT, in_dtype);
+        auto out_kernel_type =
+            phi::KernelKey(cpu, phi::DataLayout::ALL_LAYOUT, out_dtype);
+        phi::DenseTensor fp16_tensor;
+        fp16_tensor.set_lod(mapped.lod());
+        framework::TransDataType(
+            in_kernel_type, out_kernel_type, mapped, &fp16_tensor);
+        mapped = fp16_tensor;
+      }
+
+      auto *tensor = out_vars[i]->GetMutable<phi::DenseTensor>();
+      if (platform::is_cpu_place(place)) {
+        tensor->ShareDataWith(mapped);
+      } else {
+        framework::TensorCopySync(mapped, place, tensor);
+      }
+      tensor->set_lod(mapped.lod());
+    }
+    PADDLE_ENFORCE_EQ(offset,
+                      file->size(),
+                      platform::errors::Unavailable(
+                          "Not allowed to load partial data via "
+                          "load_combine_op, please use load_op instead."));
+#else
+    PADDLE_THROW(platform::errors::Unimplemented(
+        "Loading the file %s of the aligned layout is not supported on "
+        "Windows.",
+        filename));
+#endif
+  }
+
   void LoadParamsFromBuffer(
       const framework::ExecutionContext &context,
       const platform::Place &place,
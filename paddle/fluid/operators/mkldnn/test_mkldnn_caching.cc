@@ -13,9 +13,12 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <map>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/lod_tensor.h"
@@ -26,6 +29,9 @@
 #include "paddle/phi/core/enforce.h"
 #include "paddle/phi/core/kernel_registry.h"
 
+DECLARE_int32(onednn_primitive_cache_capacity);
+DECLARE_string(onednn_primitive_cache_save_file);
+
 USE_OP_ITSELF(elementwise_add);
 PD_DECLARE_KERNEL(add_raw, OneDNN, ONEDNN);
 USE_OP_ITSELF(elementwise_mul);
@@ -161,5 +167,104 @@ TEST(test_conv2d_noreuse_cache, cpu_place) {
                         "Invalid number of cached oneDNN objects"));
 }
 
+TEST(test_onednn_primitive_cache, lru) {
+  auto &cache = phi::OneDNNPrimitiveCache::Instance();
+  cache.Clear();
+  int capacity = FLAGS_onednn_primitive_cache_capacity;
+  FLAGS_onednn_primitive_cache_capacity = 2;
+  int64_t records[] = {1, 2, 3};
+  for (int i = 0; i < 2; ++i) {
+    cache.Set(&records[i], sizeof(int64_t), std::make_shared<int>(i));
+  }
+  // the record 1 is used more recently than the record 2
+  ASSERT_NE(cache.Get(&records[0], sizeof(int64_t)), nullptr);
+  cache.Set(&records[2], sizeof(int64_t), std::make_shared<int>(2));
+  ASSERT_EQ(cache.Size(), 2UL);
+  ASSERT_NE(cache.Get(&records[0], sizeof(int64_t)), nullptr);
+  ASSERT_EQ(cache.Get(&records[1], sizeof(int64_t)), nullptr);
+  ASSERT_EQ(
+      *std::static_pointer_cast<int>(cache.Get(&records[2], sizeof(int64_t))),
+      2);
+  FLAGS_onednn_primitive_cache_capacity = capacity;
+  cache.Clear();
+}
+
+TEST(test_onednn_primitive_cache, concurrent) {
+  auto &cache = phi::OneDNNPrimitiveCache::Instance();
+  cache.Clear();
+  int capacity = FLAGS_onednn_primitive_cache_capacity;
+  FLAGS_onednn_primitive_cache_capacity = 4;
+  // the threads look up and insert overlapping records
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&cache, i] {
+      for (int64_t j = 0; j < 1000; ++j) {
+        int64_t record = (i + j) % 8;
+        auto data = cache.Get(&record, sizeof(record));
+        if (data == nullptr) {
+          cache.Set(&record, sizeof(record), std::make_shared<int64_t>(record));
+        } else {
+          ASSERT_EQ(*std::static_pointer_cast<int64_t>(data), record);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(cache.Size(), 4UL);
+  FLAGS_onednn_primitive_cache_capacity = capacity;
+  cache.Clear();
+}
+
+TEST(test_onednn_primitive_cache, save_at_exit) {
+  const char *path = "test_onednn_primitive_cache_save_at_exit.records";
+  std::remove(path);
+  // the records are saved when the process running the statement exits
+  EXPECT_EXIT(
+      {
+        FLAGS_onednn_primitive_cache_save_file = path;
+        int64_t record = 1;
+        phi::OneDNNPrimitiveCache::Instance().Set(
+            &record, sizeof(record), std::make_shared<int>(1));
+        std::exit(0);
+      },
+      ::testing::ExitedWithCode(0),
+      "");
+  FILE *fp = fopen(path, "rb");
+  ASSERT_NE(fp, nullptr);
+  fclose(fp);
+  std::remove(path);
+}
+
+TEST(test_relu_share_primitive, cpu_place) {
+  auto &cache = phi::OneDNNPrimitiveCache::Instance();
+  cache.Clear();
+  framework::DDim dims({1, 16, 32, 64});
+  phi::CPUPlace p;
+  // The threads running relu of the same shape share a primitive
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back(
+        [&] { RunOperator<float>(p, "relu", dims, "input_signal"); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(cache.Size(), 1UL);
+  RunOperator<float>(p, "relu", framework::DDim({1, 16, 32, 32}), "x");
+  ASSERT_EQ(cache.Size(), 2UL);
+
+  // The records saved are replayed to create the primitives
+  const char *path = "test_relu_share_primitive.records";
+  ASSERT_TRUE(cache.SaveRecords(path));
+  cache.Clear();
+  auto &pool = platform::DeviceContextPool::Instance();
+  auto *dev_ctx = dynamic_cast<phi::OneDNNContext *>(pool.Get(p));
+  ASSERT_EQ(cache.Warmup(path, dev_ctx->GetEngine()), 2UL);
+  std::remove(path);
+  cache.Clear();
+}
+
 }  // namespace operators
 }  // namespace paddle
@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include <string>
 
+#include "paddle/fluid/framework/op_version_registry.h"
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/common/bfloat16.h"
 #include "paddle/phi/core/kernel_registry.h"
@@ -79,6 +80,13 @@ to a file on disk.
                   "(boolean, default false)"
                   "If true, the variables will be saved to binary strings.")
         .SetDefault(false);
+    AddAttr<bool>("save_aligned",
+                  "(boolean, default false)"
+                  "If true, the LoDTensors will be saved in the aligned "
+                  "layout, in which the data of every tensor is aligned, so "
+                  "that load_combine can map them from the file instead of "
+                  "copying. Vocab variables are always saved as before.")
+        .SetDefault(false);
     AddOutput("Y",
               "(RAW, default empty)."
               "This output is used when saving variables to binary strings.")
@@ -104,6 +112,16 @@ REGISTER_OPERATOR(save_combine,
                   ops::SaveCombineOpProtoMaker,
                   ops::SaveCombineOpInferVarType);
 
+REGISTER_OP_VERSION(save_combine)
+    .AddCheckpoint(
+        R"ROC(
+              Upgrade save_combine: add a new attribute [save_aligned].)ROC",
+        paddle::framework::compatible::OpVersionDesc().NewAttr(
+            "save_aligned",
+            "If true, the LoDTensors are saved in the aligned layout, which "
+            "load_combine can map from the file instead of copying.",
+            false));
+
 PD_REGISTER_KERNEL(save_combine_tensor,
                    CPU,
                    ALL_LAYOUT,
@@ -65,7 +65,14 @@ void SaveCombineTensorKernel(const Context& dev_ctx,
                              bool overwrite,
                              bool save_as_fp16,
                              bool save_to_memory,
+                             bool save_aligned,
                              phi::ExtendedTensor* out) {
+  PADDLE_ENFORCE_EQ(
+      save_aligned && save_to_memory,
+      false,
+      phi::errors::InvalidArgument(
+          "save_aligned cannot be used with save_to_memory, because "
+          "load_combine maps the aligned layout only from a file."));
   std::string* y = nullptr;
   if (out != nullptr) {
     auto raw_out = static_cast<paddle::framework::RawTensor*>(out);
@@ -110,7 +117,13 @@ void SaveCombineTensorKernel(const Context& dev_ctx,
       framework::TransDataType(in_kernel_type, out_kernel_type, tensor, &out);
       // copy LoD info to the new tensor
       out.set_lod(tensor.lod());
-      framework::SerializeToStream(ss, out, dev_ctx);
+      if (save_aligned) {
+        framework::SerializeToAlignedStream(ss, out, dev_ctx);
+      } else {
+        framework::SerializeToStream(ss, out, dev_ctx);
+      }
+    } else if (save_aligned) {
+      framework::SerializeToAlignedStream(ss, tensor, dev_ctx);
     } else {
       framework::SerializeToStream(ss, tensor, dev_ctx);
     }
@@ -179,6 +192,7 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     auto overwrite = ctx.Attr<bool>("overwrite");
     auto save_as_fp16 = ctx.Attr<bool>("save_as_fp16");
     auto save_to_memory = ctx.Attr<bool>("save_to_memory");
+    auto save_aligned = ctx.Attr<bool>("save_aligned");
     auto output = ctx.Output<framework::RawTensor>("Y");
     auto inp_var_names = ctx.InputNames("X");
     auto& inp_vars = ctx.MultiInputVar("X");
@@ -216,6 +230,7 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
                                  overwrite,
                                  save_as_fp16,
                                  save_to_memory,
+                                 save_aligned,
                                  output);
     } else {
       std::vector<const phi::ExtendedTensor*> x(inp_vars.size());
@@ -18,6 +18,7 @@ limitations under the License. */
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/memory/allocation/mmap_allocator.h"
 #include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/float16.h"
 #include "paddle/phi/core/kernel_registry.h"
@@ -87,7 +88,7 @@ void CheckValues(T* expect,
 // Here, we create 4 LoDTensors and use save_combine_op to first save these
 // in a single file. Then, we use load_combine_op to load these sequentially
 template <typename T, typename U>
-void SaveLoadCombineOp() {
+void SaveLoadCombineOp(bool save_aligned = false) {
   paddle::framework::Scope scope;
   paddle::platform::CPUPlace place;
 
@@ -119,6 +120,7 @@ void SaveLoadCombineOp() {
   std::string filename = "check_tensor.ls";
   paddle::framework::AttributeMap attrs;
   attrs.insert({"file_path", std::string(filename)});
+  attrs.insert({"save_aligned", save_aligned});
 
   // Run the save_combine_op
   auto save_combine_op = paddle::framework::OpRegistry::CreateOp(
@@ -152,10 +154,46 @@ void SaveLoadCombineOp() {
   CheckValues<T, U>(expect2, actual2, expect_lod2, actual_lod2, numel2);
   CheckValues<T, U>(expect3, actual3, expect_lod3, actual_lod3, numel3);
   CheckValues<T, U>(expect4, actual4, expect_lod4, actual_lod4, numel4);
+
+#ifndef _WIN32
+  // the tensors saved in the aligned layout are mapped from the file
+  for (auto* target : {target1, target2, target3, target4}) {
+    EXPECT_EQ(save_aligned,
+              dynamic_cast<
+                  paddle::memory::allocation::FileMemoryMapSliceAllocation*>(
+                  target->Holder().get()) != nullptr);
+  }
+  if (save_aligned) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(actual3) %
+                  paddle::framework::kAlignedTensorAlignment,
+              0UL);
+  }
+#endif
 }
 
 TEST(SaveLoadCombineOp, CPU) { SaveLoadCombineOp<int, int>(); }
 
+TEST(SaveLoadCombineAlignedOp, CPU) { SaveLoadCombineOp<int, int>(true); }
+
+TEST(SaveCombineAlignedOp, RejectSaveToMemory) {
+  paddle::framework::Scope scope;
+  paddle::platform::CPUPlace place;
+  std::vector<int> lod = {0, 1, 2, 3, 10};
+  paddle::framework::LoD expect_lod;
+  CreateForSaveCombineOp<int, int>(
+      10, 10, lod, "test_var", place, &scope, &expect_lod);
+  scope.Var("out_str")->GetMutable<paddle::framework::RawTensor>();
+
+  paddle::framework::AttributeMap attrs;
+  attrs.insert({"file_path", std::string("check_aligned_memory.ls")});
+  attrs.insert({"save_to_memory", true});
+  attrs.insert({"save_aligned", true});
+  auto save_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "save_combine", {{"X", {"test_var"}}}, {{"Y", {"out_str"}}}, attrs);
+  EXPECT_THROW(save_combine_op->Run(scope, place),
+               paddle::platform::EnforceNotMet);
+}
+
 TEST(SaveLoadCombineBF16Op, CPU) {
   SaveLoadCombineOp<paddle::platform::bfloat16, paddle::platform::bfloat16>();
 }
@@ -14,15 +14,21 @@ limitations under the License. */
 
 #include "paddle/fluid/platform/device_code.h"
 
+#include <dlfcn.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <algorithm>
+#include <cstdlib>
+#include <fstream>
 #include <set>
+#include <sstream>
 #include <utility>
 
 #include "paddle/fluid/platform/enforce.h"
 
 DECLARE_string(cuda_dir);
+DECLARE_string(fusion_group_cpu_compiler);
 
 namespace paddle {
 namespace platform {
@@ -69,6 +75,14 @@ DeviceCodePool::DeviceCodePool(const std::vector<platform::Place>& places) {
                     errors::InvalidArgument(
                         "Expected the number of places >= 1. But received %d.",
                         places.size()));
+  AddPlaces(places);
+
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
+  CUDADeviceCode::CheckAvailableStatus();
+#endif
+}
+
+void DeviceCodePool::AddPlaces(const std::vector<platform::Place>& places) {
   // Remove the duplicated places
   std::set<Place> set;
   for (auto& p : places) {
@@ -83,12 +97,10 @@ DeviceCodePool::DeviceCodePool(const std::vector<platform::Place>& places) {
           "CUDAPlace or HIPPlace is not supported, please re-compile with "
           "WITH_GPU=ON or WITH_ROCM=ON."));
 #endif
+    } else if (is_cpu_place(p)) {
+      device_codes_.emplace(p, DeviceCodeMap());
     }
   }
-
-#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
-  CUDADeviceCode::CheckAvailableStatus();
-#endif
 }
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
@@ -476,5 +488,97 @@ bool CUDADeviceCode::CheckNVRTCResult(nvrtcResult result,
 }
 #endif
 
+CPUDeviceCode::CPUDeviceCode(const Place& place,
+                             const std::string& name,
+                             const std::string& kernel) {
+  if (!is_cpu_place(place)) {
+    PADDLE_THROW(platform::errors::PermissionDenied(
+        "CPUDeviceCode can only launch on CPU place."));
+  }
+
+  place_ = place;
+  name_ = name;
+  kernel_ = kernel;
+}
+
+CPUDeviceCode::~CPUDeviceCode() {
+  if (handle_ != nullptr) {
+    dlclose(handle_);
+  }
+}
+
+bool CPUDeviceCode::Compile(bool include_path) {
+  is_compiled_ = false;
+  const char* tmp_dir = std::getenv("TMPDIR");
+  std::string dir_template =
+      std::string(tmp_dir != nullptr && tmp_dir[0] != '\0' ? tmp_dir : "/tmp") +
+      "/paddle_device_code_XXXXXX";
+  std::vector<char> dir_buf(dir_template.begin(), dir_template.end());
+  dir_buf.push_back('\0');
+  if (mkdtemp(dir_buf.data()) == nullptr) {
+    LOG_FIRST_N(WARNING, 1) << "Cannot create the directory "
+                            << dir_template << " to compile CPU code.";
+    return false;
+  }
+  std::string dir = dir_buf.data();
+  std::string src_path = dir + "/" + name_ + ".cc";
+  std::string lib_path = dir + "/" + name_ + ".so";
+  std::string log_path = dir + "/" + name_ + ".log";
+  auto remove_all = [&]() {
+    for (auto& path : {src_path, lib_path, log_path}) {
+      unlink(path.c_str());
+    }
+    rmdir(dir.c_str());
+  };
+
+  {
+    std::ofstream src(src_path);
+    src << kernel_;
+  }
+  // The library is only loaded by this process, so it can be built for the
+  // instruction sets of this machine.
+  std::string command = FLAGS_fusion_group_cpu_compiler +
+                        " -std=c++11 -O3 -march=native -fno-math-errno"
+                        " -fPIC -shared -o " +
+                        lib_path + " " + src_path + " > " + log_path +
+                        " 2>&1";
+  if (std::system(command.c_str()) != 0) {
+    std::ifstream log(log_path);
+    std::stringstream log_str;
+    log_str << log.rdbuf();
+    LOG(WARNING) << "JIT compiling of CPU code failed:"
+                 << "\n  Kernel name: " << name_ << "\n  Kernel body:\n"
+                 << kernel_ << "\n  Compiling log: " << log_str.str();
+    remove_all();
+    return false;
+  }
+
+  // The library stays mapped after its file is removed.
+  handle_ = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  remove_all();
+  if (handle_ == nullptr) {
+    LOG_FIRST_N(WARNING, 1) << "Call dlopen for < " << name_
+                            << " > failed: " << dlerror();
+    return false;
+  }
+  function_ = reinterpret_cast<KernelFunc>(dlsym(handle_, name_.c_str()));
+  if (function_ == nullptr) {
+    LOG_FIRST_N(WARNING, 1) << "Call dlsym for < " << name_
+                            << " > failed: " << dlerror();
+    return false;
+  }
+  is_compiled_ = true;
+  return true;
+}
+
+void CPUDeviceCode::Launch(const size_t n, std::vector<void*>* args) const {
+  PADDLE_ENFORCE_EQ(
+      is_compiled_,
+      true,
+      errors::PreconditionNotMet(
+          "Please compile the code before launching the kernel."));
+  function_(args->data());
+}
+
 }  // namespace platform
 }  // namespace paddle
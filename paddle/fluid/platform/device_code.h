@@ -89,6 +89,28 @@ class CUDADeviceCode : public DeviceCode {
 };
 #endif
 
+// The C++ code of a kernel compiled by the compiler set by
+// FLAGS_fusion_group_cpu_compiler into a shared library, which is loaded
+// with dlopen. The kernel is an extern "C" function of the same name taking
+// an array of pointers to its arguments, the same ones in the same order as
+// those of a CUDA kernel.
+class CPUDeviceCode : public DeviceCode {
+ public:
+  explicit CPUDeviceCode(const Place& place,
+                         const std::string& name,
+                         const std::string& kernel);
+  ~CPUDeviceCode() override;
+  bool Compile(bool include_path = false) override;
+  void Launch(const size_t n, std::vector<void*>* args) const override;
+
+ private:
+  using KernelFunc = void (*)(void**);
+
+  bool is_compiled_{false};
+  void* handle_{nullptr};
+  KernelFunc function_{nullptr};
+};
+
 class DeviceCodePool {
  public:
   using DeviceCodeMap =
@@ -107,6 +129,8 @@ class DeviceCodePool {
   static DeviceCodePool& Init(const std::vector<platform::Place>& places) {
     if (pool == nullptr) {
       pool = new DeviceCodePool(places);
+    } else {
+      pool->AddPlaces(places);
     }
     return *pool;
   }
@@ -125,6 +149,8 @@ class DeviceCodePool {
   }
 
  private:
+  void AddPlaces(const std::vector<platform::Place>& places);
+
   static DeviceCodePool* pool;
   std::map<Place, DeviceCodeMap> device_codes_;
   DISABLE_COPY_AND_ASSIGN(DeviceCodePool);
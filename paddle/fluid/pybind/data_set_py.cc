@@ -287,6 +287,12 @@ void BindDataset(py::module *m) {
       .def("global_shuffle",
            &framework::Dataset::GlobalShuffle,
            py::call_guard<py::gil_scoped_release>())
+      .def("external_global_shuffle",
+           &framework::Dataset::ExternalGlobalShuffle,
+           py::call_guard<py::gil_scoped_release>())
+      .def("pre_external_global_shuffle",
+           &framework::Dataset::PreExternalGlobalShuffle,
+           py::call_guard<py::gil_scoped_release>())
       .def("get_memory_data_size",
            &framework::Dataset::GetMemoryDataSize,
            py::call_guard<py::gil_scoped_release>())
@@ -380,6 +386,9 @@ void BindDataset(py::module *m) {
            py::call_guard<py::gil_scoped_release>())
       .def("dump_walk_path",
            &framework::Dataset::DumpWalkPath,
+           py::call_guard<py::gil_scoped_release>())
+      .def("convert_to_binary",
+           &framework::Dataset::ConvertToBinary,
            py::call_guard<py::gil_scoped_release>());
 
   py::class_<IterableDatasetWrapper>(*m, "IterableDatasetWrapper")
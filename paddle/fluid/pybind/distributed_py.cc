@@ -1320,7 +1320,31 @@ void BindDistributed(py::module *m) {
                   py::arg("group_id") = 0,
                   py::call_guard<py::gil_scoped_release>())
       .def_static("create_default_device",
-                  &ProcessGroupGloo::createDefaultDevice);
+                  &ProcessGroupGloo::createDefaultDevice)
+      .def(
+          "all_reduce_coalesced",
+          [](ProcessGroupGloo &self,
+             py::handle py_tensor_list,
+             distributed::ReduceOp op,
+             int64_t bucket_size,
+             bool sync_op) {
+            auto tensor_list =
+                CastPyArg2VectorOfTensor(py_tensor_list.ptr(), 0);
+            std::vector<phi::DenseTensor> dense_tensors;
+            dense_tensors.reserve(tensor_list.size());
+            for (auto &tensor : tensor_list) {
+              dense_tensors.emplace_back(
+                  *std::dynamic_pointer_cast<phi::DenseTensor>(tensor.impl()));
+            }
+            distributed::AllreduceOptions opts{op};
+            return self.AllReduceCoalesced(
+                dense_tensors, opts, bucket_size, sync_op);
+          },
+          py::arg("tensors"),
+          py::arg("op") = distributed::ReduceOp::SUM,
+          py::arg("bucket_size") = 25 * 1024 * 1024,
+          py::arg("sync_op") = true,
+          py::call_guard<py::gil_scoped_release>());
 #endif
 
   m->def(
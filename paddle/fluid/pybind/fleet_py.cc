@@ -222,6 +222,8 @@ void BindGraphPyServer(py::module* m) {
       .def(py::init<>())
       .def("start_server", &GraphPyServer::start_server)
       .def("set_up", &GraphPyServer::set_up)
+      .def("set_build_csr", &GraphPyServer::set_build_csr)
+      .def("set_sample_type", &GraphPyServer::set_sample_type)
       .def("add_table_feat_conf", &GraphPyServer::add_table_feat_conf);
 }
 void BindGraphPyClient(py::module* m) {
@@ -229,6 +231,8 @@ void BindGraphPyClient(py::module* m) {
       .def(py::init<>())
       .def("load_edge_file", &GraphPyClient::load_edge_file)
       .def("load_node_file", &GraphPyClient::load_node_file)
+      .def("save_csr", &GraphPyClient::save_csr)
+      .def("load_csr", &GraphPyClient::load_csr)
       .def("set_up", &GraphPyClient::set_up)
       .def("add_table_feat_conf", &GraphPyClient::add_table_feat_conf)
       .def("pull_graph_list", &GraphPyClient::pull_graph_list)
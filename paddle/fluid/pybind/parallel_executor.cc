@@ -850,7 +850,9 @@ void BindParallelExecutor(pybind11::module &m) {  // NOLINT
           R"DOC((bool, optional): Whether to enable fusing subgraph to a
                 fusion_group. Now we only support fusing subgraph that composed
                 of elementwise-like operators, such as elementwise_add/mul
-                without broadcast and activations.
+                without broadcast and activations. On CPU, the code of the
+                fused subgraphs is compiled by the compiler set by
+                FLAGS_fusion_group_cpu_compiler, c++ by default.
 
                 Examples:
                     .. code-block:: python
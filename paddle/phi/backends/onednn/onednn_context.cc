@@ -14,19 +14,75 @@
 #ifdef PADDLE_WITH_MKLDNN
 #include "paddle/phi/backends/onednn/onednn_context.h"
 
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include <xxhash.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <set>
+
 #include "paddle/phi/common/place.h"
 #include "paddle/phi/core/enforce.h"
 #include "paddle/utils/flat_hash_map.h"
 
 #include "paddle/phi/backends/context_pool.h"
 #include "paddle/phi/core/expect.h"
+#include "paddle/phi/core/flags.h"
 
 #include "glog/logging.h"
 
+PADDLE_DEFINE_EXPORTED_int32(
+    onednn_primitive_cache_capacity,
+    1024,
+    "The number of oneDNN primitives cached for all the threads by the "
+    "descriptors they are created from. 0 to disable the cache.");
+
+PADDLE_DEFINE_EXPORTED_string(
+    onednn_primitive_cache_warmup_file,
+    "",
+    "The file saved by OneDNNPrimitiveCache::SaveRecords, whose primitives "
+    "are created when the oneDNN context is created. Empty to disable the "
+    "warmup.");
+
+PADDLE_DEFINE_EXPORTED_string(
+    onednn_primitive_cache_save_file,
+    "",
+    "The file to save the records of the oneDNN primitive cache to when the "
+    "process exits, which later processes can replay with "
+    "onednn_primitive_cache_warmup_file. Empty to not save them.");
+
 namespace phi {
 
+namespace {
+
+const dnnl::engine& GetSharedCPUEngine() {
+  static dnnl::engine engine(dnnl::engine::kind::cpu, 0);
+  return engine;
+}
+
+int CurrentProcessId() {
+#ifdef _WIN32
+  return _getpid();
+#else
+  return getpid();
+#endif
+}
+
+constexpr uint64_t kRecordFileMagic = 0x3143455250444e4fULL;  // ONDPREC1
+constexpr uint64_t kRecordFileVersion = 1;
+// Far larger than any op descriptor of oneDNN
+constexpr uint64_t kMaxRecordSize = 1 << 16;
+
+}  // namespace
+
 OneDNNContextThreadLocals::Body::Body()
-    : cur_engine(dnnl::engine::kind::cpu, 0), cur_stream(cur_engine) {
+    : cur_engine(GetSharedCPUEngine()), cur_stream(cur_engine) {
   cur_mkldnn_session_id = kMKLDNNSessionID_Default;
   cur_input_shape_str = "";
   cur_input_shape_cache_capacity = 1;
@@ -83,6 +139,165 @@ void OneDNNContextThreadLocals::Body::log_lib_version(void) {
   }
 }
 
+OneDNNPrimitiveCache& OneDNNPrimitiveCache::Instance() {
+  static OneDNNPrimitiveCache cache;
+  return cache;
+}
+
+bool OneDNNPrimitiveCache::Enabled() const {
+  return FLAGS_onednn_primitive_cache_capacity > 0;
+}
+
+OneDNNPrimitiveCache::~OneDNNPrimitiveCache() {
+  if (!FLAGS_onednn_primitive_cache_save_file.empty()) {
+    SaveRecords(FLAGS_onednn_primitive_cache_save_file);
+  }
+}
+
+std::shared_ptr<void> OneDNNPrimitiveCache::Get(const void* record,
+                                                size_t size) {
+  uint64_t key = XXH64(record, size, 0);
+  AutoRDLock lock(&lock_);
+  auto it = entries_.find(key);
+  // A record differing only in the padding bytes just misses the cache
+  if (it == entries_.end() || it->second->record.size() != size ||
+      memcmp(it->second->record.data(), record, size) != 0) {
+    return nullptr;
+  }
+  it->second->last_use.store(++tick_, std::memory_order_relaxed);
+  return it->second->data;
+}
+
+void OneDNNPrimitiveCache::Set(const void* record,
+                               size_t size,
+                               std::shared_ptr<void> data) {
+  uint64_t key = XXH64(record, size, 0);
+  std::unique_ptr<Entry> entry(new Entry());
+  entry->record.assign(static_cast<const char*>(record), size);
+  entry->data = std::move(data);
+  entry->last_use = ++tick_;
+  AutoWRLock lock(&lock_);
+  entries_[key] = std::move(entry);
+  size_t capacity = std::max(FLAGS_onednn_primitive_cache_capacity, 0);
+  while (entries_.size() > capacity) {
+    auto lru = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->second->last_use.load(std::memory_order_relaxed) <
+          lru->second->last_use.load(std::memory_order_relaxed)) {
+        lru = it;
+      }
+    }
+    VLOG(4) << "Evict the oneDNN primitive of key " << lru->first;
+    entries_.erase(lru);
+  }
+}
+
+size_t OneDNNPrimitiveCache::Size() const {
+  AutoRDLock lock(&lock_);
+  return entries_.size();
+}
+
+void OneDNNPrimitiveCache::Clear() {
+  AutoWRLock lock(&lock_);
+  entries_.clear();
+  replayed_records_.clear();
+}
+
+bool OneDNNPrimitiveCache::SaveRecords(const std::string& path) const {
+  std::set<std::string> records;
+  {
+    AutoRDLock lock(&lock_);
+    for (auto& pair : entries_) {
+      records.insert(pair.second->record);
+    }
+    records.insert(replayed_records_.begin(), replayed_records_.end());
+  }
+
+  std::string tmp_path = path + ".tmp" + std::to_string(CurrentProcessId());
+  FILE* fp = fopen(tmp_path.c_str(), "wb");
+  if (fp == nullptr) {
+    LOG(WARNING) << "Failed to open " << tmp_path
+                 << " to save the oneDNN primitive records.";
+    return false;
+  }
+  auto write = [fp](const void* data, size_t size) {
+    return fwrite(data, 1, size, fp) == size;
+  };
+  uint64_t header[] = {kRecordFileMagic, kRecordFileVersion, records.size()};
+  bool ok = write(header, sizeof(header));
+  for (auto& record : records) {
+    uint64_t size = record.size();
+    ok = ok && write(&size, sizeof(size)) && write(record.data(), size);
+  }
+  ok = fclose(fp) == 0 && ok;
+  // renamed in the end so that a process never replays a partial file
+  if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Failed to save the oneDNN primitive records to " << path;
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  VLOG(3) << "Save " << records.size() << " oneDNN primitive records to "
+          << path;
+  return true;
+}
+
+size_t OneDNNPrimitiveCache::Warmup(const std::string& path,
+                                    const dnnl::engine& engine) {
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (fp == nullptr) {
+    LOG(WARNING) << "Failed to open the oneDNN primitive records " << path;
+    return 0;
+  }
+  auto read = [fp](void* data, size_t size) {
+    return fread(data, 1, size, fp) == size;
+  };
+  uint64_t header[3];
+  if (!read(header, sizeof(header)) || header[0] != kRecordFileMagic ||
+      header[1] != kRecordFileVersion) {
+    fclose(fp);
+    LOG(WARNING) << path << " is not a file of oneDNN primitive records.";
+    return 0;
+  }
+
+  std::vector<std::string> records;
+  size_t num_created = 0;
+  for (uint64_t i = 0; i < header[2]; ++i) {
+    uint64_t size = 0;
+    if (!read(&size, sizeof(size)) || size < sizeof(dnnl_primitive_kind_t) ||
+        size > kMaxRecordSize) {
+      LOG(WARNING) << "oneDNN primitive records " << path << " is corrupted.";
+      break;
+    }
+    std::string record(size, '\0');
+    if (!read(&record[0], size)) {
+      LOG(WARNING) << "oneDNN primitive records " << path << " is corrupted.";
+      break;
+    }
+    // The primitives are not kept, as the typed primitive descriptors of the
+    // kernels are unknown here, but creating them generates their code into
+    // the primitive cache of oneDNN, which the kernels hit afterwards.
+    dnnl_primitive_desc_t pd = nullptr;
+    if (dnnl_primitive_desc_create(
+            &pd, record.data(), nullptr, engine.get(), nullptr) !=
+        dnnl_success) {
+      VLOG(3) << "Skip the oneDNN primitive record " << i << " of " << path;
+      continue;
+    }
+    dnnl_primitive_t primitive = nullptr;
+    if (dnnl_primitive_create(&primitive, pd) == dnnl_success) {
+      dnnl_primitive_destroy(primitive);
+      ++num_created;
+    }
+    dnnl_primitive_desc_destroy(pd);
+    records.emplace_back(std::move(record));
+  }
+  fclose(fp);
+
+  AutoWRLock lock(&lock_);
+  replayed_records_ = std::move(records);
+  return num_created;
+}
+
 struct OneDNNContext::Impl {
   Impl() : p_blobmap_() {
     p_blobmap_.reset(new BlobMap());
@@ -102,6 +317,8 @@ struct OneDNNContext::Impl {
       // objects allocated when using given executor
       if (ptr == nullptr) {
         p_blobmap_->clear();
+        shape_lru_.clear();
+        shape_lru_index_.clear();
       } else {
         // Iterate through all shapes and release
         // for each shape and active executor all entries
@@ -150,8 +367,20 @@ struct OneDNNContext::Impl {
             << "\n";
   }
 
-  void RemoveShapeEntriesWithExecutor() const {
-    p_exec_items_->erase(p_exec_items_->begin());
+  void RemoveShapeEntriesWithExecutor(const std::string& shape) const {
+    p_exec_items_->erase(shape);
+  }
+
+  // Mark the shape as the most recently used one of the cache clearing
+  // session
+  void TouchShape(const std::string& shape) const {
+    auto it = shape_lru_index_.find(shape);
+    if (it != shape_lru_index_.end()) {
+      shape_lru_.splice(shape_lru_.begin(), shape_lru_, it->second);
+    } else {
+      shape_lru_.push_front(shape);
+      shape_lru_index_[shape] = shape_lru_.begin();
+    }
   }
 
   void BlockNextCacheClearing() {
@@ -197,26 +426,36 @@ struct OneDNNContext::Impl {
 
     // Find KeyBlob for current input shape
     auto key_it = sBlob->find(OneDNNContext::tls().cur_input_shape_str);
+    bool cache_clearing =
+        static_cast<size_t>(sid) ==
+        OneDNNContextThreadLocals::kMKLDNNSessionID_CacheClearing;
 
     if (key_it == sBlob->end()) {
       // In cache clearing mode, cur_input_shape_cache_capacity defines
-      // max pblob capacity
-      if ((static_cast<size_t>(sid) ==
-           OneDNNContextThreadLocals::kMKLDNNSessionID_CacheClearing) &&
-          sBlob->size() &&
+      // max pblob capacity, and the least recently used shape is removed
+      if (cache_clearing && sBlob->size() &&
           (sBlob->size() >=
            static_cast<size_t>(
                OneDNNContext::tls().cur_input_shape_cache_capacity))) {
-        VLOG(2) << "sid=" << sid
-                << ", remove all blobs of shape: " << sBlob->begin()->first;
-        sBlob->erase(sBlob->begin()->first);
-        RemoveShapeEntriesWithExecutor();
+        std::string shape = shape_lru_.empty() ? sBlob->begin()->first
+                                               : shape_lru_.back();
+        VLOG(2) << "sid=" << sid << ", remove all blobs of shape: " << shape;
+        sBlob->erase(shape);
+        RemoveShapeEntriesWithExecutor(shape);
+        auto lru_it = shape_lru_index_.find(shape);
+        if (lru_it != shape_lru_index_.end()) {
+          shape_lru_.erase(lru_it->second);
+          shape_lru_index_.erase(lru_it);
+        }
       }
       pBlob = std::make_shared<KeyBlob>();
       (*sBlob)[OneDNNContext::tls().cur_input_shape_str] = pBlob;
     } else {
       pBlob = key_it->second;
     }
+    if (cache_clearing) {
+      TouchShape(OneDNNContext::tls().cur_input_shape_str);
+    }
 
     // Find Blob via name
     auto blob_it = pBlob->find(name);
@@ -272,6 +511,10 @@ struct OneDNNContext::Impl {
       return nullptr;
     }
     pBlob = sBlob_it->second;
+    if (static_cast<size_t>(sid) ==
+        OneDNNContextThreadLocals::kMKLDNNSessionID_CacheClearing) {
+      TouchShape(sBlob_it->first);
+    }
 
     // Find Blob via name
     auto key_it = pBlob->find(name);
@@ -358,6 +601,11 @@ struct OneDNNContext::Impl {
   std::shared_ptr<std::mutex> p_mutex_;
   // 0 - clearing is allowed. x > 0 do not clear.
   unsigned int block_next_cache_clearing_ = 0;
+  // Shapes of the cache clearing session, from the most recently used one
+  // to the least one, so that the least recently used one is removed first
+  mutable std::list<std::string> shape_lru_;
+  mutable std::unordered_map<std::string, std::list<std::string>::iterator>
+      shape_lru_index_;
 
   // Holds some attributes only used by the onednn kernel calculation
   // Since original mkldnn op kernel directly adds the operations that require
@@ -388,7 +636,14 @@ thread_local TensorNameMap OneDNNContext::Impl::inputs_name_ = {};
 thread_local TensorNameMap OneDNNContext::Impl::outputs_name_ = {};
 
 OneDNNContext::OneDNNContext(const Place& place)
-    : CPUContext(place), impl_(std::make_unique<Impl>()) {}
+    : CPUContext(place), impl_(std::make_unique<Impl>()) {
+  if (!FLAGS_onednn_primitive_cache_warmup_file.empty()) {
+    size_t num = OneDNNPrimitiveCache::Instance().Warmup(
+        FLAGS_onednn_primitive_cache_warmup_file, GetEngine());
+    VLOG(3) << "Create " << num << " oneDNN primitives from "
+            << FLAGS_onednn_primitive_cache_warmup_file;
+  }
+}
 
 OneDNNContext::~OneDNNContext() = default;
 
@@ -14,13 +14,19 @@ limitations under the License. */
 
 #pragma once
 #ifdef PADDLE_WITH_MKLDNN
+#include <atomic>
 #include <memory>
-#include <mutex>     // NOLINT
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "dnnl.hpp"  // NOLINT
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/common/layout.h"
 #include "paddle/phi/common/place.h"
 #include "paddle/phi/core/attribute.h"
+#include "paddle/phi/core/utils/rw_lock.h"
 
 namespace phi {
 
@@ -43,8 +49,10 @@ class OneDNNContextThreadLocals {
     // Recently registered data_format. This is needed to
     // know for converting MKL-DNN Tensor to non MKL-DNN
     DataLayout cur_paddle_data_layout;
-    // MKL-DNN stream used for execution of primitives (per-thread)
+    // MKL-DNN engine shared by all the threads, so that the primitives
+    // created by one thread can be executed in the stream of another one
     dnnl::engine cur_engine;
+    // MKL-DNN stream used for execution of primitives (per-thread)
     dnnl::stream cur_stream;
     std::string key_suffix;  // Key identifying current Executor
     bool key_attach_thread_id = true;
@@ -82,6 +90,65 @@ class OneDNNContextThreadLocals {
   }
 };
 
+// A cache of the oneDNN primitives shared by all the threads. Every entry is
+// keyed by the 64-bit hash of the binary record it is created from, i.e. the
+// op descriptor of oneDNN that holds the shapes and formats of the memories,
+// and the least recently used entry is evicted when the cache holds
+// FLAGS_onednn_primitive_cache_capacity entries. Lookups only take a read
+// lock and stamp the entry with a use tick, so the threads running the
+// cached primitives do not serialize on the cache; an insertion takes the
+// write lock and scans the entries for the least recently used one.
+//
+// The records of the cached primitives can be saved to a file, also at exit
+// (see FLAGS_onednn_primitive_cache_save_file), and replayed by a later
+// process (see FLAGS_onednn_primitive_cache_warmup_file) to create the
+// primitives, and so generate their code, before the first run.
+class OneDNNPrimitiveCache {
+ public:
+  static OneDNNPrimitiveCache& Instance();
+
+  // Whether the capacity of the cache is positive.
+  bool Enabled() const;
+
+  // Find the entry created from the record of size bytes. Return nullptr if
+  // not found.
+  std::shared_ptr<void> Get(const void* record, size_t size);
+
+  // Set the entry created from the record of size bytes, which is the most
+  // recently used one afterwards.
+  void Set(const void* record, size_t size, std::shared_ptr<void> data);
+
+  // Number of the cached entries.
+  size_t Size() const;
+
+  void Clear();
+
+  // Save the records of the cached and the replayed entries to path. Return
+  // false on failure.
+  bool SaveRecords(const std::string& path) const;
+
+  // Create the primitives of the forward op descriptors saved to path on
+  // engine. Return the number of created primitives.
+  size_t Warmup(const std::string& path, const dnnl::engine& engine);
+
+ private:
+  OneDNNPrimitiveCache() = default;
+  // Saves the records to FLAGS_onednn_primitive_cache_save_file if set.
+  ~OneDNNPrimitiveCache();
+
+  struct Entry {
+    std::string record;
+    std::shared_ptr<void> data;
+    // the tick of the last Get or Set of the entry
+    std::atomic<uint64_t> last_use{0};
+  };
+
+  mutable RWLock lock_;
+  std::unordered_map<uint64_t, std::unique_ptr<Entry>> entries_;
+  std::atomic<uint64_t> tick_{0};
+  std::vector<std::string> replayed_records_;
+};
+
 class OneDNNContext : public CPUContext {
  public:
   template <class T>
@@ -15,6 +15,7 @@ limitations under the License. */
 
 #include <algorithm>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <set>
 #include <sstream>
 #include <string>
@@ -506,6 +507,16 @@ class OneDNNHandlerT {
   std::shared_ptr<typename TBackward_params::primitive_desc> bwd_w_pd_;
 };
 
+// The forward primitive descriptor and primitive shared by the threads through
+// OneDNNPrimitiveCache. The primitive is created by the first thread
+// acquiring it.
+template <typename TForward>
+struct OneDNNSharedForwardPrimitive {
+  std::shared_ptr<typename TForward::primitive_desc> pd;
+  std::once_flag primitive_created;
+  std::shared_ptr<TForward> primitive;
+};
+
 template <typename T,
           typename TForward,
           typename TBackward = onednn_dummy_primitive,
@@ -518,6 +529,13 @@ class OneDNNHandlerNoCachingT {
   }
 
   std::shared_ptr<TForward> AcquireForwardPrimitive() {
+    if (shared_fwd_ != nullptr && shared_fwd_->pd == fwd_pd_) {
+      auto* shared = shared_fwd_.get();
+      std::call_once(shared->primitive_created, [shared] {
+        shared->primitive = std::make_shared<TForward>(*shared->pd);
+      });
+      return shared->primitive;
+    }
     return std::make_shared<TForward>(*fwd_pd_);
   }
 
@@ -609,18 +627,37 @@ class OneDNNHandlerNoCachingT {
                                        dnnl::primitive_attr>::value>::type
   CreateForwardPrimitiveDescriptor(First&& first, Args&&... args) {
     auto fwd_desc = typename TForward::desc(std::forward<Args>(args)...);
+    shared_fwd_ = nullptr;
     fwd_pd_ = std::make_shared<typename TForward::primitive_desc>(
         fwd_desc, first, engine_);
   }
 
+  // Without attributes, the op descriptor alone decides the primitive, so
+  // the primitive is shared by the threads through OneDNNPrimitiveCache,
+  // keyed by the binary op descriptor instead of a string key.
   template <class First, class... Args>
   typename std::enable_if<!std::is_same<typename std::decay<First>::type,
                                         dnnl::primitive_attr>::value>::type
   CreateForwardPrimitiveDescriptor(First&& first, Args&&... args) {
     auto fwd_desc = typename TForward::desc(std::forward<First>(first),
                                             std::forward<Args>(args)...);
-    fwd_pd_ =
-        std::make_shared<typename TForward::primitive_desc>(fwd_desc, engine_);
+    auto& cache = OneDNNPrimitiveCache::Instance();
+    if (!cache.Enabled()) {
+      shared_fwd_ = nullptr;
+      fwd_pd_ = std::make_shared<typename TForward::primitive_desc>(fwd_desc,
+                                                                    engine_);
+      return;
+    }
+    shared_fwd_ =
+        std::static_pointer_cast<OneDNNSharedForwardPrimitive<TForward>>(
+            cache.Get(&fwd_desc.data, sizeof(fwd_desc.data)));
+    if (shared_fwd_ == nullptr) {
+      shared_fwd_ = std::make_shared<OneDNNSharedForwardPrimitive<TForward>>();
+      shared_fwd_->pd = std::make_shared<typename TForward::primitive_desc>(
+          fwd_desc, engine_);
+      cache.Set(&fwd_desc.data, sizeof(fwd_desc.data), shared_fwd_);
+    }
+    fwd_pd_ = shared_fwd_->pd;
   }
 
   template <typename... Args>
@@ -706,6 +743,7 @@ class OneDNNHandlerNoCachingT {
   std::shared_ptr<typename TForward::primitive_desc> fwd_pd_;
   std::shared_ptr<typename TBackward::primitive_desc> bwd_pd_;
   std::shared_ptr<typename TBackward_params::primitive_desc> bwd_w_pd_;
+  std::shared_ptr<OneDNNSharedForwardPrimitive<TForward>> shared_fwd_;
 };
 
 template <typename T>
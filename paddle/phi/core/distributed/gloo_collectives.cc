@@ -0,0 +1,143 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/core/distributed/gloo_collectives.h"
+
+#include <gloo/transport/unbound_buffer.h>
+#include <gloo/types.h>
+
+#include <cstring>
+
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/errors.h"
+
+namespace phi {
+namespace distributed {
+
+namespace {
+// slot prefixes after the ones used by gloo and gloo_send_recv.h
+constexpr uint8_t kReduceScatterSlotPrefix = 0x09;
+constexpr uint8_t kAllToAllSlotPrefix = 0x0a;
+}  // namespace
+
+void GlooReduceScatter(const std::shared_ptr<gloo::Context>& context,
+                       const void* in,
+                       void* out,
+                       size_t count,
+                       size_t elem_size,
+                       GlooReduceFunc fn,
+                       uint32_t tag) {
+  const int rank = context->rank;
+  const int size = context->size;
+  const size_t block_bytes = count * elem_size;
+  if (size == 1 || block_bytes == 0) {
+    std::memcpy(out, in, block_bytes);
+    return;
+  }
+
+  // The blocks are reduced in a copy of in, the block b of this rank is sent
+  // to the right at step s when b == rank - s - 1, so the last step receives
+  // the partial sums of the block rank from all the other ranks.
+  std::vector<char> work(block_bytes * size);
+  std::memcpy(work.data(), in, work.size());
+  std::vector<char> recv_block(block_bytes);
+  auto send_buf = context->createUnboundBuffer(work.data(), work.size());
+  auto recv_buf =
+      context->createUnboundBuffer(recv_block.data(), recv_block.size());
+  const int right = (rank + 1) % size;
+  const int left = (rank + size - 1) % size;
+  const auto slot = gloo::Slot::build(kReduceScatterSlotPrefix, tag);
+  const auto timeout = context->getTimeout();
+  for (int step = 0; step < size - 1; ++step) {
+    int send_block = ((rank - step - 1) % size + size) % size;
+    int recv_block_id = ((rank - step - 2) % size + size) % size;
+    recv_buf->recv(left, slot, 0, block_bytes);
+    send_buf->send(right, slot, send_block * block_bytes, block_bytes);
+    recv_buf->waitRecv(timeout);
+    char* dst = work.data() + recv_block_id * block_bytes;
+    fn(dst, dst, recv_block.data(), count);
+    send_buf->waitSend(timeout);
+  }
+  std::memcpy(out, work.data() + rank * block_bytes, block_bytes);
+}
+
+void GlooAllToAll(const std::shared_ptr<gloo::Context>& context,
+                  const void* in,
+                  void* out,
+                  const std::vector<size_t>& in_bytes,
+                  const std::vector<size_t>& out_bytes,
+                  uint32_t tag) {
+  const int rank = context->rank;
+  const int size = context->size;
+  PADDLE_ENFORCE_EQ(
+      in_bytes.size() == static_cast<size_t>(size) &&
+          out_bytes.size() == static_cast<size_t>(size),
+      true,
+      phi::errors::InvalidArgument(
+          "The number of blocks of all_to_all should be equal to the world "
+          "size %d.",
+          size));
+  PADDLE_ENFORCE_EQ(in_bytes[rank],
+                    out_bytes[rank],
+                    phi::errors::InvalidArgument(
+                        "The block of all_to_all sent to the rank itself has "
+                        "%d bytes, but %d bytes are expected.",
+                        in_bytes[rank],
+                        out_bytes[rank]));
+
+  std::vector<size_t> in_offsets(size, 0), out_offsets(size, 0);
+  for (int i = 1; i < size; ++i) {
+    in_offsets[i] = in_offsets[i - 1] + in_bytes[i - 1];
+    out_offsets[i] = out_offsets[i - 1] + out_bytes[i - 1];
+  }
+  size_t in_total = in_offsets[size - 1] + in_bytes[size - 1];
+  size_t out_total = out_offsets[size - 1] + out_bytes[size - 1];
+
+  std::memcpy(static_cast<char*>(out) + out_offsets[rank],
+              static_cast<const char*>(in) + in_offsets[rank],
+              in_bytes[rank]);
+  if (size == 1) {
+    return;
+  }
+  // gloo only support mutable data input
+  auto send_buf =
+      context->createUnboundBuffer(const_cast<void*>(in), in_total);
+  auto recv_buf = context->createUnboundBuffer(out, out_total);
+  const auto slot = gloo::Slot::build(kAllToAllSlotPrefix, tag);
+  const auto timeout = context->getTimeout();
+  int num_recv = 0, num_send = 0;
+  for (int i = 1; i < size; ++i) {
+    int src = (rank + size - i) % size;
+    if (out_bytes[src] > 0) {
+      recv_buf->recv(src, slot, out_offsets[src], out_bytes[src]);
+      ++num_recv;
+    }
+  }
+  for (int i = 1; i < size; ++i) {
+    int dst = (rank + i) % size;
+    if (in_bytes[dst] > 0) {
+      send_buf->send(dst, slot, in_offsets[dst], in_bytes[dst]);
+      ++num_send;
+    }
+  }
+  for (int i = 0; i < num_recv; ++i) {
+    recv_buf->waitRecv(timeout);
+  }
+  for (int i = 0; i < num_send; ++i) {
+    send_buf->waitSend(timeout);
+  }
+}
+
+}  // namespace distributed
+}  // namespace phi
@@ -0,0 +1,52 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <gloo/context.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace phi {
+namespace distributed {
+
+// Collectives not provided by gloo, implemented with the unbound buffers of
+// the full mesh context like the gloo algorithms.
+
+using GlooReduceFunc = void (*)(void*, const void*, const void*, size_t);
+
+// Ring reduce-scatter, in holds size * count elements of elem_size bytes and
+// rank i gets the reduced i-th block of count elements in out. Each rank
+// sends and receives (size - 1) * count elements, half of an allreduce.
+void GlooReduceScatter(const std::shared_ptr<gloo::Context>& context,
+                       const void* in,
+                       void* out,
+                       size_t count,
+                       size_t elem_size,
+                       GlooReduceFunc fn,
+                       uint32_t tag);
+
+// Pairwise all-to-all, the i-th block of in of in_bytes[i] bytes is sent to
+// rank i and the block from rank i is written to the i-th block of out of
+// out_bytes[i] bytes. All the transfers are in flight at the same time.
+void GlooAllToAll(const std::shared_ptr<gloo::Context>& context,
+                  const void* in,
+                  void* out,
+                  const std::vector<size_t>& in_bytes,
+                  const std::vector<size_t>& out_bytes,
+                  uint32_t tag);
+
+}  // namespace distributed
+}  // namespace phi
@@ -94,5 +94,27 @@ void GlooCommContext::Reduce(phi::DenseTensor* out_tensor,
   gloo::reduce(opts);
 }
 
+void GlooCommContext::ReduceScatter(phi::DenseTensor* out_tensor,
+                                    const phi::DenseTensor& in_tensor,
+                                    int reduce_type) {
+  // gloo only uses CPU now
+  CommStaticCheck::ScatterLikeShape(*out_tensor,
+                                    in_tensor,
+                                    /*dst_rank*/ rank_,
+                                    /*cur_rank*/ rank_,
+                                    size_,
+                                    phi::AllocationType::CPU);
+  const auto& dtype = in_tensor.dtype();
+  GlooReduceFunc fn;
+  GENERATE_FUNC(dtype, GetReduceFunc, reduce_type, &fn);
+  GlooReduceScatter(gloo_context_,
+                    in_tensor.data(),
+                    out_tensor->data(),
+                    out_tensor->numel(),
+                    phi::SizeOf(dtype),
+                    fn,
+                    /*tag*/ 0);
+}
+
 }  // namespace distributed
 }  // namespace phi
@@ -47,6 +47,10 @@ class GlooCommContext final : public CommContext {
   void AllGather(phi::DenseTensor* out_tensor,
                  const phi::DenseTensor& in_tensor);
 
+  void ReduceScatter(phi::DenseTensor* out_tensor,
+                     const phi::DenseTensor& in_tensor,
+                     int reduce_type);
+
  private:
   DISABLE_COPY_AND_ASSIGN(GlooCommContext);
 
@@ -26,6 +26,7 @@
 
 #include "paddle/phi/common/data_type.h"
 #include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/distributed/gloo_collectives.h"
 #include "paddle/phi/core/distributed/reduce_helper.h"
 
 namespace phi {
@@ -103,29 +104,20 @@ void SetInput(P* opts, const phi::DenseTensor& tensor) {
                  tensor.numel());
 }
 
-template <typename T, typename P>
-void SetReduceFunc(P* opts, int reduce_type) {
-  // gloo only support mutable data input
+template <typename T>
+void GetReduceFunc(int reduce_type, GlooReduceFunc* fn) {
   switch (reduce_type) {
     case kRedSum:
-      opts->setReduceFunction(
-          static_cast<void (*)(void*, const void*, const void*, size_t)>(
-              &gloo::sum<T>));
+      *fn = static_cast<GlooReduceFunc>(&gloo::sum<T>);
       break;
     case kRedMax:
-      opts->setReduceFunction(
-          static_cast<void (*)(void*, const void*, const void*, size_t)>(
-              &gloo::max<T>));
+      *fn = static_cast<GlooReduceFunc>(&gloo::max<T>);
       break;
     case kRedMin:
-      opts->setReduceFunction(
-          static_cast<void (*)(void*, const void*, const void*, size_t)>(
-              &gloo::min<T>));
+      *fn = static_cast<GlooReduceFunc>(&gloo::min<T>);
       break;
     case kRedProd:
-      opts->setReduceFunction(
-          static_cast<void (*)(void*, const void*, const void*, size_t)>(
-              &gloo::product<T>));
+      *fn = static_cast<GlooReduceFunc>(&gloo::product<T>);
       break;
     default:
       PADDLE_THROW(
@@ -133,6 +125,13 @@ void SetReduceFunc(P* opts, int reduce_type) {
   }
 }
 
+template <typename T, typename P>
+void SetReduceFunc(P* opts, int reduce_type) {
+  GlooReduceFunc fn;
+  GetReduceFunc<T>(reduce_type, &fn);
+  opts->setReduceFunction(fn);
+}
+
 // env preparation
 std::shared_ptr<gloo::transport::Device> CreateGlooDevice();
 
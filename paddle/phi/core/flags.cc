@@ -465,8 +465,8 @@ PADDLE_DEFINE_EXPORTED_double(
  * Allocator related FLAG
  * Name: FLAGS_allocator_strategy
  * Since Version: 1.2
- * Value Range: string, {naive_best_fit, auto_growth, thread_local},
- * default=auto_growth
+ * Value Range: string, {naive_best_fit, auto_growth, thread_local,
+ * size_class}, default=auto_growth
  * Example:
  * Note: For selecting allocator policy of PaddlePaddle.
  */
@@ -484,7 +484,10 @@ PADDLE_DEFINE_EXPORTED_string(
     "size of models may be larger). auto_growth strategy would allocate "
     "GPU memory on demand, which allows users to start several Paddle jobs "
     "on the same GPU card but may lead to more memory fragmentation "
-    "(i.e., maximum batch size of models may be smaller).");
+    "(i.e., maximum batch size of models may be smaller). "
+    "size_class is the same as auto_growth except that CPU memory is "
+    "allocated from thread-local caches of size-class slabs, which scales "
+    "better when many threads allocate concurrently.");
 
 /**
  * Memory related FLAG
@@ -1245,3 +1248,54 @@ PADDLE_DEFINE_EXPORTED_bool(use_shm_cache,
 PADDLE_DEFINE_EXPORTED_string(tensor_operants_mode,
                               "eager",
                               "Tensor operants mode");
+
+/**
+ * Eager backward related FLAG
+ * Name: eager_backward_num_threads
+ * Since Version: 2.5.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_eager_backward_num_threads=4
+ * Note: Number of threads used to run the grad nodes of a dygraph backward.
+ *       A value less than 2 runs the grad nodes one by one in the calling
+ *       thread. Otherwise, grad nodes whose inputs are ready are dispatched
+ *       to a thread pool, so the independent branches of a wide graph run
+ *       concurrently. paddle.grad and graphs with force-sequential nodes
+ *       always run sequentially.
+ */
+PADDLE_DEFINE_EXPORTED_int32(
+    eager_backward_num_threads,
+    0,
+    "Number of threads to run the grad nodes of a dygraph backward, "
+    "0 or 1 runs them sequentially.");
+
+/**
+ * Eager backward related FLAG
+ * Name: eager_backward_deterministic
+ * Since Version: 2.5.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: Only takes effect when FLAGS_eager_backward_num_threads > 1. If True,
+ *       the results of the grad nodes are accumulated in the order the nodes
+ *       were dispatched instead of the order they finish, so the summation
+ *       order of gradients, and thus the result, is the same in every run.
+ */
+PADDLE_DEFINE_EXPORTED_bool(
+    eager_backward_deterministic,
+    false,
+    "Accumulate gradients in a fixed order in the multi-threaded backward.");
+
+/**
+ * Fusion group related FLAG
+ * Name: fusion_group_cpu_compiler
+ * Since Version: 2.5.0
+ * Value Range: string, default=c++
+ * Example: FLAGS_fusion_group_cpu_compiler=clang++
+ * Note: The C++ compiler used by fusion_group_pass to compile the code of
+ *       the fused elementwise subgraphs on CPU into shared libraries, which
+ *       are then loaded with dlopen. It must be able to run from the working
+ *       directory and accept the gcc style options.
+ */
+PADDLE_DEFINE_EXPORTED_string(
+    fusion_group_cpu_compiler,
+    "c++",
+    "The C++ compiler to compile the fused elementwise subgraphs on CPU.");
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <map>
 #include <ostream>
 #include <string>
@@ -315,7 +317,17 @@ class KernelFactory {
  public:
   static KernelFactory& Instance();
 
-  KernelNameMap& kernels() { return kernels_; }
+  // NOTE: The kernels may be changed through the returned map, so the kernels
+  // selected before, e.g. those in KernelDispatchCache, are invalidated.
+  KernelNameMap& kernels() {
+    kernels_version_.fetch_add(1, std::memory_order_acq_rel);
+    return kernels_;
+  }
+
+  // Changed whenever the kernels may be changed.
+  uint64_t kernels_version() const {
+    return kernels_version_.load(std::memory_order_acquire);
+  }
 
   bool HasCompatiblePhiKernel(const std::string& op_type) const;
 
@@ -347,10 +359,74 @@ class KernelFactory {
 
   KernelNameMap kernels_;
 
+  std::atomic<uint64_t> kernels_version_{0};
+
   // Get the low precision kernel list of current module.
   std::map<const std::string, OpCount> low_precision_kernels_;
 };
 
+/**
+ * Note: KernelDispatchCache caches the kernels selected by
+ *       SelectKernelOrThrowError for the last few kernel keys of a kernel,
+ *       so that selecting them again skips looking up the kernel name and
+ *       key. It is used at the call sites of the generated apis as
+ *
+ *         static thread_local KernelDispatchCache cache("scale");
+ *         auto kernel_result = cache.Select(kernel_key);
+ *
+ *       The kernels falling back to CPU are not cached, as the fallback
+ *       depends on the flags. The cache is not thread safe.
+ */
+class KernelDispatchCache {
+ public:
+  explicit KernelDispatchCache(const char* kernel_name)
+      : kernel_name_(kernel_name), factory_(&KernelFactory::Instance()) {}
+
+  KernelResult Select(const KernelKey& kernel_key) {
+    uint64_t version = factory_->kernels_version();
+    if (version == version_) {
+      for (size_t i = 0; i < size_; ++i) {
+        const KernelKey& key = entries_[i].kernel_key;
+        if (key.backend() == kernel_key.backend() &&
+            key.layout() == kernel_key.layout() &&
+            key.dtype() == kernel_key.dtype()) {
+          return {*entries_[i].kernel, false};
+        }
+      }
+    } else {
+      version_ = version;
+      size_ = 0;
+    }
+    auto kernel_result =
+        factory_->SelectKernelOrThrowError(kernel_name_, kernel_key);
+    if (!kernel_result.has_fallback_cpu) {
+      if (size_ < kCapacity) {
+        ++size_;
+      }
+      // the oldest entry is replaced if the cache is full
+      for (size_t i = size_ - 1; i > 0; --i) {
+        entries_[i] = entries_[i - 1];
+      }
+      entries_[0] = {kernel_key, &kernel_result.kernel};
+    }
+    return kernel_result;
+  }
+
+ private:
+  static constexpr size_t kCapacity = 4;
+
+  struct Entry {
+    KernelKey kernel_key;
+    const Kernel* kernel{nullptr};
+  };
+
+  const char* kernel_name_;
+  const KernelFactory* factory_;
+  uint64_t version_{0};
+  size_t size_{0};
+  std::array<Entry, kCapacity> entries_;
+};
+
 inline std::ostream& operator<<(std::ostream& os, const KernelKey& kernel_key) {
   os << "(" << kernel_key.backend() << ", " << kernel_key.layout() << ", "
      << kernel_key.dtype() << ")";
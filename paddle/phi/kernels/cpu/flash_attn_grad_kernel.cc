@@ -0,0 +1,304 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/flash_attn_grad_kernel.h"
+
+#include <cmath>
+#include <vector>
+
+#include "glog/logging.h"  // For VLOG()
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/cpu/flash_attn_utils.h"
+#include "paddle/phi/kernels/funcs/math_function.h"
+
+namespace phi {
+
+// Gradients of one sequence and one head. The probabilities of every tile
+// are recomputed from softmax_lse of the forward, dk/dv of a k block are
+// accumulated over all the q blocks before they are written back.
+template <typename T>
+void FlashAttnBwdHead(const FlashAttnCPUParams& params,
+                      int64_t b,
+                      int64_t h,
+                      const T* q,
+                      const T* k,
+                      const T* v,
+                      const T* out,
+                      const float* softmax_lse,
+                      const T* dout,
+                      T* dq,
+                      T* dk,
+                      T* dv) {
+  const int64_t H = params.num_heads;
+  const int64_t D = params.head_size;
+  const int64_t Dv = params.value_size;
+  const int64_t q_start = params.cu_seqlens_q[b];
+  const int64_t k_start = params.cu_seqlens_k[b];
+  const int64_t seqlen_q = params.cu_seqlens_q[b + 1] - q_start;
+  const int64_t seqlen_k = params.cu_seqlens_k[b + 1] - k_start;
+  const int64_t bh = b * H + h;
+  const float* lse = softmax_lse + bh * params.max_seqlen_q;
+  const T scale = static_cast<T>(params.scale);
+
+  // D_i = rowsum(dout_i * out_i), which equals rowsum(P_i * dP_i).
+  ConstFlashAttnRows<T> out_rows(
+      out + (q_start * H + h) * Dv, seqlen_q, Dv, Eigen::OuterStride<>(H * Dv));
+  ConstFlashAttnRows<T> dout_rows(dout + (q_start * H + h) * Dv,
+                                  seqlen_q,
+                                  Dv,
+                                  Eigen::OuterStride<>(H * Dv));
+  Eigen::Matrix<T, Eigen::Dynamic, 1> delta =
+      dout_rows.cwiseProduct(out_rows).rowwise().sum();
+
+  FlashAttnMatrix<T> scores, keep, dprob, dk_acc, dv_acc;
+  for (int64_t k_begin = 0; k_begin < seqlen_k; k_begin += kFlashAttnBlockK) {
+    int64_t k_len = std::min(kFlashAttnBlockK, seqlen_k - k_begin);
+    ConstFlashAttnRows<T> k_tile(k + ((k_start + k_begin) * H + h) * D,
+                                 k_len,
+                                 D,
+                                 Eigen::OuterStride<>(H * D));
+    ConstFlashAttnRows<T> v_tile(v + ((k_start + k_begin) * H + h) * Dv,
+                                 k_len,
+                                 Dv,
+                                 Eigen::OuterStride<>(H * Dv));
+    dk_acc.setZero(k_len, D);
+    dv_acc.setZero(k_len, Dv);
+
+    // In the causal mode the q blocks above the diagonal see no key here.
+    int64_t q_first =
+        params.causal ? k_begin / kFlashAttnBlockQ * kFlashAttnBlockQ : 0;
+    for (int64_t q_begin = q_first; q_begin < seqlen_q;
+         q_begin += kFlashAttnBlockQ) {
+      int64_t q_len = std::min(kFlashAttnBlockQ, seqlen_q - q_begin);
+      ConstFlashAttnRows<T> q_tile(q + ((q_start + q_begin) * H + h) * D,
+                                   q_len,
+                                   D,
+                                   Eigen::OuterStride<>(H * D));
+      ConstFlashAttnRows<T> dout_tile(
+          dout + ((q_start + q_begin) * H + h) * Dv,
+          q_len,
+          Dv,
+          Eigen::OuterStride<>(H * Dv));
+      FlashAttnRows<T> dq_tile(dq + ((q_start + q_begin) * H + h) * D,
+                               q_len,
+                               D,
+                               Eigen::OuterStride<>(H * D));
+      FlashAttnScoreTile<T>(
+          params, bh, q_tile, k_tile, q_begin, k_begin, &scores, &keep);
+
+      // scores -> P = exp(S - lse), the fully masked rows stay zero.
+      for (int64_t i = 0; i < q_len; ++i) {
+        float row_lse = lse[q_begin + i];
+        if (row_lse == -std::numeric_limits<float>::infinity()) {
+          scores.row(i).setZero();
+        } else {
+          scores.row(i) =
+              (scores.row(i).array() - static_cast<T>(row_lse)).exp().matrix();
+        }
+      }
+
+      dprob.noalias() = dout_tile * v_tile.transpose();
+      if (params.dropout > 0.0f) {
+        dv_acc.noalias() += scores.cwiseProduct(keep).transpose() * dout_tile;
+        dprob = dprob.cwiseProduct(keep);
+      } else {
+        dv_acc.noalias() += scores.transpose() * dout_tile;
+      }
+      // dS = P * (dP - D_i), stored in dprob.
+      dprob.colwise() -= delta.segment(q_begin, q_len);
+      dprob = dprob.cwiseProduct(scores);
+
+      dq_tile.noalias() += scale * (dprob * k_tile);
+      dk_acc.noalias() += scale * (dprob.transpose() * q_tile);
+    }
+
+    FlashAttnRows<T>(dk + ((k_start + k_begin) * H + h) * D,
+                     k_len,
+                     D,
+                     Eigen::OuterStride<>(H * D)) = dk_acc;
+    FlashAttnRows<T>(dv + ((k_start + k_begin) * H + h) * Dv,
+                     k_len,
+                     Dv,
+                     Eigen::OuterStride<>(H * Dv)) = dv_acc;
+  }
+}
+
+template <typename T, typename Context>
+void FlashAttnUnpaddedGradKernel(const Context& ctx,
+                                 const DenseTensor& q,
+                                 const DenseTensor& k,
+                                 const DenseTensor& v,
+                                 const DenseTensor& cu_seqlens_q,
+                                 const DenseTensor& cu_seqlens_k,
+                                 const DenseTensor& out,
+                                 const DenseTensor& softmax_lse,
+                                 const DenseTensor& seed_offset,
+                                 const DenseTensor& dout,
+                                 int64_t max_seqlen_q,
+                                 int64_t max_seqlen_k,
+                                 float scale,
+                                 float dropout,
+                                 bool causal,
+                                 DenseTensor* dq,
+                                 DenseTensor* dk,
+                                 DenseTensor* dv) {
+  // q,k,v [total_*, num_heads, head_dim]
+  CheckFlashAttnCPUInputs(q, k, v, cu_seqlens_q, cu_seqlens_k);
+  auto dims = q.dims();
+
+  FlashAttnCPUParams params;
+  params.batch_size = cu_seqlens_q.numel() - 1;
+  params.num_heads = dims[1];
+  params.head_size = dims[2];
+  params.value_size = v.dims()[2];
+  params.max_seqlen_q = max_seqlen_q;
+  params.max_seqlen_k = max_seqlen_k;
+  params.cu_seqlens_q = cu_seqlens_q.data<int32_t>();
+  params.cu_seqlens_k = cu_seqlens_k.data<int32_t>();
+  params.scale = scale;
+  params.dropout = dropout;
+  params.causal = causal;
+
+  const int64_t* seed_offset_data = seed_offset.data<int64_t>();
+  params.seed = static_cast<uint64_t>(seed_offset_data[0]);
+  params.offset = static_cast<uint64_t>(seed_offset_data[1]);
+
+  VLOG(4) << "FlashAttn CPU bwd seed: " << params.seed
+          << ", offset: " << params.offset;
+
+  T* dq_data = ctx.template Alloc<T>(dq);
+  T* dk_data = ctx.template Alloc<T>(dk);
+  T* dv_data = ctx.template Alloc<T>(dv);
+  // dq is accumulated tile by tile, the rows of dk/dv beyond the sequences
+  // are never written.
+  phi::funcs::SetConstant<Context, T> set_zero;
+  set_zero(ctx, dq, static_cast<T>(0));
+  set_zero(ctx, dk, static_cast<T>(0));
+  set_zero(ctx, dv, static_cast<T>(0));
+
+  const T* q_data = q.data<T>();
+  const T* k_data = k.data<T>();
+  const T* v_data = v.data<T>();
+  const T* out_data = out.data<T>();
+  const T* dout_data = dout.data<T>();
+  const float* softmax_lse_data = softmax_lse.data<float>();
+
+  int64_t num_tasks = params.batch_size * params.num_heads;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+  for (int64_t task = 0; task < num_tasks; ++task) {
+    FlashAttnBwdHead<T>(params,
+                        task / params.num_heads,
+                        task % params.num_heads,
+                        q_data,
+                        k_data,
+                        v_data,
+                        out_data,
+                        softmax_lse_data,
+                        dout_data,
+                        dq_data,
+                        dk_data,
+                        dv_data);
+  }
+}
+
+template <typename T, typename Context>
+void FlashAttnGradKernel(const Context& ctx,
+                         const DenseTensor& q,
+                         const DenseTensor& k,
+                         const DenseTensor& v,
+                         const DenseTensor& out,
+                         const DenseTensor& softmax_lse,
+                         const DenseTensor& seed_offset,
+                         const DenseTensor& dout,
+                         float dropout,
+                         bool causal,
+                         DenseTensor* dq,
+                         DenseTensor* dk,
+                         DenseTensor* dv) {
+  // q,k,v [batch_size, seq_len, num_heads, head_dim]
+
+  auto dims = q.dims();
+  int64_t batch_size = dims[0];
+  int64_t seq_len_q = dims[1];
+  int64_t num_heads = dims[2];
+  int64_t head_size = dims[3];
+
+  int64_t seq_len_k = k.dims()[1];
+
+  int64_t total_q = batch_size * seq_len_q;
+  int64_t total_k = batch_size * seq_len_k;
+
+  float scale = 1.0f / std::sqrt(head_size);
+
+  VLOG(4) << "FlashAttn CPU bwd dims q[" << q.dims() << "], k[" << k.dims()
+          << "], v[" << v.dims() << "]";
+
+  DenseTensor q_t_s, k_t_s, v_t_s;
+  q_t_s.ShareDataWith(q).Resize({total_q, num_heads, head_size});
+  k_t_s.ShareDataWith(k).Resize({total_k, num_heads, head_size});
+  v_t_s.ShareDataWith(v).Resize({total_k, num_heads, v.dims()[3]});
+
+  DenseTensor cu_seqlens_q;
+  DenseTensor cu_seqlens_k;
+  cu_seqlens_q.Resize({batch_size + 1});
+  cu_seqlens_k.Resize({batch_size + 1});
+  int32_t* cu_seqlens_q_data = ctx.template Alloc<int32_t>(&cu_seqlens_q);
+  int32_t* cu_seqlens_k_data = ctx.template Alloc<int32_t>(&cu_seqlens_k);
+  for (int64_t b = 0; b <= batch_size; ++b) {
+    cu_seqlens_q_data[b] = static_cast<int32_t>(b * seq_len_q);
+    cu_seqlens_k_data[b] = static_cast<int32_t>(b * seq_len_k);
+  }
+
+  FlashAttnUnpaddedGradKernel<T, Context>(ctx,
+                                          q_t_s,
+                                          k_t_s,
+                                          v_t_s,
+                                          cu_seqlens_q,
+                                          cu_seqlens_k,
+                                          out,
+                                          softmax_lse,
+                                          seed_offset,
+                                          dout,
+                                          seq_len_q,
+                                          seq_len_k,
+                                          scale,
+                                          dropout,
+                                          causal,
+                                          dq,
+                                          dk,
+                                          dv);
+}
+
+}  // namespace phi
+
+PD_REGISTER_KERNEL(flash_attn_unpadded_grad,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::FlashAttnUnpaddedGradKernel,
+                   float,
+                   double) {
+  kernel->InputAt(7).SetBackend(phi::Backend::ALL_BACKEND);  // seed_offset
+}
+
+PD_REGISTER_KERNEL(flash_attn_grad,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::FlashAttnGradKernel,
+                   float,
+                   double) {
+  kernel->InputAt(5).SetBackend(phi::Backend::ALL_BACKEND);  // seed_offset
+}
@@ -0,0 +1,361 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/flash_attn_kernel.h"
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"  // For VLOG()
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/generator.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/cpu/flash_attn_utils.h"
+#include "paddle/phi/kernels/funcs/math_function.h"
+
+namespace phi {
+
+// Attention of the q block [q_begin, q_begin + kFlashAttnBlockQ) of one
+// sequence and one head, the k/v blocks are visited once while the row max,
+// the row sum and the output of the block are rescaled online.
+template <typename T>
+void FlashAttnFwdBlock(const FlashAttnCPUParams& params,
+                       int64_t b,
+                       int64_t h,
+                       int64_t q_begin,
+                       const T* q,
+                       const T* k,
+                       const T* v,
+                       T* out,
+                       float* softmax_lse,
+                       T* softmax) {
+  using RowArray = Eigen::Array<T, 1, Eigen::Dynamic>;
+  const int64_t H = params.num_heads;
+  const int64_t D = params.head_size;
+  const int64_t Dv = params.value_size;
+  const int64_t q_start = params.cu_seqlens_q[b];
+  const int64_t k_start = params.cu_seqlens_k[b];
+  const int64_t seqlen_q = params.cu_seqlens_q[b + 1] - q_start;
+  const int64_t seqlen_k = params.cu_seqlens_k[b + 1] - k_start;
+  const int64_t q_len = std::min(kFlashAttnBlockQ, seqlen_q - q_begin);
+  const int64_t bh = b * H + h;
+
+  ConstFlashAttnRows<T> q_tile(q + ((q_start + q_begin) * H + h) * D,
+                               q_len,
+                               D,
+                               Eigen::OuterStride<>(H * D));
+  FlashAttnMatrix<T> acc = FlashAttnMatrix<T>::Zero(q_len, Dv);
+  std::vector<T> row_max(q_len, -std::numeric_limits<T>::infinity());
+  std::vector<T> row_sum(q_len, 0);
+  FlashAttnMatrix<T> scores, keep;
+
+  int64_t num_blocks_k = FlashAttnNumBlocksK(params, q_begin, q_len, seqlen_k);
+  for (int64_t kb = 0; kb < num_blocks_k; ++kb) {
+    int64_t k_begin = kb * kFlashAttnBlockK;
+    int64_t k_len = std::min(kFlashAttnBlockK, seqlen_k - k_begin);
+    ConstFlashAttnRows<T> k_tile(k + ((k_start + k_begin) * H + h) * D,
+                                 k_len,
+                                 D,
+                                 Eigen::OuterStride<>(H * D));
+    ConstFlashAttnRows<T> v_tile(v + ((k_start + k_begin) * H + h) * Dv,
+                                 k_len,
+                                 Dv,
+                                 Eigen::OuterStride<>(H * Dv));
+    FlashAttnScoreTile<T>(
+        params, bh, q_tile, k_tile, q_begin, k_begin, &scores, &keep);
+
+    for (int64_t i = 0; i < q_len; ++i) {
+      T max_val = std::max(row_max[i], scores.row(i).maxCoeff());
+      if (max_val == -std::numeric_limits<T>::infinity()) {
+        scores.row(i).setZero();
+        continue;
+      }
+      T rescale = std::exp(row_max[i] - max_val);
+      scores.row(i) = (scores.row(i).array() - max_val).exp().matrix();
+      row_sum[i] = row_sum[i] * rescale + scores.row(i).sum();
+      acc.row(i) *= rescale;
+      row_max[i] = max_val;
+    }
+    // The normalizer sums the probabilities before dropout.
+    if (params.dropout > 0.0f) {
+      scores = scores.cwiseProduct(keep);
+    }
+    acc.noalias() += scores * v_tile;
+  }
+
+  FlashAttnRows<T> out_tile(out + ((q_start + q_begin) * H + h) * Dv,
+                            q_len,
+                            Dv,
+                            Eigen::OuterStride<>(H * Dv));
+  float* lse = softmax_lse + bh * params.max_seqlen_q + q_begin;
+  for (int64_t i = 0; i < q_len; ++i) {
+    if (row_sum[i] > 0) {
+      out_tile.row(i) = acc.row(i) / row_sum[i];
+      lse[i] = static_cast<float>(row_max[i] + std::log(row_sum[i]));
+    } else {
+      out_tile.row(i).setZero();
+      lse[i] = -std::numeric_limits<float>::infinity();
+    }
+  }
+
+  // Only when return_softmax is set, the probabilities (after dropout) of
+  // the block are recomputed with the final log-sum-exp.
+  if (softmax != nullptr) {
+    for (int64_t kb = 0; kb < num_blocks_k; ++kb) {
+      int64_t k_begin = kb * kFlashAttnBlockK;
+      int64_t k_len = std::min(kFlashAttnBlockK, seqlen_k - k_begin);
+      ConstFlashAttnRows<T> k_tile(k + ((k_start + k_begin) * H + h) * D,
+                                   k_len,
+                                   D,
+                                   Eigen::OuterStride<>(H * D));
+      FlashAttnScoreTile<T>(
+          params, bh, q_tile, k_tile, q_begin, k_begin, &scores, &keep);
+      for (int64_t i = 0; i < q_len; ++i) {
+        Eigen::Map<RowArray> prob(
+            softmax + (bh * params.max_seqlen_q + q_begin + i) *
+                          params.max_seqlen_k +
+                k_begin,
+            k_len);
+        prob = (scores.row(i).array() - static_cast<T>(lse[i])).exp();
+        if (params.dropout > 0.0f) {
+          prob *= keep.row(i).array();
+        }
+      }
+    }
+  }
+}
+
+template <typename T, typename Context>
+void FlashAttnUnpaddedKernel(
+    const Context& ctx,
+    const DenseTensor& q,
+    const DenseTensor& k,
+    const DenseTensor& v,
+    const DenseTensor& cu_seqlens_q,
+    const DenseTensor& cu_seqlens_k,
+    const paddle::optional<DenseTensor>& fixed_seed_offset,
+    int64_t max_seqlen_q,
+    int64_t max_seqlen_k,
+    float scale,
+    float dropout,
+    bool causal,
+    bool return_softmax,
+    bool is_test,
+    const std::string& rng_name,
+    DenseTensor* out,
+    DenseTensor* softmax,
+    DenseTensor* softmax_lse,
+    DenseTensor* seed_offset) {
+  if (is_test) dropout = 0.0f;
+
+  // q,k,v [total_*, num_heads, head_dim]
+  CheckFlashAttnCPUInputs(q, k, v, cu_seqlens_q, cu_seqlens_k);
+  auto dims = q.dims();
+
+  FlashAttnCPUParams params;
+  params.batch_size = cu_seqlens_q.numel() - 1;
+  params.num_heads = dims[1];
+  params.head_size = dims[2];
+  params.value_size = v.dims()[2];
+  params.max_seqlen_q = max_seqlen_q;
+  params.max_seqlen_k = max_seqlen_k;
+  params.cu_seqlens_q = cu_seqlens_q.data<int32_t>();
+  params.cu_seqlens_k = cu_seqlens_k.data<int32_t>();
+  params.scale = scale;
+  params.dropout = dropout;
+  params.causal = causal;
+
+  if (fixed_seed_offset.get_ptr()) {
+    const int64_t* fixed_seed_offset_data =
+        fixed_seed_offset.get_ptr()->data<int64_t>();
+    params.seed = static_cast<uint64_t>(fixed_seed_offset_data[0]);
+    params.offset = static_cast<uint64_t>(fixed_seed_offset_data[1]);
+  } else {
+    uint64_t inc = params.batch_size * params.num_heads * max_seqlen_q *
+                   max_seqlen_k;
+    std::pair<uint64_t, uint64_t> seed_offset_pair;
+    if (rng_name != "") {
+      auto gen = phi::GetRandomSeedGenerator(rng_name);
+      seed_offset_pair = gen->IncrementOffset(inc);
+    } else {
+      auto* gen = ctx.GetGenerator();
+      seed_offset_pair = gen->IncrementOffset(inc);
+    }
+    params.seed = seed_offset_pair.first;
+    params.offset = seed_offset_pair.second;
+  }
+
+  VLOG(4) << "FlashAttn CPU fwd seed: " << params.seed
+          << ", offset: " << params.offset;
+
+  seed_offset->Resize({2});
+  int64_t* seed_offset_data = ctx.template Alloc<int64_t>(seed_offset);
+  seed_offset_data[0] = static_cast<int64_t>(params.seed);
+  seed_offset_data[1] = static_cast<int64_t>(params.offset);
+
+  softmax_lse->Resize({params.batch_size, params.num_heads, max_seqlen_q});
+  float* softmax_lse_data = ctx.template Alloc<float>(softmax_lse);
+
+  T* softmax_data = nullptr;
+  if (return_softmax) {
+    softmax->Resize(
+        {params.batch_size, params.num_heads, max_seqlen_q, max_seqlen_k});
+    softmax_data = ctx.template Alloc<T>(softmax);
+    phi::funcs::SetConstant<Context, T> set_zero;
+    set_zero(ctx, softmax, static_cast<T>(0));
+  }
+
+  const T* q_data = q.data<T>();
+  const T* k_data = k.data<T>();
+  const T* v_data = v.data<T>();
+  T* out_data = ctx.template Alloc<T>(out);
+
+  // (sequence, q block) pairs, every pair is computed for all the heads.
+  std::vector<std::pair<int64_t, int64_t>> blocks;
+  for (int64_t b = 0; b < params.batch_size; ++b) {
+    int64_t seqlen_q = params.cu_seqlens_q[b + 1] - params.cu_seqlens_q[b];
+    PADDLE_ENFORCE_LE(seqlen_q,
+                      max_seqlen_q,
+                      phi::errors::InvalidArgument(
+                          "The length of sequence %d is %d, which is greater "
+                          "than max_seqlen_q %d.",
+                          b,
+                          seqlen_q,
+                          max_seqlen_q));
+    PADDLE_ENFORCE_LE(
+        params.cu_seqlens_k[b + 1] - params.cu_seqlens_k[b],
+        max_seqlen_k,
+        phi::errors::InvalidArgument(
+            "The length of sequence %d of k is greater than max_seqlen_k %d.",
+            b,
+            max_seqlen_k));
+    for (int64_t q_begin = 0; q_begin < seqlen_q;
+         q_begin += kFlashAttnBlockQ) {
+      blocks.emplace_back(b, q_begin);
+    }
+  }
+
+  int64_t num_tasks = static_cast<int64_t>(blocks.size()) * params.num_heads;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+  for (int64_t task = 0; task < num_tasks; ++task) {
+    const auto& block = blocks[task / params.num_heads];
+    FlashAttnFwdBlock<T>(params,
+                         block.first,
+                         task % params.num_heads,
+                         block.second,
+                         q_data,
+                         k_data,
+                         v_data,
+                         out_data,
+                         softmax_lse_data,
+                         softmax_data);
+  }
+}
+
+template <typename T, typename Context>
+void FlashAttnKernel(const Context& ctx,
+                     const DenseTensor& q,
+                     const DenseTensor& k,
+                     const DenseTensor& v,
+                     const paddle::optional<DenseTensor>& fixed_seed_offset,
+                     float dropout,
+                     bool causal,
+                     bool return_softmax,
+                     bool is_test,
+                     const std::string& rng_name,
+                     DenseTensor* out,
+                     DenseTensor* softmax,
+                     DenseTensor* softmax_lse,
+                     DenseTensor* seed_offset) {
+  // q,k,v [batch_size, seq_len, num_heads, head_dim]
+
+  auto dims = q.dims();
+  PADDLE_ENFORCE_EQ(dims.size(),
+                    4,
+                    phi::errors::InvalidArgument(
+                        "flash_attn receive input with dim "
+                        "[batch_size, seq_len, num_heads, head_dim]"));
+
+  int64_t batch_size = dims[0];
+  int64_t seq_len_q = dims[1];
+  int64_t num_heads = dims[2];
+  int64_t head_size = dims[3];
+
+  int64_t seq_len_k = k.dims()[1];
+
+  int64_t total_q = batch_size * seq_len_q;
+  int64_t total_k = batch_size * seq_len_k;
+
+  float scale = 1.0f / std::sqrt(head_size);
+
+  VLOG(4) << "FlashAttn CPU fwd dims q[" << q.dims() << "], k[" << k.dims()
+          << "], v[" << v.dims() << "]";
+
+  DenseTensor q_t_s, k_t_s, v_t_s;
+  q_t_s.ShareDataWith(q).Resize({total_q, num_heads, head_size});
+  k_t_s.ShareDataWith(k).Resize({total_k, num_heads, head_size});
+  v_t_s.ShareDataWith(v).Resize({total_k, num_heads, v.dims()[3]});
+
+  DenseTensor cu_seqlens_q;
+  DenseTensor cu_seqlens_k;
+  cu_seqlens_q.Resize({batch_size + 1});
+  cu_seqlens_k.Resize({batch_size + 1});
+  int32_t* cu_seqlens_q_data = ctx.template Alloc<int32_t>(&cu_seqlens_q);
+  int32_t* cu_seqlens_k_data = ctx.template Alloc<int32_t>(&cu_seqlens_k);
+  for (int64_t b = 0; b <= batch_size; ++b) {
+    cu_seqlens_q_data[b] = static_cast<int32_t>(b * seq_len_q);
+    cu_seqlens_k_data[b] = static_cast<int32_t>(b * seq_len_k);
+  }
+
+  FlashAttnUnpaddedKernel<T, Context>(ctx,
+                                      q_t_s,
+                                      k_t_s,
+                                      v_t_s,
+                                      cu_seqlens_q,
+                                      cu_seqlens_k,
+                                      fixed_seed_offset,
+                                      seq_len_q,
+                                      seq_len_k,
+                                      scale,
+                                      dropout,
+                                      causal,
+                                      return_softmax,
+                                      is_test,
+                                      rng_name,
+                                      out,
+                                      softmax,
+                                      softmax_lse,
+                                      seed_offset);
+}
+
+}  // namespace phi
+
+PD_REGISTER_KERNEL(flash_attn_unpadded,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::FlashAttnUnpaddedKernel,
+                   float,
+                   double) {
+  kernel->InputAt(5).SetBackend(
+      phi::Backend::ALL_BACKEND);  // fixed_seed_offset
+}
+
+PD_REGISTER_KERNEL(
+    flash_attn, CPU, ALL_LAYOUT, phi::FlashAttnKernel, float, double) {
+  kernel->InputAt(3).SetBackend(
+      phi::Backend::ALL_BACKEND);  // fixed_seed_offset
+}
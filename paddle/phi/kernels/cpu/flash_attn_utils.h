@@ -0,0 +1,165 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "Eigen/Core"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/enforce.h"
+
+namespace phi {
+
+// The CPU flash attention computes the attention tile by tile with an
+// online softmax, only a [kFlashAttnBlockQ, kFlashAttnBlockK] score tile is
+// alive per thread, the [seq_len_q, seq_len_k] scores are never allocated.
+constexpr int64_t kFlashAttnBlockQ = 64;
+constexpr int64_t kFlashAttnBlockK = 64;
+
+template <typename T>
+using FlashAttnMatrix =
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+// Rows of one head in q/k/v/out of layout [total_seq_len, num_heads, dim],
+// the rows of a head are num_heads * dim elements apart.
+template <typename T>
+using FlashAttnRows =
+    Eigen::Map<FlashAttnMatrix<T>, Eigen::Unaligned, Eigen::OuterStride<>>;
+template <typename T>
+using ConstFlashAttnRows = Eigen::Map<const FlashAttnMatrix<T>,
+                                      Eigen::Unaligned,
+                                      Eigen::OuterStride<>>;
+
+struct FlashAttnCPUParams {
+  int64_t batch_size;
+  int64_t num_heads;
+  int64_t head_size;
+  int64_t value_size;
+  int64_t max_seqlen_q;
+  int64_t max_seqlen_k;
+  const int32_t* cu_seqlens_q;
+  const int32_t* cu_seqlens_k;
+  float scale;
+  float dropout;
+  bool causal;
+  uint64_t seed;
+  uint64_t offset;
+};
+
+inline void CheckFlashAttnCPUInputs(const DenseTensor& q,
+                                    const DenseTensor& k,
+                                    const DenseTensor& v,
+                                    const DenseTensor& cu_seqlens_q,
+                                    const DenseTensor& cu_seqlens_k) {
+  PADDLE_ENFORCE_EQ(
+      q.dims().size(),
+      3,
+      phi::errors::InvalidArgument("flash_attn_raw receive input with dim "
+                                   "[total_seq_len, num_heads, head_dim]"));
+  PADDLE_ENFORCE_EQ(
+      k.dims()[1] == q.dims()[1] && v.dims()[1] == q.dims()[1] &&
+          k.dims()[2] == q.dims()[2] && v.dims()[0] == k.dims()[0],
+      true,
+      phi::errors::InvalidArgument(
+          "The CPU flash_attn requires q, k, v with the same num_heads, q and "
+          "k with the same head_dim, k and v with the same total_seq_len."));
+  PADDLE_ENFORCE_EQ(
+      cu_seqlens_q.numel(),
+      cu_seqlens_k.numel(),
+      phi::errors::InvalidArgument(
+          "The size of cu_seqlens_q and cu_seqlens_k must be equal."));
+  PADDLE_ENFORCE_EQ(cu_seqlens_q.dtype(),
+                    DataType::INT32,
+                    phi::errors::InvalidArgument(
+                        "The dtype of cu_seqlens_q must be int32."));
+  PADDLE_ENFORCE_EQ(cu_seqlens_k.dtype(),
+                    DataType::INT32,
+                    phi::errors::InvalidArgument(
+                        "The dtype of cu_seqlens_k must be int32."));
+}
+
+// Keep-mask of dropout at element idx of the [batch_size, num_heads,
+// max_seqlen_q, max_seqlen_k] attention probabilities. It is a counter based
+// hash (splitmix64) of (seed, offset + idx), so the backward regenerates the
+// mask of the forward from seed_offset without storing it.
+inline bool FlashAttnDropoutKeep(uint64_t seed,
+                                 uint64_t offset,
+                                 uint64_t idx,
+                                 float dropout) {
+  uint64_t z = seed ^ ((offset + idx) * 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+  float u = static_cast<float>(z >> 40) * (1.0f / (1ULL << 24));
+  return u >= dropout;
+}
+
+// Number of k blocks of the q block starting at q_begin with q_len rows, the
+// blocks after the diagonal are skipped in the causal mode.
+inline int64_t FlashAttnNumBlocksK(const FlashAttnCPUParams& params,
+                                   int64_t q_begin,
+                                   int64_t q_len,
+                                   int64_t seqlen_k) {
+  int64_t k_end = params.causal ? std::min(seqlen_k, q_begin + q_len)
+                                : seqlen_k;
+  return (k_end + kFlashAttnBlockK - 1) / kFlashAttnBlockK;
+}
+
+// Computes the scaled scores of a tile and masks the causal positions with
+// -inf. When dropout > 0, keep is filled with 1 / (1 - dropout) at the kept
+// positions and 0 at the dropped ones.
+template <typename T>
+void FlashAttnScoreTile(const FlashAttnCPUParams& params,
+                        int64_t bh,
+                        const ConstFlashAttnRows<T>& q_tile,
+                        const ConstFlashAttnRows<T>& k_tile,
+                        int64_t q_begin,
+                        int64_t k_begin,
+                        FlashAttnMatrix<T>* scores,
+                        FlashAttnMatrix<T>* keep) {
+  scores->noalias() = q_tile * k_tile.transpose();
+  *scores *= static_cast<T>(params.scale);
+  int64_t rows = scores->rows();
+  int64_t cols = scores->cols();
+  if (params.causal) {
+    for (int64_t i = 0; i < rows; ++i) {
+      for (int64_t j = std::max<int64_t>(q_begin + i - k_begin + 1, 0);
+           j < cols;
+           ++j) {
+        (*scores)(i, j) = -std::numeric_limits<T>::infinity();
+      }
+    }
+  }
+  if (params.dropout > 0.0f) {
+    keep->resize(rows, cols);
+    T keep_scale = static_cast<T>(1.0f / (1.0f - params.dropout));
+    for (int64_t i = 0; i < rows; ++i) {
+      uint64_t row_idx =
+          (bh * params.max_seqlen_q + q_begin + i) * params.max_seqlen_k;
+      for (int64_t j = 0; j < cols; ++j) {
+        (*keep)(i, j) = FlashAttnDropoutKeep(params.seed,
+                                             params.offset,
+                                             row_idx + k_begin + j,
+                                             params.dropout)
+                            ? keep_scale
+                            : static_cast<T>(0);
+      }
+    }
+  }
+}
+
+}  // namespace phi
@@ -17,6 +17,10 @@
 #include "paddle/phi/backends/all_context.h"
 #include "paddle/phi/core/kernel_registry.h"
 
+#if defined(PADDLE_WITH_GLOO)
+#include "paddle/phi/core/distributed/gloo_comm_context.h"
+#endif
+
 namespace phi {
 
 template <typename T, typename Context>
@@ -24,8 +28,36 @@ void ReduceScatterKernel(const Context& dev_ctx,
                          const DenseTensor& x,
                          int nranks,
                          DenseTensor* out) {
-  PADDLE_THROW(
-      errors::Unimplemented("Unimplemented cpu kernel for CReduceScatterOp."));
+#if defined(PADDLE_WITH_GLOO)
+  auto comm_ctx =
+      static_cast<distributed::GlooCommContext*>(dev_ctx.GetCommContext());
+  PADDLE_ENFORCE_NE(
+      comm_ctx,
+      nullptr,
+      errors::Unavailable("GlooCommContext is nullptr, collective op should "
+                          "has ring_id attr."));
+  PADDLE_ENFORCE_EQ(
+      nranks,
+      comm_ctx->GetSize(),
+      errors::InvalidArgument(
+          "nranks: %s should equal to %s", nranks, comm_ctx->GetSize()));
+
+  auto out_dims = x.dims();
+  PADDLE_ENFORCE_EQ(
+      out_dims[0] % nranks,
+      0,
+      errors::InvalidArgument("The input tensor X's "
+                              "dim[0] (%d) should be divisible by nranks(%d)",
+                              out_dims[0],
+                              nranks));
+  out_dims[0] = out_dims[0] / nranks;
+  out->Resize(out_dims);
+  dev_ctx.template Alloc<T>(out);
+  comm_ctx->ReduceScatter(out, x, distributed::kRedSum);
+#else
+  PADDLE_THROW(errors::Unavailable(
+      "PaddlePaddle should compile with GLOO by setting WITH_GLOO=ON"));
+#endif
 }
 
 }  // namespace phi
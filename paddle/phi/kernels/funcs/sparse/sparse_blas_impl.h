@@ -0,0 +1,493 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "Eigen/Core"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/ddim.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/sparse_coo_tensor.h"
+#include "paddle/phi/core/sparse_csr_tensor.h"
+#include "paddle/phi/core/visit_type.h"
+
+namespace phi {
+namespace funcs {
+namespace sparse {
+
+/************* SPARSE MATRIX VIEW (COO/CSR) ************/
+
+// Row compressed view of a batched sparse matrix of shape
+// [batch_size, rows, cols]. As SparseCsrTensor, crows restarts from 0 in
+// every batch, the entries of batch b start at offsets[b]. The indices of
+// SparseCsrTensor are used in place when they are int64, COO tensors and
+// int32 indices are converted into the owned buffers.
+template <typename T>
+struct CpuCsrMatrix {
+  int64_t batch_size = 1;
+  int64_t rows = 0;
+  int64_t cols = 0;
+  const int64_t* crows = nullptr;
+  const int64_t* col_idx = nullptr;
+  const T* values = nullptr;
+  std::vector<int64_t> offsets;
+
+  std::vector<int64_t> crows_buffer;
+  std::vector<int64_t> cols_buffer;
+  std::vector<T> values_buffer;
+
+  int64_t RowBegin(int64_t b, int64_t i) const {
+    return offsets[b] + crows[b * (rows + 1) + i];
+  }
+  int64_t RowEnd(int64_t b, int64_t i) const {
+    return offsets[b] + crows[b * (rows + 1) + i + 1];
+  }
+  int64_t BatchNnz(int64_t b) const { return crows[b * (rows + 1) + rows]; }
+};
+
+inline void GetBatchMatrixShape(const DDim& dims,
+                                int64_t* batch_size,
+                                int64_t* rows,
+                                int64_t* cols) {
+  int ndims = dims.size();
+  PADDLE_ENFORCE_GE(
+      ndims,
+      2,
+      phi::errors::InvalidArgument("the dim size of matrix must be greater "
+                                   "than or eaqual to 2."));
+  *batch_size = 1;
+  for (int i = 0; i < ndims - 2; ++i) {
+    *batch_size *= dims[i];
+  }
+  *rows = dims[ndims - 2];
+  *cols = dims[ndims - 1];
+}
+
+template <typename IntT>
+inline const int64_t* GetInt64Indices(const IntT* data,
+                                      int64_t numel,
+                                      std::vector<int64_t>* buffer) {
+  if (std::is_same<IntT, int64_t>::value) {
+    return reinterpret_cast<const int64_t*>(data);
+  }
+  buffer->assign(data, data + numel);
+  return buffer->data();
+}
+
+template <typename T>
+inline void MakeCpuCsrMatrix(const SparseCsrTensor& x, CpuCsrMatrix<T>* mat) {
+  GetBatchMatrixShape(x.dims(), &mat->batch_size, &mat->rows, &mat->cols);
+  PADDLE_ENFORCE_EQ(x.crows().numel(),
+                    mat->batch_size * (mat->rows + 1),
+                    phi::errors::PreconditionNotMet(
+                        "the length of SparseCsrTensor crows is not right."));
+  PD_VISIT_BASE_INTEGRAL_TYPES(x.crows().dtype(), "MakeCpuCsrMatrix", ([&] {
+                                 mat->crows = GetInt64Indices(
+                                     x.crows().data<data_t>(),
+                                     x.crows().numel(),
+                                     &mat->crows_buffer);
+                                 mat->col_idx = GetInt64Indices(
+                                     x.cols().data<data_t>(),
+                                     x.cols().numel(),
+                                     &mat->cols_buffer);
+                               }));
+  mat->values = x.values().data<T>();
+  mat->offsets.resize(mat->batch_size);
+  int64_t offset = 0;
+  for (int64_t b = 0; b < mat->batch_size; ++b) {
+    mat->offsets[b] = offset;
+    offset += mat->BatchNnz(b);
+  }
+}
+
+// Entries of COO are bucketed by (batch, row) with a counting sort, so the
+// COO tensor is not required to be coalesced.
+template <typename T>
+inline void MakeCpuCsrMatrix(const SparseCooTensor& x, CpuCsrMatrix<T>* mat) {
+  GetBatchMatrixShape(x.dims(), &mat->batch_size, &mat->rows, &mat->cols);
+  int ndims = x.dims().size();
+  PADDLE_ENFORCE_EQ(x.sparse_dim(),
+                    ndims,
+                    phi::errors::InvalidArgument(
+                        "the sparse_dim of SparseCooTensor must be equal to "
+                        "its dim size, but received sparse_dim=%d, dims=%d.",
+                        x.sparse_dim(),
+                        ndims));
+  int64_t nnz = x.nnz();
+  int64_t total_rows = mat->batch_size * mat->rows;
+  std::vector<int64_t> row_ids(nnz);
+  std::vector<int64_t> row_nnz(total_rows + 1, 0);
+  mat->cols_buffer.resize(nnz);
+  mat->values_buffer.resize(nnz);
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      x.indices().dtype(), "MakeCpuCsrMatrix", ([&] {
+        const data_t* indices = x.indices().data<data_t>();
+        for (int64_t p = 0; p < nnz; ++p) {
+          int64_t row = 0;
+          for (int d = 0; d < ndims - 1; ++d) {
+            row = row * x.dims()[d] + indices[d * nnz + p];
+          }
+          row_ids[p] = row;
+          ++row_nnz[row + 1];
+        }
+        for (int64_t r = 0; r < total_rows; ++r) {
+          row_nnz[r + 1] += row_nnz[r];
+        }
+        std::vector<int64_t> pos(row_nnz.begin(), row_nnz.end() - 1);
+        const data_t* cols = indices + (ndims - 1) * nnz;
+        const T* values = x.values().data<T>();
+        for (int64_t p = 0; p < nnz; ++p) {
+          int64_t dst = pos[row_ids[p]]++;
+          mat->cols_buffer[dst] = cols[p];
+          mat->values_buffer[dst] = values[p];
+        }
+      }));
+  mat->crows_buffer.resize(mat->batch_size * (mat->rows + 1));
+  mat->offsets.resize(mat->batch_size);
+  for (int64_t b = 0; b < mat->batch_size; ++b) {
+    int64_t offset = row_nnz[b * mat->rows];
+    mat->offsets[b] = offset;
+    for (int64_t i = 0; i <= mat->rows; ++i) {
+      mat->crows_buffer[b * (mat->rows + 1) + i] =
+          row_nnz[b * mat->rows + i] - offset;
+    }
+  }
+  mat->crows = mat->crows_buffer.data();
+  mat->col_idx = mat->cols_buffer.data();
+  mat->values = mat->values_buffer.data();
+}
+
+// Transposes every batch of src, which turns a column scatter into a row
+// gather, so that op(A) = A' is computed with the same row parallel loops.
+template <typename T>
+inline void TransposeCpuCsrMatrix(const CpuCsrMatrix<T>& src,
+                                  CpuCsrMatrix<T>* dst) {
+  dst->batch_size = src.batch_size;
+  dst->rows = src.cols;
+  dst->cols = src.rows;
+  int64_t nnz = src.batch_size > 0 ? src.offsets[src.batch_size - 1] +
+                                         src.BatchNnz(src.batch_size - 1)
+                                   : 0;
+  dst->crows_buffer.assign(dst->batch_size * (dst->rows + 1), 0);
+  dst->cols_buffer.resize(nnz);
+  dst->values_buffer.resize(nnz);
+  dst->offsets = src.offsets;
+  for (int64_t b = 0; b < src.batch_size; ++b) {
+    int64_t* crows = dst->crows_buffer.data() + b * (dst->rows + 1);
+    for (int64_t p = src.offsets[b]; p < src.offsets[b] + src.BatchNnz(b);
+         ++p) {
+      ++crows[src.col_idx[p] + 1];
+    }
+    for (int64_t j = 0; j < dst->rows; ++j) {
+      crows[j + 1] += crows[j];
+    }
+    std::vector<int64_t> pos(crows, crows + dst->rows);
+    for (int64_t i = 0; i < src.rows; ++i) {
+      for (int64_t p = src.RowBegin(b, i); p < src.RowEnd(b, i); ++p) {
+        int64_t q = src.offsets[b] + pos[src.col_idx[p]]++;
+        dst->cols_buffer[q] = i;
+        dst->values_buffer[q] = src.values[p];
+      }
+    }
+  }
+  dst->crows = dst->crows_buffer.data();
+  dst->col_idx = dst->cols_buffer.data();
+  dst->values = dst->values_buffer.data();
+}
+
+// Transposes the last two dims of a batched dense matrix [batch, rows, cols].
+template <typename T>
+inline void TransposeBatchMatrix(
+    const T* src, int64_t batch_size, int64_t rows, int64_t cols, T* dst) {
+  for (int64_t b = 0; b < batch_size; ++b) {
+    const T* src_b = src + b * rows * cols;
+    T* dst_b = dst + b * rows * cols;
+    for (int64_t i = 0; i < rows; ++i) {
+      for (int64_t j = 0; j < cols; ++j) {
+        dst_b[j * rows + i] = src_b[i * cols + j];
+      }
+    }
+  }
+}
+
+/************* SPARSE*DENSE->DENSE MATMUL ************/
+// out[b, i, :] = alpha * sum(a[b, i, k] * mat_b[b, k, :]) + beta * out[b, i, :]
+// Rows are computed in parallel, the inner axpy of length n is vectorized
+// by Eigen.
+template <typename T>
+void CpuCsrDenseMatmul(const CpuCsrMatrix<T>& a,
+                       const T* mat_b,
+                       int64_t n,
+                       T alpha,
+                       T beta,
+                       T* out) {
+  using RowArray = Eigen::Array<T, 1, Eigen::Dynamic>;
+  int64_t total_rows = a.batch_size * a.rows;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+  for (int64_t r = 0; r < total_rows; ++r) {
+    int64_t b = r / a.rows;
+    int64_t i = r % a.rows;
+    Eigen::Map<RowArray> out_row(out + r * n, n);
+    if (beta == static_cast<T>(0)) {
+      out_row.setZero();
+    } else if (beta != static_cast<T>(1)) {
+      out_row *= beta;
+    }
+    const T* b_batch = mat_b + b * a.cols * n;
+    for (int64_t p = a.RowBegin(b, i); p < a.RowEnd(b, i); ++p) {
+      Eigen::Map<const RowArray> b_row(b_batch + a.col_idx[p] * n, n);
+      out_row += (alpha * a.values[p]) * b_row;
+    }
+  }
+}
+
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMM(bool transa,
+                                       bool transb,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& mat_b,
+                                       T beta,
+                                       phi::DenseTensor* mat_out) const {
+  CpuCsrMatrix<T> a;
+  MakeCpuCsrMatrix(mat_a, &a);
+  if (transa) {
+    CpuCsrMatrix<T> a_trans;
+    TransposeCpuCsrMatrix(a, &a_trans);
+    std::swap(a, a_trans);
+  }
+
+  int64_t b_batch_size = 0, b_rows = 0, b_cols = 0;
+  GetBatchMatrixShape(mat_b.dims(), &b_batch_size, &b_rows, &b_cols);
+  PADDLE_ENFORCE_EQ(
+      b_batch_size,
+      a.batch_size,
+      phi::errors::InvalidArgument("the batch size of sparse matrix and dense "
+                                   "matrix must be equal in SPMM."));
+  const T* b_data = mat_b.data<T>();
+  std::vector<T> b_trans;
+  if (transb) {
+    b_trans.resize(mat_b.numel());
+    TransposeBatchMatrix(b_data, b_batch_size, b_rows, b_cols, b_trans.data());
+    b_data = b_trans.data();
+    std::swap(b_rows, b_cols);
+  }
+  PADDLE_ENFORCE_EQ(
+      a.cols,
+      b_rows,
+      phi::errors::InvalidArgument("the cols of op(A) must be equal to the "
+                                   "rows of op(B) in SPMM."));
+  CpuCsrDenseMatmul(a, b_data, b_cols, alpha, beta, mat_out->data<T>());
+}
+
+/************* SPARSE*DENSE->DENSE MV ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMV(bool transa,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& vec_x,
+                                       T beta,
+                                       phi::DenseTensor* vec_out) const {
+  CpuCsrMatrix<T> a;
+  MakeCpuCsrMatrix(mat_a, &a);
+  if (transa) {
+    CpuCsrMatrix<T> a_trans;
+    TransposeCpuCsrMatrix(a, &a_trans);
+    std::swap(a, a_trans);
+  }
+  PADDLE_ENFORCE_EQ(
+      a.cols,
+      vec_x.numel() / a.batch_size,
+      phi::errors::InvalidArgument("the cols of op(A) must be equal to the "
+                                   "length of x in SPMV."));
+  const T* x_data = vec_x.data<T>();
+  T* out_data = vec_out->data<T>();
+  int64_t total_rows = a.batch_size * a.rows;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+  for (int64_t r = 0; r < total_rows; ++r) {
+    int64_t b = r / a.rows;
+    int64_t i = r % a.rows;
+    const T* x_batch = x_data + b * a.cols;
+    T sum = 0;
+    for (int64_t p = a.RowBegin(b, i); p < a.RowEnd(b, i); ++p) {
+      sum += a.values[p] * x_batch[a.col_idx[p]];
+    }
+    out_data[r] = beta == static_cast<T>(0) ? alpha * sum
+                                            : alpha * sum + beta * out_data[r];
+  }
+}
+
+/************* DENSE*DENSE->SPARSE MATMUL ************/
+// Both op(A) and op(B)' are made row major, so that every nonzero of the
+// output is the dot product of two contiguous rows.
+template <typename T>
+inline void GetSddmmOperands(bool transa,
+                             bool transb,
+                             const phi::DenseTensor& mat_a,
+                             const phi::DenseTensor& mat_b,
+                             std::vector<T>* a_buffer,
+                             std::vector<T>* b_buffer,
+                             const T** a_rows,
+                             const T** b_cols,
+                             int64_t* k) {
+  int64_t a_batch_size = 0, a_rows_num = 0, a_cols_num = 0;
+  int64_t b_batch_size = 0, b_rows_num = 0, b_cols_num = 0;
+  GetBatchMatrixShape(mat_a.dims(), &a_batch_size, &a_rows_num, &a_cols_num);
+  GetBatchMatrixShape(mat_b.dims(), &b_batch_size, &b_rows_num, &b_cols_num);
+  *a_rows = mat_a.data<T>();
+  if (transa) {
+    a_buffer->resize(mat_a.numel());
+    TransposeBatchMatrix(
+        *a_rows, a_batch_size, a_rows_num, a_cols_num, a_buffer->data());
+    *a_rows = a_buffer->data();
+    std::swap(a_rows_num, a_cols_num);
+  }
+  *b_cols = mat_b.data<T>();
+  if (!transb) {
+    b_buffer->resize(mat_b.numel());
+    TransposeBatchMatrix(
+        *b_cols, b_batch_size, b_rows_num, b_cols_num, b_buffer->data());
+    *b_cols = b_buffer->data();
+  } else {
+    std::swap(b_rows_num, b_cols_num);
+  }
+  PADDLE_ENFORCE_EQ(
+      a_cols_num,
+      b_rows_num,
+      phi::errors::InvalidArgument("the cols of op(A) must be equal to the "
+                                   "rows of op(B) in SDDMM."));
+  *k = a_cols_num;
+}
+
+template <typename T>
+inline T SddmmDot(const T* a, const T* b, int64_t k) {
+  using RowArray = Eigen::Array<T, 1, Eigen::Dynamic>;
+  return (Eigen::Map<const RowArray>(a, k) * Eigen::Map<const RowArray>(b, k))
+      .sum();
+}
+
+template <typename T>
+inline void CpuSddmm(bool transa,
+                     bool transb,
+                     T alpha,
+                     const phi::DenseTensor& mat_a,
+                     const phi::DenseTensor& mat_b,
+                     T beta,
+                     phi::SparseCsrTensor* mat_out) {
+  std::vector<T> a_buffer, b_buffer;
+  const T* a_rows = nullptr;
+  const T* b_cols = nullptr;
+  int64_t k = 0;
+  GetSddmmOperands(
+      transa, transb, mat_a, mat_b, &a_buffer, &b_buffer, &a_rows, &b_cols, &k);
+
+  CpuCsrMatrix<T> out;
+  MakeCpuCsrMatrix(*mat_out, &out);
+  T* out_values = mat_out->mutable_values()->data<T>();
+  int64_t total_rows = out.batch_size * out.rows;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+  for (int64_t r = 0; r < total_rows; ++r) {
+    int64_t b = r / out.rows;
+    int64_t i = r % out.rows;
+    const T* a_row = a_rows + r * k;
+    const T* b_batch = b_cols + b * out.cols * k;
+    for (int64_t p = out.RowBegin(b, i); p < out.RowEnd(b, i); ++p) {
+      T dot = SddmmDot(a_row, b_batch + out.col_idx[p] * k, k);
+      out_values[p] = beta == static_cast<T>(0)
+                          ? alpha * dot
+                          : alpha * dot + beta * out_values[p];
+    }
+  }
+}
+
+template <typename T, typename IntT>
+inline void CpuCooSddmm(const T* a_rows,
+                        const T* b_cols,
+                        int64_t k,
+                        T alpha,
+                        T beta,
+                        phi::SparseCooTensor* mat_out) {
+  const DDim& dims = mat_out->dims();
+  int ndims = dims.size();
+  int64_t rows = dims[ndims - 2];
+  int64_t cols = dims[ndims - 1];
+  int64_t nnz = mat_out->nnz();
+  const IntT* indices = mat_out->indices().data<IntT>();
+  T* out_values = mat_out->mutable_values()->data<T>();
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t p = 0; p < nnz; ++p) {
+    // index of the row in [batch_size * rows]
+    int64_t row = 0;
+    for (int d = 0; d < ndims - 1; ++d) {
+      row = row * dims[d] + indices[d * nnz + p];
+    }
+    int64_t b = row / rows;
+    int64_t j = indices[(ndims - 1) * nnz + p];
+    T dot = SddmmDot(a_rows + row * k, b_cols + (b * cols + j) * k, k);
+    out_values[p] = beta == static_cast<T>(0)
+                        ? alpha * dot
+                        : alpha * dot + beta * out_values[p];
+  }
+}
+
+template <typename T>
+inline void CpuSddmm(bool transa,
+                     bool transb,
+                     T alpha,
+                     const phi::DenseTensor& mat_a,
+                     const phi::DenseTensor& mat_b,
+                     T beta,
+                     phi::SparseCooTensor* mat_out) {
+  std::vector<T> a_buffer, b_buffer;
+  const T* a_rows = nullptr;
+  const T* b_cols = nullptr;
+  int64_t k = 0;
+  GetSddmmOperands(
+      transa, transb, mat_a, mat_b, &a_buffer, &b_buffer, &a_rows, &b_cols, &k);
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      mat_out->indices().dtype(), "CpuCooSddmm", ([&] {
+        CpuCooSddmm<T, data_t>(a_rows, b_cols, k, alpha, beta, mat_out);
+      }));
+}
+
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SDDMM(bool transa,
+                                        bool transb,
+                                        T alpha,
+                                        const phi::DenseTensor& mat_a,
+                                        const phi::DenseTensor& mat_b,
+                                        T beta,
+                                        TensorType* mat_out) const {
+  CpuSddmm<T>(transa, transb, alpha, mat_a, mat_b, beta, mat_out);
+}
+
+}  // namespace sparse
+}  // namespace funcs
+}  // namespace phi
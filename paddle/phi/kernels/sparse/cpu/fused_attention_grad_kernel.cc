@@ -14,12 +14,62 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/sparse/fused_attention_grad_kernel.h"
 
+#include <cmath>
+
+#include "Eigen/Core"
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/sparse/sparse_blas.h"
+#include "paddle/phi/kernels/sparse/empty_kernel.h"
 
 namespace phi {
 namespace sparse {
 
+// Computes one row of the grad of the scaled scores and of query, only at
+// the nonzero positions of softmax:
+//   dsoftmax[i, j] = dout[i, :] . v[j, :]
+//   dscore[i, j] = (dsoftmax[i, j] - sum_j(dsoftmax * softmax)) *
+//                  softmax[i, j] * scale
+//   dq[i, :] = sum_j(dscore[i, j] * k[j, :])
+template <typename T>
+void AttnCsrGradRowCPUKernel(const funcs::sparse::CpuCsrMatrix<T>& softmax,
+                             int64_t batch,
+                             int64_t row,
+                             const T* key,
+                             const T* value,
+                             const T* dout,
+                             int64_t head_dim,
+                             int64_t value_dim,
+                             T scale,
+                             T* dscore_values,
+                             T* dquery) {
+  using RowArray = Eigen::Array<T, 1, Eigen::Dynamic>;
+  int64_t M = softmax.rows;
+  int64_t row_begin = softmax.RowBegin(batch, row);
+  int64_t row_end = softmax.RowEnd(batch, row);
+  const T* dout_row = dout + (batch * M + row) * value_dim;
+  const T* k_batch = key + batch * M * head_dim;
+  const T* v_batch = value + batch * M * value_dim;
+
+  T mul_sum = 0;
+  for (int64_t p = row_begin; p < row_end; ++p) {
+    const T* v_row = v_batch + softmax.col_idx[p] * value_dim;
+    dscore_values[p] = funcs::sparse::SddmmDot(dout_row, v_row, value_dim);
+    mul_sum += dscore_values[p] * softmax.values[p];
+  }
+
+  Eigen::Map<RowArray> dq_row(dquery + (batch * M + row) * head_dim, head_dim);
+  dq_row.setZero();
+  for (int64_t p = row_begin; p < row_end; ++p) {
+    dscore_values[p] = (dscore_values[p] - mul_sum) * softmax.values[p] * scale;
+    if (dscore_values[p] != 0) {
+      dq_row += dscore_values[p] *
+                Eigen::Map<const RowArray>(
+                    k_batch + softmax.col_idx[p] * head_dim, head_dim);
+    }
+  }
+}
+
 template <typename T, typename Context>
 void FusedAttentionCsrGradKernel(const Context& dev_ctx,
                                  const DenseTensor& query,
@@ -30,9 +80,84 @@ void FusedAttentionCsrGradKernel(const Context& dev_ctx,
                                  DenseTensor* dquery,
                                  DenseTensor* dkey,
                                  DenseTensor* dvalue) {
-  PD_THROW(
-      "Not support CPU kernel of 'sparse.nn.functional.fused_attention' now");
+  auto q_dim = query.dims();
+  auto q_rank = q_dim.size();
+  int64_t M = q_dim[q_rank - 2];
+  int64_t N = q_dim[q_rank - 1];
+  int64_t value_dim = value.dims()[value.dims().size() - 1];
+  auto sparse_blas = phi::funcs::sparse::GetSparseBlas<Context, T>(dev_ctx);
+
+  /* Step1: dvalue{Dense} = softmax'{SparseCsr} * dout{Dense} */
+  if (dvalue) {
+    dvalue->Resize(value.dims());
+    dev_ctx.template Alloc<T>(dvalue);
+    sparse_blas.SPMM(true,
+                     false,
+                     static_cast<T>(1.f),
+                     softmax,
+                     dout,
+                     static_cast<T>(0.f),
+                     dvalue);
+  }
+
+  /* Step2: grad of the scaled scores and dquery, fused by rows */
+  SparseCsrTensor d_sdd_result;
+  EmptyLikeCsrKernel<T, Context>(dev_ctx, softmax, &d_sdd_result);
+  funcs::sparse::CpuCsrMatrix<T> softmax_mat;
+  funcs::sparse::MakeCpuCsrMatrix(softmax, &softmax_mat);
+
+  DenseTensor dquery_tmp;
+  DenseTensor* dquery_out = dquery ? dquery : &dquery_tmp;
+  dquery_out->Resize(query.dims());
+  dev_ctx.template Alloc<T>(dquery_out);
+
+  const T* k_data = key.data<T>();
+  const T* v_data = value.data<T>();
+  const T* dout_data = dout.data<T>();
+  T* dscore_values = d_sdd_result.mutable_values()->data<T>();
+  T* dquery_data = dquery_out->data<T>();
+  T scale = static_cast<T>(1 / std::sqrt(N));
+  int64_t total_row_num = softmax_mat.batch_size * M;
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+  for (int64_t r = 0; r < total_row_num; ++r) {
+    AttnCsrGradRowCPUKernel<T>(softmax_mat,
+                               r / M,
+                               r % M,
+                               k_data,
+                               v_data,
+                               dout_data,
+                               N,
+                               value_dim,
+                               scale,
+                               dscore_values,
+                               dquery_data);
+  }
+
+  /* Step3: dkey{Dense} = d_sdd_result'{SparseCsr} * query{Dense} */
+  if (dkey) {
+    dkey->Resize(key.dims());
+    dev_ctx.template Alloc<T>(dkey);
+    sparse_blas.SPMM(true,
+                     false,
+                     static_cast<T>(1.f),
+                     d_sdd_result,
+                     query,
+                     static_cast<T>(0.f),
+                     dkey);
+  }
 }
 
 }  // namespace sparse
 }  // namespace phi
+
+PD_REGISTER_KERNEL(fused_attention_csr_grad,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::sparse::FusedAttentionCsrGradKernel,
+                   float,
+                   double) {
+  kernel->InputAt(0).SetDataLayout(phi::DataLayout::SPARSE_CSR);
+}
@@ -14,12 +14,86 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/sparse/fused_attention_kernel.h"
 
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "Eigen/Core"
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/core/meta_tensor.h"
+#include "paddle/phi/kernels/funcs/sparse/sparse_blas.h"
+#include "paddle/phi/kernels/sparse/empty_kernel.h"
 
 namespace phi {
 namespace sparse {
 
+// Computes one row of the attention, only at the nonzero positions of the
+// mask: the scores of the row are kept in softmax, so neither the dense
+// [seq_len, seq_len] score matrix nor the SDDMM result is materialized.
+//   softmax[i, j] = softmax_j(scale * q[i] . k[j]),  j in mask row i
+//   out[i, :] = sum_j(softmax[i, j] * v[j, :])
+template <typename T>
+void AttnCsrRowCPUKernel(const funcs::sparse::CpuCsrMatrix<T>& mask,
+                         int64_t batch,
+                         int64_t row,
+                         const T* query,
+                         const T* key,
+                         const T* value,
+                         const T* kp_mask,
+                         const T* attn_mask,
+                         int64_t head_dim,
+                         int64_t value_dim,
+                         int num_heads,
+                         T scale,
+                         T* softmax_values,
+                         T* out) {
+  using RowArray = Eigen::Array<T, 1, Eigen::Dynamic>;
+  int64_t M = mask.rows;
+  int64_t row_begin = mask.RowBegin(batch, row);
+  int64_t row_end = mask.RowEnd(batch, row);
+  const T* q_row = query + (batch * M + row) * head_dim;
+  const T* k_batch = key + batch * M * head_dim;
+  const T* v_batch = value + batch * M * value_dim;
+
+  T max_val = -std::numeric_limits<T>::infinity();
+  for (int64_t p = row_begin; p < row_end; ++p) {
+    int64_t col = mask.col_idx[p];
+    bool masked =
+        (kp_mask != nullptr && kp_mask[(batch / num_heads) * M + col] == 0) ||
+        (attn_mask != nullptr && attn_mask[row * M + col] == 0);
+    if (masked) {
+      softmax_values[p] = -std::numeric_limits<T>::infinity();
+      continue;
+    }
+    const T* k_row = k_batch + col * head_dim;
+    T val = scale * funcs::sparse::SddmmDot(q_row, k_row, head_dim);
+    softmax_values[p] = val;
+    max_val = std::max(max_val, val);
+  }
+
+  Eigen::Map<RowArray> out_row(out + (batch * M + row) * value_dim, value_dim);
+  out_row.setZero();
+  // all the elements of the row are masked
+  if (max_val == -std::numeric_limits<T>::infinity()) {
+    std::fill(softmax_values + row_begin, softmax_values + row_end, 0);
+    return;
+  }
+  T exp_sum = 0;
+  for (int64_t p = row_begin; p < row_end; ++p) {
+    softmax_values[p] = std::exp(softmax_values[p] - max_val);
+    exp_sum += softmax_values[p];
+  }
+  for (int64_t p = row_begin; p < row_end; ++p) {
+    softmax_values[p] /= exp_sum;
+    if (softmax_values[p] != 0) {
+      out_row += softmax_values[p] *
+                 Eigen::Map<const RowArray>(
+                     v_batch + mask.col_idx[p] * value_dim, value_dim);
+    }
+  }
+}
+
 template <typename T, typename Context>
 void FusedAttentionCsrKernel(
     const Context& dev_ctx,
@@ -31,9 +105,139 @@ void FusedAttentionCsrKernel(
     const paddle::optional<DenseTensor>& attn_mask,
     DenseTensor* out,
     SparseCsrTensor* softmax) {
-  PD_THROW(
-      "Not support CPU kernel of 'sparse.nn.functional.fused_attention' now");
+  /* Check Shape */
+  auto q_dim = query.dims();
+  auto q_rank = q_dim.size();
+
+  PADDLE_ENFORCE_EQ(query.dims().size(),
+                    4,
+                    phi::errors::InvalidArgument(" 'query' must be 4D Tensor"));
+  PADDLE_ENFORCE_EQ(key.dims().size(),
+                    4,
+                    phi::errors::InvalidArgument(" 'key' must be 4D Tensor"));
+  PADDLE_ENFORCE_EQ(value.dims().size(),
+                    4,
+                    phi::errors::InvalidArgument(" 'value' must be 4D Tensor"));
+  PADDLE_ENFORCE_EQ(
+      key.dims(),
+      q_dim,
+      phi::errors::InvalidArgument("shape of 'key' must be equal to 'query'"));
+
+  int64_t M = q_dim[q_rank - 2];
+  int64_t N = q_dim[q_rank - 1];
+  PADDLE_ENFORCE_EQ(
+      sparse_mask.dims().size(),
+      3,
+      phi::errors::InvalidArgument("dense shape of 'sparse_mask' must be "
+                                   "[batch_size*num_heads, seq_len, seq_len]"));
+  PADDLE_ENFORCE_EQ(
+      sparse_mask.dims()[0],
+      q_dim[0] * q_dim[1],
+      phi::errors::InvalidArgument("dense shape of 'sparse_mask' must be "
+                                   "[batch_size*num_heads, seq_len, seq_len]"));
+  PADDLE_ENFORCE_EQ(
+      sparse_mask.dims()[1],
+      M,
+      phi::errors::InvalidArgument("dense shape of 'sparse_mask' must be "
+                                   "[batch_size*num_heads, seq_len, seq_len]"));
+  PADDLE_ENFORCE_EQ(
+      sparse_mask.dims()[2],
+      M,
+      phi::errors::InvalidArgument("dense shape of 'sparse_mask' must be "
+                                   "[batch_size*num_heads, seq_len, seq_len]"));
+  PADDLE_ENFORCE_EQ(
+      value.dims()[0] * value.dims()[1] * value.dims()[2],
+      q_dim[0] * q_dim[1] * M,
+      phi::errors::InvalidArgument("shape of 'value' must be "
+                                   "[batch_size, num_heads, seq_len, dim]"));
+
+  const auto kp_mask_ptr = key_padding_mask.get_ptr();
+  if (kp_mask_ptr) {
+    PADDLE_ENFORCE_EQ(
+        kp_mask_ptr->dims().size(),
+        2,
+        phi::errors::InvalidArgument(
+            "shape of 'key_padding_mask' must be [batch_size, seq_len]"));
+    PADDLE_ENFORCE_EQ(
+        kp_mask_ptr->dims()[0],
+        q_dim[0],
+        phi::errors::InvalidArgument(
+            "shape of 'key_padding_mask' must be [batch_size, seq_len]"));
+    PADDLE_ENFORCE_EQ(
+        kp_mask_ptr->dims()[1],
+        M,
+        phi::errors::InvalidArgument(
+            "shape of 'key_padding_mask' must be [batch_size, seq_len]"));
+  }
+
+  const auto attn_mask_ptr = attn_mask.get_ptr();
+  if (attn_mask_ptr) {
+    PADDLE_ENFORCE_EQ(attn_mask_ptr->dims().size(),
+                      2,
+                      phi::errors::InvalidArgument(
+                          "shape of 'attn_mask' must be [seq_len, seq_len]"));
+    PADDLE_ENFORCE_EQ(attn_mask_ptr->dims()[0],
+                      M,
+                      phi::errors::InvalidArgument(
+                          "shape of 'attn_mask' must be [seq_len, seq_len]"));
+    PADDLE_ENFORCE_EQ(attn_mask_ptr->dims()[1],
+                      M,
+                      phi::errors::InvalidArgument(
+                          "shape of 'attn_mask' must be [seq_len, seq_len]"));
+  }
+
+  // InferMeta of SparseCsrTensor 'softmax', CreateLikeInferMeta
+  EmptyLikeCsrKernel<T, Context>(dev_ctx, sparse_mask, softmax);
+  softmax->set_dims(phi::make_ddim({q_dim[0], q_dim[1], M, M}));
+  funcs::sparse::CpuCsrMatrix<T> mask;
+  funcs::sparse::MakeCpuCsrMatrix(*softmax, &mask);
+
+  // InferMeta of DenseTensor 'out'
+  int64_t value_dim = value.dims()[3];
+  MetaTensor meta_out(out);
+  meta_out.set_dims(phi::make_ddim({q_dim[0], q_dim[1], M, value_dim}));
+  meta_out.set_dtype(value.dtype());
+  T* out_data = dev_ctx.template Alloc<T>(out);
+
+  const T* q_data = query.data<T>();
+  const T* k_data = key.data<T>();
+  const T* v_data = value.data<T>();
+  const T* kp_mask_data = kp_mask_ptr ? kp_mask_ptr->data<T>() : nullptr;
+  const T* attn_mask_data = attn_mask_ptr ? attn_mask_ptr->data<T>() : nullptr;
+  T* softmax_values = softmax->mutable_values()->data<T>();
+  int num_heads = q_dim[1];
+  T scale = static_cast<T>(1 / std::sqrt(N));
+  int64_t total_row_num = mask.batch_size * M;
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+  for (int64_t r = 0; r < total_row_num; ++r) {
+    AttnCsrRowCPUKernel<T>(mask,
+                           r / M,
+                           r % M,
+                           q_data,
+                           k_data,
+                           v_data,
+                           kp_mask_data,
+                           attn_mask_data,
+                           N,
+                           value_dim,
+                           num_heads,
+                           scale,
+                           softmax_values,
+                           out_data);
+  }
 }
 
 }  // namespace sparse
 }  // namespace phi
+
+PD_REGISTER_KERNEL(fused_attention_csr,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::sparse::FusedAttentionCsrKernel,
+                   float,
+                   double) {
+  kernel->InputAt(0).SetDataLayout(phi::DataLayout::SPARSE_CSR);
+}
@@ -19,11 +19,14 @@ namespace phi {
 KernelSignature SaveCombineOpArgumentMapping(
     const ArgumentMappingContext& ctx) {
   if (ctx.IsDenseTensorInputs("X")) {
-    return KernelSignature(
-        "save_combine_tensor",
-        {"X"},
-        {"file_path", "overwrite", "save_as_fp16", "save_to_memory"},
-        {"Y"});
+    return KernelSignature("save_combine_tensor",
+                           {"X"},
+                           {"file_path",
+                            "overwrite",
+                            "save_as_fp16",
+                            "save_to_memory",
+                            "save_aligned"},
+                           {"Y"});
   } else {
     return KernelSignature(
         "save_combine_vocab",
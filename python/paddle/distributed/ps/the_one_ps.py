@@ -771,6 +771,10 @@ class SparseTable(Table):
             table_proto.enable_revert = usr_table_proto.enable_revert
         if usr_table_proto.HasField("shard_merge_rate"):
             table_proto.shard_merge_rate = usr_table_proto.shard_merge_rate
+        if usr_table_proto.HasField("enable_binary_save"):
+            table_proto.enable_binary_save = usr_table_proto.enable_binary_save
+        if usr_table_proto.HasField("push_quant_type"):
+            table_proto.push_quant_type = usr_table_proto.push_quant_type
 
         if usr_table_proto.accessor.ByteSize() == 0:
             warnings.warn(
@@ -228,6 +228,67 @@ class TestProcessGroupFp32(unittest.TestCase):
         test_gather(pg.size() - 1)
         print("test gather api ok\n")
 
+        # test reduce_scatter
+        x = np.random.random(in_shape).astype(self.dtype)
+        y = np.random.random(in_shape).astype(self.dtype)
+        tensor_x = paddle.to_tensor(x)
+        tensor_y = paddle.to_tensor(y)
+        tensor_out = paddle.zeros(self.shape, self.dtype)
+        sum_result = paddle.split(tensor_x + tensor_y, pg.size(), axis=0)
+        if pg.rank() == 0:
+            task = pg.reduce_scatter_tensor(
+                tensor_out, tensor_x, core.ReduceOp.SUM, True
+            )
+        else:
+            task = pg.reduce_scatter_tensor(
+                tensor_out, tensor_y, core.ReduceOp.SUM, True
+            )
+        task.wait()
+        np.testing.assert_allclose(tensor_out, sum_result[pg.rank()])
+        print("test reduce_scatter api ok\n")
+
+        # test all_to_all
+        x = np.random.random(in_shape).astype(self.dtype)
+        y = np.random.random(in_shape).astype(self.dtype)
+        tensor_x = paddle.to_tensor(x)
+        tensor_y = paddle.to_tensor(y)
+        tensor_out = paddle.zeros(in_shape, self.dtype)
+        x_1, x_2 = paddle.split(tensor_x, 2, axis=0)
+        y_1, y_2 = paddle.split(tensor_y, 2, axis=0)
+        if pg.rank() == 0:
+            task = pg.all_to_all_tensor(tensor_out, tensor_x, True)
+            task.wait()
+            assert np.array_equal(tensor_out, paddle.concat([x_1, y_1]))
+        else:
+            task = pg.all_to_all_tensor(tensor_out, tensor_y, True)
+            task.wait()
+            assert np.array_equal(tensor_out, paddle.concat([x_2, y_2]))
+        print("test all_to_all api ok\n")
+
+        # test all_reduce_coalesced, the small bucket_size splits the
+        # tensors into several buckets
+        shapes = [(3,), (2, 5), (4, 1), (7,)]
+        dtypes = [self.dtype, self.dtype, "int64", self.dtype]
+        xs = [
+            np.random.randint(0, 10, shape).astype(dtype)
+            for shape, dtype in zip(shapes, dtypes)
+        ]
+        ys = [
+            np.random.randint(0, 10, shape).astype(dtype)
+            for shape, dtype in zip(shapes, dtypes)
+        ]
+        tensors = [
+            paddle.to_tensor(x if pg.rank() == 0 else y)
+            for x, y in zip(xs, ys)
+        ]
+        task = pg.all_reduce_coalesced(
+            tensors, core.ReduceOp.SUM, bucket_size=64
+        )
+        task.wait()
+        for tensor, x, y in zip(tensors, xs, ys):
+            np.testing.assert_array_equal(tensor, x + y)
+        print("test all_reduce_coalesced api ok\n")
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -279,5 +279,91 @@ class TestFlashAttentionAPITest4(TestFlashAttentionAPI):
         self.return_softmax = False
 
 
+
+class TestFlashAttentionCPU(unittest.TestCase):
+    def setUp(self):
+        self.place = paddle.CPUPlace()
+        self.shape = (2, 100, 4, 16)
+        self.dtype = 'float32'
+        self.causal = False
+
+    def naive(self, q, k, v):
+        qt = paddle.transpose(q, [0, 2, 1, 3])
+        kt = paddle.transpose(k, [0, 2, 1, 3])
+        vt = paddle.transpose(v, [0, 2, 1, 3])
+        scale = 1.0 / np.sqrt(q.shape[-1])
+        s = paddle.matmul(qt, kt, transpose_y=True)
+        s = paddle.scale(s, scale)
+        if self.causal:
+            mask = paddle.triu(
+                paddle.full(s.shape[-2:], -np.inf, dtype=self.dtype), 1
+            )
+            s = s + mask
+        o = paddle.matmul(F.softmax(s), vt)
+        return paddle.transpose(o, [0, 2, 1, 3])
+
+    def to_tensors(self, *arrays):
+        return [
+            paddle.to_tensor(
+                a, place=self.place, dtype=self.dtype, stop_gradient=False
+            )
+            for a in arrays
+        ]
+
+    def test_all(self):
+        paddle.disable_static()
+
+        query = np.random.random(self.shape)
+        key = np.random.random(self.shape)
+        value = np.random.random(self.shape)
+        q, k, v = self.to_tensors(query, key, value)
+        q_, k_, v_ = self.to_tensors(query, key, value)
+
+        out, _ = flash_attention(q, k, v, 0.0, self.causal, False)
+        out_ = self.naive(q_, k_, v_)
+        np.testing.assert_allclose(out.numpy(), out_, rtol=1e-05, atol=1e-06)
+
+        out.backward()
+        out_.backward()
+        for x, x_ in [(q, q_), (k, k_), (v, v_)]:
+            np.testing.assert_allclose(
+                x.grad.numpy(), x_.grad.numpy(), rtol=1e-05, atol=1e-06
+            )
+
+    def test_unpadded(self):
+        paddle.disable_static()
+
+        bs, ms, nh, hd = self.shape
+        query = np.random.random(self.shape)
+        (q,) = self.to_tensors(query)
+        (q_,) = self.to_tensors(query)
+
+        cu_q = paddle.arange(0, (bs + 1) * ms, ms, dtype='int32')
+        qq = paddle.reshape(q, [bs * ms, nh, hd])
+        scale = 1.0 / np.sqrt(hd)
+        out, softmax = flash_attn_unpadded(
+            qq, qq, qq, cu_q, cu_q, ms, ms, scale, 0.0, self.causal, True
+        )
+        out_ = paddle.reshape(self.naive(q_, q_, q_), [bs * ms, nh, hd])
+        np.testing.assert_allclose(out.numpy(), out_, rtol=1e-05, atol=1e-06)
+        np.testing.assert_allclose(
+            softmax.numpy().sum(-1), np.ones([bs, nh, ms]), rtol=1e-05
+        )
+
+        out.backward()
+        out_.backward()
+        np.testing.assert_allclose(
+            q.grad.numpy(), q_.grad.numpy(), rtol=1e-05, atol=1e-06
+        )
+
+
+class TestFlashAttentionCPUCausal(TestFlashAttentionCPU):
+    def setUp(self):
+        self.place = paddle.CPUPlace()
+        self.shape = (2, 150, 4, 16)
+        self.dtype = 'float32'
+        self.causal = True
+
+
 if __name__ == '__main__':
     unittest.main()
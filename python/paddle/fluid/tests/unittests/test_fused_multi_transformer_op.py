@@ -47,7 +47,10 @@ class TestFusedMultiTransformerOp(OpTest):
         #  changed back after the precision problem is solved.
         self.atol = 1e-2
         # make sure local development precision
-        if "V100" in paddle.device.cuda.get_device_name():
+        if (
+            not isinstance(self.place, paddle.CUDAPlace)
+            or "V100" in paddle.device.cuda.get_device_name()
+        ):
             self.atol = 1e-4
         if self.x_type is np.float16:
             self.atol = 1e-1
@@ -112,6 +115,8 @@ class TestFusedMultiTransformerOp(OpTest):
         # for debug
         self.debug = False
 
+        self.place = paddle.CUDAPlace(0)
+
         self.x_type = np.float32
         self.attn_mask_type = np.float64
         # self.attn_mask_type = np.bool_
@@ -190,7 +195,7 @@ class TestFusedMultiTransformerOp(OpTest):
                     for _ in range(self.batch_size)
                 ]
                 self.seq_lens[
-                    random.randint(0, self.batch_size)
+                    random.randint(0, self.batch_size - 1)
                 ] = self.cache_length
                 self.seq_lens = np.array(self.seq_lens).astype(np.int32)
             else:
@@ -199,7 +204,7 @@ class TestFusedMultiTransformerOp(OpTest):
                     for _ in range(self.batch_size)
                 ]
                 self.seq_lens[
-                    random.randint(0, self.batch_size)
+                    random.randint(0, self.batch_size - 1)
                 ] = self.query_length
                 self.seq_lens = np.array(self.seq_lens).astype(np.int32)
 
@@ -291,7 +296,7 @@ class TestFusedMultiTransformerOp(OpTest):
         return paddle.concat(rotary_dims, axis=-1)
 
     def GetBaselineOut(self):
-        paddle.disable_static(place=paddle.CUDAPlace(0))
+        paddle.disable_static(place=self.place)
         tensor_query = paddle.to_tensor(self.query, stop_gradient=False)
 
         cache_kvs = []
@@ -435,7 +440,7 @@ class TestFusedMultiTransformerOp(OpTest):
         return final_out
 
     def GetVariableDecoderBaselineOut(self):
-        paddle.disable_static(place=paddle.CUDAPlace(0))
+        paddle.disable_static(place=self.place)
         final_outs = []
         cache_outs = []
         if self.rotary_emb_dims > 0:
@@ -567,7 +572,7 @@ class TestFusedMultiTransformerOp(OpTest):
         return final_out, cache_outs
 
     def GetFusedMultiTransformerOut(self):
-        paddle.disable_static(place=paddle.CUDAPlace(0))
+        paddle.disable_static(place=self.place)
         q_proj_weight = paddle.to_tensor(
             self.q_proj.weight, stop_gradient=False
         )
@@ -982,7 +987,7 @@ class TestFusedMultiTransformerOp(OpTest):
             rotary_emb_dims=self.rotary_emb_dims,
             time_step=time_step,
         )
-        exe = paddle.static.Executor(place=paddle.CUDAPlace(0))
+        exe = paddle.static.Executor(place=self.place)
         exe.run(paddle.static.default_startup_program())
         feed_data = {
             'x': self.query,
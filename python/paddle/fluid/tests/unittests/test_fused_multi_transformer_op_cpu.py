@@ -0,0 +1,104 @@
+# Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import unittest
+
+# import the module rather than the class, so the CUDA cases are not
+# collected here.
+import test_fused_multi_transformer_op as base
+
+import paddle
+
+
+class TestFusedMultiTransformerOpCPU(base.TestFusedMultiTransformerOp):
+    def config(self):
+        super().config()
+        self.place = paddle.CPUPlace()
+        self.layers = 2
+        self.batch_size = 4
+        self.query_length = 32
+        self.cache_length = 32
+        self.pre_cache_num = 16
+        self.head_dim = 16
+        self.num_heads = 4
+        self.embed_dim = self.head_dim * self.num_heads
+        self.kdim, self.vdim = self.embed_dim, self.embed_dim
+        self.key_length, self.value_length = (
+            self.query_length,
+            self.query_length,
+        )
+
+
+class TestFusedMultiTransformerOpCPUPostLayerNormRelu(
+    TestFusedMultiTransformerOpCPU
+):
+    def config(self):
+        super().config()
+        self.pre_layer_norm = False
+        self.act_method = "relu"
+
+
+class TestFusedMultiTransformerOpCPURotary(TestFusedMultiTransformerOpCPU):
+    def config(self):
+        super().config()
+        self.rotary_emb_dims = 2
+
+
+class TestFusedMultiTransformerOpCPUPreCache(TestFusedMultiTransformerOpCPU):
+    def config(self):
+        super().config()
+        self.has_pre_cache = True
+
+
+class TestFusedMultiTransformerOpCPUGenCacheKV(TestFusedMultiTransformerOpCPU):
+    def config(self):
+        super().config()
+        self.has_cache_kv = True
+        self.gen_cache_kv = True
+        self.rotary_emb_dims = 1
+
+
+class TestFusedMultiTransformerOpCPUCacheKV(TestFusedMultiTransformerOpCPU):
+    def config(self):
+        super().config()
+        self.has_cache_kv = True
+        self.query_length = 1
+        self.key_length, self.value_length = 1, 1
+        self.rotary_emb_dims = 1
+
+
+class TestFusedMultiTransformerOpCPUVariableGenCache(
+    TestFusedMultiTransformerOpCPU
+):
+    def config(self):
+        super().config()
+        self.has_cache_kv = True
+        self.gen_cache_kv = True
+        self.remove_padding = True
+
+
+class TestFusedMultiTransformerOpCPUVariableDecoder(
+    TestFusedMultiTransformerOpCPU
+):
+    def config(self):
+        super().config()
+        self.has_cache_kv = True
+        self.remove_padding = True
+        self.query_length = 1
+        self.key_length, self.value_length = 1, 1
+        self.pre_layer_norm = False
+
+
+if __name__ == "__main__":
+    unittest.main()
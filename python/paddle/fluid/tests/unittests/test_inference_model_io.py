@@ -530,6 +530,61 @@ class TestSaveInferenceModelNew(unittest.TestCase):
         )
 
 
+class TestSaveAlignedInferenceModel(unittest.TestCase):
+    def test_save_and_load_aligned(self):
+        root_path = tempfile.TemporaryDirectory()
+        path_prefix = os.path.join(root_path.name, "aligned_model")
+        init_program = Program()
+        program = Program()
+        with program_guard(program, init_program):
+            x = paddle.static.data(name='x', shape=[-1, 2], dtype='float32')
+            y_predict = paddle.static.nn.fc(x, size=3, activation=None)
+
+        place = core.CPUPlace()
+        exe = executor.Executor(place)
+        exe.run(init_program, feed={}, fetch_list=[])
+        tensor_x = np.array([[1, 1], [1, 2], [5, 2]]).astype("float32")
+        [expected] = exe.run(
+            program, feed={'x': tensor_x}, fetch_list=[y_predict]
+        )
+
+        paddle.static.save_inference_model(
+            path_prefix,
+            [x],
+            [y_predict],
+            exe,
+            program=program,
+            save_aligned=True,
+        )
+        with open(path_prefix + ".pdiparams", 'rb') as f:
+            self.assertEqual(f.read(4), b'DPAL')
+        [
+            infer_program,
+            feed_target_names,
+            fetch_targets,
+        ] = paddle.static.load_inference_model(path_prefix, exe)
+        [actual] = exe.run(
+            infer_program,
+            feed={feed_target_names[0]: tensor_x},
+            fetch_list=fetch_targets,
+        )
+        np.testing.assert_allclose(actual, expected)
+
+        # the aligned layout is only saved to a single file
+        self.assertRaises(
+            ValueError,
+            paddle.static.save_vars,
+            exe,
+            root_path.name,
+            program,
+            None,
+            paddle.static.is_persistable,
+            None,
+            True,
+        )
+        root_path.cleanup()
+
+
 class TestLoadInferenceModelError(unittest.TestCase):
     def test_load_model_not_exist(self):
         place = core.CPUPlace()
@@ -172,5 +172,30 @@ class TestSparseAttentionAPI5(TestSparseAttentionAPI1):
         self.use_mask = True
 
 
+class TestSparseAttentionAPICPU1(unittest.TestCase):
+    def setUp(self):
+        self.batch_size = 4
+        self.num_heads = 4
+        self.seq_len = 128
+        self.head_dim = 16
+        self.dtype = 'float64'
+        self.use_mask = True
+        self.origin_device = paddle.device.get_device()
+        paddle.set_device('cpu')
+
+    def tearDown(self):
+        paddle.set_device(self.origin_device)
+
+    def test_dygraph(self):
+        TestSparseAttentionAPI1.test_dygraph(self)
+
+
+class TestSparseAttentionAPICPU2(TestSparseAttentionAPICPU1):
+    def setUp(self):
+        super().setUp()
+        self.head_dim = 32
+        self.use_mask = False
+
+
 if __name__ == '__main__':
     unittest.main()
@@ -64,7 +64,7 @@ class TestMatmul(unittest.TestCase):
         np.testing.assert_allclose(
             sp_out.numpy(), dense_out.numpy(), rtol=1e-05
         )
-        if get_cuda_version() >= 11030:
+        if paddle.device.get_device() == 'cpu' or get_cuda_version() >= 11030:
             dense_out.backward()
             sp_out.backward()
             np.testing.assert_allclose(
@@ -92,14 +92,19 @@ class TestMatmul(unittest.TestCase):
         self.check_result([8, 16, 12], [8, 12, 10], 'coo')
         self.check_result([8, 16, 12], [8, 12, 10], 'csr')
 
+    def test_matmul_cpu(self):
+        origin_device = paddle.device.get_device()
+        paddle.set_device('cpu')
+        self.check_result([16, 12], [12, 10], 'coo')
+        self.check_result([16, 12], [12, 10], 'csr')
+        self.check_result([8, 16, 12], [8, 12, 10], 'coo')
+        self.check_result([8, 16, 12], [8, 12, 10], 'csr')
+        paddle.set_device(origin_device)
+
 
 class TestMaskedMatmul(unittest.TestCase):
     # x: dense, y: dense, out: sparse_`csr
-    @unittest.skipIf(
-        not paddle.is_compiled_with_cuda() or get_cuda_version() < 11030,
-        "only support on cuda>=11.3",
-    )
-    def test_masked_matmul_2d(self):
+    def check_masked_matmul_2d(self):
         np_mask = np.random.rand(10, 6) < 0.2
 
         np_x = np.random.rand(10, 12)
@@ -132,6 +137,19 @@ class TestMaskedMatmul(unittest.TestCase):
         np.testing.assert_allclose(np_x_grad, x.grad.numpy(), rtol=1e-05)
         np.testing.assert_allclose(np_y_grad, y.grad.numpy(), rtol=1e-05)
 
+    @unittest.skipIf(
+        not paddle.is_compiled_with_cuda() or get_cuda_version() < 11030,
+        "only support on cuda>=11.3",
+    )
+    def test_masked_matmul_2d(self):
+        self.check_masked_matmul_2d()
+
+    def test_masked_matmul_cpu(self):
+        origin_device = paddle.device.get_device()
+        paddle.set_device('cpu')
+        self.check_masked_matmul_2d()
+        paddle.set_device(origin_device)
+
     @unittest.skipIf(
         not paddle.is_compiled_with_cuda() or get_cuda_version() < 11080,
         "only support on cuda>=11.8",
@@ -354,9 +354,11 @@ def serialize_persistables(feed_vars, fetch_vars, executor, **kwargs):
     return _serialize_persistables(program, executor)
 
 
-def _serialize_persistables(program, executor):
+def _serialize_persistables(program, executor, aligned_path=None):
     """
-    Serialize parameters using given program and executor.
+    Serialize parameters using given program and executor. If aligned_path is
+    given, the parameters are saved to it in the aligned layout, which
+    load_combine maps from the file instead of copying, and None is returned.
     """
     vars_ = list(filter(is_persistable, program.list_vars()))
     # warn if no variable found in model
@@ -385,11 +387,15 @@ def _serialize_persistables(program, executor):
         type=core.VarDesc.VarType.RAW, name=out_var_name
     )
     out_var.desc.set_persistable(True)
+    if aligned_path is None:
+        attrs = {'file_path': '', 'save_to_memory': True}
+    else:
+        attrs = {'file_path': aligned_path, 'save_aligned': True}
     save_block.append_op(
         type='save_combine',
         inputs={'X': in_vars},
         outputs={'Y': out_var},
-        attrs={'file_path': '', 'save_to_memory': True},
+        attrs=attrs,
     )
     # run save_program to save vars
     # NOTE(zhiqiu): save op will add variable kLookupTablePath to save_program.desc,
@@ -397,6 +403,8 @@ def _serialize_persistables(program, executor):
     # to keep consistency.
     save_program._sync_with_cpp()
     executor.run(save_program)
+    if aligned_path is not None:
+        return None
     # return serialized bytes in out_var
     return global_scope().find_var(out_var_name).get_bytes()
 
@@ -463,6 +471,8 @@ def save_inference_model(
 
             - legacy_format(bool): whether to save inference model in legacy format. Default: False.
 
+            - save_aligned(bool): whether to save the parameters in the aligned layout, which is mapped from the file instead of copied when loaded on CPU. Default: False.
+
     Returns:
         None
 
@@ -528,6 +538,10 @@ def save_inference_model(
         legacy_format=legacy_format,
     )
     save_to_file(model_path, program_bytes)
+    if kwargs.get('save_aligned', False):
+        # the aligned layout is written by save_combine to the file directly
+        _serialize_persistables(program, executor, aligned_path=params_path)
+        return
     # serialize and save params
     params_bytes = _serialize_persistables(program, executor)
     # program may not contain any parameter and just compute operation
@@ -622,6 +636,14 @@ def deserialize_persistables(program, data, executor):
             deserialized_params = paddle.static.deserialize_persistables(main_program, serialized_params, exe)
 
 
+    """
+    return _deserialize_persistables(program, data, executor)
+
+
+def _deserialize_persistables(program, data, executor, from_file=False):
+    """
+    Deserialize parameters from data, or from the file whose path is data if
+    from_file.
     """
     if not isinstance(program, Program):
         raise TypeError(
@@ -665,7 +687,7 @@ def deserialize_persistables(program, data, executor):
         inputs={},
         outputs={"Out": load_var_list},
         # if load from memory, file_path is data
-        attrs={'file_path': data, 'model_from_memory': True},
+        attrs={'file_path': data, 'model_from_memory': not from_file},
     )
     executor.run(load_program)
     # check var shape
@@ -723,6 +745,15 @@ def load_from_file(path):
     return data
 
 
+def _is_aligned_params_file(path):
+    """
+    Whether the parameters file at path is saved in the aligned layout, whose
+    first word is kAlignedTensorVersion.
+    """
+    with open(path, 'rb') as f:
+        return f.read(4) == b'DPAL'
+
+
 @static_only
 def load_inference_model(path_prefix, executor, **kwargs):
     """
@@ -807,6 +838,7 @@ def load_inference_model(path_prefix, executor, **kwargs):
         load_dirname = ''
         program_bytes = model_filename
         params_bytes = params_filename
+        params_aligned = False
     # load from file
     else:
         # check and norm path_prefix
@@ -852,13 +884,22 @@ def load_inference_model(path_prefix, executor, **kwargs):
         # load params data
         params_path = os.path.join(load_dirname, params_filename)
         params_bytes = None
+        params_aligned = False
         if os.path.exists(params_path):
-            params_bytes = load_from_file(params_path)
+            params_aligned = _is_aligned_params_file(params_path)
+            if not params_aligned:
+                params_bytes = load_from_file(params_path)
 
     # deserialize bytes to program
     program = deserialize_program(program_bytes)
-    # deserialize bytes to params
-    deserialize_persistables(program, params_bytes, executor)
+    if params_aligned:
+        # load_combine maps the aligned layout from the file
+        _deserialize_persistables(
+            program, params_path, executor, from_file=True
+        )
+    else:
+        # deserialize bytes to params
+        deserialize_persistables(program, params_bytes, executor)
 
     feed_target_names = program.desc.get_feed_target_names()
     fetch_target_names = program.desc.get_fetch_target_names()
@@ -877,6 +918,7 @@ def save_vars(
     vars=None,
     predicate=None,
     filename=None,
+    save_aligned=False,
 ):
     """
     Save specific variables in the `Program` to files.
@@ -906,6 +948,11 @@ def save_vars(
         filename(str, optional): If you prefer to save all variables in a single file,
                                  use `filename` to specify it. Otherwise, let `filename` be None.
                                  Default: None
+        save_aligned(bool, optional): Whether to save the variables in the aligned layout,
+                                 which is mapped from the file instead of copied when loaded
+                                 on CPU. It requires `filename`, and can not be used to save
+                                 to memory.
+                                 Default: False
 
     Returns:
         str: When saving parameters to a file, returns None.
@@ -913,6 +960,7 @@ def save_vars(
 
     Raises:
         TypeError: If `main_program` is not an instance of Program nor None.
+        ValueError: If `save_aligned` is set without `filename`.
 
     Examples:
         .. code-block:: python
@@ -951,6 +999,11 @@ def save_vars(
     save_to_memory = False
     if dirname is None and filename is None:
         save_to_memory = True
+    if save_aligned and filename is None:
+        raise ValueError(
+            "save_aligned requires filename, the aligned layout is only "
+            "saved to a single file."
+        )
 
     main_program = paddle.static.io._get_valid_program(main_program)
 
@@ -961,6 +1014,7 @@ def save_vars(
             dirname=dirname,
             vars=list(filter(predicate, main_program.list_vars())),
             filename=filename,
+            save_aligned=save_aligned,
         )
     else:
         params_var_name = "saved_params"
@@ -1013,6 +1067,7 @@ def save_vars(
                 attrs={
                     'file_path': save_path,
                     'save_to_memory': save_to_memory,
+                    'save_aligned': save_aligned,
                 },
             )
 
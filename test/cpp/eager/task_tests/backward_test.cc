@@ -32,6 +32,9 @@
 PD_DECLARE_KERNEL(full, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
 
+DECLARE_int32(eager_backward_num_threads);
+DECLARE_bool(eager_backward_deterministic);
+
 namespace egr {
 
 TEST(Backward, SingleNodeEmptyGrad) {
@@ -343,4 +346,76 @@ TEST(Backward, WithAccumulation) {
   eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 2500.0);
 }
 
+TEST(Backward, MultiThreadWideGraph) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+  FLAGS_eager_backward_num_threads = 4;
+  FLAGS_eager_backward_deterministic = true;
+
+  // Prepare Inputs
+  paddle::framework::DDim ddim = phi::make_ddim({4, 16, 16, 32});
+  const int num_branches = 8;
+
+  // Branch i: target_tensors[i] -> Node(scale=i+1) -> Node(scale=2) -> Leaf
+  std::vector<paddle::Tensor> target_tensors;
+  for (int i = 0; i < num_branches; i++) {
+    target_tensors.emplace_back(
+        egr_utils_api::CreateTensorWithValue(ddim,
+                                             paddle::platform::CPUPlace(),
+                                             phi::DataType::FLOAT32,
+                                             phi::DataLayout::NCHW,
+                                             1.0 /*value*/,
+                                             false /*is_leaf*/));
+  }
+
+  paddle::Tensor leaf_tensor;
+  {
+    // Create the node shared by all branches
+    auto node_join_ptr = std::make_shared<GradNodeScale>(1, 1);
+    node_join_ptr->SetAttributes_scale(2.0 /*scale*/);
+    node_join_ptr->SetDefaultGradInOutMeta();
+
+    for (int i = 0; i < num_branches; i++) {
+      auto node_ptr = std::make_shared<GradNodeScale>(1, 1);
+      node_ptr->SetAttributes_scale(i + 1.0 /*scale*/);
+      node_ptr->SetDefaultGradInOutMeta();
+
+      // Connect target_tensors[i] and Node via AutoGradMeta
+      AutogradMeta* auto_grad_meta =
+          EagerUtils::autograd_meta(&(target_tensors[i]));
+      auto_grad_meta->SetGradNode(
+          std::dynamic_pointer_cast<GradNodeBase>(node_ptr));
+      auto_grad_meta->SetSingleOutRankWithSlot(0, 0);
+      auto_grad_meta->SetStopGradient(false);
+
+      // Connect Node -> NodeJoin via Edge
+      auto tmp_tensor = paddle::Tensor();
+      auto* meta = EagerUtils::autograd_meta(&tmp_tensor);
+      meta->SetStopGradient(false);
+      meta->SetSingleOutRankWithSlot(0, 0);
+      meta->SetGradNode(node_join_ptr);
+      node_ptr->SetGradOutMeta(tmp_tensor, 0);
+    }
+
+    AutogradMeta* auto_grad_meta_leaf =
+        EagerUtils::autograd_meta(&leaf_tensor);
+    // Connect Tensor and AccumulationNode via AutoGradMeta
+    auto acc_node_ptr =
+        std::make_shared<egr::GradNodeAccumulation>(auto_grad_meta_leaf);
+
+    auto_grad_meta_leaf->SetGradNode(
+        std::dynamic_pointer_cast<GradNodeBase>(acc_node_ptr));
+    auto_grad_meta_leaf->SetSingleOutRankWithSlot(0, 0);
+    auto_grad_meta_leaf->SetStopGradient(false);
+    node_join_ptr->SetGradOutMeta(leaf_tensor, 0);
+  }
+
+  Backward(target_tensors, {});
+  FLAGS_eager_backward_num_threads = 0;
+  FLAGS_eager_backward_deterministic = false;
+
+  // 2 * (1 + 2 + ... + 8)
+  eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 72.0);
+}
+
 }  // namespace egr
@@ -20,6 +20,8 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <functional>
+#include <numeric>
 #include <thread>  // NOLINT
 
 #include "paddle/fluid/framework/ir/pass.h"
@@ -467,6 +469,131 @@ TEST(Predictor, Run) {
   predictor->TryShrinkMemory();
 }
 
+// Runs batches of growing and shrinking sizes, so that the arena is planned
+// again when the vars outgrow their slots.
+static std::vector<std::vector<float>> RunMemoryOptimPredictor(bool arena) {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  config.EnableMemoryOptim();
+  config.EnableMemoryOptimArena(arena);
+  auto predictor = CreatePredictor(config);
+  std::vector<std::vector<float>> outputs;
+  for (int batch : {2, 8, 4, 16}) {
+    for (auto& name : predictor->GetInputNames()) {
+      auto input = predictor->GetInputHandle(name);
+      std::vector<int64_t> data(batch);
+      for (int i = 0; i < batch; i++) {
+        data[i] = (i * 7 + name.size()) % 100;
+      }
+      input->Reshape({batch, 1});
+      input->CopyFromCpu(data.data());
+    }
+    EXPECT_TRUE(predictor->Run());
+    auto out = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+    auto shape = out->shape();
+    std::vector<float> out_data(std::accumulate(
+        shape.begin(), shape.end(), 1, std::multiplies<int>()));
+    out->CopyToCpu(out_data.data());
+    outputs.push_back(out_data);
+  }
+  return outputs;
+}
+
+TEST(Predictor, MemoryOptimArena) {
+  auto expect = RunMemoryOptimPredictor(false);
+  auto outputs = RunMemoryOptimPredictor(true);
+  ASSERT_EQ(outputs.size(), expect.size());
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    ASSERT_EQ(outputs[i].size(), expect[i].size());
+    for (size_t j = 0; j < outputs[i].size(); ++j) {
+      EXPECT_NEAR(outputs[i][j], expect[i][j], 1e-6);
+    }
+  }
+}
+
+TEST(Predictor, BatchingPredictor) {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  auto predictor = CreatePredictor(config);
+  auto output_names = predictor->GetOutputNames();
+  ASSERT_EQ(output_names.size(), 1UL);
+
+  services::BatchingPredictor::Options options;
+  options.max_batch_size = 8;
+  options.batch_timeout_us = 10000;
+  options.num_workers = 2;
+  services::BatchingPredictor batching_predictor(config, options);
+  ASSERT_EQ(batching_predictor.GetOutputNames(), output_names);
+
+  auto make_request = [](int rows, int64_t base) {
+    std::vector<services::BatchingPredictor::HostTensor> inputs;
+    for (auto name : {"firstw", "secondw", "thirdw", "forthw"}) {
+      services::BatchingPredictor::HostTensor t;
+      t.name = name;
+      t.shape = {rows, 1};
+      t.dtype = DataType::INT64;
+      t.data.resize(rows * sizeof(int64_t));
+      auto* data = reinterpret_cast<int64_t*>(t.data.data());
+      for (int i = 0; i < rows; i++) {
+        data[i] = base + i;
+      }
+      inputs.emplace_back(std::move(t));
+    }
+    return inputs;
+  };
+
+  const int num_threads = 6;
+  std::vector<std::vector<float>> expected(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    auto inputs = make_request(i % 3 + 1, i);
+    for (auto& input : inputs) {
+      auto handle = predictor->GetInputHandle(input.name);
+      handle->Reshape(input.shape);
+      handle->CopyFromCpu(reinterpret_cast<int64_t*>(input.data.data()));
+    }
+    ASSERT_TRUE(predictor->Run());
+    auto out = predictor->GetOutputHandle(output_names[0]);
+    auto shape = out->shape();
+    int numel = std::accumulate(
+        shape.begin(), shape.end(), 1, std::multiplies<int>());
+    expected[i].resize(numel);
+    out->CopyToCpu(expected[i].data());
+  }
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      auto outputs = batching_predictor.Run(make_request(i % 3 + 1, i)).get();
+      ASSERT_EQ(outputs.size(), 1UL);
+      ASSERT_EQ(outputs[0].shape[0], i % 3 + 1);
+      ASSERT_EQ(outputs[0].data.size(), expected[i].size() * sizeof(float));
+      auto* data = reinterpret_cast<float*>(outputs[0].data.data());
+      for (size_t j = 0; j < expected[i].size(); j++) {
+        EXPECT_NEAR(data[j], expected[i][j], 1e-5);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  auto stats = batching_predictor.GetStats();
+  ASSERT_EQ(stats.num_requests, static_cast<uint64_t>(num_threads));
+  ASSERT_LE(stats.num_batches, stats.num_requests);
+  ASSERT_EQ(stats.batch_size_histogram.size(), 9UL);
+  uint64_t num_batches = 0;
+  for (auto count : stats.batch_size_histogram) {
+    num_batches += count;
+  }
+  ASSERT_EQ(num_batches, stats.num_batches);
+
+  // A request missing inputs fails through its future.
+  auto bad_request = make_request(1, 0);
+  bad_request.pop_back();
+  ASSERT_ANY_THROW(batching_predictor.Run(std::move(bad_request)).get());
+}
+
 TEST(Predictor, EnableONNXRuntime) {
   Config config;
   config.SetModel(FLAGS_dirname);
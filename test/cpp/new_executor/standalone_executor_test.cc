@@ -14,14 +14,19 @@
 
 #include "paddle/fluid/framework/new_executor/standalone_executor.h"
 
+#include <dirent.h>
 #include <gtest/gtest.h>
+#include <unistd.h>
 
 #include <chrono>
 #include <iostream>
 #include <string>
 
+#include "paddle/fluid/framework/new_executor/interpreter/analysis_cache.h"
 #include "paddle/phi/core/kernel_registry.h"
 
+DECLARE_string(new_executor_analysis_cache_dir);
+
 USE_OP_ITSELF(fill_constant);
 USE_OP_ITSELF(uniform_random);
 USE_OP(lookup_table);
@@ -279,5 +284,114 @@ TEST(InterpreterCore, workqueue_multiplexing) {
       program, {"a", "b"}, {tensor_a, tensor_b}, {"c"}, {0.0, 1.1, 2.2, 3.3});
 }
 
+TEST(InterpreterCore, analysis_cache) {
+  ProgramDesc program;
+  BlockDesc* main_block = program.MutableBlock(0);
+  for (const char* name : {"a", "b", "c", "d"}) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+
+  OpDesc* add1 = main_block->AppendOp();
+  add1->SetType("elementwise_add");
+  add1->SetInput("X", {"a"});
+  add1->SetInput("Y", {"b"});
+  add1->SetOutput("Out", {"c"});
+
+  OpDesc* add2 = main_block->AppendOp();
+  add2->SetType("elementwise_add");
+  add2->SetInput("X", {"a"});
+  add2->SetInput("Y", {"c"});
+  add2->SetOutput("Out", {"d"});
+
+  float data_a[] = {0, 1, 2, 3};
+  float data_b[] = {0.0, 0.1, 0.2, 0.3};
+
+  phi::DDim dims = phi::make_ddim({2, 2});
+  const platform::CPUPlace place = platform::CPUPlace();
+
+  phi::DenseTensor tensor_a = phi::DenseTensor();
+  phi::DenseTensor tensor_b = phi::DenseTensor();
+
+  std::copy_n(data_a, 4, tensor_a.mutable_data<float>(dims, place));
+  std::copy_n(data_b, 4, tensor_b.mutable_data<float>(dims, place));
+
+  char cache_dir[] = "/tmp/analysis_cache_XXXXXX";
+  ASSERT_NE(mkdtemp(cache_dir), nullptr);
+  FLAGS_new_executor_analysis_cache_dir = cache_dir;
+
+  auto cache_files = [&cache_dir]() {
+    std::vector<std::string> files;
+    DIR* dir = opendir(cache_dir);
+    while (dirent* entry = readdir(dir)) {
+      if (entry->d_name[0] != '.') {
+        files.emplace_back(std::string(cache_dir) + "/" + entry->d_name);
+      }
+    }
+    closedir(dir);
+    return files;
+  };
+
+  // the first core saves its analysis, and the second one of the same
+  // program reuses it
+  Scope scope;
+  for (int i = 0; i < 2; ++i) {
+    std::shared_ptr<InterpreterCore> core =
+        CreateInterpreterCore(place, program, &scope, {"c", "d"});
+    for (int step = 0; step < 2; ++step) {
+      FetchList fetch_list = core->Run({"a", "b"}, {tensor_a, tensor_b});
+      ASSERT_EQ(fetch_list.size(), 2UL);
+      const float* c = PADDLE_GET_CONST(phi::DenseTensor, fetch_list[0])
+                           .data<float>();
+      const float* d = PADDLE_GET_CONST(phi::DenseTensor, fetch_list[1])
+                           .data<float>();
+      for (int j = 0; j < 4; ++j) {
+        ASSERT_FLOAT_EQ(c[j], data_a[j] + data_b[j]);
+        ASSERT_FLOAT_EQ(d[j], 2 * data_a[j] + data_b[j]);
+      }
+    }
+    ASSERT_EQ(cache_files().size(), 1UL);
+  }
+
+  FLAGS_new_executor_analysis_cache_dir = "";
+  for (const std::string& file : cache_files()) {
+    unlink(file.c_str());
+  }
+  rmdir(cache_dir);
+}
+
+TEST(InterpreterCore, analysis_cache_bounds) {
+  char cache_dir[] = "/tmp/analysis_cache_XXXXXX";
+  ASSERT_NE(mkdtemp(cache_dir), nullptr);
+  std::string path = std::string(cache_dir) + "/analysis";
+  const uint64_t key = 7;
+
+  // 2 instructions and 3 vars
+  interpreter::InstructionAnalysis analysis;
+  analysis.op_downstream_map[0] = {1};
+  analysis.op_happens_before = {{false, true}, {false, false}};
+  analysis.last_live_ops[2] = {1};
+  analysis.events = {{0, 1}};
+  interpreter::SaveInstructionAnalysis(path, key, analysis);
+  interpreter::InstructionAnalysis loaded;
+  ASSERT_TRUE(interpreter::LoadInstructionAnalysis(path, key, 2, 3, &loaded));
+  ASSERT_EQ(loaded.op_downstream_map, analysis.op_downstream_map);
+  ASSERT_EQ(loaded.op_happens_before, analysis.op_happens_before);
+  ASSERT_EQ(loaded.last_live_ops, analysis.last_live_ops);
+  ASSERT_EQ(loaded.events, analysis.events);
+  // another number of instructions or vars, or an id out of range
+  ASSERT_FALSE(interpreter::LoadInstructionAnalysis(path, key, 3, 3, &loaded));
+  ASSERT_FALSE(interpreter::LoadInstructionAnalysis(path, key, 2, 2, &loaded));
+  analysis.op_downstream_map[5] = {1};
+  interpreter::SaveInstructionAnalysis(path, key, analysis);
+  ASSERT_FALSE(interpreter::LoadInstructionAnalysis(path, key, 2, 3, &loaded));
+  analysis.op_downstream_map.erase(5);
+  analysis.events.emplace_back(2, 0);
+  interpreter::SaveInstructionAnalysis(path, key, analysis);
+  ASSERT_FALSE(interpreter::LoadInstructionAnalysis(path, key, 2, 3, &loaded));
+
+  unlink(path.c_str());
+  rmdir(cache_dir);
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -0,0 +1,74 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include "glog/logging.h"
+#include "paddle/phi/api/include/api.h"
+#include "paddle/phi/core/kernel_factory.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "test/cpp/phi/core/timer.h"
+
+PD_DECLARE_KERNEL(full, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(scale, CPU, ALL_LAYOUT);
+
+namespace paddle {
+namespace tests {
+
+// The overhead of selecting the kernel of an api, with and without the
+// KernelDispatchCache used by the generated apis, compared with the whole
+// call of an api on a small tensor.
+TEST(API, kernel_dispatch) {
+  const size_t cycles = 1000000;
+  phi::KernelKey kernel_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  phi::tests::Timer timer;
+
+  const phi::Kernel* kernel = nullptr;
+  timer.tic();
+  for (size_t i = 0; i < cycles; ++i) {
+    auto kernel_result =
+        phi::KernelFactory::Instance().SelectKernelOrThrowError("scale",
+                                                                kernel_key);
+    kernel = &kernel_result.kernel;
+  }
+  double t1 = timer.toc();
+
+  phi::KernelDispatchCache cache("scale");
+  const phi::Kernel* cached_kernel = nullptr;
+  timer.tic();
+  for (size_t i = 0; i < cycles; ++i) {
+    cached_kernel = &cache.Select(kernel_key).kernel;
+  }
+  double t2 = timer.toc();
+  EXPECT_EQ(kernel, cached_kernel);
+
+  auto x = experimental::full({3, 4}, 1.0, phi::DataType::FLOAT32, CPUPlace());
+  const size_t api_cycles = cycles / 10;
+  timer.tic();
+  for (size_t i = 0; i < api_cycles; ++i) {
+    auto out = experimental::scale(x, 2.0, 1.0, true);
+  }
+  double t3 = timer.toc();
+
+  LOG(INFO) << "The cost of SelectKernelOrThrowError is "
+            << t1 * 1e6 / cycles << "ns.";
+  LOG(INFO) << "The cost of KernelDispatchCache::Select is "
+            << t2 * 1e6 / cycles << "ns.";
+  LOG(INFO) << "The cost of the scale api is " << t3 * 1e6 / api_cycles
+            << "ns.";
+}
+
+}  // namespace tests
+}  // namespace paddle
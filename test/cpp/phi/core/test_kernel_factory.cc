@@ -48,6 +48,31 @@ TEST(KernelFactory, SelectedKernelMap) {
   }
 }
 
+TEST(KernelDispatchCache, Select) {
+  auto& factory = phi::KernelFactory::Instance();
+  phi::KernelDispatchCache cache("scale");
+  for (auto dtype : {phi::DataType::FLOAT32,
+                     phi::DataType::FLOAT64,
+                     phi::DataType::FLOAT32}) {
+    phi::KernelKey kernel_key(phi::Backend::CPU, phi::DataLayout::NCHW, dtype);
+    auto expected = factory.SelectKernelOrThrowError("scale", kernel_key);
+    for (int i = 0; i < 2; ++i) {
+      auto result = cache.Select(kernel_key);
+      EXPECT_EQ(&result.kernel, &expected.kernel);
+      EXPECT_FALSE(result.has_fallback_cpu);
+    }
+    EXPECT_EQ(expected.kernel.args_def().input_defs().at(0).dtype, dtype);
+  }
+  // the kernels selected before are invalidated once the kernels may change
+  uint64_t version = factory.kernels_version();
+  factory.kernels();
+  EXPECT_NE(factory.kernels_version(), version);
+  phi::KernelKey kernel_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  EXPECT_EQ(&cache.Select(kernel_key).kernel,
+            &factory.SelectKernelOrThrowError("scale", kernel_key).kernel);
+}
+
 template <typename T, typename Context>
 void TestKernel(const Context& dev_ctx,
                 const DenseTensor& x,
@@ -0,0 +1,324 @@
+/* Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/funcs/blas/blas.h"
+#include "paddle/phi/kernels/funcs/sparse/sparse_blas.h"
+
+namespace phi {
+namespace tests {
+
+inline double GetCurrentUS() {
+  struct timeval time;
+  gettimeofday(&time, NULL);
+  return 1e+6 * time.tv_sec + time.tv_usec;
+}
+
+class SparseBlasTest {
+ public:
+  SparseBlasTest()
+      : alloc_(std::make_unique<paddle::experimental::DefaultAllocator>(
+            phi::CPUPlace())),
+        dev_ctx_(static_cast<const phi::CPUContext*>(
+            phi::DeviceContextPool::Instance().Get(phi::CPUPlace()))) {}
+
+  template <typename T>
+  DenseTensor MakeTensor(const std::vector<int64_t>& dims,
+                         const std::vector<T>& data) {
+    DenseTensor tensor(alloc_.get(),
+                       DenseTensorMeta(phi::CppTypeToDataType<T>::Type(),
+                                       phi::make_ddim(dims),
+                                       DataLayout::NCHW));
+    T* ptr = dev_ctx_->template Alloc<T>(&tensor);
+    if (!data.empty()) {
+      memcpy(ptr, data.data(), data.size() * sizeof(T));
+    }
+    return tensor;
+  }
+
+  // Random dense matrix [batch, rows, cols] in which about density of the
+  // elements are nonzero.
+  std::vector<float> RandomMatrix(int64_t numel, float density) {
+    std::uniform_real_distribution<float> value_dist(-1.f, 1.f);
+    std::uniform_real_distribution<float> mask_dist(0.f, 1.f);
+    std::vector<float> data(numel, 0.f);
+    for (auto& v : data) {
+      if (mask_dist(rng_) < density) {
+        v = value_dist(rng_);
+      }
+    }
+    return data;
+  }
+
+  SparseCsrTensor DenseToCsr(const std::vector<float>& dense,
+                             const std::vector<int64_t>& dims) {
+    int64_t batch = dims.size() == 3 ? dims[0] : 1;
+    int64_t rows = dims[dims.size() - 2];
+    int64_t cols = dims[dims.size() - 1];
+    std::vector<int64_t> crows, col_idx;
+    std::vector<float> values;
+    for (int64_t b = 0; b < batch; ++b) {
+      crows.push_back(0);
+      int64_t nnz = 0;
+      for (int64_t i = 0; i < rows; ++i) {
+        for (int64_t j = 0; j < cols; ++j) {
+          float v = dense[(b * rows + i) * cols + j];
+          if (v != 0.f) {
+            col_idx.push_back(j);
+            values.push_back(v);
+            ++nnz;
+          }
+        }
+        crows.push_back(nnz);
+      }
+    }
+    int64_t nnz = values.size();
+    return SparseCsrTensor(
+        MakeTensor<int64_t>({static_cast<int64_t>(crows.size())}, crows),
+        MakeTensor<int64_t>({nnz}, col_idx),
+        MakeTensor<float>({nnz}, values),
+        phi::make_ddim(dims));
+  }
+
+  // The entries are shuffled, the COO tensor is not coalesced.
+  SparseCooTensor DenseToCoo(const std::vector<float>& dense,
+                             const std::vector<int64_t>& dims) {
+    int ndims = dims.size();
+    std::vector<std::vector<int64_t>> entries;
+    std::vector<int64_t> index(ndims, 0);
+    for (size_t p = 0; p < dense.size(); ++p) {
+      int64_t offset = p;
+      for (int d = ndims - 1; d >= 0; --d) {
+        index[d] = offset % dims[d];
+        offset /= dims[d];
+      }
+      if (dense[p] != 0.f) {
+        entries.push_back(index);
+        entries.back().push_back(p);
+      }
+    }
+    std::shuffle(entries.begin(), entries.end(), rng_);
+    int64_t nnz = entries.size();
+    std::vector<int64_t> indices(ndims * nnz);
+    std::vector<float> values(nnz);
+    for (int64_t i = 0; i < nnz; ++i) {
+      for (int d = 0; d < ndims; ++d) {
+        indices[d * nnz + i] = entries[i][d];
+      }
+      values[i] = dense[entries[i][ndims]];
+    }
+    return SparseCooTensor(MakeTensor<int64_t>({ndims, nnz}, indices),
+                           MakeTensor<float>({nnz}, values),
+                           phi::make_ddim(dims));
+  }
+
+  const phi::CPUContext& dev_ctx() const { return *dev_ctx_; }
+
+ private:
+  std::unique_ptr<Allocator> alloc_;
+  const phi::CPUContext* dev_ctx_;
+  std::mt19937 rng_{2023};
+};
+
+// out[b] = op(a[b]) * op(c[b]) of row major dense matrices.
+void RefMatmul(const std::vector<float>& a,
+               const std::vector<float>& c,
+               bool transa,
+               bool transb,
+               int64_t batch,
+               int64_t m,
+               int64_t n,
+               int64_t k,
+               std::vector<float>* out) {
+  out->assign(batch * m * n, 0.f);
+  for (int64_t b = 0; b < batch; ++b) {
+    for (int64_t i = 0; i < m; ++i) {
+      for (int64_t j = 0; j < n; ++j) {
+        float sum = 0.f;
+        for (int64_t l = 0; l < k; ++l) {
+          float av = transa ? a[(b * k + l) * m + i] : a[(b * m + i) * k + l];
+          float cv = transb ? c[(b * n + j) * k + l] : c[(b * k + l) * n + j];
+          sum += av * cv;
+        }
+        (*out)[(b * m + i) * n + j] = sum;
+      }
+    }
+  }
+}
+
+template <typename MakeSparseFunc>
+void CheckSpmm(SparseBlasTest* test,
+               const MakeSparseFunc& make_sparse,
+               bool transa) {
+  int64_t batch = 2, m = 17, k = 33, n = 9;
+  std::vector<float> x_dense = test->RandomMatrix(batch * m * k, 0.3f);
+  std::vector<int64_t> x_dims = {batch, m, k};
+  if (transa) {
+    std::swap(x_dims[1], x_dims[2]);
+  }
+  std::vector<float> y = test->RandomMatrix(batch * k * n, 1.f);
+  std::vector<float> out_ref;
+  RefMatmul(x_dense, y, transa, false, batch, m, n, k, &out_ref);
+
+  auto sp_x = make_sparse(test, x_dense, x_dims);
+  DenseTensor dense_y = test->MakeTensor<float>({batch, k, n}, y);
+  std::vector<float> beta_init(batch * m * n, 1.f);
+  DenseTensor out = test->MakeTensor<float>({batch, m, n}, beta_init);
+  auto sparse_blas =
+      funcs::sparse::GetSparseBlas<phi::CPUContext, float>(test->dev_ctx());
+  sparse_blas.SPMM(transa, false, 2.f, sp_x, dense_y, 0.5f, &out);
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    EXPECT_NEAR(out.data<float>()[i], 2.f * out_ref[i] + 0.5f, 1e-4);
+  }
+}
+
+TEST(SparseBlas, SPMM) {
+  SparseBlasTest test;
+  auto to_csr = [](SparseBlasTest* t,
+                   const std::vector<float>& dense,
+                   const std::vector<int64_t>& dims) {
+    return t->DenseToCsr(dense, dims);
+  };
+  auto to_coo = [](SparseBlasTest* t,
+                   const std::vector<float>& dense,
+                   const std::vector<int64_t>& dims) {
+    return t->DenseToCoo(dense, dims);
+  };
+  for (bool transa : {false, true}) {
+    CheckSpmm(&test, to_csr, transa);
+    CheckSpmm(&test, to_coo, transa);
+  }
+}
+
+TEST(SparseBlas, SPMV) {
+  SparseBlasTest test;
+  int64_t m = 31, k = 47;
+  std::vector<float> x_dense = test.RandomMatrix(m * k, 0.2f);
+  std::vector<float> vec = test.RandomMatrix(m, 1.f);
+  std::vector<float> out_ref;
+  // out = x' * vec
+  RefMatmul(x_dense, vec, true, false, 1, k, 1, m, &out_ref);
+
+  auto sparse_blas =
+      funcs::sparse::GetSparseBlas<phi::CPUContext, float>(test.dev_ctx());
+  DenseTensor dense_vec = test.MakeTensor<float>({m}, vec);
+  DenseTensor out_csr = test.MakeTensor<float>({k}, {});
+  DenseTensor out_coo = test.MakeTensor<float>({k}, {});
+  sparse_blas.SPMV(
+      true, 1.f, test.DenseToCsr(x_dense, {m, k}), dense_vec, 0.f, &out_csr);
+  sparse_blas.SPMV(
+      true, 1.f, test.DenseToCoo(x_dense, {m, k}), dense_vec, 0.f, &out_coo);
+  for (int64_t i = 0; i < k; ++i) {
+    EXPECT_NEAR(out_csr.data<float>()[i], out_ref[i], 1e-4);
+    EXPECT_NEAR(out_coo.data<float>()[i], out_ref[i], 1e-4);
+  }
+}
+
+TEST(SparseBlas, SDDMM) {
+  SparseBlasTest test;
+  int64_t batch = 3, m = 13, k = 21, n = 11;
+  std::vector<float> x = test.RandomMatrix(batch * m * k, 1.f);
+  std::vector<float> y = test.RandomMatrix(batch * n * k, 1.f);
+  std::vector<float> mask = test.RandomMatrix(batch * m * n, 0.4f);
+  std::vector<float> out_ref;
+  // out = (x * y') masked
+  RefMatmul(x, y, false, true, batch, m, n, k, &out_ref);
+
+  DenseTensor dense_x = test.MakeTensor<float>({batch, m, k}, x);
+  DenseTensor dense_y = test.MakeTensor<float>({batch, n, k}, y);
+  SparseCsrTensor out_csr = test.DenseToCsr(mask, {batch, m, n});
+  SparseCooTensor out_coo = test.DenseToCoo(mask, {batch, m, n});
+  auto sparse_blas =
+      funcs::sparse::GetSparseBlas<phi::CPUContext, float>(test.dev_ctx());
+  sparse_blas.SDDMM(false, true, 1.f, dense_x, dense_y, 0.f, &out_csr);
+  sparse_blas.SDDMM(false, true, 1.f, dense_x, dense_y, 0.f, &out_coo);
+
+  const int64_t* crows = out_csr.crows().data<int64_t>();
+  const int64_t* cols = out_csr.cols().data<int64_t>();
+  const float* values = out_csr.values().data<float>();
+  int64_t offset = 0;
+  for (int64_t b = 0; b < batch; ++b) {
+    for (int64_t i = 0; i < m; ++i) {
+      for (int64_t p = crows[b * (m + 1) + i]; p < crows[b * (m + 1) + i + 1];
+           ++p) {
+        EXPECT_NEAR(values[offset + p],
+                    out_ref[(b * m + i) * n + cols[offset + p]],
+                    1e-4);
+      }
+    }
+    offset += crows[b * (m + 1) + m];
+  }
+  int64_t nnz = out_coo.nnz();
+  const int64_t* indices = out_coo.indices().data<int64_t>();
+  for (int64_t p = 0; p < nnz; ++p) {
+    int64_t b = indices[p], i = indices[nnz + p], j = indices[2 * nnz + p];
+    EXPECT_NEAR(out_coo.values().data<float>()[p],
+                out_ref[(b * m + i) * n + j],
+                1e-4);
+  }
+}
+
+// CSR/COO @ DENSE against the dense GEMM over a range of sparsity.
+TEST(SparseBlas, SPMM_benchmark) {
+  constexpr int repeat = 10;
+  int64_t m = 1024, k = 1024, n = 128;
+  SparseBlasTest test;
+  auto sparse_blas =
+      funcs::sparse::GetSparseBlas<phi::CPUContext, float>(test.dev_ctx());
+  auto blas = funcs::GetBlas<phi::CPUContext, float>(test.dev_ctx());
+  std::vector<float> y = test.RandomMatrix(k * n, 1.f);
+  DenseTensor dense_y = test.MakeTensor<float>({k, n}, y);
+  DenseTensor out = test.MakeTensor<float>({m, n}, {});
+
+  for (float sparsity : {0.5f, 0.9f, 0.95f, 0.99f, 0.999f}) {
+    std::vector<float> x = test.RandomMatrix(m * k, 1.f - sparsity);
+    DenseTensor dense_x = test.MakeTensor<float>({m, k}, x);
+    SparseCsrTensor csr_x = test.DenseToCsr(x, {m, k});
+    SparseCooTensor coo_x = test.DenseToCoo(x, {m, k});
+
+    auto t0 = GetCurrentUS();
+    for (int i = 0; i < repeat; ++i) {
+      blas.MatMul(dense_x, false, dense_y, false, &out);
+    }
+    auto t1 = GetCurrentUS();
+    for (int i = 0; i < repeat; ++i) {
+      sparse_blas.SPMM(false, false, 1.f, csr_x, dense_y, 0.f, &out);
+    }
+    auto t2 = GetCurrentUS();
+    for (int i = 0; i < repeat; ++i) {
+      sparse_blas.SPMM(false, false, 1.f, coo_x, dense_y, 0.f, &out);
+    }
+    auto t3 = GetCurrentUS();
+    LOG(INFO) << "sparsity " << sparsity << " [" << m << ", " << k << "] @ ["
+              << k << ", " << n << "]: dense gemm " << (t1 - t0) / repeat
+              << " us, csr " << (t2 - t1) / repeat << " us, coo "
+              << (t3 - t2) / repeat << " us";
+  }
+}
+
+}  // namespace tests
+}  // namespace phi